@@ -53,6 +53,8 @@ static const S32 WAV_HEADER_SIZE = 44;
 //////////////////////////////////////////////////////////////////////////////
 
 
+struct LLVorbisCacheSource;
+
 class LLVorbisDecodeState : public LLThreadSafeRefCount
 {
 public:
@@ -93,29 +95,46 @@ protected:
 	std::string mOutFilename;
 	LLLFSThread::handle_t mFileHandle;
 	
-	LLFileSystem *mInFilep;
+	LLVorbisCacheSource *mInFilep;
 	OggVorbis_File mVF;
 	S32 mCurrentSection;
 };
 
-size_t cache_read(void *ptr, size_t size, size_t nmemb, void *datasource)
+// Vorbis reads the whole sound in small chunks and seeks around in it while
+// looking for the stream boundaries, so decode straight from a view of the
+// cached asset rather than issuing one cache read per callback.
+struct LLVorbisCacheSource
 {
-	LLFileSystem *file = (LLFileSystem *)datasource;
-
-	if (file->read((U8*)ptr, (S32)(size * nmemb)))	/*Flawfinder: ignore*/
+	LLVorbisCacheSource(const LLUUID& uuid)
+	:	mFile(uuid, LLAssetType::AT_SOUND),
+		mPosition(0)
 	{
-		S32 read = file->getLastBytesRead();
-		return  read / size;	/*Flawfinder: ignore*/
+		mView = mFile.getView();
 	}
-	else
+
+	LLFileSystem mFile;
+	LLFileSystemView::ptr_t mView;
+	S32 mPosition;
+};
+
+size_t cache_read(void *ptr, size_t size, size_t nmemb, void *datasource)
+{
+	LLVorbisCacheSource *source = (LLVorbisCacheSource *)datasource;
+
+	S32 available = source->mView->getSize() - source->mPosition;
+	S32 read = (S32)llmin((size_t)llmax(available, 0), size * nmemb);	/*Flawfinder: ignore*/
+	if (read <= 0)
 	{
 		return 0;
 	}
+	memcpy(ptr, source->mView->getData() + source->mPosition, read);	/*Flawfinder: ignore*/
+	source->mPosition += read;
+	return read / size;	/*Flawfinder: ignore*/
 }
 
 S32 cache_seek(void *datasource, ogg_int64_t offset, S32 whence)
 {
-	LLFileSystem *file = (LLFileSystem *)datasource;
+	LLVorbisCacheSource *source = (LLVorbisCacheSource *)datasource;
 
 	// cache has 31-bit files
 	if (offset > S32_MAX)
@@ -123,43 +142,41 @@ S32 cache_seek(void *datasource, ogg_int64_t offset, S32 whence)
 		return -1;
 	}
 
-	S32 origin;
+	S64 position;
 	switch (whence) {
 	case SEEK_SET:
-		origin = 0;
+		position = offset;
 		break;
 	case SEEK_END:
-		origin = file->getSize();
+		position = source->mView->getSize() + offset;
 		break;
 	case SEEK_CUR:
-		origin = -1;
+		position = source->mPosition + offset;
 		break;
 	default:
 		LL_ERRS("AudioEngine") << "Invalid whence argument to cache_seek" << LL_ENDL;
 		return -1;
 	}
 
-	if (file->seek((S32)offset, origin))
-	{
-		return 0;
-	}
-	else
+	if (position < 0 || position > source->mView->getSize())
 	{
 		return -1;
 	}
+	source->mPosition = (S32)position;
+	return 0;
 }
 
 S32 cache_close (void *datasource)
 {
-	LLFileSystem *file = (LLFileSystem *)datasource;
-	delete file;
+	LLVorbisCacheSource *source = (LLVorbisCacheSource *)datasource;
+	delete source;
 	return 0;
 }
 
 long cache_tell (void *datasource)
 {
-	LLFileSystem *file = (LLFileSystem *)datasource;
-	return file->tell();
+	LLVorbisCacheSource *source = (LLVorbisCacheSource *)datasource;
+	return source->mPosition;
 }
 
 LLVorbisDecodeState::LLVorbisDecodeState(const LLUUID &uuid, const std::string &out_filename)
@@ -198,8 +215,8 @@ BOOL LLVorbisDecodeState::initDecode()
 
 	LL_DEBUGS("AudioEngine") << "Initing decode from vfile: " << mUUID << LL_ENDL;
 
-	mInFilep = new LLFileSystem(mUUID, LLAssetType::AT_SOUND);
-	if (!mInFilep || !mInFilep->getSize())
+	mInFilep = new LLVorbisCacheSource(mUUID);
+	if (!mInFilep->mView)
 	{
 		LL_WARNS("AudioEngine") << "unable to open vorbis source vfile for reading" << LL_ENDL;
 		delete mInFilep;
@@ -524,7 +541,7 @@ void LLVorbisDecodeState::flushBadFile()
 	if (mInFilep)
 	{
 		LL_WARNS("AudioEngine") << "Flushing bad vorbis file from cache for " << mUUID << LL_ENDL;
-		mInFilep->remove();
+		mInFilep->mFile.remove();
 
 		// <FS:ND> FIRE-15975; Delete the current file, or we might end with stale locks during the re-transfer
 		delete mInFilep;
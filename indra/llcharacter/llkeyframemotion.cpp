@@ -129,6 +129,70 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 
+// Index of a key at time in times, which is added unless replace comes back
+// true for a key already at that time. Keys nearly always come in order.
+static S32 add_key_time(std::vector<F32>& times, F32 time, bool& replace)
+{
+	if (times.empty() || times.back() < time)
+	{
+		replace = false;
+		times.push_back(time);
+		return (S32)times.size() - 1;
+	}
+
+	std::vector<F32>::iterator it = std::lower_bound(times.begin(), times.end(), time);
+	replace = *it == time;
+	if (!replace)
+	{
+		it = times.insert(it, time);
+	}
+	return (S32)(it - times.begin());
+}
+
+// Finds the keys for time the way a lower_bound() on the times would,
+// starting from where cursor was left. Returns true with the keys before
+// and after and the weight u when time falls between two keys, false with
+// the key to use as it is in before. times must not be empty.
+static bool find_keys(const std::vector<F32>& times, F32 time, S32& cursor, S32& before, S32& after, F32& u)
+{
+	S32 num_keys = (S32)times.size();
+	S32 right = cursor;
+	if (right < 0 || right > num_keys || (right > 0 && times[right - 1] >= time))
+	{
+		// first read, or time went back for a loop or a restart
+		right = (S32)(std::lower_bound(times.begin(), times.end(), time) - times.begin());
+	}
+	else if (right < num_keys && times[right] < time)
+	{
+		// moved forward, usually by no more than a key
+		++right;
+		if (right < num_keys && times[right] < time)
+		{
+			right = (S32)(std::lower_bound(times.begin() + right, times.end(), time) - times.begin());
+		}
+	}
+	llassert(right == (S32)(std::lower_bound(times.begin(), times.end(), time) - times.begin()));
+	cursor = right;
+
+	if (right == num_keys)
+	{
+		// Past last key
+		before = num_keys - 1;
+		return false;
+	}
+	if (right == 0 || times[right] == time)
+	{
+		// Before first key or exactly on a key
+		before = right;
+		return false;
+	}
+
+	// Between two keys
+	before = right - 1;
+	after = right;
+	u = (time - times[before]) / (times[after] - times[before]);
+	return true;
+}
 
 //-----------------------------------------------------------------------------
 // ScaleCurve::ScaleCurve()
@@ -144,51 +208,56 @@ LLKeyframeMotion::ScaleCurve::ScaleCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::ScaleCurve::~ScaleCurve() 
 {
-	mKeys.clear();
+	mKeyTimes.clear();
+	mKeyScales.clear();
 	mNumKeys = 0;
 }
 
+//-----------------------------------------------------------------------------
+// ScaleCurve::addKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::ScaleCurve::addKey(const ScaleKey& key)
+{
+	bool replace;
+	S32 index = add_key_time(mKeyTimes, key.mTime, replace);
+	if (replace)
+	{
+		mKeyScales[index] = key.mScale;
+	}
+	else
+	{
+		mKeyScales.insert(mKeyScales.begin() + index, key.mScale);
+	}
+}
+
 //-----------------------------------------------------------------------------
 // getValue()
 //-----------------------------------------------------------------------------
 LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = -1;
+	return getValue(time, duration, cursor);
+}
+
+LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration, S32& cursor)
 {
 	LLVector3 value;
 
-	if (mKeys.empty())
+	if (mKeyTimes.empty())
 	{
 		value.clearVec();
 		return value;
 	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
+
+	S32 before, after;
+	F32 u;
+	if (find_keys(mKeyTimes, time, cursor, before, after, u))
 	{
-		// Past last key
-		--right;
-		value = right->second.mScale;
-	}
-	else if (right == mKeys.begin() || right->first == time)
-	{
-		// Before first key or exactly on a key
-		value = right->second.mScale;
+		value = interp(u, mKeyScales[before], mKeyScales[after]);
 	}
 	else
 	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		ScaleKey& scale_before = left->second;
-		ScaleKey& scale_after = right->second;
-		if (right == mKeys.end())
-		{
-			scale_after = mLoopInKey;
-			index_after = duration;
-		}
-
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, scale_before, scale_after);
+		value = mKeyScales[before];
 	}
 	return value;
 }
@@ -196,17 +265,17 @@ LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey& after)
+LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, const LLVector3& before, const LLVector3& after)
 {
 	switch (mInterpolationType)
 	{
 	case IT_STEP:
-		return before.mScale;
+		return before;
 
 	default:
 	case IT_LINEAR:
 	case IT_SPLINE:
-		return lerp(before.mScale, after.mScale, u);
+		return lerp(before, after, u);
 	}
 }
 
@@ -224,69 +293,82 @@ LLKeyframeMotion::RotationCurve::RotationCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::RotationCurve::~RotationCurve()
 {
-	mKeys.clear();
+	mKeyTimes.clear();
+	mKeyRotations.clear();
 	mNumKeys = 0;
 }
 
+//-----------------------------------------------------------------------------
+// RotationCurve::addKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::RotationCurve::addKey(const RotationKey& key)
+{
+	bool replace;
+	S32 index = add_key_time(mKeyTimes, key.mTime, replace);
+	if (replace)
+	{
+		mKeyRotations[index] = key.mRotation;
+	}
+	else
+	{
+		mKeyRotations.insert(mKeyRotations.begin() + index, key.mRotation);
+	}
+}
+
 //-----------------------------------------------------------------------------
 // RotationCurve::getValue()
 //-----------------------------------------------------------------------------
 LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = -1;
+	return getValue(time, duration, cursor);
+}
+
+LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration, S32& cursor)
 {
 	LLQuaternion value;
 
-	if (mKeys.empty())
+	if (mKeyTimes.empty())
 	{
 		value = LLQuaternion::DEFAULT;
 		return value;
 	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
-	{
-		// Past last key
-		--right;
-		value = right->second.mRotation;
-	}
-	else if (right == mKeys.begin() || right->first == time)
+
+	S32 before, after;
+	F32 u;
+	if (find_keys(mKeyTimes, time, cursor, before, after, u))
 	{
-		// Before first key or exactly on a key
-		value = right->second.mRotation;
+		value = interp(u, mKeyRotations[before], mKeyRotations[after]);
 	}
 	else
 	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		RotationKey& rot_before = left->second;
-		RotationKey& rot_after = right->second;
-		if (right == mKeys.end())
-		{
-			rot_after = mLoopInKey;
-			index_after = duration;
-		}
-
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, rot_before, rot_after);
+		value = mKeyRotations[before];
 	}
 	return value;
 }
 
+//-----------------------------------------------------------------------------
+// RotationCurve::getBlend()
+//-----------------------------------------------------------------------------
+bool LLKeyframeMotion::RotationCurve::getBlend(F32 time, S32& cursor, S32& before, S32& after, F32& u)
+{
+	return find_keys(mKeyTimes, time, cursor, before, after, u) && mInterpolationType != IT_STEP;
+}
+
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before, RotationKey& after)
+LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, const LLQuaternion& before, const LLQuaternion& after)
 {
 	switch (mInterpolationType)
 	{
 	case IT_STEP:
-		return before.mRotation;
+		return before;
 
 	default:
 	case IT_LINEAR:
 	case IT_SPLINE:
-		return nlerp(u, before.mRotation, after.mRotation);
+		return nlerp(u, before, after);
 	}
 }
 
@@ -305,51 +387,56 @@ LLKeyframeMotion::PositionCurve::PositionCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::PositionCurve::~PositionCurve()
 {
-	mKeys.clear();
+	mKeyTimes.clear();
+	mKeyPositions.clear();
 	mNumKeys = 0;
 }
 
+//-----------------------------------------------------------------------------
+// PositionCurve::addKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::PositionCurve::addKey(const PositionKey& key)
+{
+	bool replace;
+	S32 index = add_key_time(mKeyTimes, key.mTime, replace);
+	if (replace)
+	{
+		mKeyPositions[index] = key.mPosition;
+	}
+	else
+	{
+		mKeyPositions.insert(mKeyPositions.begin() + index, key.mPosition);
+	}
+}
+
 //-----------------------------------------------------------------------------
 // PositionCurve::getValue()
 //-----------------------------------------------------------------------------
 LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = -1;
+	return getValue(time, duration, cursor);
+}
+
+LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration, S32& cursor)
 {
 	LLVector3 value;
 
-	if (mKeys.empty())
+	if (mKeyTimes.empty())
 	{
 		value.clearVec();
 		return value;
 	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
-	{
-		// Past last key
-		--right;
-		value = right->second.mPosition;
-	}
-	else if (right == mKeys.begin() || right->first == time)
+
+	S32 before, after;
+	F32 u;
+	if (find_keys(mKeyTimes, time, cursor, before, after, u))
 	{
-		// Before first key or exactly on a key
-		value = right->second.mPosition;
+		value = interp(u, mKeyPositions[before], mKeyPositions[after]);
 	}
 	else
 	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		PositionKey& pos_before = left->second;
-		PositionKey& pos_after = right->second;
-		if (right == mKeys.end())
-		{
-			pos_after = mLoopInKey;
-			index_after = duration;
-		}
-
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, pos_before, pos_after);
+		value = mKeyPositions[before];
 	}
 
 	llassert(value.isFinite());
@@ -360,62 +447,16 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, PositionKey& after)
+LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, const LLVector3& before, const LLVector3& after)
 {
 	switch (mInterpolationType)
 	{
 	case IT_STEP:
-		return before.mPosition;
+		return before;
 	default:
 	case IT_LINEAR:
 	case IT_SPLINE:
-		return lerp(before.mPosition, after.mPosition, u);
-	}
-}
-
-
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-// JointMotion class
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-
-//-----------------------------------------------------------------------------
-// JointMotion::update()
-//-----------------------------------------------------------------------------
-void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration)
-{
-	// this value being 0 is the cause of https://jira.lindenlab.com/browse/SL-22678 but I haven't 
-	// managed to get a stack to see how it got here. Testing for 0 here will stop the crash.
-	if ( joint_state == NULL )
-	{
-		return;
-	}
-
-	U32 usage = joint_state->getUsage();
-
-	//-------------------------------------------------------------------------
-	// update scale component of joint state
-	//-------------------------------------------------------------------------
-	if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
-	{
-		joint_state->setScale( mScaleCurve.getValue( time, duration ) );
-	}
-
-	//-------------------------------------------------------------------------
-	// update rotation component of joint state
-	//-------------------------------------------------------------------------
-	if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
-	{
-		joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
-	}
-
-	//-------------------------------------------------------------------------
-	// update position component of joint state
-	//-------------------------------------------------------------------------
-	if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
-	{
-		joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+		return lerp(before, after, u);
 	}
 }
 
@@ -738,11 +779,66 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 void LLKeyframeMotion::applyKeyframes(F32 time)
 {
 	llassert_always (mJointMotionList->getNumJointMotions() <= mJointStates.size());
-	for (U32 i=0; i<mJointMotionList->getNumJointMotions(); i++)
+	U32 num_joints = mJointMotionList->getNumJointMotions();
+	F32 duration = mJointMotionList->mDuration;
+	mKeyCursors.resize(num_joints);
+	mBlendStates.clear();
+	mBlendWeights.clear();
+	mBlendBefore.clear();
+	mBlendAfter.clear();
+
+	for (U32 i=0; i<num_joints; i++)
+	{
+		// this value being 0 is the cause of https://jira.lindenlab.com/browse/SL-22678 but I haven't 
+		// managed to get a stack to see how it got here. Testing for 0 here will stop the crash.
+		LLJointState* joint_state = mJointStates[i];
+		if (joint_state == NULL)
+		{
+			continue;
+		}
+
+		JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
+		KeyCursor& cursor = mKeyCursors[i];
+		U32 usage = joint_state->getUsage();
+
+		if ((usage & LLJointState::SCALE) && joint_motion->mScaleCurve.mNumKeys)
+		{
+			joint_state->setScale(joint_motion->mScaleCurve.getValue(time, duration, cursor.mScale));
+		}
+
+		if ((usage & LLJointState::ROT) && joint_motion->mRotationCurve.mNumKeys)
+		{
+			RotationCurve& curve = joint_motion->mRotationCurve;
+			S32 before, after;
+			F32 u;
+			if (curve.getBlend(time, cursor.mRotation, before, after, u))
+			{
+				// blended below along with the other joints
+				mBlendStates.push_back(joint_state);
+				mBlendWeights.push_back(u);
+				mBlendBefore.push_back(curve.mKeyRotations[before]);
+				mBlendAfter.push_back(curve.mKeyRotations[after]);
+			}
+			else
+			{
+				joint_state->setRotation(curve.mKeyRotations[before]);
+			}
+		}
+
+		if ((usage & LLJointState::POS) && joint_motion->mPositionCurve.mNumKeys)
+		{
+			joint_state->setPosition(joint_motion->mPositionCurve.getValue(time, duration, cursor.mPosition));
+		}
+	}
+
+	U32 num_blends = mBlendStates.size();
+	if (num_blends)
 	{
-		mJointMotionList->getJointMotion(i)->update(mJointStates[i],
-													  time, 
-													  mJointMotionList->mDuration );
+		LLQuaternion2::nlerp(num_blends, &mBlendWeights[0], &mBlendBefore[0], &mBlendAfter[0], &mBlendBefore[0]);
+		for (U32 i = 0; i < num_blends; i++)
+		{
+			mBlendStates[i]->setRotation(mBlendBefore[i]);
+		}
 	}
 
 	LLJoint::JointPriority* pose_priority = (LLJoint::JointPriority* )mCharacter->getAnimationData("Hand Pose Priority");
@@ -1630,10 +1726,10 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 				return FALSE;
 			}
 
-			rCurve->mKeys[time] = rot_key;
+			rCurve->addKey(rot_key);
 		}
 
-        if (joint_motion->mRotationCurve.mNumKeys > joint_motion->mRotationCurve.mKeys.size())
+        if (joint_motion->mRotationCurve.mNumKeys > joint_motion->mRotationCurve.mKeyTimes.size())
         {
             rotation_dupplicates++;
             LL_INFOS() << "Motion: " << asset_id << " had dupplicate rotation keys that were removed" << LL_ENDL;
@@ -1733,7 +1829,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 				return FALSE;
 			}
 			
-			pCurve->mKeys[pos_key.mTime] = pos_key;
+			pCurve->addKey(pos_key);
 
 			if (is_pelvis)
 			{
@@ -1741,7 +1837,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 			}
 		}
 
-        if (joint_motion->mPositionCurve.mNumKeys > joint_motion->mPositionCurve.mKeys.size())
+        if (joint_motion->mPositionCurve.mNumKeys > joint_motion->mPositionCurve.mKeyTimes.size())
         {
             position_dupplicates++;
         }
@@ -2038,19 +2134,21 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 		JointMotion* joint_motionp = mJointMotionList->getJointMotion(i);
 		success &= dp.packString(joint_motionp->mJointName, "joint_name");
 		success &= dp.packS32(joint_motionp->mPriority, "joint_priority");
-        success &= dp.packS32(joint_motionp->mRotationCurve.mKeys.size(), "num_rot_keys");
+        RotationCurve& rot_curve = joint_motionp->mRotationCurve;
+        PositionCurve& pos_curve = joint_motionp->mPositionCurve;
+        success &= dp.packS32(rot_curve.mKeyTimes.size(), "num_rot_keys");
 
         LL_DEBUGS("BVH") << "Joint " << i
             << " name: " << joint_motionp->mJointName
-            << " Rotation keys: " << joint_motionp->mRotationCurve.mKeys.size()
-            << " Position keys: " << joint_motionp->mPositionCurve.mKeys.size() << LL_ENDL;
-        for (RotationCurve::key_map_t::value_type& rot_pair : joint_motionp->mRotationCurve.mKeys)
+            << " Rotation keys: " << rot_curve.mKeyTimes.size()
+            << " Position keys: " << pos_curve.mKeyTimes.size() << LL_ENDL;
+        for (U32 k = 0; k < rot_curve.mKeyTimes.size(); k++)
 		{
-			RotationKey& rot_key = rot_pair.second;
-			U16 time_short = F32_to_U16(rot_key.mTime, 0.f, mJointMotionList->mDuration);
+			F32 time = rot_curve.mKeyTimes[k];
+			U16 time_short = F32_to_U16(time, 0.f, mJointMotionList->mDuration);
 			success &= dp.packU16(time_short, "time");
 
-			LLVector3 rot_angles = rot_key.mRotation.packToVector3();
+			LLVector3 rot_angles = rot_curve.mKeyRotations[k].packToVector3();
 			
 			U16 x, y, z;
 			rot_angles.quantize16(-1.f, 1.f, -1.f, 1.f);
@@ -2061,26 +2159,27 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 			success &= dp.packU16(y, "rot_angle_y");
 			success &= dp.packU16(z, "rot_angle_z");
 
-			LL_DEBUGS("BVH") << "  rot: t " << rot_key.mTime << " angles " << rot_angles.mV[VX] <<","<< rot_angles.mV[VY] <<","<< rot_angles.mV[VZ] << LL_ENDL;
+			LL_DEBUGS("BVH") << "  rot: t " << time << " angles " << rot_angles.mV[VX] <<","<< rot_angles.mV[VY] <<","<< rot_angles.mV[VZ] << LL_ENDL;
 		}
 
-		success &= dp.packS32(joint_motionp->mPositionCurve.mKeys.size(), "num_pos_keys");
-		for (PositionCurve::key_map_t::value_type& pos_pair : joint_motionp->mPositionCurve.mKeys)
+		success &= dp.packS32(pos_curve.mKeyTimes.size(), "num_pos_keys");
+		for (U32 k = 0; k < pos_curve.mKeyTimes.size(); k++)
 		{
-			PositionKey& pos_key = pos_pair.second;
-			U16 time_short = F32_to_U16(pos_key.mTime, 0.f, mJointMotionList->mDuration);
+			F32 time = pos_curve.mKeyTimes[k];
+			LLVector3& position = pos_curve.mKeyPositions[k];
+			U16 time_short = F32_to_U16(time, 0.f, mJointMotionList->mDuration);
 			success &= dp.packU16(time_short, "time");
 
 			U16 x, y, z;
-			pos_key.mPosition.quantize16(-LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			x = F32_to_U16(pos_key.mPosition.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			y = F32_to_U16(pos_key.mPosition.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			z = F32_to_U16(pos_key.mPosition.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			position.quantize16(-LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			x = F32_to_U16(position.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			y = F32_to_U16(position.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			z = F32_to_U16(position.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
 			success &= dp.packU16(x, "pos_x");
 			success &= dp.packU16(y, "pos_y");
 			success &= dp.packU16(z, "pos_z");
 
-			LL_DEBUGS("BVH") << "  pos: t " << pos_key.mTime << " pos " << pos_key.mPosition.mV[VX] <<","<< pos_key.mPosition.mV[VY] <<","<< pos_key.mPosition.mV[VZ] << LL_ENDL;
+			LL_DEBUGS("BVH") << "  pos: t " << time << " pos " << position.mV[VX] <<","<< position.mV[VY] <<","<< position.mV[VZ] << LL_ENDL;
 		}
 	}	
 
@@ -325,13 +325,15 @@ public:
 	public:
 		ScaleCurve();
 		~ScaleCurve();
+		void addKey(const ScaleKey& key);
 		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, ScaleKey& before, ScaleKey& after);
+		LLVector3 getValue(F32 time, F32 duration, S32& cursor);
+		LLVector3 interp(F32 u, const LLVector3& before, const LLVector3& after);
 
 		InterpolationType	mInterpolationType;
-		S32					mNumKeys;
-		typedef std::map<F32, ScaleKey> key_map_t;
-		key_map_t 			mKeys;
+		S32					mNumKeys;		// as stored in the asset, duplicate times included
+		std::vector<F32>		mKeyTimes;	// sorted, one entry per key
+		std::vector<LLVector3>	mKeyScales;
 		ScaleKey			mLoopInKey;
 		ScaleKey			mLoopOutKey;
 	};
@@ -344,13 +346,18 @@ public:
 	public:
 		RotationCurve();
 		~RotationCurve();
+		void addKey(const RotationKey& key);
 		LLQuaternion getValue(F32 time, F32 duration);
-		LLQuaternion interp(F32 u, RotationKey& before, RotationKey& after);
+		LLQuaternion getValue(F32 time, F32 duration, S32& cursor);
+		// Returns true when the value at time is a blend of keys before and
+		// after by u, false when it is key before as it is
+		bool getBlend(F32 time, S32& cursor, S32& before, S32& after, F32& u);
+		LLQuaternion interp(F32 u, const LLQuaternion& before, const LLQuaternion& after);
 
 		InterpolationType	mInterpolationType;
-		S32					mNumKeys;
-		typedef std::map<F32, RotationKey> key_map_t;
-		key_map_t		mKeys;
+		S32					mNumKeys;		// as stored in the asset, duplicate times included
+		std::vector<F32>			mKeyTimes;	// sorted, one entry per key
+		std::vector<LLQuaternion>	mKeyRotations;
 		RotationKey		mLoopInKey;
 		RotationKey		mLoopOutKey;
 	};
@@ -363,13 +370,15 @@ public:
 	public:
 		PositionCurve();
 		~PositionCurve();
+		void addKey(const PositionKey& key);
 		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, PositionKey& before, PositionKey& after);
+		LLVector3 getValue(F32 time, F32 duration, S32& cursor);
+		LLVector3 interp(F32 u, const LLVector3& before, const LLVector3& after);
 
 		InterpolationType	mInterpolationType;
-		S32					mNumKeys;
-		typedef std::map<F32, PositionKey> key_map_t;
-		key_map_t		mKeys;
+		S32					mNumKeys;		// as stored in the asset, duplicate times included
+		std::vector<F32>		mKeyTimes;	// sorted, one entry per key
+		std::vector<LLVector3>	mKeyPositions;
 		PositionKey		mLoopInKey;
 		PositionKey		mLoopOutKey;
 	};
@@ -386,8 +395,22 @@ public:
 		std::string		mJointName;
 		U32				mUsage;
 		LLJoint::JointPriority	mPriority;
+	};
+
+	//-------------------------------------------------------------------------
+	// KeyCursor
+	//-------------------------------------------------------------------------
+	// Where each curve of a joint was last read by this motion instance, so
+	// playback moving forward finds its keys without a search. The curves
+	// themselves are shared through LLKeyframeDataCache.
+	class KeyCursor
+	{
+	public:
+		KeyCursor() : mScale(-1), mRotation(-1), mPosition(-1) {}
 
-		void update(LLJointState* joint_state, F32 time, F32 duration);
+		S32		mScale;
+		S32		mRotation;
+		S32		mPosition;
 	};
 	
 	//-------------------------------------------------------------------------
@@ -432,6 +455,12 @@ protected:
 	F32								mLastUpdateTime;
 	F32								mLastLoopedTime;
 	AssetStatus						mAssetStatus;
+	std::vector<KeyCursor>			mKeyCursors;
+	// rotations applyKeyframes() blends together
+	std::vector<LLJointState*>		mBlendStates;
+	std::vector<F32>				mBlendWeights;
+	std::vector<LLQuaternion>		mBlendBefore;
+	std::vector<LLQuaternion>		mBlendAfter;
 
 public:
 	void setCharacter(LLCharacter* character) { mCharacter = character; }
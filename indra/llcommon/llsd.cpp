@@ -36,7 +36,12 @@
 #include "llsdserialize.h"
 #include "stringize.h"
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
 
 // Defend against a caller forcibly passing a negative number into an unsigned
 // size_t index param
@@ -154,7 +159,7 @@ public:
 	virtual const LLSD& ref(size_t) const		{ return undef(); }
 
 	virtual LLSD::map_const_iterator beginMap() const { return endMap(); }
-	virtual LLSD::map_const_iterator endMap() const { static const std::map<String, LLSD> empty; return empty.end(); }
+	virtual LLSD::map_const_iterator endMap() const { return LLSD::map_const_iterator(); }
 	virtual LLSD::array_const_iterator beginArray() const { return endArray(); }
 	virtual LLSD::array_const_iterator endArray() const { static const std::vector<LLSD> empty; return empty.end(); }
 
@@ -176,6 +181,14 @@ public:
 	static U32 sOutstandingCount;
 };
 
+struct LLSD::MapKey
+{
+	MapKey(const LLSD::String& key) : mString(key), mCount(1) { }
+
+	const LLSD::String	mString;
+	std::atomic<U32>	mCount;		// maps holding this key
+};
+
 #ifdef NAME_UNNAMED_NAMESPACE
 namespace LLSDUnnamedNamespace 
 #else
@@ -368,18 +381,105 @@ namespace
 	};
 
 
+	// Map keys are interned: all the maps holding a key share one MapKey.
+	// Like LLStdStringTable it hands out stable std::string pointers, but
+	// it counts references, since keys can be UUIDs or other open ended
+	// data, and it locks, since maps are built on many threads.
+	class MapKeyTable
+	{
+	public:
+		static MapKeyTable& instance();
+
+		LLSD::MapKey* add(const LLSD::String& k);
+		static void addRef(LLSD::MapKey* key)	{ key->mCount.fetch_add(1, std::memory_order_relaxed); }
+		void release(LLSD::MapKey* key);
+
+	private:
+		struct Shard
+		{
+			std::mutex mMutex;
+			// viewing the string of the MapKey it maps to
+			std::unordered_map<std::string_view, LLSD::MapKey*> mKeys;
+		};
+
+		Shard& shardFor(std::string_view k)
+		{
+			return mShards[std::hash<std::string_view>()(k) % SHARD_COUNT];
+		}
+
+		static const size_t SHARD_COUNT = 16;
+		Shard mShards[SHARD_COUNT];
+	};
+
+	MapKeyTable& MapKeyTable::instance()
+	{
+		// Never destroyed: static LLSD maps release their keys after any
+		// static table would be gone
+		static MapKeyTable* sTable = new MapKeyTable;
+		return *sTable;
+	}
+
+	LLSD::MapKey* MapKeyTable::add(const LLSD::String& k)
+	{
+		Shard& shard = shardFor(k);
+		std::lock_guard<std::mutex> lock(shard.mMutex);
+		auto found = shard.mKeys.find(std::string_view(k));
+		if (found != shard.mKeys.end())
+		{
+			addRef(found->second);
+			return found->second;
+		}
+		LLSD::MapKey* key = new LLSD::MapKey(k);
+		shard.mKeys.emplace(std::string_view(key->mString), key);
+		return key;
+	}
+
+	void MapKeyTable::release(LLSD::MapKey* key)
+	{
+		// Only dropping the last reference needs the lock
+		U32 count = key->mCount.load(std::memory_order_relaxed);
+		while (count > 1)
+		{
+			if (key->mCount.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel))
+			{
+				return;
+			}
+		}
+
+		Shard& shard = shardFor(key->mString);
+		{
+			std::lock_guard<std::mutex> lock(shard.mMutex);
+			if (key->mCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			{
+				// add() found it again meanwhile
+				return;
+			}
+			shard.mKeys.erase(std::string_view(key->mString));
+		}
+		delete key;
+	}
+
+
 	class ImplMap : public LLSD::Impl
 	{
 	private:
-		typedef std::map<LLSD::String, LLSD>	DataMap;
+		// Sorted by key, so maps iterate in key order.  Each entry has its
+		// own allocation, which keeps LLSD& references to a value valid
+		// while other keys come and go.
+		typedef std::vector<LLSD::MapSlot>	DataVector;
 		
-		DataMap mData;
+		DataVector mData;
+
+		DataVector::iterator lowerBound(const LLSD::String& k);
+		DataVector::const_iterator find(const LLSD::String& k) const;
+		DataVector::iterator insertEntry(DataVector::iterator pos, const LLSD::String& k, const LLSD& v);
 		
 	protected:
-		ImplMap(const DataMap& data) : mData(data) { }
+		ImplMap(const DataVector& data);
 		
 	public:
 		ImplMap() { }
+		~ImplMap();
 		
 		virtual ImplMap& makeMap(LLSD::Impl*&);
 
@@ -401,14 +501,36 @@ namespace
 
 		virtual size_t size() const { return mData.size(); }
 
-		LLSD::map_iterator beginMap() { return mData.begin(); }
-		LLSD::map_iterator endMap() { return mData.end(); }
-		virtual LLSD::map_const_iterator beginMap() const { return mData.begin(); }
-		virtual LLSD::map_const_iterator endMap() const { return mData.end(); }
+		LLSD::map_iterator beginMap() { return LLSD::map_iterator(mData.data()); }
+		LLSD::map_iterator endMap() { return LLSD::map_iterator(mData.data() + mData.size()); }
+		virtual LLSD::map_const_iterator beginMap() const { return LLSD::map_const_iterator(mData.data()); }
+		virtual LLSD::map_const_iterator endMap() const { return LLSD::map_const_iterator(mData.data() + mData.size()); }
 
 		virtual void dumpStats() const;
 		virtual void calcStats(S32 type_counts[], S32 share_counts[]) const;
 	};
+
+	ImplMap::ImplMap(const DataVector& data)
+	{
+		// The copy shares the keys but not the entries
+		mData.reserve(data.size());
+		for (const LLSD::MapSlot& slot : data)
+		{
+			MapKeyTable::addRef(slot.mKey);
+			LLSD::MapSlot copy = { slot.mKey, new LLSD::map_entry(slot.mKey->mString, slot.mEntry->second) };
+			mData.push_back(copy);
+		}
+	}
+
+	ImplMap::~ImplMap()
+	{
+		MapKeyTable& keys = MapKeyTable::instance();
+		for (const LLSD::MapSlot& slot : mData)
+		{
+			delete slot.mEntry;
+			keys.release(slot.mKey);
+		}
+	}
 	
 	ImplMap& ImplMap::makeMap(LLSD::Impl*& var)
 	{
@@ -424,30 +546,56 @@ namespace
 			return *this;
 		}
 	}
+
+	static bool slot_key_less(const LLSD::MapSlot& slot, const LLSD::String& k)
+	{
+		return slot.mKey->mString < k;
+	}
+
+	ImplMap::DataVector::iterator ImplMap::lowerBound(const LLSD::String& k)
+	{
+		// Parsers and most code fill maps in key order: append those
+		// without a search
+		if (mData.empty() || slot_key_less(mData.back(), k))
+		{
+			return mData.end();
+		}
+		return std::lower_bound(mData.begin(), mData.end(), k, slot_key_less);
+	}
+
+	ImplMap::DataVector::const_iterator ImplMap::find(const LLSD::String& k) const
+	{
+		DataVector::const_iterator i = std::lower_bound(mData.begin(), mData.end(), k, slot_key_less);
+		return (i != mData.end() && i->mKey->mString == k) ? i : mData.end();
+	}
+
+	ImplMap::DataVector::iterator ImplMap::insertEntry(DataVector::iterator pos, const LLSD::String& k, const LLSD& v)
+	{
+		LLSD::MapKey* key = MapKeyTable::instance().add(k);
+		LLSD::MapSlot slot = { key, new LLSD::map_entry(key->mString, v) };
+		return mData.insert(pos, slot);
+	}
 	
 	bool ImplMap::has(const LLSD::String& k) const
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-		DataMap::const_iterator i = mData.find(k);
-		return i != mData.end();
+		return find(k) != mData.end();
 	}
 	
 	LLSD ImplMap::get(const LLSD::String& k) const
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-		DataMap::const_iterator i = mData.find(k);
-		return (i != mData.end()) ? i->second : LLSD();
+		DataVector::const_iterator i = find(k);
+		return (i != mData.end()) ? i->mEntry->second : LLSD();
 	}
 
 	LLSD ImplMap::getKeys() const
 	{ 
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
 		LLSD keys = LLSD::emptyArray();
-		DataMap::const_iterator iter = mData.begin();
-		while (iter != mData.end())
+		for (const LLSD::MapSlot& slot : mData)
 		{
-			keys.append((*iter).first);
-			iter++;
+			keys.append(slot.mKey->mString);
 		}
 		return keys;
 	}
@@ -455,29 +603,46 @@ namespace
 	void ImplMap::insert(const LLSD::String& k, const LLSD& v)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-		mData.insert(DataMap::value_type(k, v));
+		// Like std::map::insert(), an existing key keeps its value
+		DataVector::iterator i = lowerBound(k);
+		if (i == mData.end() || i->mKey->mString != k)
+		{
+			insertEntry(i, k, v);
+		}
 	}
 	
 	void ImplMap::erase(const LLSD::String& k)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-		mData.erase(k);
+		DataVector::iterator i = lowerBound(k);
+		if (i != mData.end() && i->mKey->mString == k)
+		{
+			LLSD::MapSlot slot = *i;
+			mData.erase(i);
+			delete slot.mEntry;
+			MapKeyTable::instance().release(slot.mKey);
+		}
 	}
 	
 	LLSD& ImplMap::ref(const LLSD::String& k)
 	{
-		return mData[k];
+		DataVector::iterator i = lowerBound(k);
+		if (i == mData.end() || i->mKey->mString != k)
+		{
+			i = insertEntry(i, k, LLSD());
+		}
+		return i->mEntry->second;
 	}
 	
 	const LLSD& ImplMap::ref(const LLSD::String& k) const
 	{
-		DataMap::const_iterator i = mData.lower_bound(k);
-		if (i == mData.end()  ||  mData.key_comp()(k, i->first))
+		DataVector::const_iterator i = find(k);
+		if (i == mData.end())
 		{
 			return undef();
 		}
 		
-		return i->second;
+		return i->mEntry->second;
 	}
 
 	void ImplMap::dumpStats() const
@@ -833,6 +998,7 @@ LLSD::LLSD() : impl(0)					{ ALLOC_LLSD_OBJECT; }
 LLSD::~LLSD()							{ FREE_LLSD_OBJECT; Impl::reset(impl, 0); }
 
 LLSD::LLSD(const LLSD& other) : impl(0) { ALLOC_LLSD_OBJECT;  assign(other); }
+LLSD::LLSD(LLSD&& other) noexcept : impl(other.impl) { ALLOC_LLSD_OBJECT; other.impl = 0; }
 void LLSD::assign(const LLSD& other)	{ Impl::assign(impl, other.impl); }
 
 
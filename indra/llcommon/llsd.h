@@ -27,8 +27,12 @@
 #ifndef LL_LLSD_NEW_H
 #define LL_LLSD_NEW_H
 
+#include <cstddef>
+#include <iterator>
 #include <map>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "stdtypes.h"
@@ -159,6 +163,12 @@ public:
 		void assign(const LLSD& other);
 		LLSD& operator=(const LLSD& other)	{ assign(other); return *this; }
 
+		// Moving hands the value over without touching its use count;
+		// the source is left Undefined.
+		LLSD(LLSD&& other) noexcept;
+		LLSD& operator=(LLSD&& other) noexcept
+			{ LLSD taken(std::move(other)); std::swap(impl, taken.impl); return *this; }
+
 	//@}
 
 	void clear();	///< resets to Undefined
@@ -342,8 +352,75 @@ public:
 	//@{
 		size_t size() const;
 
-		typedef std::map<String, LLSD>::iterator		map_iterator;
-		typedef std::map<String, LLSD>::const_iterator	map_const_iterator;
+		/// What map iterators dereference to: first is the key, second the
+		/// value.  Keys are interned, every map holding a key shares one
+		/// copy of its string.
+		typedef std::pair<const String&, LLSD>	map_entry;
+
+		struct MapKey;						///< an interned key, see llsd.cpp
+		struct MapSlot						///< one key of a map, see ImplMap
+		{
+			MapKey*		mKey;
+			map_entry*	mEntry;
+		};
+
+		/// Walks a map in key order.  Map values stay where they are while
+		/// other keys are inserted or erased, but like vector iterators
+		/// these are invalidated by either.
+		template<class Entry>
+		class MapIterator
+		{
+		public:
+			typedef std::random_access_iterator_tag			iterator_category;
+			typedef typename std::remove_const<Entry>::type	value_type;
+			typedef std::ptrdiff_t							difference_type;
+			typedef Entry*									pointer;
+			typedef Entry&									reference;
+
+			MapIterator() : mSlot(NULL) { }
+			explicit MapIterator(const MapSlot* slot) : mSlot(slot) { }
+			// a map_iterator converts to a map_const_iterator
+			template<class Other,
+					 typename std::enable_if<std::is_convertible<Other*, Entry*>::value,
+											 bool>::type = true>
+			MapIterator(const MapIterator<Other>& other) : mSlot(other.mSlot) { }
+
+			reference operator*() const						{ return *mSlot->mEntry; }
+			pointer operator->() const						{ return mSlot->mEntry; }
+			reference operator[](difference_type n) const	{ return *mSlot[n].mEntry; }
+
+			MapIterator& operator++()						{ ++mSlot; return *this; }
+			MapIterator& operator--()						{ --mSlot; return *this; }
+			MapIterator operator++(int)						{ MapIterator i(*this); ++mSlot; return i; }
+			MapIterator operator--(int)						{ MapIterator i(*this); --mSlot; return i; }
+			MapIterator& operator+=(difference_type n)		{ mSlot += n; return *this; }
+			MapIterator& operator-=(difference_type n)		{ mSlot -= n; return *this; }
+			MapIterator operator+(difference_type n) const	{ return MapIterator(mSlot + n); }
+			MapIterator operator-(difference_type n) const	{ return MapIterator(mSlot - n); }
+
+			template<class Other>
+			difference_type operator-(const MapIterator<Other>& other) const	{ return mSlot - other.mSlot; }
+			template<class Other>
+			bool operator==(const MapIterator<Other>& other) const	{ return mSlot == other.mSlot; }
+			template<class Other>
+			bool operator!=(const MapIterator<Other>& other) const	{ return mSlot != other.mSlot; }
+			template<class Other>
+			bool operator<(const MapIterator<Other>& other) const	{ return mSlot < other.mSlot; }
+			template<class Other>
+			bool operator>(const MapIterator<Other>& other) const	{ return mSlot > other.mSlot; }
+			template<class Other>
+			bool operator<=(const MapIterator<Other>& other) const	{ return mSlot <= other.mSlot; }
+			template<class Other>
+			bool operator>=(const MapIterator<Other>& other) const	{ return mSlot >= other.mSlot; }
+
+		private:
+			template<class> friend class MapIterator;
+
+			const MapSlot* mSlot;
+		};
+
+		typedef MapIterator<map_entry>			map_iterator;
+		typedef MapIterator<const map_entry>	map_const_iterator;
 		
 		map_iterator		beginMap();
 		map_iterator		endMap();
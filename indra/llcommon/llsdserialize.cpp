@@ -82,6 +82,240 @@ S32 parse_using(std::istream& istr, LLSD& data, size_t max_bytes, S32 max_depth=
     return p->parse(istr, data, max_bytes, max_depth);
 }
 
+namespace
+{
+	/**
+	 * Read cursor over an LLSDSpanList. Reads that fall within one span
+	 * are served straight out of it; only reads straddling the end of a
+	 * span are gathered piecewise.
+	 */
+	class LLSDSpanReader
+	{
+	public:
+		LLSDSpanReader(const LLSDSpanList& spans)
+		:	mSpans(spans),
+			mSpan(0),
+			mPos(0),
+			mLeft(0)
+		{
+			for (const LLSDSpan& span : spans)
+			{
+				mLeft += span.second;
+			}
+			skipEmpty();
+		}
+
+		size_t left() const { return mLeft; }
+
+		bool peek(char& c) const
+		{
+			if (!mLeft) return false;
+			c = mSpans[mSpan].first[mPos];
+			return true;
+		}
+
+		bool get(char& c)
+		{
+			if (!peek(c)) return false;
+			advance(1);
+			return true;
+		}
+
+		/**
+		 * Calls func(const char* data, size_t len) for each contiguous
+		 * piece of the next n bytes. Returns false, without consuming
+		 * anything, if fewer than n bytes are left.
+		 */
+		template <typename FUNC>
+		bool consume(size_t n, FUNC func)
+		{
+			if (n > mLeft) return false;
+			while (n)
+			{
+				const LLSDSpan& span = mSpans[mSpan];
+				size_t len = llmin(n, span.second - mPos);
+				func(span.first + mPos, len);
+				advance(len);
+				n -= len;
+			}
+			return true;
+		}
+
+		bool read(void* dest, size_t n)
+		{
+			char* out = (char*)dest;
+			return consume(n, [&out](const char* data, size_t len)
+						   {
+							   memcpy(out, data, len);	/* Flawfinder: ignore */
+							   out += len;
+						   });
+		}
+
+		bool skip(size_t n)
+		{
+			return consume(n, [](const char*, size_t) {});
+		}
+
+		/**
+		 * The spans covering the bytes not read yet.
+		 */
+		void remaining(LLSDSpanList& spans) const
+		{
+			spans.clear();
+			if (!mLeft) return;
+			spans.emplace_back(mSpans[mSpan].first + mPos, mSpans[mSpan].second - mPos);
+			spans.insert(spans.end(), mSpans.begin() + mSpan + 1, mSpans.end());
+		}
+
+	private:
+		void advance(size_t n)
+		{
+			mPos += n;
+			mLeft -= n;
+			if (mPos == mSpans[mSpan].second)
+			{
+				++mSpan;
+				mPos = 0;
+				skipEmpty();
+			}
+		}
+
+		void skipEmpty()
+		{
+			while (mSpan < mSpans.size() && !mSpans[mSpan].second)
+			{
+				++mSpan;
+			}
+		}
+
+		const LLSDSpanList& mSpans;
+		size_t mSpan;
+		size_t mPos;
+		size_t mLeft;
+	};
+
+	/**
+	 * Read-only streambuf over an LLSDSpanList, for the few places where
+	 * an existing istream based helper has to run over spans. It does
+	 * not support putback across span boundaries.
+	 */
+	class LLSDSpanStreamBuf : public std::streambuf
+	{
+	public:
+		LLSDSpanStreamBuf(const LLSDSpanList& spans)
+		:	mSpans(spans),
+			mNext(0)
+		{
+		}
+
+	protected:
+		int_type underflow() override
+		{
+			while (mNext < mSpans.size())
+			{
+				const LLSDSpan& span = mSpans[mNext++];
+				if (span.second)
+				{
+					char* begin = const_cast<char*>(span.first);
+					setg(begin, begin, begin + span.second);
+					return traits_type::to_int_type(*gptr());
+				}
+			}
+			return traits_type::eof();
+		}
+
+	private:
+		const LLSDSpanList& mSpans;
+		size_t mNext;
+	};
+
+	/**
+	 * Same header sniffing as LLSDSerialize::deserialize(std::istream&),
+	 * peeking into the spans. Returns the format of the document, or -1
+	 * if there is nothing to read, and sets body to the spans to hand to
+	 * the parser for that format.
+	 */
+	S32 sniff_spans(const LLSDSpanList& spans, LLSDSpanList& body)
+	{
+		LLSDSpanReader reader(spans);
+		std::string header;
+		char c;
+		while (header.size() < MAX_HDR_LEN && reader.get(c))
+		{
+			header += c;
+			if (c == '\n')
+			{
+				break;
+			}
+		}
+		if (header.empty())
+		{
+			return -1;
+		}
+
+		body = spans;
+		if (!strncasecmp(LEGACY_NON_HEADER, header.c_str(), strlen(LEGACY_NON_HEADER))) /* Flawfinder: ignore */
+		{
+			// The legacy "header" is the start of the document itself
+			return LLSDSerialize::LLSD_XML;
+		}
+		const char first = header[0];
+
+		std::string::size_type lastchar = header.find_last_not_of("\r\n");
+		if (lastchar != std::string::npos)
+		{
+			header.erase(lastchar+1);
+		}
+
+		LLSDSpanList rest;
+		auto start = header.find_first_not_of("<? ");
+		if (start != std::string::npos)
+		{
+			auto end = header.find_first_of(" ?", start);
+			if (end != std::string::npos)
+			{
+				header = header.substr(start, end - start);
+				while (reader.peek(c) && isspace((unsigned char)c))
+				{
+					reader.skip(1);
+				}
+				reader.remaining(rest);
+			}
+		}
+
+		if (0 == LLStringUtil::compareInsensitive(header, LLSD_BINARY_HEADER))
+		{
+			body.swap(rest);
+			return LLSDSerialize::LLSD_BINARY;
+		}
+		else if (0 == LLStringUtil::compareInsensitive(header, LLSD_XML_HEADER))
+		{
+			body.swap(rest);
+			return LLSDSerialize::LLSD_XML;
+		}
+		else if (0 == LLStringUtil::compareInsensitive(header, LLSD_NOTATION_HEADER))
+		{
+			body.swap(rest);
+			return LLSDSerialize::LLSD_NOTATION;
+		}
+		else if (first == '<')
+		{
+			LL_DEBUGS() << "deserialize request with no header, assuming XML" << LL_ENDL;
+			return LLSDSerialize::LLSD_XML;
+		}
+		return LLSDSerialize::LLSD_NOTATION;
+	}
+
+	void gather_spans(const LLSDSpanList& spans, std::string& text)
+	{
+		text.clear();
+		for (const LLSDSpan& span : spans)
+		{
+			text.append(span.first, span.second);
+		}
+	}
+}
+
 /**
  * LLSDSerialize
  */
@@ -253,6 +487,35 @@ bool LLSDSerialize::deserialize(LLSD& sd, std::istream& str, llssize max_bytes)
 	}
 }
 
+// static
+bool LLSDSerialize::deserialize(LLSD& sd, const LLSDSpanList& spans)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+
+	LLSDSpanList body;
+	switch (sniff_spans(spans, body))
+	{
+	case LLSD_BINARY:
+		return (fromBinary(sd, body) > 0);
+
+	case LLSD_XML:
+		return (fromXML(sd, body) > 0);
+
+	case LLSD_NOTATION:
+	{
+		// Notation relies on putback(), so gather it into one buffer
+		std::string text;
+		gather_spans(body, text);
+		LLMemoryStream istr(reinterpret_cast<const U8*>(text.data()), (S32)text.size());
+		return (parse_using<LLSDNotationParser>(istr, sd, text.size()) > 0);
+	}
+
+	default:
+		LL_WARNS() << "deserialize LLSD parse failure" << LL_ENDL;
+		return false;
+	}
+}
+
 /**
  * Endian handlers
  */
@@ -1295,6 +1558,710 @@ bool LLSDBinaryParser::parseString(
 	return true;
 }
 
+namespace
+{
+	// Span counterparts of the LLSDBinaryParser methods above. They need
+	// no byte accounting: every size is checked against what is left.
+	S32 parse_binary_spans(LLSDSpanReader& reader, LLSD& data, S32 max_depth);
+
+	bool read_binary_size(LLSDSpanReader& reader, S32& size)
+	{
+		U32 size_nbo = 0;
+		if (!reader.read(&size_nbo, sizeof(U32)))
+		{
+			return false;
+		}
+		size = (S32)ntohl(size_nbo);
+		// Every element of a map or array takes at least one byte, too
+		return (size >= 0) && ((size_t)size <= reader.left());
+	}
+
+	bool read_binary_string(LLSDSpanReader& reader, std::string& value)
+	{
+		S32 size = 0;
+		if (!read_binary_size(reader, size))
+		{
+			return false;
+		}
+		value.clear();
+		value.reserve(size);
+		return reader.consume(size, [&value](const char* data, size_t len)
+							  {
+								  value.append(data, len);
+							  });
+	}
+
+	bool read_delim_string(LLSDSpanReader& reader, std::string& value, char delim)
+	{
+		LLSDSpanList rest;
+		reader.remaining(rest);
+		LLSDSpanStreamBuf buf(rest);
+		std::istream istr(&buf);
+		llssize cnt = deserialize_string_delim(istr, value, delim);
+		return (LLSDParser::PARSE_FAILURE != cnt) && reader.skip(cnt);
+	}
+
+	S32 parse_binary_map(LLSDSpanReader& reader, LLSD& map, S32 max_depth)
+	{
+		map = LLSD::emptyMap();
+		S32 size = 0;
+		if (!read_binary_size(reader, size))
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		S32 parse_count = 0;
+		S32 count = 0;
+		char c = 0;
+		bool good = reader.get(c);
+		while (good && (c != '}') && (count < size))
+		{
+			std::string name;
+			switch(c)
+			{
+			case 'k':
+				if (!read_binary_string(reader, name))
+				{
+					return LLSDParser::PARSE_FAILURE;
+				}
+				break;
+			case '\'':
+			case '"':
+				if (!read_delim_string(reader, name, c))
+				{
+					return LLSDParser::PARSE_FAILURE;
+				}
+				break;
+			}
+			LLSD child;
+			S32 child_count = parse_binary_spans(reader, child, max_depth);
+			if (child_count <= 0)
+			{
+				// There must be a value for every key
+				return LLSDParser::PARSE_FAILURE;
+			}
+			parse_count += child_count;
+			map.insert(name, child);
+			++count;
+			good = reader.get(c);
+		}
+		if (!good || (c != '}') || (count < size))
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		return parse_count;
+	}
+
+	S32 parse_binary_array(LLSDSpanReader& reader, LLSD& array, S32 max_depth)
+	{
+		array = LLSD::emptyArray();
+		S32 size = 0;
+		if (!read_binary_size(reader, size))
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		S32 parse_count = 0;
+		S32 count = 0;
+		char c = 0;
+		while (reader.peek(c) && (c != ']') && (count < size))
+		{
+			LLSD child;
+			S32 child_count = parse_binary_spans(reader, child, max_depth);
+			if (LLSDParser::PARSE_FAILURE == child_count)
+			{
+				return LLSDParser::PARSE_FAILURE;
+			}
+			if (child_count)
+			{
+				parse_count += child_count;
+				array.append(child);
+			}
+			++count;
+		}
+		if (!reader.get(c) || (c != ']') || (count < size))
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		return parse_count;
+	}
+
+	/**
+	 * Reads the value of the scalar whose type marker c has just been
+	 * read, logging why when that fails.
+	 */
+	bool read_binary_scalar(LLSDSpanReader& reader, char c, LLSD& data)
+	{
+		bool ok = true;
+		switch(c)
+		{
+		case '!':
+			data.clear();
+			break;
+
+		case '0':
+			data = false;
+			break;
+
+		case '1':
+			data = true;
+			break;
+
+		case 'i':
+		{
+			U32 value_nbo = 0;
+			ok = reader.read(&value_nbo, sizeof(U32));
+			data = (S32)ntohl(value_nbo);
+			break;
+		}
+
+		case 'r':
+		{
+			F64 real_nbo = 0.0;
+			ok = reader.read(&real_nbo, sizeof(F64));
+			data = ll_ntohd(real_nbo);
+			break;
+		}
+
+		case 'u':
+		{
+			LLUUID id;
+			ok = reader.read(id.mData, UUID_BYTES);
+			data = id;
+			break;
+		}
+
+		case '\'':
+		case '"':
+		{
+			std::string value;
+			ok = read_delim_string(reader, value, c);
+			data = value;
+			break;
+		}
+
+		case 's':
+		{
+			std::string value;
+			ok = read_binary_string(reader, value);
+			data = value;
+			break;
+		}
+
+		case 'l':
+		{
+			std::string value;
+			ok = read_binary_string(reader, value);
+			data = LLURI(value);
+			break;
+		}
+
+		case 'd':
+		{
+			F64 real = 0.0;
+			ok = reader.read(&real, sizeof(F64));
+			data = LLDate(real);
+			break;
+		}
+
+		case 'b':
+		{
+			S32 size = 0;
+			ok = read_binary_size(reader, size);
+			if (ok)
+			{
+				std::vector<U8> value(size);
+				ok = reader.read(value.data(), size);
+				data = value;
+			}
+			break;
+		}
+
+		default:
+			LL_INFOS() << "Unrecognized character while parsing: int(" << int(c)
+				<< ")" << LL_ENDL;
+			data.clear();
+			return false;
+		}
+		if (!ok)
+		{
+			LL_INFOS() << "Truncated binary LLSD value of type '" << c << "'" << LL_ENDL;
+			data.clear();
+		}
+		return ok;
+	}
+
+	S32 parse_binary_spans(LLSDSpanReader& reader, LLSD& data, S32 max_depth)
+	{
+		char c = 0;
+		if (!reader.get(c))
+		{
+			return 0;
+		}
+		if (max_depth == 0)
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		S32 parse_count = 1;
+		if ((c == '{') || (c == '['))
+		{
+			S32 child_count = (c == '{') ? parse_binary_map(reader, data, max_depth - 1)
+										 : parse_binary_array(reader, data, max_depth - 1);
+			if (LLSDParser::PARSE_FAILURE == child_count)
+			{
+				data.clear();
+				return LLSDParser::PARSE_FAILURE;
+			}
+			parse_count += child_count;
+		}
+		else if (!read_binary_scalar(reader, c, data))
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		return parse_count;
+	}
+
+	/**
+	 * Reads a map key, 'k' prefixed or delimited.
+	 */
+	bool read_binary_key(LLSDSpanReader& reader, std::string& name)
+	{
+		char c = 0;
+		if (!reader.get(c))
+		{
+			return false;
+		}
+		switch(c)
+		{
+		case 'k':
+			return read_binary_string(reader, name);
+		case '\'':
+		case '"':
+			return read_delim_string(reader, name, c);
+		default:
+			LL_INFOS() << "Unrecognized map key marker: int(" << int(c) << ")" << LL_ENDL;
+			return false;
+		}
+	}
+
+	/**
+	 * Reads past one value without decoding it.
+	 */
+	bool skip_binary_value(LLSDSpanReader& reader, S32 max_depth)
+	{
+		char c = 0;
+		if (!reader.get(c) || (max_depth == 0))
+		{
+			return false;
+		}
+		S32 size = 0;
+		switch(c)
+		{
+		case '{':
+		{
+			if (!read_binary_size(reader, size))
+			{
+				return false;
+			}
+			std::string name;
+			for (S32 count = 0; count < size; ++count)
+			{
+				if (!read_binary_key(reader, name) || !skip_binary_value(reader, max_depth - 1))
+				{
+					return false;
+				}
+			}
+			return reader.get(c) && (c == '}');
+		}
+
+		case '[':
+			if (!read_binary_size(reader, size))
+			{
+				return false;
+			}
+			for (S32 count = 0; count < size; ++count)
+			{
+				if (!skip_binary_value(reader, max_depth - 1))
+				{
+					return false;
+				}
+			}
+			return reader.get(c) && (c == ']');
+
+		case '!':
+		case '0':
+		case '1':
+			return true;
+
+		case 'i':
+			return reader.skip(sizeof(U32));
+
+		case 'r':
+		case 'd':
+			return reader.skip(sizeof(F64));
+
+		case 'u':
+			return reader.skip(UUID_BYTES);
+
+		case 's':
+		case 'l':
+		case 'b':
+			return read_binary_size(reader, size) && reader.skip(size);
+
+		default:
+		{
+			// Delimited strings have to be unescaped to find their end
+			LLSD value;
+			return read_binary_scalar(reader, c, value);
+		}
+		}
+	}
+
+	/**
+	 * Event driven counterpart of parse_binary_spans(). Unlike the tree
+	 * parser, a map or an array must hold exactly the number of elements
+	 * announced in its header.
+	 */
+	bool read_binary_events(LLSDSpanReader& reader, LLSDReader::Handler& handler, S32 max_depth)
+	{
+		char c = 0;
+		if (!reader.get(c) || (max_depth == 0))
+		{
+			return false;
+		}
+		S32 size = 0;
+		switch(c)
+		{
+		case '{':
+		{
+			if (!read_binary_size(reader, size) || !handler.startMap())
+			{
+				return false;
+			}
+			std::string name;
+			for (S32 count = 0; count < size; ++count)
+			{
+				if (!read_binary_key(reader, name))
+				{
+					return false;
+				}
+				switch (handler.key(name))
+				{
+				case LLSDReader::Handler::READ_VALUE:
+					if (!read_binary_events(reader, handler, max_depth - 1))
+					{
+						return false;
+					}
+					break;
+				case LLSDReader::Handler::SKIP_VALUE:
+					if (!skip_binary_value(reader, max_depth - 1))
+					{
+						return false;
+					}
+					break;
+				default:
+					return false;
+				}
+			}
+			return reader.get(c) && (c == '}') && handler.endMap();
+		}
+
+		case '[':
+			if (!read_binary_size(reader, size) || !handler.startArray())
+			{
+				return false;
+			}
+			for (S32 count = 0; count < size; ++count)
+			{
+				if (!read_binary_events(reader, handler, max_depth - 1))
+				{
+					return false;
+				}
+			}
+			return reader.get(c) && (c == ']') && handler.endArray();
+
+		default:
+		{
+			LLSD value;
+			return read_binary_scalar(reader, c, value) && handler.value(value);
+		}
+		}
+	}
+
+	/**
+	 * Handler reading past everything, for skipping notation values.
+	 */
+	class LLSDSkipHandler : public LLSDReader::Handler
+	{
+	public:
+		bool startMap() override { return true; }
+		EAction key(const std::string&) override { return SKIP_VALUE; }
+		bool endMap() override { return true; }
+		bool startArray() override { return true; }
+		bool endArray() override { return true; }
+		bool value(const LLSD&) override { return true; }
+	};
+
+	/**
+	 * Event driven counterpart of LLSDNotationParser::doParse(). Maps and
+	 * arrays are walked here, with the same leniency about separators as
+	 * LLSDNotationParser::parseMap() and parseArray(); any other value is
+	 * read by the parser.
+	 */
+	bool read_notation_events(std::istream& istr, LLSDNotationParser& parser,
+							  LLSDReader::Handler& handler, S32 max_depth)
+	{
+		char c = istr.peek();
+		while (isspace(c))
+		{
+			istr.get();
+			c = istr.peek();
+		}
+		if (!istr.good() || (max_depth == 0))
+		{
+			return false;
+		}
+		switch(c)
+		{
+		case '{':
+		{
+			istr.get();
+			if (!handler.startMap())
+			{
+				return false;
+			}
+			bool found_name = false;
+			std::string name;
+			c = istr.get();
+			while ((c != '}') && istr.good())
+			{
+				if (!found_name)
+				{
+					if ((c == '\"') || (c == '\'') || (c == 's'))
+					{
+						istr.putback(c);
+						found_name = true;
+						if (LLSDParser::PARSE_FAILURE ==
+							deserialize_string(istr, name, LLSDSerialize::SIZE_UNLIMITED))
+						{
+							return false;
+						}
+					}
+					c = istr.get();
+					continue;
+				}
+				if (isspace(c) || (c == ':'))
+				{
+					c = istr.get();
+					continue;
+				}
+				istr.putback(c);
+				switch (handler.key(name))
+				{
+				case LLSDReader::Handler::READ_VALUE:
+					if (!read_notation_events(istr, parser, handler, max_depth - 1))
+					{
+						return false;
+					}
+					break;
+				case LLSDReader::Handler::SKIP_VALUE:
+				{
+					LLSDSkipHandler skipper;
+					if (!read_notation_events(istr, parser, skipper, max_depth - 1))
+					{
+						return false;
+					}
+					break;
+				}
+				default:
+					return false;
+				}
+				found_name = false;
+				c = istr.get();
+			}
+			return (c == '}') && handler.endMap();
+		}
+
+		case '[':
+		{
+			istr.get();
+			if (!handler.startArray())
+			{
+				return false;
+			}
+			c = istr.get();
+			while ((c != ']') && istr.good())
+			{
+				if (isspace(c) || (c == ','))
+				{
+					c = istr.get();
+					continue;
+				}
+				istr.putback(c);
+				if (!read_notation_events(istr, parser, handler, max_depth - 1))
+				{
+					return false;
+				}
+				c = istr.get();
+			}
+			return (c == ']') && handler.endArray();
+		}
+
+		default:
+		{
+			LLSD value;
+			return (parser.parse(istr, value, LLSDSerialize::SIZE_UNLIMITED, 1) > 0)
+				&& handler.value(value);
+		}
+		}
+	}
+}
+
+S32 LLSDBinaryParser::parse(const LLSDSpanList& spans, LLSD& data, S32 max_depth)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+
+	LLSDSpanReader reader(spans);
+	return parse_binary_spans(reader, data, max_depth);
+}
+
+
+/**
+ * LLSDReader
+ */
+LLSDReader::Builder::Builder()
+	: mComplete(false)
+{
+}
+
+void LLSDReader::Builder::reset()
+{
+	mResult.clear();
+	mStack.clear();
+	mKey.clear();
+	mComplete = false;
+}
+
+LLSD& LLSDReader::Builder::place(const LLSD& value)
+{
+	if (mStack.empty())
+	{
+		mResult = value;
+		return mResult;
+	}
+	LLSD& parent = *mStack.back();
+	if (parent.isMap())
+	{
+		LLSD& child = parent[mKey];
+		child = value;
+		return child;
+	}
+	return parent.append(value);
+}
+
+bool LLSDReader::Builder::endContainer()
+{
+	if (mStack.empty())
+	{
+		return false;
+	}
+	mStack.pop_back();
+	mComplete = mStack.empty();
+	return true;
+}
+
+bool LLSDReader::Builder::startMap()
+{
+	if (mComplete)
+	{
+		return false;
+	}
+	// Values nested in a map or an array never move while they are
+	// being filled, so pointers to them stay valid.
+	mStack.push_back(&place(LLSD::emptyMap()));
+	return true;
+}
+
+LLSDReader::Handler::EAction LLSDReader::Builder::key(const std::string& key)
+{
+	mKey = key;
+	return READ_VALUE;
+}
+
+bool LLSDReader::Builder::endMap()
+{
+	return endContainer();
+}
+
+bool LLSDReader::Builder::startArray()
+{
+	if (mComplete)
+	{
+		return false;
+	}
+	mStack.push_back(&place(LLSD::emptyArray()));
+	return true;
+}
+
+bool LLSDReader::Builder::endArray()
+{
+	return endContainer();
+}
+
+bool LLSDReader::Builder::value(const LLSD& value)
+{
+	if (mComplete)
+	{
+		return false;
+	}
+	place(value);
+	mComplete = mStack.empty();
+	return true;
+}
+
+// static
+bool LLSDReader::parseBinary(const LLSDSpanList& spans, Handler& handler, S32 max_depth)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+
+	LLSDSpanReader reader(spans);
+	return read_binary_events(reader, handler, max_depth);
+}
+
+// static
+bool LLSDReader::parseNotation(std::istream& istr, Handler& handler, S32 max_depth)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+
+	LLPointer<LLSDNotationParser> parser(new LLSDNotationParser);
+	return read_notation_events(istr, *parser, handler, max_depth);
+}
+
+// static
+bool LLSDReader::parse(const LLSDSpanList& spans, Handler& handler)
+{
+	LLSDSpanList body;
+	switch (sniff_spans(spans, body))
+	{
+	case LLSDSerialize::LLSD_BINARY:
+		return parseBinary(body, handler);
+
+	case LLSDSerialize::LLSD_XML:
+		return parseXML(body, handler);
+
+	case LLSDSerialize::LLSD_NOTATION:
+	{
+		// Notation relies on putback(), so gather it into one buffer
+		std::string text;
+		gather_spans(body, text);
+		LLMemoryStream istr(reinterpret_cast<const U8*>(text.data()), (S32)text.size());
+		return parseNotation(istr, handler);
+	}
+
+	default:
+		LL_WARNS() << "LLSDReader parse failure" << LL_ENDL;
+		return false;
+	}
+}
+
 
 /**
  * LLSDFormatter
@@ -2355,6 +3322,157 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
 		free(result);
 	return ZR_OK;
 }
+constexpr size_t UZIP_READER_CHUNK = 64 * 1024;
+
+LLUZipReader::LLUZipReader(const U8* in, S32 size)
+:	mStream(new(std::nothrow) z_stream),
+	mBuffer(new(std::nothrow) U8[UZIP_READER_CHUNK]),
+	mNext(NULL),
+	mAvailable(0),
+	mEnded(false),
+	mResult(LLUZipHelper::ZR_OK)
+{
+	if (!mStream || !mBuffer)
+	{
+		mResult = LLUZipHelper::ZR_MEM_ERROR;
+		return;
+	}
+	mStream->zalloc = Z_NULL;
+	mStream->zfree = Z_NULL;
+	mStream->opaque = Z_NULL;
+	mStream->avail_in = size;
+	mStream->next_in = const_cast<U8*>(in);
+	if (inflateInit(mStream) != Z_OK)
+	{
+		mResult = LLUZipHelper::ZR_MEM_ERROR;
+		delete mStream;
+		mStream = NULL;
+	}
+}
+
+LLUZipReader::~LLUZipReader()
+{
+	if (mStream)
+	{
+		inflateEnd(mStream);
+		delete mStream;
+	}
+}
+
+bool LLUZipReader::inflateTo(U8* out, size_t size, size_t& produced)
+{
+	produced = 0;
+	if (mResult != LLUZipHelper::ZR_OK || mEnded)
+	{
+		if (mResult == LLUZipHelper::ZR_OK)
+		{
+			// Read past the end of the block
+			mResult = LLUZipHelper::ZR_DATA_ERROR;
+		}
+		return false;
+	}
+
+	uInt avail = (uInt)llmin(size, (size_t)U32_MAX);
+	mStream->next_out = out;
+	mStream->avail_out = avail;
+	S32 ret = inflate(mStream, Z_NO_FLUSH);
+	produced = avail - mStream->avail_out;
+	switch (ret)
+	{
+	case Z_OK:
+		break;
+	case Z_STREAM_END:
+		mEnded = true;
+		break;
+	case Z_MEM_ERROR:
+		mResult = LLUZipHelper::ZR_MEM_ERROR;
+		return false;
+	case Z_STREAM_ERROR:
+	case Z_BUF_ERROR:
+		// Z_BUF_ERROR: no progress, the input ran out before the block ended
+		mResult = LLUZipHelper::ZR_BUFFER_ERROR;
+		return false;
+	default:
+		mResult = LLUZipHelper::ZR_DATA_ERROR;
+		return false;
+	}
+	return true;
+}
+
+bool LLUZipReader::fill()
+{
+	size_t produced = 0;
+	if (!inflateTo(mBuffer.get(), UZIP_READER_CHUNK, produced))
+	{
+		return false;
+	}
+	mNext = mBuffer.get();
+	mAvailable = produced;
+	return true;
+}
+
+bool LLUZipReader::read(void* out, size_t size)
+{
+	U8* dst = (U8*)out;
+	while (size)
+	{
+		if (mAvailable)
+		{
+			size_t count = llmin(size, mAvailable);
+			memcpy(dst, mNext, count);		/* Flawfinder: ignore */
+			mNext += count;
+			mAvailable -= count;
+			dst += count;
+			size -= count;
+		}
+		else if (size >= UZIP_READER_CHUNK)
+		{
+			// Big reads inflate straight into the caller's memory
+			size_t produced = 0;
+			if (!inflateTo(dst, size, produced))
+			{
+				return false;
+			}
+			dst += produced;
+			size -= produced;
+		}
+		else if (!fill())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool LLUZipReader::skip(size_t size)
+{
+	while (size)
+	{
+		if (!mAvailable && !fill())
+		{
+			return false;
+		}
+		size_t count = llmin(size, mAvailable);
+		mNext += count;
+		mAvailable -= count;
+		size -= count;
+	}
+	return true;
+}
+
+bool LLUZipReader::finish()
+{
+	mAvailable = 0;
+	while (!mEnded)
+	{
+		if (!fill())
+		{
+			return false;
+		}
+	}
+	return mResult == LLUZipHelper::ZR_OK;
+}
+
 //This unzip function will only work with a gzip header and trailer - while the contents
 //of the actual compressed data is the same for either format (gzip vs zlib ), the headers
 //and trailers are different for the formats.
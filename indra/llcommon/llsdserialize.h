@@ -30,10 +30,21 @@
 #define LL_LLSDSERIALIZE_H
 
 #include <iosfwd>
+#include <utility>
+#include <vector>
 #include "llpointer.h"
 #include "llrefcount.h"
 #include "llsd.h"
 
+/**
+ * A serialized LLSD document held in one or more discontiguous blocks of
+ * memory, such as the blocks of an LLCore::BufferArray. The span based
+ * parse() entry points read the blocks in place, without first copying
+ * them into a string or going through a std::istream.
+ */
+typedef std::pair<const char*, size_t> LLSDSpan;
+typedef std::vector<LLSDSpan> LLSDSpanList;
+
 /** 
  * @class LLSDParser
  * @brief Abstract base class for LLSD parsers.
@@ -308,6 +319,20 @@ public:
 	 */
 	LLSDXMLParser(bool emit_errors=true);
 
+	using LLSDParser::parse;
+
+	/** 
+	 * @brief Parse a complete XML document held in spans.
+	 *
+	 * Each span is handed to expat as is, so the document is never
+	 * copied or read a line at a time.
+	 * @param spans The document.
+	 * @param data[out] The newly parse structured data.
+	 * @return Returns the number of LLSD objects parsed into
+	 * data. Returns PARSE_FAILURE (-1) on parse failure.
+	 */
+	S32 parse(const LLSDSpanList& spans, LLSD& data);
+
 protected:
 	/** 
 	 * @brief Call this method to parse a stream for LLSD.
@@ -338,6 +363,7 @@ private:
 
 	void parsePart(const char* buf, llssize len);
 	friend class LLSDSerialize;
+	friend class LLSDReader;
 };
 
 /** 
@@ -358,6 +384,24 @@ public:
 	 */
 	LLSDBinaryParser();
 
+	using LLSDParser::parse;
+
+	/** 
+	 * @brief Parse one binary LLSD object held in spans.
+	 *
+	 * Scalars and strings are read straight out of the spans; only
+	 * values straddling two spans are gathered piecewise. Sizes are
+	 * checked against the bytes actually available, so there is no
+	 * max_bytes parameter.
+	 * @param spans The serialized data.
+	 * @param data[out] The newly parse structured data.
+	 * @param max_depth Max depth parser will check before exiting
+	 *  with parse error, -1 - unlimited.
+	 * @return Returns the number of LLSD objects parsed into
+	 * data. Returns PARSE_FAILURE (-1) on parse failure.
+	 */
+	S32 parse(const LLSDSpanList& spans, LLSD& data, S32 max_depth = -1);
+
 protected:
 	/** 
 	 * @brief Call this method to parse a stream for LLSD.
@@ -408,6 +452,110 @@ private:
 	bool parseString(std::istream& istr, std::string& value) const;
 };
 
+/** 
+ * @class LLSDReader
+ * @brief Event based reader for serialized LLSD.
+ *
+ * The parsers above always build the complete LLSD tree. LLSDReader
+ * walks the same formats and hands every map, array, key and scalar
+ * to a Handler as soon as it has been read, so a consumer that copies
+ * the data into its own structures never holds more than the value at
+ * hand. The handler may skip the value of any map key it is not
+ * interested in, or abandon the parse altogether.
+ */
+class LL_COMMON_API LLSDReader
+{
+public:
+	/** 
+	 * @brief Receives the parse events, in document order.
+	 *
+	 * Except for key(), returning false abandons the parse.
+	 */
+	class LL_COMMON_API Handler
+	{
+	public:
+		enum EAction
+		{
+			READ_VALUE,		// Deliver the events of the value of this key.
+			SKIP_VALUE,		// Read past the value without any event.
+			STOP			// Abandon the parse.
+		};
+
+		virtual ~Handler() {}
+
+		virtual bool startMap() = 0;
+		virtual EAction key(const std::string& key) = 0;
+		virtual bool endMap() = 0;
+		virtual bool startArray() = 0;
+		virtual bool endArray() = 0;
+
+		/** 
+		 * @brief Any value but a map or an array, including undefined.
+		 */
+		virtual bool value(const LLSD& value) = 0;
+	};
+
+	/** 
+	 * @brief Handler turning the events back into an LLSD.
+	 *
+	 * Useful to materialise one small part of a large document: forward
+	 * the events of that part to a Builder, then pick up the result once
+	 * isComplete() turns true.
+	 */
+	class LL_COMMON_API Builder : public Handler
+	{
+	public:
+		Builder();
+
+		void reset();
+		bool isComplete() const { return mComplete; }
+		const LLSD& getLLSD() const { return mResult; }
+
+		bool startMap() override;
+		EAction key(const std::string& key) override;
+		bool endMap() override;
+		bool startArray() override;
+		bool endArray() override;
+		bool value(const LLSD& value) override;
+
+	private:
+		LLSD& place(const LLSD& value);
+		bool endContainer();
+
+		LLSD mResult;
+		std::vector<LLSD*> mStack;
+		std::string mKey;
+		bool mComplete;
+	};
+
+	/** 
+	 * @brief Read one binary LLSD object (no header) held in spans.
+	 *
+	 * @return Returns true if a complete object was read, false on a
+	 * parse error or when the handler abandoned the parse.
+	 */
+	static bool parseBinary(const LLSDSpanList& spans, Handler& handler, S32 max_depth = -1);
+
+	/** 
+	 * @brief Read a complete XML LLSD document held in spans.
+	 */
+	static bool parseXML(const LLSDSpanList& spans, Handler& handler, bool emit_errors = true);
+
+	/** 
+	 * @brief Read one notation LLSD object (no header) from a stream.
+	 *
+	 * Only maps and arrays are walked incrementally, scalars are read
+	 * with an LLSDNotationParser.
+	 */
+	static bool parseNotation(std::istream& istr, Handler& handler, S32 max_depth = -1);
+
+	/** 
+	 * @brief Examine the header of the document held in spans, like
+	 * LLSDSerialize::deserialize() does, and read it in that format.
+	 */
+	static bool parse(const LLSDSpanList& spans, Handler& handler);
+};
+
 
 /** 
  * @class LLSDFormatter
@@ -758,6 +906,12 @@ public:
 	 */
 	static bool deserialize(LLSD& sd, std::istream& str, llssize max_bytes);
 
+	/**
+	 * @brief Same as above, for a document held in spans. Binary and
+	 * XML are parsed in place; notation is gathered into a stream.
+	 */
+	static bool deserialize(LLSD& sd, const LLSDSpanList& spans);
+
 	/*
 	 * Notation Methods
 	 */
@@ -825,6 +979,11 @@ public:
 		return fromXMLEmbedded(sd, str, emit_errors);
 //		return fromXMLDocument(sd, str, emit_errors);
 	}
+	static S32 fromXML(LLSD& sd, const LLSDSpanList& spans, bool emit_errors=true)
+	{
+		LLPointer<LLSDXMLParser> p = new LLSDXMLParser(emit_errors);
+		return p->parse(spans, sd);
+	}
 
 	/*
 	 * Binary Methods
@@ -846,6 +1005,11 @@ public:
 		(void)p->parse(str, sd, max_bytes, max_depth);
 		return sd;
 	}
+	static S32 fromBinary(LLSD& sd, const LLSDSpanList& spans, S32 max_depth = -1)
+	{
+		LLPointer<LLSDBinaryParser> p = new LLSDBinaryParser;
+		return p->parse(spans, sd, max_depth);
+	}
 };
 
 class LL_COMMON_API LLUZipHelper : public LLRefCount
@@ -866,6 +1030,34 @@ public:
 	static EZipRresult unzip_llsd(LLSD& data, const U8* in, S32 size);
 };
 
+// Inflates a zlib block on demand, so a caller can parse the block as it
+// goes instead of holding all of it decompressed.
+class LL_COMMON_API LLUZipReader
+{
+public:
+	LLUZipReader(const U8* in, S32 size);
+	~LLUZipReader();
+
+	// Reads size bytes. False on a zlib error or when the block ends first.
+	bool read(void* out, size_t size);
+	bool skip(size_t size);
+	// Inflates the rest of the block, true if it ends cleanly
+	bool finish();
+
+	LLUZipHelper::EZipRresult getResult() const	{ return mResult; }
+
+private:
+	bool inflateTo(U8* out, size_t size, size_t& produced);
+	bool fill();
+
+	struct z_stream_s* mStream;
+	std::unique_ptr<U8[]> mBuffer;
+	const U8* mNext;
+	size_t mAvailable;
+	bool mEnded;
+	LLUZipHelper::EZipRresult mResult;
+};
+
 //dirty little zip functions -- yell at davep
 LL_COMMON_API std::string zip_llsd(LLSD& data);
 
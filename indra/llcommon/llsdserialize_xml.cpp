@@ -268,6 +268,8 @@ public:
 	~Impl();
 	
 	S32 parse(std::istream& input, LLSD& data);
+	S32 parse(const LLSDSpanList& spans, LLSD& data);
+	bool parse(const LLSDSpanList& spans, LLSDReader::Handler& handler);
 	S32 parseLines(std::istream& input, LLSD& data);
 
 	void parsePart(const char *buf, llssize len);
@@ -305,6 +307,13 @@ private:
 		ELEMENT_UNKNOWN
 	};
 	static Element readElement(const XML_Char* name);
+
+	void readValue(Element element, LLSD& value);
+
+	// Event mode, see LLSDReader::parseXML()
+	void startEventElement(Element element, const XML_Char** attributes);
+	void endEventElement(Element element);
+	void stopEvents();
 	
 	static const XML_Char* findAttribute(const XML_Char* name, const XML_Char** pairs);
 	
@@ -328,11 +337,16 @@ private:
 	
 	std::string mCurrentKey;		// Current XML <tag>
 	std::string mCurrentContent;	// String data between <tag> and </tag>
+
+	LLSDReader::Handler* mHandler;	// Receives the events instead of mResult
+	std::vector<Element> mEventStack;	// Value elements open in event mode
+	bool mHandlerFailed;			// true if the handler abandoned the parse
 };
 
 
 LLSDXMLParser::Impl::Impl(bool emit_errors)
-	: mEmitErrors(emit_errors)
+	: mEmitErrors(emit_errors),
+	  mHandler(NULL)
 {
 	mParser = XML_ParserCreate(NULL);
 	reset();
@@ -437,6 +451,54 @@ S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSD& data)
 }
 
 
+S32 LLSDXMLParser::Impl::parse(const LLSDSpanList& spans, LLSD& data)
+{
+	XML_Status status = XML_STATUS_OK;
+	for (const LLSDSpan& span : spans)
+	{
+		if (!span.second)
+		{
+			continue;
+		}
+		status = XML_Parse(mParser, span.first, (int)span.second, false);
+		if (status != XML_STATUS_OK || mGracefullStop)
+		{
+			break;
+		}
+	}
+	if (status == XML_STATUS_OK && !mGracefullStop)
+	{
+		status = XML_Parse(mParser, NULL, 0, true);
+	}
+
+	// Reaching </llsd> stops the parser, which expat reports as an error.
+	if (status == XML_STATUS_ERROR && !mGracefullStop)
+	{
+		if (mEmitErrors && !mHandlerFailed)
+		{
+			LL_INFOS() << "LLSDXMLParser::Impl::parse: XML_STATUS_ERROR: "
+				<< XML_ErrorString(XML_GetErrorCode(mParser)) << " at line "
+				<< XML_GetCurrentLineNumber(mParser) << LL_ENDL;
+		}
+		data = LLSD();
+		return LLSDParser::PARSE_FAILURE;
+	}
+
+	data = mResult;
+	return mParseCount;
+}
+
+
+bool LLSDXMLParser::Impl::parse(const LLSDSpanList& spans, LLSDReader::Handler& handler)
+{
+	mHandler = &handler;
+	LLSD unused;
+	S32 parse_count = parse(spans, unused);
+	mHandler = NULL;
+	return (parse_count > 0) && !mHandlerFailed && mEventStack.empty();
+}
+
+
 S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 {
 	XML_Status status = XML_STATUS_OK;
@@ -534,6 +596,9 @@ void LLSDXMLParser::Impl::reset()
 	mSkipping = false;
 	
 	mCurrentKey.clear();
+
+	mEventStack.clear();
+	mHandlerFailed = false;
 	
 	XML_ParserReset(mParser, "utf-8");
 	XML_SetUserData(mParser, this);
@@ -611,7 +676,7 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 	#endif // XML_PARSER_PERFORMANCE_TESTS
 	
 	++mDepth;
-	if (mSkipping)
+	if (mSkipping || mHandlerFailed)
 	{
 		return;
 	}
@@ -620,6 +685,11 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 	mStackElements.push( element );
 	mCurrentContent.clear();
 
+	if (mHandler)
+	{
+		return startEventElement(element, attributes);
+	}
+
 	switch (element)
 	{
 		case ELEMENT_LLSD:
@@ -725,6 +795,10 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 		}
 		return;
 	}
+	if (mHandlerFailed)
+	{
+		return;
+	}
 	
 	// <FS:ND>: we've saved the element we need in a stack, so we can avoid readElement()
 	// Element element = readElement(name);
@@ -732,6 +806,11 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 	mStackElements.pop();
 	// </FS:ND>
 
+	if (mHandler)
+	{
+		return endEventElement(element);
+	}
+
 	switch (element)
 	{
 		case ELEMENT_LLSD:
@@ -756,7 +835,13 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 
 	LLSD& value = *mStack.back();
 	mStack.pop_back();
-	
+
+	readValue(element, value);
+	mCurrentContent.clear();
+}
+
+void LLSDXMLParser::Impl::readValue(Element element, LLSD& value)
+{
 	switch (element)
 	{
 		case ELEMENT_UNDEF:
@@ -842,8 +927,161 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 			// other values, map and array, have already been set
 			break;
 	}
+}
+
+void LLSDXMLParser::Impl::startEventElement(Element element, const XML_Char** attributes)
+{
+	// Same checks as startElementHandler(), against the open value
+	// elements rather than the LLSD under construction
+	switch (element)
+	{
+		case ELEMENT_LLSD:
+			if (mInLLSDElement)
+			{
+				mStackElements.pop();
+				return startSkipping();
+			}
+			mInLLSDElement = true;
+			return;
+
+		case ELEMENT_KEY:
+			if (mEventStack.empty() || (mEventStack.back() != ELEMENT_MAP))
+			{
+				mStackElements.pop();
+				return startSkipping();
+			}
+			return;
+
+		case ELEMENT_BINARY:
+		{
+			const XML_Char* encoding = findAttribute("encoding", attributes);
+			if(encoding && strcmp("base64", encoding) != 0)
+			{
+				mStackElements.pop();
+				return startSkipping();
+			}
+			break;
+		}
+
+		default:
+			;
+	}
+
+	if (!mInLLSDElement)
+	{
+		mStackElements.pop();
+		return startSkipping();
+	}
 
+	if (!mEventStack.empty())
+	{
+		if (mEventStack.back() == ELEMENT_MAP)
+		{
+			if (mCurrentKey.empty())
+			{
+				mStackElements.pop();
+				return startSkipping();
+			}
+
+			LLSDReader::Handler::EAction action = mHandler->key(mCurrentKey);
+			mCurrentKey.clear();
+			if (LLSDReader::Handler::SKIP_VALUE == action)
+			{
+				mStackElements.pop();
+				return startSkipping();
+			}
+			if (LLSDReader::Handler::READ_VALUE != action)
+			{
+				return stopEvents();
+			}
+		}
+		else if (mEventStack.back() != ELEMENT_ARRAY)
+		{
+			// improperly nested value in a non-structure
+			mStackElements.pop();
+			return startSkipping();
+		}
+	}
+
+	++mParseCount;
+	mEventStack.push_back(element);
+	switch (element)
+	{
+		case ELEMENT_MAP:
+			if (!mHandler->startMap())
+			{
+				stopEvents();
+			}
+			break;
+
+		case ELEMENT_ARRAY:
+			if (!mHandler->startArray())
+			{
+				stopEvents();
+			}
+			break;
+
+		default:
+			// all the other values are delivered by the end element handler
+			;
+	}
+}
+
+void LLSDXMLParser::Impl::endEventElement(Element element)
+{
+	switch (element)
+	{
+		case ELEMENT_LLSD:
+			if (mInLLSDElement)
+			{
+				mInLLSDElement = false;
+				mGracefullStop = true;
+				XML_StopParser(mParser, false);
+			}
+			return;
+
+		case ELEMENT_KEY:
+			mCurrentKey = mCurrentContent;
+			return;
+
+		default:
+			;
+	}
+
+	if (!mInLLSDElement) { return; }
+
+	mEventStack.pop_back();
+	bool ok = true;
+	switch (element)
+	{
+		case ELEMENT_MAP:
+			ok = mHandler->endMap();
+			break;
+
+		case ELEMENT_ARRAY:
+			ok = mHandler->endArray();
+			break;
+
+		default:
+		{
+			LLSD value;
+			readValue(element, value);
+			ok = mHandler->value(value);
+			break;
+		}
+	}
 	mCurrentContent.clear();
+
+	if (!ok)
+	{
+		stopEvents();
+	}
+}
+
+void LLSDXMLParser::Impl::stopEvents()
+{
+	mHandlerFailed = true;
+	XML_StopParser(mParser, false);
 }
 
 void LLSDXMLParser::Impl::characterDataHandler(const XML_Char* data, int length)
@@ -962,6 +1200,22 @@ void LLSDXMLParser::parsePart(const char *buf, llssize len)
 	impl.parsePart(buf, len);
 }
 
+S32 LLSDXMLParser::parse(const LLSDSpanList& spans, LLSD& data)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+
+	return impl.parse(spans, data);
+}
+
+// static
+bool LLSDReader::parseXML(const LLSDSpanList& spans, Handler& handler, bool emit_errors)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+
+	LLPointer<LLSDXMLParser> parser(new LLSDXMLParser(emit_errors));
+	return parser->impl.parse(spans, handler);
+}
+
 // virtual
 S32 LLSDXMLParser::doParse(std::istream& input, LLSD& data, S32 max_depth) const
 {
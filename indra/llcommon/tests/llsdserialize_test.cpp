@@ -51,13 +51,17 @@ typedef U32 uint32_t;
 #include "llsdutil.h"
 #include "llformat.h"
 #include "llmemorystream.h"
+#include "llmemory.h"
 
 #include "../test/hexdump.h"
 #include "../test/lltut.h"
 #include "../test/namedtempfile.h"
 #include "stringize.h"
 #include "StringVec.h"
+#include <algorithm>
+#include <chrono>
 #include <functional>
+#include <iterator>
 
 typedef std::function<void(const LLSD& data, std::ostream& str)> FormatterFunction;
 typedef std::function<bool(std::istream& istr, LLSD& data, llssize max_bytes)> ParserFunction;
@@ -243,6 +247,16 @@ namespace tut
 		xml_test("binary", expected);
 	}
 
+	static LLSDSpanList split_spans(const std::string& text, size_t span_size)
+	{
+		LLSDSpanList spans;
+		for (size_t pos = 0; pos < text.size(); pos += span_size)
+		{
+			spans.push_back(LLSDSpan(text.data() + pos, llmin(span_size, text.size() - pos)));
+		}
+		return spans;
+	}
+
 	class TestLLSDSerializeData
 	{
 	public:
@@ -268,6 +282,18 @@ namespace tut
 			};
 		}
 
+		// Parse from small spans, so that nearly every value straddles
+		// two of them
+		void setSpanParser(std::function<bool(LLSD&, const LLSDSpanList&)> parser)
+		{
+			mParser = [parser](std::istream& istr, LLSD& data, llssize)
+			{
+				std::string text((std::istreambuf_iterator<char>(istr)),
+								 std::istreambuf_iterator<char>());
+				return parser(data, split_spans(text, 5));
+			};
+		}
+
 		void setParser(bool (*parser)(LLSD&, std::istream&, llssize))
 		{
 			// why does LLSDSerialize::deserialize() reverse the parse() params??
@@ -602,6 +628,337 @@ namespace tut
 	};
 |*==========================================================================*/
 
+	template<> template<>
+	void TestLLSDSerializeObject::test<11>()
+	{
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::toBinary(sd, str);
+		};
+		setSpanParser([](LLSD& sd, const LLSDSpanList& spans)
+					  { return LLSDSerialize::fromBinary(sd, spans) > 0; });
+		doRoundTripTests("binary serialization from spans");
+	};
+
+	template<> template<>
+	void TestLLSDSerializeObject::test<12>()
+	{
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::toXML(sd, str);
+		};
+		setSpanParser([](LLSD& sd, const LLSDSpanList& spans)
+					  { return LLSDSerialize::fromXML(sd, spans) > 0; });
+		doRoundTripTests("xml serialization from spans");
+	};
+
+	template<> template<>
+	void TestLLSDSerializeObject::test<13>()
+	{
+		setSpanParser([](LLSD& sd, const LLSDSpanList& spans)
+					  { return LLSDSerialize::deserialize(sd, spans); });
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::serialize(sd, str, LLSDSerialize::LLSD_BINARY);
+		};
+		doRoundTripTests("serialize(LLSD_BINARY) -> deserialize spans");
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::serialize(sd, str, LLSDSerialize::LLSD_XML);
+		};
+		doRoundTripTests("serialize(LLSD_XML) -> deserialize spans");
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::serialize(sd, str, LLSDSerialize::LLSD_NOTATION);
+		};
+		doRoundTripTests("serialize(LLSD_NOTATION) -> deserialize spans");
+	};
+
+	template<> template<>
+	void TestLLSDSerializeObject::test<14>()
+	{
+		set_test_name("truncated and notation-string binary spans");
+
+		// Binary LLSD also accepts notation style strings
+		const char raw[] = "[\0\0\0\2'a\\'b'\"c\\x41d\"]";
+		std::string text(raw, sizeof(raw) - 1);
+		LLSD sd;
+		ensure_equals("delimited strings", LLSDSerialize::fromBinary(sd, split_spans(text, 1)), 3);
+		ensure_equals("escaped quote", sd[0].asString(), "a'b");
+		ensure_equals("hex escape", sd[1].asString(), "cAd");
+
+		LLSD map;
+		map["name"] = "value";
+		map["blob"] = string_to_vector("some binary");
+		std::ostringstream str;
+		LLSDSerialize::toBinary(map, str);
+		text = str.str();
+		for (size_t len = 0; len < text.size(); ++len)
+		{
+			ensure(STRINGIZE("truncated at " << len),
+				   LLSDSerialize::fromBinary(sd, split_spans(text.substr(0, len), 3)) <= 0);
+		}
+	}
+
+	template<> template<>
+	void TestLLSDSerializeObject::test<15>()
+	{
+		set_test_name("stream vs. span parsing benchmark");
+
+		// Something shaped like an AIS inventory response
+		LLSD items = LLSD::emptyArray();
+		for (S32 i = 0; i < 20000; ++i)
+		{
+			LLUUID id;
+			id.generate();
+			LLSD item;
+			item["item_id"] = id;
+			item["name"] = llformat("Inventory item number %d", i);
+			item["desc"] = "(No Description)";
+			item["type"] = i % 20;
+			item["flags"] = (i * 31) % 1000;
+			item["created_at"] = LLDate(1600000000.0 + i);
+			item["permissions"]["owner_id"] = id;
+			item["permissions"]["owner_mask"] = 0x7fffffff;
+			items.append(item);
+		}
+
+		// The block size of an LLCore::BufferArray
+		const size_t HTTP_BLOCK_SIZE = 65540;
+		const S32 PASSES = 5;
+		for (bool xml : { false, true })
+		{
+			std::ostringstream str;
+			if (xml)
+			{
+				LLSDSerialize::toXML(items, str);
+			}
+			else
+			{
+				LLSDSerialize::toBinary(items, str);
+			}
+			const std::string text(str.str());
+			const LLSDSpanList spans(split_spans(text, HTTP_BLOCK_SIZE));
+
+			LLSD from_stream, from_spans;
+			auto start = std::chrono::steady_clock::now();
+			for (S32 pass = 0; pass < PASSES; ++pass)
+			{
+				std::istringstream istr(text);
+				if (xml)
+				{
+					LLSDSerialize::fromXML(from_stream, istr);
+				}
+				else
+				{
+					LLSDSerialize::fromBinary(from_stream, istr, text.size());
+				}
+			}
+			auto middle = std::chrono::steady_clock::now();
+			for (S32 pass = 0; pass < PASSES; ++pass)
+			{
+				if (xml)
+				{
+					LLSDSerialize::fromXML(from_spans, spans);
+				}
+				else
+				{
+					LLSDSerialize::fromBinary(from_spans, spans);
+				}
+			}
+			auto end = std::chrono::steady_clock::now();
+
+			ensure(xml ? "xml results match" : "binary results match",
+				   llsd_equals(from_stream, items) && llsd_equals(from_spans, items));
+			typedef std::chrono::duration<double, std::milli> ms_t;
+			std::cout << (xml ? "xml " : "binary ") << text.size() << " bytes, stream: "
+					  << ms_t(middle - start).count() / PASSES << " ms, spans: "
+					  << ms_t(end - middle).count() / PASSES << " ms" << std::endl;
+		}
+	}
+
+	template<> template<>
+	void TestLLSDSerializeObject::test<16>()
+	{
+		setSpanParser([](LLSD& sd, const LLSDSpanList& spans)
+					  {
+						  LLSDReader::Builder builder;
+						  bool ok = LLSDReader::parse(spans, builder) && builder.isComplete();
+						  sd = builder.getLLSD();
+						  return ok;
+					  });
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::serialize(sd, str, LLSDSerialize::LLSD_BINARY);
+		};
+		doRoundTripTests("serialize(LLSD_BINARY) -> LLSDReader::Builder");
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::serialize(sd, str, LLSDSerialize::LLSD_XML);
+		};
+		doRoundTripTests("serialize(LLSD_XML) -> LLSDReader::Builder");
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::serialize(sd, str, LLSDSerialize::LLSD_NOTATION);
+		};
+		doRoundTripTests("serialize(LLSD_NOTATION) -> LLSDReader::Builder");
+	};
+
+	// Records the events it gets, skipping the values of "skipped" keys
+	// and abandoning the parse at a "stop" key
+	class RecordingHandler : public LLSDReader::Handler
+	{
+	public:
+		bool startMap() override { mEvents << '{'; return true; }
+		EAction key(const std::string& key) override
+		{
+			mEvents << key << ':';
+			return (key == "skipped") ? SKIP_VALUE : (key == "stop") ? STOP : READ_VALUE;
+		}
+		bool endMap() override { mEvents << '}'; return true; }
+		bool startArray() override { mEvents << '['; return true; }
+		bool endArray() override { mEvents << ']'; return true; }
+		bool value(const LLSD& value) override { mEvents << value.asString() << ','; return true; }
+
+		std::ostringstream mEvents;
+	};
+
+	template<> template<>
+	void TestLLSDSerializeObject::test<17>()
+	{
+		set_test_name("LLSDReader events");
+
+		LLSD sd;
+		sd["a"] = 1;
+		sd["skipped"]["deep"][0] = "nested";
+		sd["skipped"]["deep"][1] = LLSD::emptyMap();
+		sd["z"][0] = "x";
+		sd["z"][1] = LLSD::emptyArray();
+		for (S32 type : { LLSDSerialize::LLSD_BINARY, LLSDSerialize::LLSD_XML, LLSDSerialize::LLSD_NOTATION })
+		{
+			std::ostringstream str;
+			LLSDSerialize::serialize(sd, str, LLSDSerialize::ELLSD_Serialize(type));
+			const std::string text(str.str());
+			const std::string name(STRINGIZE("format " << type));
+
+			RecordingHandler recorder;
+			ensure(name, LLSDReader::parse(split_spans(text, 3), recorder));
+			ensure_equals(name, recorder.mEvents.str(), "{a:1,skipped:z:[x,[]]}");
+
+			LLSD stop(sd);
+			stop["stop"] = "here";
+			std::ostringstream stopstr;
+			LLSDSerialize::serialize(stop, stopstr, LLSDSerialize::ELLSD_Serialize(type));
+			RecordingHandler stopper;
+			ensure(name + " stopped", !LLSDReader::parse(split_spans(stopstr.str(), 3), stopper));
+			ensure_equals(name + " stopped", stopper.mEvents.str(), "{a:1,skipped:stop:");
+
+			for (size_t len = 0; len < text.find_last_not_of("\r\n"); ++len)
+			{
+				LLSDReader::Builder builder;
+				ensure(STRINGIZE(name << " truncated at " << len),
+					   !LLSDReader::parse(split_spans(text.substr(0, len), 3), builder));
+			}
+		}
+	}
+
+	template<> template<>
+	void TestLLSDSerializeObject::test<18>()
+	{
+		set_test_name("LLSD map vs. std::map benchmark");
+
+		typedef std::chrono::steady_clock clock_t;
+		typedef std::chrono::duration<double, std::milli> ms_t;
+		// Many maps the size of an inventory item or a setting, then one
+		// map as large as a whole settings group
+		const std::pair<S32, S32> shapes[] = { { 20000, 12 }, { 1, 5000 } };
+		for (const std::pair<S32, S32>& shape : shapes)
+		{
+			const S32 map_count = shape.first;
+			std::vector<std::string> keys;
+			for (S32 i = 0; i < shape.second; ++i)
+			{
+				// Unordered, some longer than the small string buffer
+				S32 n = (i * 7919) % shape.second;
+				keys.push_back(llformat(n % 2 ? "key%d" : "some_longer_setting_name_%d", n));
+			}
+
+			// What LLSD maps used to hold. Both sets stay alive so the
+			// resident size grows by what each one holds.
+			std::vector<std::map<std::string, LLSD> > trees(map_count);
+			std::vector<LLSD> maps(map_count);
+			U64 rss_start = LLMemory::getCurrentRSS();
+			auto start = clock_t::now();
+			for (std::map<std::string, LLSD>& tree : trees)
+			{
+				for (const std::string& key : keys)
+				{
+					tree[key] = 1;
+				}
+			}
+			auto middle = clock_t::now();
+			U64 rss_middle = LLMemory::getCurrentRSS();
+			for (LLSD& map : maps)
+			{
+				for (const std::string& key : keys)
+				{
+					map[key] = 1;
+				}
+			}
+			auto end = clock_t::now();
+			U64 rss_end = LLMemory::getCurrentRSS();
+			std::cout << map_count << " maps of " << keys.size() << " keys, insert std::map: "
+					  << ms_t(middle - start).count() << " ms, LLSD: "
+					  << ms_t(end - middle).count() << " ms" << std::endl;
+			const F64 key_count = F64(map_count) * keys.size();
+			std::cout << map_count << " maps of " << keys.size() << " keys, resident bytes per key std::map: "
+					  << F64(rss_middle - rss_start) / key_count << ", LLSD: "
+					  << F64(rss_end - rss_middle) / key_count << std::endl;
+
+			S32 found = 0;
+			start = clock_t::now();
+			for (const std::map<std::string, LLSD>& tree : trees)
+			{
+				for (const std::string& key : keys)
+				{
+					found += (tree.find(key) != tree.end());
+					found += (tree.find(key + "x") != tree.end());
+				}
+			}
+			middle = clock_t::now();
+			for (const LLSD& map : maps)
+			{
+				for (const std::string& key : keys)
+				{
+					found -= map.has(key);
+					found -= map[key + "x"].isDefined();
+				}
+			}
+			end = clock_t::now();
+			ensure_equals("lookups agree", found, 0);
+			std::cout << map_count << " maps of " << keys.size() << " keys, lookup std::map: "
+					  << ms_t(middle - start).count() << " ms, LLSD: "
+					  << ms_t(end - middle).count() << " ms" << std::endl;
+
+			const LLSD& map(maps.back());
+			ensure_equals("map size", map.size(), keys.size());
+			LLSD::map_const_iterator it = map.beginMap();
+			for (const auto& pair : trees.back())
+			{
+				ensure_equals("map order", it->first, pair.first);
+				++it;
+			}
+			ensure("map end", it == map.endMap());
+		}
+
+		// Per key: a tree node holds the string and the value plus its
+		// links and color; a flat map holds a slot pointing at the shared
+		// interned key and an entry holding a reference to it.
+		const size_t tree_bytes = sizeof(std::map<std::string, LLSD>::value_type) + 4 * sizeof(void*);
+		const size_t flat_bytes = sizeof(LLSD::MapSlot) + sizeof(LLSD::map_entry);
+		std::cout << "map bytes per key, std::map: " << tree_bytes << ", LLSD: " << flat_bytes << std::endl;
+	}
+
 	/**
 	 * @class TestLLSDParsing
 	 * @brief Base class for of a parse tester.
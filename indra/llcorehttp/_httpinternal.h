@@ -153,6 +153,10 @@ const int HTTP_CONNECTION_LIMIT_MAX = 256;
 const long HTTP_PIPELINING_DEFAULT = 0L;
 const long HTTP_PIPELINING_MAX = 20L;
 
+// HTTP/2 modes, see HttpRequest::PO_HTTP2
+const long HTTP_HTTP2_DEFAULT = 0L;
+const long HTTP_HTTP2_MAX = 2L;
+
 // Miscellaneous defaults
 const bool HTTP_USE_RETRY_AFTER_DEFAULT = true;
 const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
@@ -160,9 +164,16 @@ const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
 // Tuning parameters
 
 // Time worker thread sleeps after a pass through the
-// request, ready and active queues.
+// request, ready and active queues when libcurl is too old
+// for curl_multi_poll() and there is no way to wake it up.
 const int HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS = 2;
 
+// Longest the worker thread waits in HttpLibcurl::poll()
+// with requests active.  Socket activity, libcurl timers,
+// retries coming due and new requests all end the wait
+// earlier, this only bounds the damage of anything missed.
+const long HTTP_SERVICE_LOOP_POLL_MAX_MS = 100L;
+
 // Block allocation size (a tuning parameter) is found
 // in bufferarray.h.
 
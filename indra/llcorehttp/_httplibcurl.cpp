@@ -30,8 +30,10 @@
 #include "bufferarray.h"
 #include "_httpoprequest.h"
 #include "_httppolicy.h"
+#include "httpstats.h"
 
 #include "llhttpconstants.h"
+#include "lltimer.h"
 
 namespace
 {
@@ -51,6 +53,40 @@ void check_curl_multi_setopt(CURLM* handle, CURLMoption option, ARG argument)
 
 static const char * const LOG_CORE("CoreHttp");
 
+// Add a socket to a poll() wait list, merging events if the
+// socket is already listed from index 'first' on.
+void add_wait_fd(std::vector<curl_waitfd> & fds, size_t first, curl_socket_t fd, short events)
+{
+	for (size_t i(first); i < fds.size(); ++i)
+	{
+		if (fds[i].fd == fd)
+		{
+			fds[i].events |= events;
+			return;
+		}
+	}
+	curl_waitfd wait_fd;
+	wait_fd.fd = fd;
+	wait_fd.events = events;
+	wait_fd.revents = 0;
+	fds.push_back(wait_fd);
+}
+
+// "host:port" part of a URL, the key for per-host statistics
+std::string get_host_key(const std::string & url)
+{
+	std::string::size_type start(url.find("://"));
+	start = (std::string::npos == start) ? 0 : start + 3;
+	const std::string::size_type end(url.find_first_of("/?#", start));
+	std::string host(url, start, (std::string::npos == end) ? std::string::npos : end - start);
+	const std::string::size_type userinfo(host.rfind('@'));
+	if (std::string::npos != userinfo)
+	{
+		host.erase(0, userinfo + 1);
+	}
+	return host;
+}
+
 } // end anonymous namespace
 
 
@@ -63,8 +99,10 @@ HttpLibcurl::HttpLibcurl(HttpService * service)
 	  mHandleCache(),
 	  mPolicyCount(0),
 	  mMultiHandles(NULL),
+	  mMultiplexed(false),
 	  mActiveHandles(NULL),
-	  mDirtyPolicy(NULL)
+	  mDirtyPolicy(NULL),
+	  mPollHandle(NULL)
 {}
 
 
@@ -90,11 +128,11 @@ void HttpLibcurl::shutdown()
 	{
 		for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
 		{
-			if (mMultiHandles[policy_class])
+			if (mMultiHandles[policy_class] && ! (mMultiplexed && policy_class))
 			{
 				curl_multi_cleanup(mMultiHandles[policy_class]);
-				mMultiHandles[policy_class] = 0;
 			}
+			mMultiHandles[policy_class] = 0;
 		}
 
 		delete [] mMultiHandles;
@@ -107,7 +145,15 @@ void HttpLibcurl::shutdown()
 		mDirtyPolicy = NULL;
 	}
 
+	if (mPollHandle)
+	{
+		curl_multi_cleanup(mPollHandle);
+		mPollHandle = NULL;
+	}
+
 	mPolicyCount = 0;
+	mMultiplexed = false;
+	mHostActive.clear();
 }
 
 
@@ -121,10 +167,15 @@ void HttpLibcurl::start(int policy_count)
 	mMultiHandles = new CURLM * [mPolicyCount];
 	mActiveHandles = new int [mPolicyCount];
 	mDirtyPolicy = new bool [mPolicyCount];
+	mMultiplexed = mService->getPolicy().getGlobalOptions().mHttp2 > 0;
 	
 	for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
 	{
-		if (NULL == (mMultiHandles[policy_class] = curl_multi_init()))
+		if (mMultiplexed && policy_class)
+		{
+			mMultiHandles[policy_class] = mMultiHandles[0];
+		}
+		else if (NULL == (mMultiHandles[policy_class] = curl_multi_init()))
 		{
 			LL_ERRS(LOG_CORE) << "Failed to allocate multi handle in libcurl."
 							  << LL_ENDL;
@@ -133,6 +184,14 @@ void HttpLibcurl::start(int policy_count)
 		mDirtyPolicy[policy_class] = false;
 		policyUpdated(policy_class);
 	}
+
+	// Requests are never added to this one.  It only exists to give
+	// poll() something to block in that wakeup() can interrupt.
+	if (NULL == (mPollHandle = curl_multi_init()))
+	{
+		LL_ERRS(LOG_CORE) << "Failed to allocate multi handle in libcurl."
+						  << LL_ENDL;
+	}
 }
 
 
@@ -148,14 +207,14 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
 	HttpService::ELoopSpeed	ret(HttpService::REQUEST_SLEEP);
 
 	// Give libcurl some cycles to do I/O & callbacks
-	for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
+	for (int policy_class(0); policy_class < getMultiCount(); ++policy_class)
 	{
 		if (! mMultiHandles[policy_class])
 		{
 			// No handle, nothing to do.
 			continue;
 		}
-		if (! mActiveHandles[policy_class])
+		if (! getActiveCountInMulti(policy_class))
 		{
 			// If we've gone quiet and there's a dirty update, apply it,
 			// otherwise we're done.
@@ -217,6 +276,155 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
 }
 
 
+// Wait on the sockets of all class handles at once.  libcurl
+// can only poll a single multi handle, so the sockets of the
+// class handles are collected with curl_multi_waitfds(), or
+// curl_multi_fdset() before libcurl 8.8.0, and passed as extra
+// descriptors to a poll on the (empty) poll handle.
+void HttpLibcurl::poll(long timeout_ms)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+	mPollFds.clear();
+	for (int policy_class(0); policy_class < getMultiCount(); ++policy_class)
+	{
+		CURLM * multi_handle(mMultiHandles[policy_class]);
+		if (! multi_handle)
+		{
+			continue;
+		}
+		if (! getActiveCountInMulti(policy_class))
+		{
+			if (mDirtyPolicy[policy_class])
+			{
+				// processTransport() can apply the update now
+				return;
+			}
+			continue;
+		}
+
+		long curl_timeout(-1);
+		if (CURLM_OK == curl_multi_timeout(multi_handle, &curl_timeout) && curl_timeout >= 0)
+		{
+			timeout_ms = (std::min)(timeout_ms, curl_timeout);
+		}
+
+		const size_t first(mPollFds.size());
+#if LIBCURL_VERSION_NUM >= 0x080800
+		// libcurl fills in the wait list itself, with no
+		// FD_SETSIZE limit.  Guess the room needed, a class
+		// handle rarely has more than a few connections open.
+		unsigned int fd_count(0);
+		mPollFds.resize(first + 16);
+		CURLMcode status(curl_multi_waitfds(multi_handle, &mPollFds[first], 16, &fd_count));
+		if (CURLM_OUT_OF_MEMORY == status && fd_count > 16)
+		{
+			mPollFds.resize(first + fd_count);
+			status = curl_multi_waitfds(multi_handle, &mPollFds[first], fd_count, &fd_count);
+		}
+		mPollFds.resize(CURLM_OK == status ? first + fd_count : first);
+		if (first == mPollFds.size())
+		{
+			// Active requests without sockets (e.g. name resolution
+			// in progress).  Nothing to wait on, so check back soon.
+			timeout_ms = (std::min)(timeout_ms, long(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS));
+		}
+#else
+		fd_set read_fds, write_fds, exc_fds;
+		FD_ZERO(&read_fds);
+		FD_ZERO(&write_fds);
+		FD_ZERO(&exc_fds);
+		int max_fd(-1);
+		CURLMcode status(curl_multi_fdset(multi_handle, &read_fds, &write_fds, &exc_fds, &max_fd));
+		if (CURLM_OK != status || max_fd < 0)
+		{
+			// Active requests without sockets (e.g. name resolution
+			// in progress) or only sockets that don't fit an fd_set.
+			// Nothing to wait on, so check back soon.
+			timeout_ms = (std::min)(timeout_ms, long(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS));
+			continue;
+		}
+
+#if LL_WINDOWS
+		for (u_int i(0); i < read_fds.fd_count; ++i)
+		{
+			add_wait_fd(mPollFds, first, read_fds.fd_array[i], CURL_WAIT_POLLIN);
+		}
+		for (u_int i(0); i < write_fds.fd_count; ++i)
+		{
+			add_wait_fd(mPollFds, first, write_fds.fd_array[i], CURL_WAIT_POLLOUT);
+		}
+		for (u_int i(0); i < exc_fds.fd_count; ++i)
+		{
+			add_wait_fd(mPollFds, first, exc_fds.fd_array[i], CURL_WAIT_POLLPRI);
+		}
+		const bool sets_full(read_fds.fd_count >= FD_SETSIZE
+							 || write_fds.fd_count >= FD_SETSIZE
+							 || exc_fds.fd_count >= FD_SETSIZE);
+#else
+		for (int fd(0); fd <= max_fd; ++fd)
+		{
+			short events((FD_ISSET(fd, &read_fds) ? CURL_WAIT_POLLIN : 0)
+						 | (FD_ISSET(fd, &write_fds) ? CURL_WAIT_POLLOUT : 0)
+						 | (FD_ISSET(fd, &exc_fds) ? CURL_WAIT_POLLPRI : 0));
+			if (events)
+			{
+				add_wait_fd(mPollFds, first, fd, events);
+			}
+		}
+		const bool sets_full(max_fd >= FD_SETSIZE - 1);
+#endif
+		if (sets_full)
+		{
+			// libcurl silently leaves out the sockets that don't
+			// fit an fd_set, those are only noticed by polling.
+			timeout_ms = (std::min)(timeout_ms, long(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS));
+		}
+#endif
+	}
+
+	if (timeout_ms <= 0)
+	{
+		return;
+	}
+
+	LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("httppt - poll");
+	CURLMcode status(CURLM_OK);
+#if LIBCURL_VERSION_NUM >= 0x074400
+	status = curl_multi_poll(mPollHandle,
+							 mPollFds.empty() ? NULL : &mPollFds[0],
+							 unsigned(mPollFds.size()),
+							 int(timeout_ms),
+							 NULL);
+#else
+	// No curl_multi_poll() and no wakeup, new requests are
+	// only noticed when this returns.  And curl_multi_wait()
+	// doesn't wait at all when it has no descriptors.
+	timeout_ms = (std::min)(timeout_ms, long(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS));
+	if (mPollFds.empty())
+	{
+		ms_sleep(timeout_ms);
+	}
+	else
+	{
+		status = curl_multi_wait(mPollHandle, &mPollFds[0], unsigned(mPollFds.size()),
+								 int(timeout_ms), NULL);
+	}
+#endif
+	check_curl_multi_code(status);
+}
+
+
+void HttpLibcurl::wakeup()
+{
+#if LIBCURL_VERSION_NUM >= 0x074400
+	if (mPollHandle)
+	{
+		curl_multi_wakeup(mPollHandle);
+	}
+#endif
+}
+
+
 // Caller has provided us with a ref count on op.
 void HttpLibcurl::addOp(const HttpOpRequest::ptr_t &op)
 {
@@ -244,6 +452,7 @@ void HttpLibcurl::addOp(const HttpOpRequest::ptr_t &op)
 	op->mCurlActive = true;
 	mActiveOps.insert(op);
 	++mActiveHandles[op->mReqPolicy];
+	updateHostActive(op, 1);
 	
 	if (op->mTracing > HTTP_TRACE_OFF)
 	{
@@ -293,6 +502,7 @@ void HttpLibcurl::cancelRequest(const HttpOpRequest::ptr_t &op)
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
 	// Deactivate request
 	op->mCurlActive = false;
+	updateHostActive(op, -1);
 
 	// Detach from multi and recycle handle
 	curl_multi_remove_handle(mMultiHandles[op->mReqPolicy], op->mCurlHandle);
@@ -357,6 +567,17 @@ bool HttpLibcurl::completeRequest(CURLM * multi_handle, CURL * handle, CURLcode
 	mActiveOps.erase(it);
 	--mActiveHandles[op->mReqPolicy];
 	op->mCurlActive = false;
+	updateHostActive(op, -1);
+
+	// Connection use for the per-host statistics.  With redirects,
+	// this is the original host getting credit for the last hop.
+	long new_connects(0);
+	long http_version(0);
+	curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &new_connects);
+	curl_easy_getinfo(handle, CURLINFO_HTTP_VERSION, &http_version);
+	HTTPStats::instance().recordHostCompletion(get_host_key(op->mReqURL),
+											   new_connects > 0,
+											   CURL_HTTP_VERSION_2_0 == http_version);
 
 	// Set final status of request if it hasn't failed by other mechanisms yet
 	if (op->mStatus)
@@ -507,6 +728,22 @@ int HttpLibcurl::getActiveCountInClass(int policy_class) const
 	return mActiveHandles ? mActiveHandles[policy_class] : 0;
 }
 
+void HttpLibcurl::updateHostActive(const HttpOpRequest::ptr_t &op, int delta)
+{
+	const std::string host(get_host_key(op->mReqURL));
+	std::map<std::string, int>::iterator it(mHostActive.insert(std::make_pair(host, 0)).first);
+	it->second += delta;
+	if (delta > 0)
+	{
+		HTTPStats::instance().recordHostActive(host, U32(it->second));
+	}
+	else if (it->second <= 0)
+	{
+		mHostActive.erase(it);
+	}
+}
+
+
 void HttpLibcurl::policyUpdated(int policy_class)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
@@ -516,6 +753,28 @@ void HttpLibcurl::policyUpdated(int policy_class)
 	}
 	
 	HttpPolicy & policy(mService->getPolicy());
+
+	if (mMultiplexed)
+	{
+		// Classes don't own the multi handle so there is nothing per
+		// class to change.  HttpPolicy reads the class limits it uses
+		// as weights directly.  Connection limits on the shared handle
+		// are only there for servers that don't do HTTP/2, streams are
+		// held to the class budget by HttpPolicy.
+		policy.stallPolicy(policy_class, false);
+		mDirtyPolicy[policy_class] = false;
+
+		check_curl_multi_setopt(mMultiHandles[0],
+								 CURLMOPT_PIPELINING,
+								 long(CURLPIPE_MULTIPLEX));
+		check_curl_multi_setopt(mMultiHandles[0],
+								 CURLMOPT_MAX_HOST_CONNECTIONS,
+								 0L);
+		check_curl_multi_setopt(mMultiHandles[0],
+								 CURLMOPT_MAX_TOTAL_CONNECTIONS,
+								 long(policy.getStreamBudget()));
+		return;
+	}
 	
 	if (! mActiveHandles[policy_class])
 	{
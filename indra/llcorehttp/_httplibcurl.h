@@ -32,7 +32,10 @@
 #include <curl/curl.h>
 #include <curl/multi.h>
 
+#include <map>
 #include <set>
+#include <string>
+#include <vector>
 
 #include "httprequest.h"
 #include "_httpservice.h"
@@ -77,6 +80,24 @@ public:
 	/// Threading:  called by worker thread.
 	HttpService::ELoopSpeed processTransport();
 
+	/// Block until there is socket activity on any active request,
+	/// a libcurl timer expires, @timeout_ms elapses or another
+	/// thread calls wakeup().  Returns immediately if a policy
+	/// class has a dirty update that can now be applied.
+	///
+	/// Threading:  called by worker thread.
+	void poll(long timeout_ms);
+
+	/// Interrupt a current or the next poll() call.  Requires
+	/// libcurl 7.68.0 or later, older versions fall back to
+	/// polling at HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS intervals
+	/// and this does nothing.
+	///
+	/// Threading:  callable by any thread between start() and
+	/// shutdown().  Caller must guarantee that shutdown() isn't
+	/// running concurrently (HttpRequestQueue does this).
+	void wakeup();
+
 	/// Add request to the active list.  Caller is expected to have
 	/// provided us with a reference count on the op to hold the
 	/// request.  (No additional references will be added.)
@@ -86,7 +107,9 @@ public:
 
 	/// One-time call to set the number of policy classes to be
 	/// serviced and to create the resources for each.  Value
-	/// must agree with HttpPolicy::setPolicies() call.
+	/// must agree with HttpPolicy::setPolicies() call.  In
+	/// HTTP/2 mode (HttpRequest::PO_HTTP2), a single multi handle
+	/// is created and shared by all classes.
 	///
 	/// Threading:  called by init thread.
 	void start(int policy_count);
@@ -151,6 +174,22 @@ protected:
 	/// Invoked to cancel an active request, mainly during shutdown
 	/// and destroy.
     void cancelRequest(const opReqPtr_t &op);
+
+	/// Number of distinct multi handles in mMultiHandles and the
+	/// requests active in the one at index i.
+	int getMultiCount() const
+		{
+			return mMultiplexed ? 1 : mPolicyCount;
+		}
+
+	int getActiveCountInMulti(int i) const
+		{
+			return mMultiplexed ? int(mActiveOps.size()) : mActiveHandles[i];
+		}
+
+	/// Maintain the per-host count of requests in flight that
+	/// feeds the HTTPStats peak.
+	void updateHostActive(const opReqPtr_t &op, int delta);
 	
 protected:
     typedef std::set<opReqPtr_t> active_set_t;
@@ -212,9 +251,13 @@ protected:
 	HandleCache			mHandleCache;		// Handle allocator, owner
 	active_set_t		mActiveOps;
 	int					mPolicyCount;
-	CURLM **			mMultiHandles;		// One handle per policy class
+	CURLM **			mMultiHandles;		// One handle per policy class, or all the same one
+	bool				mMultiplexed;		// HTTP/2 mode, mMultiHandles[0] serves every class
 	int *				mActiveHandles;		// Active count per policy class
 	bool *				mDirtyPolicy;		// Dirty policy update waiting for stall (per pc)
+	CURLM *				mPollHandle;		// Empty handle poll() blocks in, target of wakeup()
+	std::vector<curl_waitfd> mPollFds;		// Sockets of the class handles, rebuilt by poll()
+	std::map<std::string, int> mHostActive;	// Requests in flight per host
 	
 }; // end class HttpLibcurl
 
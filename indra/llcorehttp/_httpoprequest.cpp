@@ -763,6 +763,21 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 /******************************/
 		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
 	}
+	if (gpolicy.mHttp2 > 0)
+	{
+		// Shared multi handle.  Wait for a connection that can take
+		// another stream rather than opening a new one and weight the
+		// stream like the class is weighted against the others.
+		const bool cleartext(0 == mReqURL.compare(0, 7, "http://"));
+		long version(CURL_HTTP_VERSION_2TLS);
+		if (cleartext)
+		{
+			version = (gpolicy.mHttp2 > 1) ? CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE : CURL_HTTP_VERSION_1_1;
+		}
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, version);
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_STREAM_WEIGHT, llclamp(cpolicy.mConnectionLimit, 1L, 256L));
+	}
 	// *DEBUG:  Enable following override for timeout handling and "[curl:bugs] #1420" tests
     //if (cpolicy.mPipelining)
     //{
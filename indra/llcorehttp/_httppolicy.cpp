@@ -216,6 +216,15 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 	const HttpTime now(totalTime());
 	HttpService::ELoopSpeed result(HttpService::REQUEST_SLEEP);
 	HttpLibcurl & transport(mService->getTransport());
+
+	// In HTTP/2 mode, classes don't have connections of their
+	// own, they share the stream budget by weight.
+	const bool multiplexed(mGlobalOptions.mHttp2 > 0);
+	int allowance[HTTP_POLICY_CLASS_LIMIT];
+	if (multiplexed)
+	{
+		allotStreams(now, allowance);
+	}
 	
 	for (int policy_class(0); policy_class < mClasses.size(); ++policy_class)
 	{
@@ -252,7 +261,9 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 						 ? (state.mOptions.mPerHostConnectionLimit
 							* state.mOptions.mPipelining)
 						 : state.mOptions.mConnectionLimit);
-		int needed(active_limit - active);		// Expect negatives here
+		int needed(multiplexed
+				   ? allowance[policy_class]
+				   : active_limit - active);		// Expect negatives here
 
 		if (needed > 0)
 		{
@@ -330,6 +341,132 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 	return result;
 }
 
+
+// Mirrors the tests in processReadyQueue().  Classes that are
+// stalled or at their connection limit are waiting on active
+// requests and those are the transport's business.
+HttpTime HttpPolicy::getNextReadyTime(HttpTime now, HttpTime max_wait) const
+{
+	HttpTime result(now + max_wait);
+	HttpLibcurl & transport(mService->getTransport());
+
+	for (int policy_class(0); policy_class < mClasses.size(); ++policy_class)
+	{
+		const ClassState & state(*mClasses[policy_class]);
+		const HttpRetryQueue & retryq(state.mRetryQueue);
+		const HttpReadyQueue & readyq(state.mReadyQueue);
+
+		if (state.mStallStaging || (retryq.empty() && readyq.empty()))
+		{
+			continue;
+		}
+
+		const bool throttle_enabled(state.mOptions.mThrottleRate > 0L);
+		if (throttle_enabled && now < state.mThrottleEnd && state.mThrottleLeft <= 0)
+		{
+			result = (std::min)(result, state.mThrottleEnd);
+			continue;
+		}
+
+		if (mGlobalOptions.mHttp2 > 0)
+		{
+			if (transport.getActiveCount() >= getStreamBudget())
+			{
+				continue;
+			}
+		}
+		else
+		{
+			int active(transport.getActiveCountInClass(policy_class));
+			int active_limit(state.mOptions.mPipelining > 1L
+							 ? (state.mOptions.mPerHostConnectionLimit
+								* state.mOptions.mPipelining)
+							 : state.mOptions.mConnectionLimit);
+			if (active >= active_limit)
+			{
+				continue;
+			}
+		}
+
+		if (! readyq.empty())
+		{
+			return now;
+		}
+		result = (std::min)(result, retryq.top()->mPolicyRetryAt);
+	}
+
+	return (std::max)(result, now);
+}
+
+
+int HttpPolicy::getStreamBudget() const
+{
+	int budget(0);
+	for (int policy_class(0); policy_class < mClasses.size(); ++policy_class)
+	{
+		budget += mClasses[policy_class]->mOptions.mConnectionLimit;
+	}
+	return budget;
+}
+
+
+// Each free stream goes to the class with the fewest active plus
+// allotted requests per unit of weight.  Busy classes end up sharing
+// in proportion to their weights and the share of a class with
+// nothing to do goes to the ones that can use it.  Retries that
+// aren't due yet count as demand, so a class can be allotted a
+// little more than it will use in this pass.
+void HttpPolicy::allotStreams(HttpTime now, int * allowance) const
+{
+	HttpLibcurl & transport(mService->getTransport());
+	const int class_count(mClasses.size());
+	int demand[HTTP_POLICY_CLASS_LIMIT];
+	int load[HTTP_POLICY_CLASS_LIMIT];
+
+	for (int policy_class(0); policy_class < class_count; ++policy_class)
+	{
+		const ClassState & state(*mClasses[policy_class]);
+		const bool throttle_enabled(state.mOptions.mThrottleRate > 0L);
+		const bool throttled(throttle_enabled
+							 && now < state.mThrottleEnd
+							 && state.mThrottleLeft <= 0);
+
+		allowance[policy_class] = 0;
+		load[policy_class] = transport.getActiveCountInClass(policy_class);
+		demand[policy_class] = (state.mStallStaging || throttled)
+			? 0
+			: int(state.mReadyQueue.size() + state.mRetryQueue.size());
+	}
+
+	int free(getStreamBudget() - transport.getActiveCount());
+	while (free > 0)
+	{
+		int best(-1);
+		for (int policy_class(0); policy_class < class_count; ++policy_class)
+		{
+			if (allowance[policy_class] >= demand[policy_class])
+			{
+				continue;
+			}
+			// load / weight < best load / best weight
+			if (best < 0
+				|| (long(load[policy_class]) * mClasses[best]->mOptions.mConnectionLimit
+					< long(load[best]) * mClasses[policy_class]->mOptions.mConnectionLimit))
+			{
+				best = policy_class;
+			}
+		}
+		if (best < 0)
+		{
+			break;
+		}
+		++allowance[best];
+		++load[best];
+		--free;
+	}
+}
+
+
 bool HttpPolicy::cancel(HttpHandle handle)
 {
 	for (int policy_class(0); policy_class < mClasses.size(); ++policy_class)
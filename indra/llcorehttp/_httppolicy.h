@@ -89,6 +89,17 @@ public:
 	/// Threading:  called by worker thread
 	HttpService::ELoopSpeed processReadyQueue();
 
+	/// Time at which processReadyQueue() will next be able to
+	/// make progress without any request completing first:  a
+	/// free connection slot with requests ready to go, the retry
+	/// at the head of a retry queue coming due or a throttle
+	/// window ending.
+	///
+	/// @return			A time in [now, now + max_wait].
+	///
+	/// Threading:  called by worker thread
+	HttpTime getNextReadyTime(HttpTime now, HttpTime max_wait) const;
+
 	/// Add request to a ready queue.  Caller is expected to have
 	/// provided us with a reference count to hold the request.  (No
 	/// additional references will be added.)
@@ -161,10 +172,22 @@ public:
 	///
 	/// Threading:  called by worker thread
 	bool stallPolicy(HttpRequest::policy_t policy_class, bool stall);
+
+	/// In HTTP/2 mode, the number of requests allowed in flight
+	/// over all classes:  the sum of the classes' connection
+	/// limits, which also serve as their weights.
+	///
+	/// Threading:  called by worker thread
+	int getStreamBudget() const;
 	
 protected:
 	struct ClassState;
 	typedef std::vector<ClassState *>	class_list_t;
+
+	/// HTTP/2 mode.  Divide the free part of the stream budget
+	/// among the classes that have requests to issue, giving
+	/// each class's count in @allowance.
+	void allotStreams(HttpTime now, int * allowance) const;
 	
 	HttpPolicyGlobal					mGlobalOptions;
 	class_list_t						mClasses;
@@ -36,7 +36,8 @@ namespace LLCore
 HttpPolicyGlobal::HttpPolicyGlobal()
 	: mConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
 	  mTrace(HTTP_TRACE_OFF),
-	  mUseLLProxy(0)
+	  mUseLLProxy(0),
+	  mHttp2(HTTP_HTTP2_DEFAULT)
 {}
 
 
@@ -54,6 +55,7 @@ HttpPolicyGlobal & HttpPolicyGlobal::operator=(const HttpPolicyGlobal & other)
 		mHttpProxy = other.mHttpProxy;
 		mTrace = other.mTrace;
 		mUseLLProxy = other.mUseLLProxy;
+		mHttp2 = other.mHttp2;
 	}
 	return *this;
 }
@@ -75,6 +77,10 @@ HttpStatus HttpPolicyGlobal::set(HttpRequest::EPolicyOption opt, long value)
 		mUseLLProxy = llclamp(value, 0L, 1L);
 		break;
 
+	case HttpRequest::PO_HTTP2:
+		mHttp2 = llclamp(value, 0L, HTTP_HTTP2_MAX);
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -140,6 +146,10 @@ HttpStatus HttpPolicyGlobal::get(HttpRequest::EPolicyOption opt, long * value) c
 		*value = mUseLLProxy;
 		break;
 
+	case HttpRequest::PO_HTTP2:
+		*value = mHttp2;
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -81,6 +81,10 @@ HttpStatus HttpRequestQueue::addOp(const HttpRequestQueue::opPtr_t &op)
 		}
 		wake = mQueue.empty();
 		mQueue.push_back(op);
+		if (wake && mWakeup)
+		{
+			mWakeup();
+		}
 	}
 	if (wake)
 	{
@@ -147,6 +151,10 @@ bool HttpRequestQueue::stopQueue()
 	{
 		HttpScopedLock lock(mQueueMutex);
 
+        if (mWakeup)
+        {
+            mWakeup();
+        }
         if (!mQueueStopped)
         {
             mQueueStopped = true;
@@ -159,4 +167,12 @@ bool HttpRequestQueue::stopQueue()
 }
 
 
+void HttpRequestQueue::setWakeup(const wakeup_t & wakeup)
+{
+	HttpScopedLock lock(mQueueMutex);
+
+	mWakeup = wakeup;
+}
+
+
 } // end namespace LLCore
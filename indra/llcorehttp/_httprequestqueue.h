@@ -30,6 +30,8 @@
 
 #include <vector>
 
+#include <boost/function.hpp>
+
 #include "httpcommon.h"
 #include "_refcounted.h"
 #include "_mutex.h"
@@ -74,6 +76,7 @@ public:
 	
 public:
     typedef std::vector<opPtr_t> OpContainer;
+	typedef boost::function<void()> wakeup_t;
 
 	/// Insert an object at the back of the request queue.
 	///
@@ -125,6 +128,15 @@ public:
 	///
 	/// Threading:  callable by any thread.
 	bool stopQueue();
+
+	/// Install a function to be called, under the queue lock, when
+	/// the queue goes non-empty or is stopped.  Used to interrupt
+	/// the service thread when it is waiting on something other
+	/// than the queue's condition variable.  Pass an empty function
+	/// to remove it; once this returns, it will not be called again.
+	///
+	/// Threading:  callable by any thread.
+	void setWakeup(const wakeup_t & wakeup);
 	
 protected:
 	static HttpRequestQueue *			sInstance;
@@ -134,6 +146,7 @@ protected:
 	LLCoreInt::HttpMutex				mQueueMutex;
 	LLCoreInt::HttpConditionVariable	mQueueCV;
 	bool								mQueueStopped;
+	wakeup_t							mWakeup;
 	
 }; // end class HttpRequestQueue
 
@@ -63,7 +63,8 @@ const HttpService::OptionDescriptor HttpService::sOptionDesc[] =
 	{	true,		true,		true,		false,		false	},		// PO_TRACE
 	{	true,		true,		false,		true,		false	},		// PO_ENABLE_PIPELINING
 	{	true,		true,		false,		true,		false	},		// PO_THROTTLE_RATE
-	{   false,		false,		true,		false,		true	}		// PO_SSL_VERIFY_CALLBACK
+	{   false,		false,		true,		false,		true	},		// PO_SSL_VERIFY_CALLBACK
+	{	true,		false,		true,		false,		false	}		// PO_HTTP2
 };
 HttpService * HttpService::sInstance(NULL);
 volatile HttpService::EState HttpService::sState(NOT_INITIALIZED);
@@ -211,6 +212,7 @@ void HttpService::startThread()
 	// Push current policy definitions, enable policy & transport components
 	mPolicy->start();
 	mTransport->start(mLastPolicy + 1);
+	mRequestQueue->setWakeup(boost::bind(&HttpLibcurl::wakeup, mTransport));
 
 	mThread = new LLCoreInt::HttpThread(boost::bind(&HttpService::threadRun, this, _1));
 	sState = RUNNING;
@@ -268,6 +270,9 @@ void HttpService::shutdown()
     }
     ops.clear();
 
+	// No more wakeups, the poll handle is going away
+	mRequestQueue->setWakeup(HttpRequestQueue::wakeup_t());
+
 	// Shutdown transport canceling requests, freeing resources
 	mTransport->shutdown();
 
@@ -305,10 +310,15 @@ void HttpService::threadRun(LLCoreInt::HttpThread * thread)
 		    new_loop = mTransport->processTransport();
 		    loop = (std::min)(loop, new_loop);
 		
-		    // Determine whether to spin, sleep briefly or sleep for next request
+		    // Determine whether to wait in libcurl or sleep for next request
 		    if (REQUEST_SLEEP != loop)
 		    {
-			    ms_sleep(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+			    // Wait for socket activity, a libcurl timer, the next
+			    // retry or throttle deadline, or a wakeup from another
+			    // thread adding to the request queue.
+			    const HttpTime now(totalTime());
+			    const HttpTime ready_at(mPolicy->getNextReadyTime(now, HTTP_SERVICE_LOOP_POLL_MAX_MS * 1000));
+			    mTransport->poll(long((ready_at - now + 999) / 1000));
 		    }
         }
         catch (const LLContinueError&)
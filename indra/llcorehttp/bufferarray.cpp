@@ -304,6 +304,20 @@ int BufferArray::findBlock(size_t pos, size_t * ret_offset)
 }
 
 
+void BufferArray::getSpans(span_list_t & spans) const
+{
+	spans.clear();
+	spans.reserve(mBlocks.size());
+	for (const Block * block : mBlocks)
+	{
+		if (block->mUsed)
+		{
+			spans.push_back(span_t(&block->mData[0], block->mUsed));
+		}
+	}
+}
+
+
 bool BufferArray::getBlockStartEnd(int block, const char ** start, const char ** end)
 {
 	if (block < 0 || block >= mBlocks.size())
@@ -29,6 +29,7 @@
 
 
 #include <cstdlib>
+#include <utility>
 #include <vector>
 #include "boost/intrusive_ptr.hpp"
 
@@ -120,6 +121,15 @@ public:
 	/// append data when current position is equal to the
 	/// size of the instance or do a mix of both.
 	size_t write(size_t pos, const void * src, size_t len);
+
+	/// Describes the used part of each block in order, without
+	/// copying anything, so that a parser can walk the data in
+	/// place.  The pointers stay valid until the instance is
+	/// modified or released.
+	typedef std::pair<const char *, size_t> span_t;
+	typedef std::vector<span_t> span_list_t;
+
+	void getSpans(span_list_t & spans) const;
 	
 protected:
 	int findBlock(size_t pos, size_t * ret_offset);
@@ -232,6 +232,23 @@ public:
 		/// Global only
 		PO_SSL_VERIFY_CALLBACK,
 
+		/// Long value selecting the HTTP/2 transport mode.  When
+		/// non-zero, all policy classes share a single libcurl multi
+		/// handle and requests to the same host are multiplexed as
+		/// streams on one connection where the server allows it.
+		/// Policy classes then no longer own connections.  Their
+		/// PO_CONNECTION_LIMIT values become relative weights
+		/// dividing a stream budget equal to the sum of those
+		/// limits, and PO_PIPELINING_DEPTH is ignored.
+		/// 0 - HTTP/1.1 with a connection pool per class (default)
+		/// 1 - HTTP/2 negotiated over TLS, cleartext stays HTTP/1.1
+		/// 2 - As 1 but also HTTP/2 with prior knowledge (h2c) on
+		///     cleartext URLs.  Only for servers known to speak it,
+		///     mainly local test servers.
+		///
+		/// Global only
+		PO_HTTP2,
+
 		PO_LAST  // Always at end
 	};
 
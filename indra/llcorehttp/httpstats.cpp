@@ -45,6 +45,9 @@ void HTTPStats::resetStats()
     mDataDown.reset();
     mDataUp.reset();
     mRequests = 0;
+
+    LLMutexLock lock(&mHostMutex);
+    mHosts.clear();
 }
 
 
@@ -61,6 +64,36 @@ void HTTPStats::recordResultCode(S32 code)
 
 }
 
+void HTTPStats::recordHostActive(const std::string & host, U32 active)
+{
+    LLMutexLock lock(&mHostMutex);
+
+    HostStats & stats(mHosts[host]);
+    stats.mPeakActive = llmax(stats.mPeakActive, active);
+}
+
+void HTTPStats::recordHostCompletion(const std::string & host, bool new_connection, bool http2)
+{
+    LLMutexLock lock(&mHostMutex);
+
+    HostStats & stats(mHosts[host]);
+    ++stats.mRequests;
+    if (new_connection)
+        ++stats.mNewConnections;
+    else
+        ++stats.mReusedConnections;
+    if (http2)
+        ++stats.mHttp2Streams;
+}
+
+HTTPStats::HostStats HTTPStats::getHostStats(const std::string & host)
+{
+    LLMutexLock lock(&mHostMutex);
+
+    std::map<std::string, HostStats>::const_iterator it(mHosts.find(host));
+    return (it != mHosts.end()) ? it->second : HostStats();
+}
+
 namespace
 {
     std::string byte_count_converter(F32 bytes)
@@ -101,6 +134,19 @@ void HTTPStats::dumpStats()
         out << (*it).first << " " << (*it).second << std::endl;
     }
 
+    out << std::endl;
+    out << "Hosts (requests, new connections, reused connections, HTTP/2 streams, peak active):" << std::endl;
+    {
+        LLMutexLock lock(&mHostMutex);
+        for (std::map<std::string, HostStats>::const_iterator it = mHosts.begin(); it != mHosts.end(); ++it)
+        {
+            const HostStats & stats((*it).second);
+            out << (*it).first << " " << stats.mRequests << " " << stats.mNewConnections
+                << " " << stats.mReusedConnections << " " << stats.mHttp2Streams
+                << " " << stats.mPeakActive << std::endl;
+        }
+    }
+
     LL_WARNS("HTTPCore") << out.str() << LL_ENDL;
 }
 
@@ -32,6 +32,7 @@
 #include "llstatsaccumulator.h"
 #include "llsingleton.h"
 #include "llsd.h"
+#include "llmutex.h"
 
 namespace LLCore
 {
@@ -59,6 +60,23 @@ namespace LLCore
 
         void    recordResultCode(S32 code);
 
+        /// Per-host transport counters.  Hosts are keyed as
+        /// "host:port" (the port is omitted when the URL has none).
+        struct HostStats
+        {
+            U32     mRequests = 0;          // Completed requests
+            U32     mNewConnections = 0;    // Requests that opened a connection
+            U32     mReusedConnections = 0; // Requests sent on an existing connection
+            U32     mHttp2Streams = 0;      // Requests carried as HTTP/2 streams
+            U32     mPeakActive = 0;        // Most requests in flight at once
+        };
+
+        /// Recorded by the service thread.
+        void    recordHostActive(const std::string & host, U32 active);
+        void    recordHostCompletion(const std::string & host, bool new_connection, bool http2);
+
+        HostStats getHostStats(const std::string & host);
+
         void    dumpStats();
     private:
         StatsAccumulator mDataDown;
@@ -67,6 +85,9 @@ namespace LLCore
         S32              mRequests;
 
         std::map<S32, S32> mResutCodes;
+
+        LLMutex          mHostMutex;
+        std::map<std::string, HostStats> mHosts;
     };
 
 
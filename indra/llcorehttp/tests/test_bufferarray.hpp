@@ -374,6 +374,42 @@ void BufferArrayTestObjectType::test<8>()
 	ba->release();
 }
 
+template <> template <>
+void BufferArrayTestObjectType::test<9>()
+{
+	set_test_name("BufferArray getSpans");
+
+	// create a new ref counted object with an implicit reference
+	BufferArray * ba = new BufferArray();
+
+	BufferArray::span_list_t spans;
+	ba->getSpans(spans);
+	ensure("Empty BufferArray has no spans", spans.empty());
+
+	// Span a block boundary and leave an empty block in the middle
+	std::string data(BufferArray::BLOCK_ALLOC_SIZE + 100, 'a');
+	for (size_t i(0); i < data.size(); ++i)
+	{
+		data[i] = char('a' + i % 26);
+	}
+	ba->append(data.data(), BufferArray::BLOCK_ALLOC_SIZE - 10);
+	ba->appendBufferAlloc(0);
+	ba->append(data.data() + BufferArray::BLOCK_ALLOC_SIZE - 10, 110);
+
+	ba->getSpans(spans);
+	ensure("More than one span", spans.size() > 1);
+	std::string gathered;
+	for (size_t i(0); i < spans.size(); ++i)
+	{
+		ensure("No empty spans", spans[i].second > 0);
+		gathered.append(spans[i].first, spans[i].second);
+	}
+	ensure_equals("Spans cover the data in order", gathered, data);
+
+	// release the implicit reference, causing the object to be released
+	ba->release();
+}
+
 }  // end namespace tut
 
 
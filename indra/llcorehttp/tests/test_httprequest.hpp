@@ -32,11 +32,15 @@
 #include "httpheaders.h"
 #include "httpresponse.h"
 #include "httpoptions.h"
+#include "httpstats.h"
 #include "_httpservice.h"
 #include "_httprequestqueue.h"
 
 #include <curl/curl.h>
 #include <boost/regex.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <sstream>
 
 #include "llcorehttp_test.h"
@@ -185,6 +189,15 @@ public:
 	regex_container_t mHeadersDisallowed;
 };
 
+// Run 'count' concurrent GETs of 'url' spread over two policy
+// classes with the transport in HTTP/2 mode 'mode' and return
+// the per-host statistics gathered for the URL's host.
+HTTPStats::HostStats run_http2_gets(HttpRequestTestData * data,
+									long mode,
+									const std::string & url,
+									const std::string & host,
+									int count);
+
 typedef test_group<HttpRequestTestData> HttpRequestTestGroupType;
 typedef HttpRequestTestGroupType::object HttpRequestTestObjectType;
 HttpRequestTestGroupType HttpRequestTestGroup("HttpRequest Tests");
@@ -3036,6 +3049,249 @@ void HttpRequestTestObjectType::test<23>()
 }
 
 
+template <> template <>
+void HttpRequestTestObjectType::test<24>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest GET round-trip latency");
+
+	// Benchmark rather than a pass/fail test.  Requests are issued
+	// one at a time so every one of them finds the service thread
+	// idle in its wait and measures the wakeup-to-completion path.
+	// Timings are reported, only completion is checked.
+	TestHandler2 handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	std::string url_base(get_base_url());
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+		HttpRequest::createService();
+		HttpRequest::startThread();
+
+		req = new HttpRequest();
+
+		mStatus = HttpStatus(200);
+		const int request_count(50);
+		std::vector<double> latencies;
+		latencies.reserve(request_count);
+		for (int i(0); i < request_count; ++i)
+		{
+			const int calls(mHandlerCalls);
+			const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+			HttpHandle handle = req->requestGetByteRange(HttpRequest::DEFAULT_POLICY_ID,
+														 url_base,
+														 0,
+														 0,
+														 HttpOptions::ptr_t(),
+														 HttpHeaders::ptr_t(),
+														 handlerp);
+			ensure("Valid handle returned for get request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+			// Pump hard so that the measurement is dominated by the
+			// service thread and not by this loop.
+			int count(0);
+			int limit(LOOP_COUNT_SHORT * 100);
+			while (count++ < limit && mHandlerCalls == calls)
+			{
+				req->update(0);
+				usleep(LOOP_SLEEP_INTERVAL / 100);
+			}
+			ensure("Request executed in reasonable time", count < limit);
+			latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		ensure("One handler invocation for each request", mHandlerCalls == request_count);
+
+		std::sort(latencies.begin(), latencies.end());
+		std::cout << "\nHttpRequest GET latency over " << request_count << " requests:  "
+				  << "median " << latencies[request_count / 2] << " ms, "
+				  << "90th percentile " << latencies[request_count * 9 / 10] << " ms, "
+				  << "max " << latencies.back() << " ms" << std::endl;
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		mHandlerCalls = 0;
+		HttpHandle handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+		int count(0);
+		int limit(LOOP_COUNT_SHORT);
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		delete req;
+		req = NULL;
+
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+
+template <> template <>
+void HttpRequestTestObjectType::test<25>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest HTTP/2 mode with HTTP/1.1 server");
+
+	// The test server only speaks HTTP/1.x without keep-alive.  In
+	// HTTP/2 mode, cleartext requests stay on HTTP/1.1 so everything
+	// must still complete through the shared multi handle with each
+	// request on its own connection.
+	const int request_count(20);
+	const std::string url(get_base_url());
+	const std::string host(url.substr(7, url.size() - 8));
+	HTTPStats::HostStats stats(run_http2_gets(this, 1L, url, host, request_count));
+
+	ensure_equals("All requests counted for host", stats.mRequests, U32(request_count));
+	ensure_equals("No HTTP/2 streams", stats.mHttp2Streams, U32(0));
+	ensure_equals("Connection per request", stats.mNewConnections, U32(request_count));
+	ensure("Requests ran concurrently", stats.mPeakActive > 1);
+}
+
+template <> template <>
+void HttpRequestTestObjectType::test<26>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest HTTP/2 multiplexing with h2c server");
+
+	// Needs a cleartext HTTP/2 server answering GETs with 200, e.g.
+	// 'nghttpd --no-tls 8080' or 'h2o' serving a directory.  Point
+	// LL_TEST_H2C_URL at it:  http://localhost:8080/
+	const char * env(getenv("LL_TEST_H2C_URL"));
+	if (! env)
+	{
+		skip("LL_TEST_H2C_URL not set");
+	}
+
+	const int request_count(20);
+	const std::string url(env);
+	const std::string::size_type host_end(url.find('/', 7));
+	const std::string host(url.substr(7, host_end == std::string::npos ? std::string::npos : host_end - 7));
+	HTTPStats::HostStats stats(run_http2_gets(this, 2L, url, host, request_count));
+
+	std::cout << "\nh2c host " << host << ":  " << stats.mRequests << " requests, "
+			  << stats.mNewConnections << " connections, "
+			  << stats.mHttp2Streams << " HTTP/2 streams, "
+			  << stats.mPeakActive << " peak active" << std::endl;
+	ensure_equals("All requests counted for host", stats.mRequests, U32(request_count));
+	ensure_equals("All requests were HTTP/2 streams", stats.mHttp2Streams, U32(request_count));
+	ensure_equals("All streams on one connection", stats.mNewConnections, U32(1));
+	ensure("Streams ran concurrently", stats.mPeakActive > 1);
+}
+
+
+HTTPStats::HostStats run_http2_gets(HttpRequestTestData * data,
+									long mode,
+									const std::string & url,
+									const std::string & host,
+									int count)
+{
+	TestHandler2 handler(data, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	data->mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+		HttpRequest::createService();
+
+		HttpStatus status(HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2,
+															  HttpRequest::GLOBAL_POLICY_ID,
+															  mode, NULL));
+		ensure("HTTP/2 mode accepted", bool(status));
+		HttpRequest::policy_t second_class(HttpRequest::createPolicyClass());
+		ensure("Second policy class created", second_class != HttpRequest::INVALID_POLICY_ID);
+
+		HttpRequest::startThread();
+		HTTPStats::instance().resetStats();
+
+		req = new HttpRequest();
+
+		data->mStatus = HttpStatus(200);
+		for (int i(0); i < count; ++i)
+		{
+			HttpHandle handle = req->requestGet((i & 1) ? second_class : HttpRequest::DEFAULT_POLICY_ID,
+												url,
+												HttpOptions::ptr_t(),
+												HttpHeaders::ptr_t(),
+												handlerp);
+			ensure("Valid handle returned for get request", handle != LLCORE_HTTP_HANDLE_INVALID);
+		}
+
+		int loop_count(0);
+		int limit(LOOP_COUNT_SHORT);
+		while (loop_count++ < limit && data->mHandlerCalls < count)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", loop_count < limit);
+		ensure("One handler invocation for each request", data->mHandlerCalls == count);
+
+		// Okay, request a shutdown of the servicing thread
+		data->mStatus = HttpStatus();
+		data->mHandlerCalls = 0;
+		HttpHandle handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+		loop_count = 0;
+		while (loop_count++ < limit && data->mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", loop_count < limit);
+
+		loop_count = 0;
+		while (loop_count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		delete req;
+		req = NULL;
+
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+
+	return HTTPStats::instance().getHostStats(host);
+}
+
+
 }  // end namespace tut
 
 namespace
@@ -42,6 +42,9 @@
 // <FS:Ansariel> Optimize asset simple disk cache
 static const char* subdirs = "0123456789abcdef";
 
+// Base name of the pack and journal files used in pack file mode
+static const std::string PACK_BASE_NAME("asset_pack");
+
 LLDiskCache::LLDiskCache(const std::string cache_dir,
                          const uintmax_t max_size_bytes,
                          const bool enable_cache_debug_info
@@ -49,6 +52,7 @@ LLDiskCache::LLDiskCache(const std::string cache_dir,
                          ,const F32 highwater_mark_percent
                          ,const F32 lowwater_mark_percent
 // </FS:Beq>
+                         ,const bool use_pack_file
                          ) :
     mCacheDir(cache_dir),
     mMaxSizeBytes(max_size_bytes),
@@ -65,6 +69,29 @@ LLDiskCache::LLDiskCache(const std::string cache_dir,
         LLFile::mkdir(dirname);
     }
     // </FS:Ansariel>
+
+    if (use_pack_file)
+    {
+        mPack = std::make_unique<LLDiskPack>(cache_dir + gDirUtilp->getDirDelimiter() + PACK_BASE_NAME);
+        bool created = false;
+        if (!mPack->open(created))
+        {
+            LL_WARNS("LLDiskCache") << "Falling back to one file per asset" << LL_ENDL;
+            mPack.reset();
+        }
+        else if (created)
+        {
+            // Switching from loose files: they would never be purged again
+            removeCacheFiles();
+        }
+    }
+    else
+    {
+        // Switching back from the pack file: drop it, it cannot be read
+        // in this mode and would never be purged either.
+        LLDiskPack::deleteFiles(cache_dir + gDirUtilp->getDirDelimiter() + PACK_BASE_NAME);
+    }
+
     // <FS:Beq> add static assets into the new cache after clear.
     // Only missing entries are copied on init, skiplist is setup
     // For everything we populate FS specific assets to allow future updates
@@ -102,6 +129,30 @@ LLDiskCache::LLDiskCache(const std::string cache_dir,
 // asset will have to be re-requested.
 void LLDiskCache::purge()
 {
+    if (mPack)
+    {
+        // The pack keeps its own LRU index, no need to walk the directory
+        auto start_time = std::chrono::high_resolution_clock::now();
+        const uintmax_t used_before = mPack->getUsedBytes();
+        const U32 evicted = mPack->purge((uintmax_t)(mMaxSizeBytes * (mHighPercent / 100)),
+                                         (uintmax_t)(mMaxSizeBytes * (mLowPercent / 100)));
+        if (evicted)
+        {
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+            LL_INFOS("LLDiskCache") << "Pack purge evicted " << evicted << " entries, " << (used_before - mPack->getUsedBytes())
+                                    << " bytes in " << execute_time << " ms" << LL_ENDL;
+        }
+        const U64 released = mPack->compact();
+        if (released)
+        {
+            LL_INFOS("LLDiskCache") << "Pack compaction released " << released << " bytes" << LL_ENDL;
+        }
+        updateCacheSize(mPack->getUsedBytes());
+        mPack->checkpoint();
+        return;
+    }
+
     if (mEnableCacheDebugInfo)
     {
         LL_INFOS() << "Total dir size before purge is " << dirFileSize(mCacheDir) << LL_ENDL;
@@ -484,7 +535,8 @@ const std::string LLDiskCache::getCacheInfo()
     std::ostringstream cache_info;
 
     F32 max_in_mb = (F32)mMaxSizeBytes / (1024.0 * 1024.0);
-    F32 percent_used = ((F32)dirFileSize(mCacheDir) / (F32)mMaxSizeBytes) * 100.0;
+    const uintmax_t used_bytes = mPack ? mPack->getUsedBytes() : dirFileSize(mCacheDir);
+    F32 percent_used = ((F32)used_bytes / (F32)mMaxSizeBytes) * 100.0;
 
     cache_info << std::fixed;
     cache_info << std::setprecision(1);
@@ -494,6 +546,47 @@ const std::string LLDiskCache::getCacheInfo()
     return cache_info.str();
 }
 
+void LLDiskCache::addStaticAssetToPack(const std::string& from_asset_file, const std::string& uuid_as_string)
+{
+    // Static assets are named UUID.asset_type, the pack is keyed by both
+    LLUUID asset_id(uuid_as_string);
+    LLAssetType::EType asset_type = LLAssetType::lookup(gDirUtilp->getExtension(from_asset_file));
+    if (asset_id.isNull() || asset_type == LLAssetType::AT_NONE)
+    {
+        LL_WARNS("LLDiskCache") << "Ignoring static asset with unexpected name " << from_asset_file << LL_ENDL;
+        return;
+    }
+
+    if (!mPack->exists(asset_id, asset_type))
+    {
+        if (mEnableCacheDebugInfo)
+        {
+            LL_INFOS("LLDiskCache") << "Adding static asset " << from_asset_file << " to asset pack" << LL_ENDL;
+        }
+        std::vector<U8> data;
+        LLFILE* file = LLFile::fopen(from_asset_file, "rb");
+        if (file)
+        {
+            if (fseek(file, 0, SEEK_END) == 0)
+            {
+                long size = ftell(file);
+                if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+                {
+                    data.resize(size);
+                    data.resize(fread(data.data(), 1, size, file));
+                }
+            }
+            fclose(file);
+        }
+        if (data.empty() || !mPack->write(asset_id, asset_type, 0, data.data(), (S32)data.size(), true))
+        {
+            LL_WARNS("LLDiskCache") << "Failed to add static asset " << from_asset_file << " to asset pack" << LL_ENDL;
+            return;
+        }
+    }
+    mPack->setPinned(asset_id, asset_type, true);
+}
+
 // <FS:Beq> Copy static items into cache and add to the skip list that prevents their purging
 // Note that there is no de-duplication nor other validation of the list.
 void LLDiskCache::prepopulateCacheWithStatic()
@@ -516,6 +609,11 @@ void LLDiskCache::prepopulateCacheWithStatic()
                 from_asset_file = from_folder + gDirUtilp->getDirDelimiter() + from_asset_file;
                 // we store static assets as UUID.asset_type the asset_type is not used in the current simple cache format
                 auto uuid_as_string{ gDirUtilp->getBaseFileName(from_asset_file, true) };
+                if (mPack)
+                {
+                    addStaticAssetToPack(from_asset_file, uuid_as_string);
+                    continue;
+                }
                 auto to_asset_file = metaDataToFilepath(uuid_as_string, LLAssetType::AT_UNKNOWN, std::string());
                 if (!gDirUtilp->fileExists(to_asset_file))
                 {
@@ -545,6 +643,26 @@ void LLDiskCache::prepopulateCacheWithStatic()
 void LLDiskCache::clearCache()
 {
     LL_INFOS() << "clearing cache " << mCacheDir << LL_ENDL;
+    bool cleared = true;
+    if (mPack)
+    {
+        mPack->clear();
+    }
+    else
+    {
+        cleared = removeCacheFiles();
+    }
+    if (cleared)
+    {
+        // <FS:Beq> add static assets into the new cache after clear
+        LL_INFOS() << "prepopulating new cache " << LL_ENDL;
+        prepopulateCacheWithStatic();
+    }
+    LL_INFOS() << "Cleared cache " << mCacheDir << LL_ENDL;
+}
+
+bool LLDiskCache::removeCacheFiles()
+{
     /**
      * See notes on performance in dirFileSize(..) - there may be
      * a quicker way to do this by operating on the parent dir vs
@@ -557,33 +675,32 @@ void LLDiskCache::clearCache()
 #else
     std::string cache_path(mCacheDir);
 #endif
-    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
+    if (!boost::filesystem::is_directory(cache_path, ec) || ec.failed())
     {
-        // <FS:Ansariel> Optimize asset simple disk cache
-        //boost::filesystem::directory_iterator iter(cache_path, ec);
-        //while (iter != boost::filesystem::directory_iterator() && !ec.failed())
-        boost::filesystem::recursive_directory_iterator iter(cache_path, ec);
-        while (iter != boost::filesystem::recursive_directory_iterator() && !ec.failed())
-        // </FS:Ansariel>
+        return false;
+    }
+
+    // <FS:Ansariel> Optimize asset simple disk cache
+    //boost::filesystem::directory_iterator iter(cache_path, ec);
+    //while (iter != boost::filesystem::directory_iterator() && !ec.failed())
+    boost::filesystem::recursive_directory_iterator iter(cache_path, ec);
+    while (iter != boost::filesystem::recursive_directory_iterator() && !ec.failed())
+    // </FS:Ansariel>
+    {
+        if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
         {
-            if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
+            if ((*iter).path().string().find(mCacheFilenamePrefix) != std::string::npos)
             {
-                if ((*iter).path().string().find(mCacheFilenamePrefix) != std::string::npos)
+                boost::filesystem::remove(*iter, ec);
+                if (ec.failed())
                 {
-                    boost::filesystem::remove(*iter, ec);
-                    if (ec.failed())
-                    {
-                        LL_WARNS() << "Failed to delete cache file " << *iter << ": " << ec.message() << LL_ENDL;
-                    }
+                    LL_WARNS() << "Failed to delete cache file " << *iter << ": " << ec.message() << LL_ENDL;
                 }
             }
-            iter.increment(ec);
         }
-        // <FS:Beq> add static assets into the new cache after clear
-    LL_INFOS() << "prepopulating new cache " << LL_ENDL;
-        prepopulateCacheWithStatic();
+        iter.increment(ec);
     }
-    LL_INFOS() << "Cleared cache " << mCacheDir << LL_ENDL;
+    return true;
 }
 
 void LLDiskCache::removeOldVFSFiles()
@@ -36,6 +36,9 @@
  *    the same sized directory of files, writing the last updated
  *    time to each took less than 600ms indicating that this
  *    important part of the mechanism has almost no overhead.
+ * 6/ Optionally, all of the above can be replaced by a single
+ *    indexed pack file (LLDiskPack) which avoids one inode per
+ *    asset and purges without scanning the directory at all.
  *
  * $LicenseInfo:firstyear=2009&license=viewerlgpl$
  * Second Life Viewer Source Code
@@ -63,6 +66,7 @@
 #define _LLDISKCACHE
 
 #include "llsingleton.h"
+#include "lldiskpack.h"
 #include <chrono>
 using namespace std::chrono;
 
@@ -104,8 +108,14 @@ class LLDiskCache :
                     /**
                      * A floating point percentage of the max_size_bytes which the cache purge will aim to reach once triggered.
                      */
-                    const F32 lowwater_mark_percent
+                    const F32 lowwater_mark_percent,
                     // </FS:Beq>
+                    /**
+                     * Store assets in a single indexed pack file (see
+                     * lldiskpack.h) instead of one file per asset. Based
+                     * on the setting at 'FSDiskCacheUsePackFile'
+                     */
+                    const bool use_pack_file
                     );
 
         virtual ~LLDiskCache() = default;
@@ -176,7 +186,28 @@ class LLDiskCache :
         void setLowWaterPercentage(F32 LowPct) { mLowPercent = llclamp(LowPct, 0.0, mHighPercent);  };
         // </FS:Beq>
 
+        /**
+         * Returns the pack file store when the cache runs in pack file
+         * mode, nullptr when assets are stored one file per asset.
+         * LLFileSystem routes all of its operations through the pack
+         * when it is available.
+         */
+        LLDiskPack* getPack() const { return mPack.get(); }
+
     private:
+        /**
+         * Remove every loose (one file per asset) cache file from the
+         * cache directory. Only files containing mCacheFilenamePrefix
+         * are removed. Returns false if the cache directory is missing.
+         */
+        bool removeCacheFiles();
+
+        /**
+         * Copy one of the static assets shipped with the viewer into the
+         * pack and pin it so that it is never purged.
+         */
+        void addStaticAssetToPack(const std::string& from_asset_file, const std::string& uuid_as_string);
+
         /**
          * Utility function to gather the total size the files in a given
          * directory. Primarily used here to determine the directory size
@@ -235,6 +266,11 @@ class LLDiskCache :
         bool mEnableCacheDebugInfo;
         
         std::vector<std::string> mSkipList;  // <FS:Beq/> Vector of "static" untouchable assets that should never be purged
+
+        /**
+         * The indexed pack file store, only set in pack file mode
+         */
+        std::unique_ptr<LLDiskPack> mPack;
 };
 
 class LLPurgeDiskCacheThread : public LLThread
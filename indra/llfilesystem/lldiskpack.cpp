@@ -0,0 +1,1101 @@
+/**
+ * @file lldiskpack.cpp
+ * @brief Indexed single-file asset store used by LLDiskCache.
+ *
+ * See lldiskpack.h for a description of the on-disk layout.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lldiskpack.h"
+
+#include "hbxxh.h"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+
+#if LL_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(LLUUID) == UUID_BYTES, "LLUUID layout changed");
+
+namespace
+{
+    // Journal format version; bump when JournalRecord, the size class
+    // table or the set of ops changes. A version mismatch discards the
+    // whole pack.
+    constexpr U32 JOURNAL_VERSION = 2;
+
+    // Smallest slot handed out. Assets below this size share the slot
+    // waste, which is still far less than a file system block plus inode.
+    constexpr U32 MIN_SLOT_SIZE = 4096;
+
+    // Size classes are spaced at quarter powers of two (4K, 5K, 6K, 7K,
+    // 8K, 10K...), which bounds internal fragmentation to 25%.
+    constexpr U32 CLASS_STEPS = 4;
+    constexpr U32 NUM_SIZE_CLASSES = 19 * CLASS_STEPS;  // 4 KB to ~2 GB
+
+    // Small classes are allocated one slab at a time.
+    constexpr U32 SLAB_SIZE = 1024 * 1024;
+
+    // Do not journal access time updates more often than this, see
+    // LLDiskCache::updateFileAccessTime().
+    constexpr S64 TOUCH_JOURNAL_INTERVAL = 60 * 60;
+
+    // Compact the journal when it holds this many records more than the
+    // live slab and entry count.
+    constexpr U32 JOURNAL_COMPACT_SLACK = 16384;
+
+    // Most asset bytes compact() copies around per call, so that a purge
+    // never holds the pack lock for long.
+    constexpr U64 COMPACT_MOVE_BYTES = 32 * 1024 * 1024;
+
+    int pack_fseek(LLFILE* file, U64 offset)
+    {
+#if LL_WINDOWS
+        return _fseeki64(file, (__int64)offset, SEEK_SET);
+#else
+        return fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+    }
+
+    U64 record_checksum(const void* rec, size_t len)
+    {
+        // The checksum is the last member of the record
+        return HBXXH64::digest(rec, len - sizeof(U64));
+    }
+}
+
+LLDiskPack::LLDiskPack(const std::string& base_path)
+:   mDataPath(base_path + ".data"),
+    mJournalPath(base_path + ".journal"),
+    mFreeSlots(NUM_SIZE_CLASSES)
+{
+}
+
+LLDiskPack::~LLDiskPack()
+{
+    close();
+}
+
+//static
+void LLDiskPack::deleteFiles(const std::string& base_path)
+{
+    LLFile::remove(base_path + ".data", ENOENT);
+    LLFile::remove(base_path + ".journal", ENOENT);
+    LLFile::remove(base_path + ".journal.tmp", ENOENT);
+}
+
+//static
+U32 LLDiskPack::slotSize(U32 size_class)
+{
+    const U32 base = MIN_SLOT_SIZE << (size_class / CLASS_STEPS);
+    return base + (base / CLASS_STEPS) * (size_class % CLASS_STEPS);
+}
+
+//static
+U32 LLDiskPack::sizeClassFor(U32 bytes)
+{
+    U32 size_class = 0;
+    while (size_class < NUM_SIZE_CLASSES - 1 && slotSize(size_class) < bytes)
+    {
+        ++size_class;
+    }
+    return size_class;
+}
+
+//static
+U32 LLDiskPack::slotsPerSlab(U32 size_class)
+{
+    return llmax(1U, SLAB_SIZE / slotSize(size_class));
+}
+
+//static
+U64 LLDiskPack::slabBytes(U32 size_class)
+{
+    return (U64)slotsPerSlab(size_class) * slotSize(size_class);
+}
+
+//static
+S64 LLDiskPack::now()
+{
+    return (S64)std::time(nullptr);
+}
+
+bool LLDiskPack::open(bool& created)
+{
+    LLMutexLock lock(&mMutex);
+
+    created = false;
+    if (mDataFile)
+    {
+        return true;
+    }
+
+    clearIndex();
+
+    bool journal_ok = replayJournal();
+    if (!journal_ok)
+    {
+        // Either a first run or a journal we cannot trust: start over.
+        created = true;
+        clearIndex();
+        LLFile::remove(mDataPath, ENOENT);
+        LLFile::remove(mJournalPath, ENOENT);
+    }
+
+    mDataFile = LLFile::fopen(mDataPath, "r+b");
+    if (!mDataFile)
+    {
+        mDataFile = LLFile::fopen(mDataPath, "w+b");
+    }
+    if (!mDataFile)
+    {
+        LL_WARNS("LLDiskCache") << "Unable to open asset pack " << mDataPath << LL_ENDL;
+        clearIndex();
+        return false;
+    }
+
+    rebuildFreeLists();
+
+    // Rewrite the journal from the replayed index. This drops any torn
+    // tail left by a crash so that new records are appended after a
+    // valid one, and starts the session with a compact journal.
+    if (!writeCompactJournal())
+    {
+        fclose(mDataFile);
+        mDataFile = nullptr;
+        clearIndex();
+        return false;
+    }
+
+    // A crash between journaling a slab release and truncating the pack
+    // leaves dead space past the last slab
+    llstat data_stat;
+    if (LLFile::stat(mDataPath, &data_stat) == 0 && (U64)data_stat.st_size > mPackEnd)
+    {
+        truncateData();
+    }
+
+    LL_INFOS("LLDiskCache") << "Opened asset pack " << mDataPath << " with " << mEntries.size()
+                            << " entries, " << mUsedBytes << " bytes used of " << mPackEnd << LL_ENDL;
+    return true;
+}
+
+void LLDiskPack::close()
+{
+    LLMutexLock lock(&mMutex);
+
+    if (mDataFile)
+    {
+        writeCompactJournal();
+        fclose(mDataFile);
+        mDataFile = nullptr;
+    }
+    if (mJournalFile)
+    {
+        fclose(mJournalFile);
+        mJournalFile = nullptr;
+    }
+    clearIndex();
+}
+
+void LLDiskPack::clearIndex()
+{
+    mEntries.clear();
+    mLRU.clear();
+    mSlabs.clear();
+    mFreeExtents.clear();
+    for (auto& free_list : mFreeSlots)
+    {
+        free_list.clear();
+    }
+    mPackEnd = 0;
+    mUsedBytes = 0;
+    mJournalRecords = 0;
+}
+
+bool LLDiskPack::replayJournal()
+{
+    LLFILE* journal = LLFile::fopen(mJournalPath, "rb");
+    if (!journal)
+    {
+        return false;
+    }
+
+    JournalRecord rec;
+    bool valid = fread(&rec, sizeof(rec), 1, journal) == 1
+                 && rec.mOp == OP_HEADER
+                 && rec.mLength == JOURNAL_VERSION
+                 && rec.mChecksum == record_checksum(&rec, sizeof(rec));
+    if (valid)
+    {
+        U32 applied = 0;
+        while (fread(&rec, sizeof(rec), 1, journal) == 1)
+        {
+            if (rec.mChecksum != record_checksum(&rec, sizeof(rec)))
+            {
+                LL_WARNS("LLDiskCache") << "Asset pack journal is corrupt after " << applied
+                                        << " records, ignoring the rest" << LL_ENDL;
+                break;
+            }
+            applyRecord(rec);
+            ++applied;
+        }
+    }
+    else
+    {
+        LL_WARNS("LLDiskCache") << "Discarding asset pack journal with unknown format" << LL_ENDL;
+    }
+
+    fclose(journal);
+    return valid;
+}
+
+void LLDiskPack::applyRecord(const JournalRecord& rec)
+{
+    Key key;
+    memcpy(key.mID.mData, rec.mID, UUID_BYTES);
+    key.mType = (LLAssetType::EType)rec.mType;
+
+    switch (rec.mOp)
+    {
+        case OP_SLAB:
+            if (rec.mSizeClass < NUM_SIZE_CLASSES)
+            {
+                mSlabs[rec.mOffset] = Slab{ rec.mSizeClass, 0 };
+            }
+            break;
+
+        case OP_FREE_SLAB:
+            mSlabs.erase(rec.mOffset);
+            break;
+
+        case OP_PUT:
+        {
+            if (rec.mSizeClass >= NUM_SIZE_CLASSES || rec.mLength > slotSize(rec.mSizeClass))
+            {
+                break;
+            }
+            auto it = mEntries.find(key);
+            if (it == mEntries.end())
+            {
+                it = mEntries.emplace(key, Entry()).first;
+                mLRU.push_front(key);
+                it->second.mLRUIter = mLRU.begin();
+            }
+            else
+            {
+                mUsedBytes -= slotSize(it->second.mSizeClass);
+            }
+            Entry& entry = it->second;
+            entry.mOffset = rec.mOffset;
+            entry.mLength = rec.mLength;
+            entry.mSizeClass = rec.mSizeClass;
+            entry.mLastAccess = entry.mJournaledAccess = rec.mTime;
+            mUsedBytes += slotSize(entry.mSizeClass);
+            break;
+        }
+
+        case OP_REMOVE:
+        {
+            auto it = mEntries.find(key);
+            if (it != mEntries.end())
+            {
+                mUsedBytes -= slotSize(it->second.mSizeClass);
+                mLRU.erase(it->second.mLRUIter);
+                mEntries.erase(it);
+            }
+            break;
+        }
+
+        case OP_TOUCH:
+        {
+            auto it = mEntries.find(key);
+            if (it != mEntries.end())
+            {
+                it->second.mLastAccess = it->second.mJournaledAccess = rec.mTime;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void LLDiskPack::rebuildFreeLists()
+{
+    // Drop any entry that is not in a slot of a live slab, it cannot be
+    // trusted
+    for (auto it = mEntries.begin(); it != mEntries.end(); )
+    {
+        const Entry& entry = it->second;
+        auto slab = findSlab(entry.mOffset);
+        if (slab == mSlabs.end() || slab->second.mSizeClass != entry.mSizeClass
+            || (entry.mOffset - slab->first) % slotSize(entry.mSizeClass) != 0)
+        {
+            mUsedBytes -= slotSize(entry.mSizeClass);
+            it = mEntries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // Order the LRU list by the replayed access times
+    std::vector<std::pair<S64, Key> > by_age;
+    by_age.reserve(mEntries.size());
+    std::unordered_set<U64> used_slots;
+    used_slots.reserve(mEntries.size());
+    for (const auto& pair : mEntries)
+    {
+        by_age.emplace_back(pair.second.mLastAccess, pair.first);
+        used_slots.insert(pair.second.mOffset);
+    }
+    std::sort(by_age.begin(), by_age.end(),
+              [](const std::pair<S64, Key>& a, const std::pair<S64, Key>& b)
+              {
+                  return a.first > b.first;
+              });
+    mLRU.clear();
+    for (const auto& aged : by_age)
+    {
+        mLRU.push_back(aged.second);
+        mEntries[aged.second].mLRUIter = std::prev(mLRU.end());
+    }
+
+    // Every slot of every slab that no entry points at is free. Walk the
+    // slabs backwards so that the lowest free slots are handed out first.
+    for (auto& free_list : mFreeSlots)
+    {
+        free_list.clear();
+    }
+    for (auto it = mSlabs.rbegin(); it != mSlabs.rend(); ++it)
+    {
+        Slab& slab = it->second;
+        const U32 size = slotSize(slab.mSizeClass);
+        const U32 count = slotsPerSlab(slab.mSizeClass);
+        slab.mUsedSlots = count;
+        for (U32 i = count; i > 0; --i)
+        {
+            const U64 offset = it->first + (U64)(i - 1) * size;
+            if (!used_slots.count(offset))
+            {
+                mFreeSlots[slab.mSizeClass].push_back(offset);
+                --slab.mUsedSlots;
+            }
+        }
+    }
+
+    // Whatever lies between slabs was left by released ones
+    mFreeExtents.clear();
+    mPackEnd = 0;
+    for (const auto& slab : mSlabs)
+    {
+        if (slab.first > mPackEnd)
+        {
+            mFreeExtents[mPackEnd] = slab.first - mPackEnd;
+        }
+        mPackEnd = llmax(mPackEnd, slab.first + slabBytes(slab.second.mSizeClass));
+    }
+}
+
+bool LLDiskPack::writeCompactJournal()
+{
+    if (mJournalFile)
+    {
+        fclose(mJournalFile);
+        mJournalFile = nullptr;
+    }
+
+    const std::string tmp_path = mJournalPath + ".tmp";
+    mJournalFile = LLFile::fopen(tmp_path, "wb");
+    if (!mJournalFile)
+    {
+        LL_WARNS("LLDiskCache") << "Unable to write asset pack journal " << tmp_path << LL_ENDL;
+        return false;
+    }
+
+    mJournalRecords = 0;
+    appendRecord(OP_HEADER, Key{ LLUUID::null, LLAssetType::AT_NONE }, 0, JOURNAL_VERSION, 0, now());
+    for (const auto& slab : mSlabs)
+    {
+        appendRecord(OP_SLAB, Key{ LLUUID::null, LLAssetType::AT_NONE }, slab.first, 0, slab.second.mSizeClass, 0);
+    }
+    for (const auto& pair : mEntries)
+    {
+        appendPut(pair.first, pair.second);
+    }
+
+    bool success = flushJournal();
+    fclose(mJournalFile);
+    mJournalFile = nullptr;
+
+    if (success)
+    {
+        // LLFile::rename() does not replace an existing file on Windows
+        LLFile::remove(mJournalPath, ENOENT);
+        success = LLFile::rename(tmp_path, mJournalPath) == 0;
+    }
+    if (success)
+    {
+        mJournalFile = LLFile::fopen(mJournalPath, "ab");
+        success = mJournalFile != nullptr;
+    }
+    if (!success)
+    {
+        LL_WARNS("LLDiskCache") << "Failed to compact asset pack journal " << mJournalPath << LL_ENDL;
+    }
+    return success;
+}
+
+bool LLDiskPack::appendRecord(U32 op, const Key& key, U64 offset, U32 length, U32 size_class, S64 time)
+{
+    if (!mJournalFile)
+    {
+        return false;
+    }
+
+    JournalRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.mOp = op;
+    rec.mType = (S32)key.mType;
+    memcpy(rec.mID, key.mID.mData, UUID_BYTES);
+    rec.mOffset = offset;
+    rec.mLength = length;
+    rec.mSizeClass = size_class;
+    rec.mTime = time;
+    rec.mChecksum = record_checksum(&rec, sizeof(rec));
+
+    if (fwrite(&rec, sizeof(rec), 1, mJournalFile) != 1)
+    {
+        return false;
+    }
+    ++mJournalRecords;
+    return true;
+}
+
+void LLDiskPack::appendPut(const Key& key, const Entry& entry)
+{
+    appendRecord(OP_PUT, key, entry.mOffset, entry.mLength, entry.mSizeClass, entry.mJournaledAccess);
+}
+
+bool LLDiskPack::flushJournal()
+{
+    return mJournalFile && fflush(mJournalFile) == 0;
+}
+
+bool LLDiskPack::allocateSlot(U32 size_class, U64& offset)
+{
+    std::vector<U64>& free_list = mFreeSlots[size_class];
+    if (free_list.empty())
+    {
+        // Start a new slab in a hole left by a released slab of any size
+        // class, or else carve it off the end of the pack file.
+        U64 slab_offset;
+        if (!takeExtent(slabBytes(size_class), mPackEnd, slab_offset))
+        {
+            slab_offset = mPackEnd;
+            mPackEnd += slabBytes(size_class);
+        }
+        addSlab(slab_offset, size_class);
+    }
+
+    offset = free_list.back();
+    free_list.pop_back();
+    ++findSlab(offset)->second.mUsedSlots;
+    return true;
+}
+
+void LLDiskPack::freeSlot(U32 size_class, U64 offset)
+{
+    mFreeSlots[size_class].push_back(offset);
+    auto slab = findSlab(offset);
+    if (slab != mSlabs.end() && slab->second.mUsedSlots)
+    {
+        --slab->second.mUsedSlots;
+    }
+}
+
+LLDiskPack::slab_map_t::iterator LLDiskPack::findSlab(U64 offset)
+{
+    auto it = mSlabs.upper_bound(offset);
+    if (it == mSlabs.begin())
+    {
+        return mSlabs.end();
+    }
+    --it;
+    return offset < it->first + slabBytes(it->second.mSizeClass) ? it : mSlabs.end();
+}
+
+void LLDiskPack::addSlab(U64 offset, U32 size_class)
+{
+    // The slab record is journaled right away: an unused slab is harmless
+    // after a crash, a slot outside any known slab would leak forever.
+    mSlabs[offset] = Slab{ size_class, 0 };
+    appendRecord(OP_SLAB, Key{ LLUUID::null, LLAssetType::AT_NONE }, offset, 0, size_class, 0);
+
+    // Hand out slots from the start of the slab first
+    const U32 size = slotSize(size_class);
+    for (U32 i = slotsPerSlab(size_class); i > 0; --i)
+    {
+        mFreeSlots[size_class].push_back(offset + (U64)(i - 1) * size);
+    }
+}
+
+void LLDiskPack::releaseSlab(slab_map_t::iterator it)
+{
+    llassert(it->second.mUsedSlots == 0);
+    const U32 size_class = it->second.mSizeClass;
+    const U64 start = it->first;
+    const U64 end = start + slabBytes(size_class);
+
+    std::vector<U64>& free_list = mFreeSlots[size_class];
+    free_list.erase(std::remove_if(free_list.begin(), free_list.end(),
+                                   [start, end](U64 offset) { return offset >= start && offset < end; }),
+                    free_list.end());
+
+    appendRecord(OP_FREE_SLAB, Key{ LLUUID::null, LLAssetType::AT_NONE }, start, 0, size_class, 0);
+    mSlabs.erase(it);
+    addExtent(start, end - start);
+}
+
+bool LLDiskPack::takeExtent(U64 bytes, U64 below, U64& offset)
+{
+    // First fit, so that the pack fills up from the start
+    for (auto it = mFreeExtents.begin(); it != mFreeExtents.end() && it->first + bytes <= below; ++it)
+    {
+        if (it->second >= bytes)
+        {
+            offset = it->first;
+            if (it->second > bytes)
+            {
+                mFreeExtents[offset + bytes] = it->second - bytes;
+            }
+            mFreeExtents.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void LLDiskPack::addExtent(U64 offset, U64 bytes)
+{
+    auto next = mFreeExtents.lower_bound(offset);
+    if (next != mFreeExtents.end() && offset + bytes == next->first)
+    {
+        bytes += next->second;
+        next = mFreeExtents.erase(next);
+    }
+    if (next != mFreeExtents.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            bytes += prev->second;
+            mFreeExtents.erase(prev);
+        }
+    }
+
+    if (offset + bytes >= mPackEnd)
+    {
+        // Free space at the end is not a hole, the pack just got shorter
+        mPackEnd = offset;
+    }
+    else
+    {
+        mFreeExtents[offset] = bytes;
+    }
+}
+
+bool LLDiskPack::moveEntry(entry_map_t::iterator it, U64 to)
+{
+    Entry& entry = it->second;
+    if (!copyData(entry.mOffset, to, entry.mLength) || fflush(mDataFile) != 0)
+    {
+        return false;
+    }
+
+    // The old slot is only reused once the new one is journaled
+    const U64 from = entry.mOffset;
+    entry.mOffset = to;
+    appendPut(it->first, entry);
+    freeSlot(entry.mSizeClass, from);
+    return true;
+}
+
+bool LLDiskPack::truncateData()
+{
+    if (fflush(mDataFile) != 0)
+    {
+        return false;
+    }
+#if LL_WINDOWS
+    return _chsize_s(_fileno(mDataFile), (__int64)mPackEnd) == 0;
+#else
+    return ftruncate(fileno(mDataFile), (off_t)mPackEnd) == 0;
+#endif
+}
+
+bool LLDiskPack::readData(U64 offset, U8* buffer, U32 bytes)
+{
+    return pack_fseek(mDataFile, offset) == 0 && fread(buffer, 1, bytes, mDataFile) == bytes;
+}
+
+bool LLDiskPack::writeData(U64 offset, const U8* buffer, U32 bytes)
+{
+    return pack_fseek(mDataFile, offset) == 0 && fwrite(buffer, 1, bytes, mDataFile) == bytes;
+}
+
+bool LLDiskPack::copyData(U64 from, U64 to, U32 bytes)
+{
+    std::vector<U8> chunk(llmin(bytes, SLAB_SIZE));
+    while (bytes > 0)
+    {
+        const U32 len = llmin(bytes, (U32)chunk.size());
+        if (!readData(from, chunk.data(), len) || !writeData(to, chunk.data(), len))
+        {
+            return false;
+        }
+        from += len;
+        to += len;
+        bytes -= len;
+    }
+    return true;
+}
+
+LLDiskPack::entry_map_t::iterator LLDiskPack::findEntry(const Key& key)
+{
+    return mDataFile ? mEntries.find(key) : mEntries.end();
+}
+
+void LLDiskPack::eraseEntry(entry_map_t::iterator it, bool journal)
+{
+    if (journal)
+    {
+        appendRecord(OP_REMOVE, it->first, 0, 0, 0, 0);
+    }
+    freeSlot(it->second.mSizeClass, it->second.mOffset);
+    mUsedBytes -= slotSize(it->second.mSizeClass);
+    mLRU.erase(it->second.mLRUIter);
+    mEntries.erase(it);
+}
+
+bool LLDiskPack::exists(const LLUUID& id, LLAssetType::EType type)
+{
+    LLMutexLock lock(&mMutex);
+    auto it = findEntry(Key{ id, type });
+    return it != mEntries.end() && it->second.mLength > 0;
+}
+
+S32 LLDiskPack::getSize(const LLUUID& id, LLAssetType::EType type)
+{
+    LLMutexLock lock(&mMutex);
+    auto it = findEntry(Key{ id, type });
+    return it != mEntries.end() ? (S32)it->second.mLength : 0;
+}
+
+S32 LLDiskPack::read(const LLUUID& id, LLAssetType::EType type, S32 offset, U8* buffer, S32 bytes)
+{
+    LLMutexLock lock(&mMutex);
+    auto it = findEntry(Key{ id, type });
+    if (it == mEntries.end() || offset < 0 || bytes <= 0)
+    {
+        return 0;
+    }
+
+    const Entry& entry = it->second;
+    if ((U32)offset >= entry.mLength)
+    {
+        return 0;
+    }
+
+    const U32 len = llmin((U32)bytes, entry.mLength - (U32)offset);
+    if (!readData(entry.mOffset + offset, buffer, len))
+    {
+        LL_WARNS("LLDiskCache") << "Failed to read " << id << " from asset pack" << LL_ENDL;
+        return 0;
+    }
+    return (S32)len;
+}
+
+bool LLDiskPack::write(const LLUUID& id, LLAssetType::EType type, S32 offset, const U8* buffer, S32 bytes, bool truncate)
+{
+    LLMutexLock lock(&mMutex);
+    if (!mDataFile || offset < 0 || bytes < 0)
+    {
+        return false;
+    }
+
+    const Key key{ id, type };
+    auto it = mEntries.find(key);
+    const bool found = it != mEntries.end();
+
+    const U32 old_length = found ? it->second.mLength : 0;
+    const U64 end = (U64)offset + (U64)bytes;
+    const U64 new_length = truncate ? end : llmax((U64)old_length, end);
+    if (new_length > (U64)S32_MAX)
+    {
+        return false;
+    }
+
+    const U32 new_class = sizeClassFor((U32)new_length);
+    const bool in_place = found && (U32)new_length <= slotSize(it->second.mSizeClass)
+                          // Don't keep a tiny asset in a huge slot after a truncating write
+                          && !(truncate && new_class + CLASS_STEPS < it->second.mSizeClass);
+
+    U64 slot_offset;
+    U32 slot_class;
+    if (in_place)
+    {
+        slot_offset = it->second.mOffset;
+        slot_class = it->second.mSizeClass;
+        if ((U32)offset < old_length)
+        {
+            // We are about to overwrite committed data: invalidate the
+            // entry first so that a crash mid-write cannot leave an index
+            // record pointing at half old, half new content.  The record
+            // has to reach the file before the data does.
+            if (!appendRecord(OP_REMOVE, key, 0, 0, 0, 0) || !flushJournal())
+            {
+                LL_WARNS("LLDiskCache") << "Failed to journal the overwrite of " << id << " in asset pack" << LL_ENDL;
+                return false;
+            }
+        }
+    }
+    else
+    {
+        slot_class = new_class;
+        if (!allocateSlot(slot_class, slot_offset))
+        {
+            LL_WARNS("LLDiskCache") << "No room for " << id << " in asset pack" << LL_ENDL;
+            return false;
+        }
+        const U32 keep = truncate ? 0 : llmin(old_length, (U32)offset);
+        if (keep && !copyData(it->second.mOffset, slot_offset, keep))
+        {
+            freeSlot(slot_class, slot_offset);
+            return false;
+        }
+    }
+
+    // Zero fill any gap between the old end of the asset and the write
+    if (!truncate && (U32)offset > old_length)
+    {
+        std::vector<U8> zeros((U32)offset - old_length, 0);
+        writeData(slot_offset + old_length, zeros.data(), (U32)zeros.size());
+    }
+
+    if ((bytes && !writeData(slot_offset + offset, buffer, (U32)bytes)) || fflush(mDataFile) != 0)
+    {
+        LL_WARNS("LLDiskCache") << "Failed to write " << id << " to asset pack" << LL_ENDL;
+        if (found)
+        {
+            eraseEntry(it, true);
+        }
+        if (!in_place)
+        {
+            freeSlot(slot_class, slot_offset);
+        }
+        flushJournal();
+        return false;
+    }
+
+    if (!found)
+    {
+        it = mEntries.emplace(key, Entry()).first;
+        mLRU.push_front(key);
+        it->second.mLRUIter = mLRU.begin();
+    }
+    else
+    {
+        mLRU.splice(mLRU.begin(), mLRU, it->second.mLRUIter);
+        mUsedBytes -= slotSize(it->second.mSizeClass);
+        if (!in_place)
+        {
+            freeSlot(it->second.mSizeClass, it->second.mOffset);
+        }
+    }
+
+    Entry& entry = it->second;
+    entry.mOffset = slot_offset;
+    entry.mLength = (U32)new_length;
+    entry.mSizeClass = slot_class;
+    entry.mLastAccess = entry.mJournaledAccess = now();
+    mUsedBytes += slotSize(slot_class);
+
+    appendPut(key, entry);
+    return flushJournal();
+}
+
+bool LLDiskPack::remove(const LLUUID& id, LLAssetType::EType type)
+{
+    LLMutexLock lock(&mMutex);
+    auto it = findEntry(Key{ id, type });
+    if (it == mEntries.end())
+    {
+        return false;
+    }
+    eraseEntry(it, true);
+    flushJournal();
+    return true;
+}
+
+bool LLDiskPack::rename(const LLUUID& old_id, LLAssetType::EType old_type,
+                        const LLUUID& new_id, LLAssetType::EType new_type)
+{
+    LLMutexLock lock(&mMutex);
+    const Key old_key{ old_id, old_type };
+    const Key new_key{ new_id, new_type };
+    if (old_key == new_key)
+    {
+        return true;
+    }
+
+    auto it = findEntry(old_key);
+    if (it == mEntries.end())
+    {
+        return false;
+    }
+
+    auto target = mEntries.find(new_key);
+    if (target != mEntries.end())
+    {
+        eraseEntry(target, true);
+    }
+
+    Entry entry = it->second;
+    mLRU.erase(entry.mLRUIter);
+    mEntries.erase(it);
+
+    mLRU.push_front(new_key);
+    entry.mLRUIter = mLRU.begin();
+    mEntries.emplace(new_key, entry);
+
+    appendRecord(OP_REMOVE, old_key, 0, 0, 0, 0);
+    appendPut(new_key, entry);
+    return flushJournal();
+}
+
+void LLDiskPack::touch(const LLUUID& id, LLAssetType::EType type)
+{
+    LLMutexLock lock(&mMutex);
+    auto it = findEntry(Key{ id, type });
+    if (it == mEntries.end())
+    {
+        return;
+    }
+
+    Entry& entry = it->second;
+    mLRU.splice(mLRU.begin(), mLRU, entry.mLRUIter);
+    entry.mLastAccess = now();
+    if (entry.mLastAccess - entry.mJournaledAccess > TOUCH_JOURNAL_INTERVAL)
+    {
+        entry.mJournaledAccess = entry.mLastAccess;
+        appendRecord(OP_TOUCH, it->first, 0, 0, 0, entry.mLastAccess);
+        flushJournal();
+    }
+}
+
+void LLDiskPack::setPinned(const LLUUID& id, LLAssetType::EType type, bool pinned)
+{
+    LLMutexLock lock(&mMutex);
+    auto it = findEntry(Key{ id, type });
+    if (it != mEntries.end())
+    {
+        it->second.mPinned = pinned;
+    }
+}
+
+U32 LLDiskPack::purge(uintmax_t high_water_bytes, uintmax_t target_bytes)
+{
+    LLMutexLock lock(&mMutex);
+    if (!mDataFile || mUsedBytes < high_water_bytes)
+    {
+        return 0;
+    }
+
+    U32 evicted = 0;
+    auto lru_it = mLRU.end();
+    while (mUsedBytes > target_bytes && lru_it != mLRU.begin())
+    {
+        --lru_it;
+        auto it = mEntries.find(*lru_it);
+        if (it->second.mPinned)
+        {
+            continue;
+        }
+        // eraseEntry() invalidates lru_it, step past it first
+        ++lru_it;
+        eraseEntry(it, true);
+        ++evicted;
+    }
+    flushJournal();
+    return evicted;
+}
+
+U64 LLDiskPack::compact()
+{
+    LLMutexLock lock(&mMutex);
+    if (!mDataFile)
+    {
+        return 0;
+    }
+
+    const U64 old_end = mPackEnd;
+
+    for (auto it = mSlabs.begin(); it != mSlabs.end(); )
+    {
+        auto next = std::next(it);
+        if (!it->second.mUsedSlots)
+        {
+            releaseSlab(it);
+        }
+        it = next;
+    }
+
+    // Empty the slab at the end of the pack into free slots of its size
+    // class further down, starting a slab in a hole for them if needed,
+    // then release it.
+    U64 moved = 0;
+    bool failed = false;
+    while (!mSlabs.empty() && moved < COMPACT_MOVE_BYTES && !failed)
+    {
+        auto last = std::prev(mSlabs.end());
+        const U64 last_start = last->first;
+        const U64 last_end = last_start + slabBytes(last->second.mSizeClass);
+        const U32 size_class = last->second.mSizeClass;
+        std::vector<U64>& free_list = mFreeSlots[size_class];
+
+        size_t free_below = std::count_if(free_list.begin(), free_list.end(),
+                                          [last_start](U64 offset) { return offset < last_start; });
+        if (free_below < last->second.mUsedSlots)
+        {
+            U64 hole;
+            if (!takeExtent(slabBytes(size_class), last_start, hole))
+            {
+                break;
+            }
+            addSlab(hole, size_class);
+        }
+
+        // Lowest free slots last, so that the moves fill them first
+        std::sort(free_list.begin(), free_list.end(), std::greater<U64>());
+
+        std::vector<entry_map_t::iterator> to_move;
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it)
+        {
+            if (it->second.mOffset >= last_start && it->second.mOffset < last_end)
+            {
+                to_move.push_back(it);
+            }
+        }
+
+        for (auto it : to_move)
+        {
+            const U64 to = free_list.back();
+            free_list.pop_back();
+            ++findSlab(to)->second.mUsedSlots;
+            if (!moveEntry(it, to))
+            {
+                LL_WARNS("LLDiskCache") << "Failed to move " << it->first.mID << " in asset pack" << LL_ENDL;
+                freeSlot(size_class, to);
+                failed = true;
+                break;
+            }
+            moved += it->second.mLength;
+        }
+
+        if (!failed)
+        {
+            releaseSlab(last);
+        }
+    }
+
+    // The slab releases must be on disk before the data goes away
+    if (flushJournal() && mPackEnd < old_end && !truncateData())
+    {
+        LL_WARNS("LLDiskCache") << "Failed to truncate asset pack " << mDataPath << LL_ENDL;
+    }
+    return old_end - mPackEnd;
+}
+
+uintmax_t LLDiskPack::getUsedBytes() const
+{
+    LLMutexLock lock(&mMutex);
+    return mUsedBytes;
+}
+
+uintmax_t LLDiskPack::getPackBytes() const
+{
+    LLMutexLock lock(&mMutex);
+    return mPackEnd;
+}
+
+size_t LLDiskPack::getEntryCount() const
+{
+    LLMutexLock lock(&mMutex);
+    return mEntries.size();
+}
+
+void LLDiskPack::clear()
+{
+    LLMutexLock lock(&mMutex);
+    if (!mDataFile)
+    {
+        return;
+    }
+
+    clearIndex();
+    fclose(mDataFile);
+    mDataFile = LLFile::fopen(mDataPath, "w+b");
+    if (!mDataFile)
+    {
+        LL_WARNS("LLDiskCache") << "Unable to recreate asset pack " << mDataPath << LL_ENDL;
+    }
+    writeCompactJournal();
+}
+
+void LLDiskPack::checkpoint(bool force)
+{
+    LLMutexLock lock(&mMutex);
+    if (!mDataFile)
+    {
+        return;
+    }
+
+    const size_t live_records = mSlabs.size() + mEntries.size() + 1;
+    if (force || mJournalRecords > live_records + JOURNAL_COMPACT_SLACK)
+    {
+        writeCompactJournal();
+    }
+}
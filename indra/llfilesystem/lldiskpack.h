@@ -0,0 +1,316 @@
+/**
+ * @file lldiskpack.h
+ * @brief Indexed single-file asset store used by LLDiskCache.
+ *
+ * @Description:
+ * This is an optional backend for LLDiskCache that keeps every cached
+ * asset inside one pack file instead of one file per asset.
+ * 1/ An in-memory index maps (asset UUID, asset type) to the offset,
+ *    length and last access time of the asset data in the pack file.
+ *    Existence checks, size queries and access time updates never
+ *    touch the file system.
+ * 2/ Space in the pack file is handed out in slabs. Each slab is
+ *    carved into slots of a single size class; freed slots go back
+ *    to the free list of their class and are reused by later writes.
+ * 3/ Every change to the index is appended to a journal file as a
+ *    fixed size, checksummed record, after the asset data has been
+ *    written. On startup the journal is replayed to rebuild the index;
+ *    a truncated or corrupt tail is simply ignored. The journal is
+ *    periodically compacted down to one record per live slab/entry.
+ * 4/ Eviction walks an LRU list kept in memory, so purging the cache
+ *    costs O(evicted) and never scans the cache directory.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDISKPACK_H
+#define LL_LLDISKPACK_H
+
+#include "llassettype.h"
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+class LLDiskPack
+{
+    public:
+        /**
+         * The pack and journal files are base_path with ".data" and
+         * ".journal" extensions.
+         */
+        LLDiskPack(const std::string& base_path);
+        ~LLDiskPack();
+
+        /**
+         * Open (or create) the pack file and rebuild the index from the
+         * journal. Returns false if the files could not be opened, in which
+         * case every other call fails gracefully. 'created' is set to true
+         * when no usable journal was found and an empty pack was started.
+         */
+        bool open(bool& created);
+
+        /**
+         * Compact the journal and close the files.
+         */
+        void close();
+
+        bool isOpen() const { return mDataFile != nullptr; }
+
+        bool exists(const LLUUID& id, LLAssetType::EType type);
+
+        /**
+         * Returns the length of the stored asset, or 0 if it is not cached.
+         */
+        S32 getSize(const LLUUID& id, LLAssetType::EType type);
+
+        /**
+         * Read up to 'bytes' bytes of the asset starting at 'offset'.
+         * Returns the number of bytes actually read.
+         */
+        S32 read(const LLUUID& id, LLAssetType::EType type, S32 offset, U8* buffer, S32 bytes);
+
+        /**
+         * Write 'bytes' bytes at 'offset', creating the entry if needed.
+         * When 'truncate' is true, the asset is replaced by the written data
+         * (the LLFileSystem::WRITE semantic); otherwise the asset grows as
+         * needed and existing data outside the written range is kept.
+         */
+        bool write(const LLUUID& id, LLAssetType::EType type, S32 offset, const U8* buffer, S32 bytes, bool truncate);
+
+        bool remove(const LLUUID& id, LLAssetType::EType type);
+
+        /**
+         * Re-key an entry without moving its data. Any existing entry at the
+         * new key is removed first.
+         */
+        bool rename(const LLUUID& old_id, LLAssetType::EType old_type,
+                    const LLUUID& new_id, LLAssetType::EType new_type);
+
+        /**
+         * Move the entry to the front of the LRU list. The new access time is
+         * only journaled once per TOUCH_JOURNAL_INTERVAL to keep the journal
+         * (and SSD writes) small, like LLDiskCache::updateFileAccessTime().
+         */
+        void touch(const LLUUID& id, LLAssetType::EType type);
+
+        /**
+         * Pinned entries are never evicted by purge(). Used for the
+         * static assets shipped with the viewer. Pinning is not persisted.
+         */
+        void setPinned(const LLUUID& id, LLAssetType::EType type, bool pinned);
+
+        /**
+         * If more than high_water_bytes are in use, evict least recently
+         * used entries until no more than target_bytes are in use.
+         * Returns the number of entries evicted.
+         */
+        U32 purge(uintmax_t high_water_bytes, uintmax_t target_bytes);
+
+        /**
+         * Remove every entry and truncate both files.
+         */
+        void clear();
+
+        /**
+         * Give the space of empty slabs back so that any size class can
+         * reuse it, move the entries of the slabs at the end of the pack
+         * into free space further down and truncate the pack file to the
+         * last live slab. Moves a bounded amount of data per call, so the
+         * pack shrinks over a few purges after a big eviction. Returns the
+         * number of bytes the pack file shrank by.
+         */
+        U64 compact();
+
+        /**
+         * Compact the journal if it has grown well beyond the live index.
+         * Called from the purge thread; force always compacts.
+         */
+        void checkpoint(bool force = false);
+
+        /**
+         * Bytes of pack file space held by live entries (slot capacity).
+         */
+        uintmax_t getUsedBytes() const;
+
+        /**
+         * Extent of the pack file, including free slots and free space
+         * left by released slabs.
+         */
+        uintmax_t getPackBytes() const;
+
+        size_t getEntryCount() const;
+
+        /**
+         * Remove the pack and journal files. The pack must be closed.
+         */
+        static void deleteFiles(const std::string& base_path);
+
+    private:
+        struct Key
+        {
+            LLUUID              mID;
+            LLAssetType::EType  mType;
+
+            bool operator==(const Key& other) const
+            {
+                return mType == other.mType && mID == other.mID;
+            }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const
+            {
+                return std::hash<LLUUID>()(key.mID) ^ (size_t)key.mType;
+            }
+        };
+
+        typedef std::list<Key> lru_list_t;
+
+        struct Entry
+        {
+            U64                 mOffset{ 0 };
+            U32                 mLength{ 0 };
+            U32                 mSizeClass{ 0 };
+            S64                 mLastAccess{ 0 };
+            S64                 mJournaledAccess{ 0 };
+            bool                mPinned{ false };
+            lru_list_t::iterator mLRUIter;
+        };
+
+        typedef std::unordered_map<Key, Entry, KeyHash> entry_map_t;
+
+        /**
+         * On-disk journal record. Fixed size so that a torn write at the
+         * end of the journal is detected by length, and checksummed so that
+         * garbage is detected by content.
+         */
+        struct JournalRecord
+        {
+            U32     mOp;
+            S32     mType;
+            U8      mID[UUID_BYTES];
+            U64     mOffset;
+            U32     mLength;
+            U32     mSizeClass;
+            S64     mTime;
+            U64     mChecksum;
+        };
+        static_assert(sizeof(JournalRecord) == 56, "JournalRecord must not contain padding");
+
+        enum EJournalOp
+        {
+            OP_HEADER = 0x4b50444c,   // "LDPK"
+            OP_SLAB = 1,
+            OP_PUT = 2,
+            OP_REMOVE = 3,
+            OP_TOUCH = 4,
+            OP_FREE_SLAB = 5,
+        };
+
+        struct Slab
+        {
+            U32                 mSizeClass{ 0 };
+            U32                 mUsedSlots{ 0 };
+        };
+
+        /**
+         * Every live slab carved out of the pack file, by offset.
+         */
+        typedef std::map<U64, Slab> slab_map_t;
+
+        static U32 sizeClassFor(U32 bytes);
+        static U32 slotSize(U32 size_class);
+        static U32 slotsPerSlab(U32 size_class);
+        static U64 slabBytes(U32 size_class);
+
+        bool allocateSlot(U32 size_class, U64& offset);
+        void freeSlot(U32 size_class, U64 offset);
+
+        slab_map_t::iterator findSlab(U64 offset);
+        void addSlab(U64 offset, U32 size_class);
+        void releaseSlab(slab_map_t::iterator it);
+        bool takeExtent(U64 bytes, U64 below, U64& offset);
+        void addExtent(U64 offset, U64 bytes);
+        bool moveEntry(entry_map_t::iterator it, U64 to);
+        bool truncateData();
+
+        entry_map_t::iterator findEntry(const Key& key);
+        void eraseEntry(entry_map_t::iterator it, bool journal);
+
+        bool readData(U64 offset, U8* buffer, U32 bytes);
+        bool writeData(U64 offset, const U8* buffer, U32 bytes);
+        bool copyData(U64 from, U64 to, U32 bytes);
+
+        // False if the record could not be written to the journal
+        bool appendRecord(U32 op, const Key& key, U64 offset, U32 length, U32 size_class, S64 time);
+        void appendPut(const Key& key, const Entry& entry);
+        bool flushJournal();
+        bool replayJournal();
+        void applyRecord(const JournalRecord& rec);
+        void rebuildFreeLists();
+        bool writeCompactJournal();
+
+        void clearIndex();
+
+        static S64 now();
+
+    private:
+        std::string         mDataPath;
+        std::string         mJournalPath;
+
+        LLFILE*             mDataFile{ nullptr };
+        LLFILE*             mJournalFile{ nullptr };
+
+        entry_map_t         mEntries;
+        lru_list_t          mLRU;               // front = most recently used
+
+        slab_map_t          mSlabs;
+
+        /**
+         * Holes left by released slabs: offset -> length. Adjacent holes
+         * are merged and a hole never touches the end of the pack.
+         */
+        std::map<U64, U64>  mFreeExtents;
+
+        /**
+         * Free slot offsets, one list per size class.
+         */
+        std::vector<std::vector<U64> > mFreeSlots;
+
+        U64                 mPackEnd{ 0 };
+        uintmax_t           mUsedBytes{ 0 };
+        U32                 mJournalRecords{ 0 };
+
+        /**
+         * All public methods may be called from any thread (the purge
+         * thread, the mesh repository thread, the main thread...).
+         */
+        mutable LLMutex     mMutex;
+};
+
+#endif // LL_LLDISKPACK_H
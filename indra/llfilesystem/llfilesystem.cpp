@@ -41,6 +41,27 @@ const S32 LLFileSystem::APPEND      = 0x00000006;  // 0x00000004 & LLFileSystem:
 
 static LLTrace::BlockTimerStatHandle FTM_VFILE_WAIT("VFile Wait");
 
+LLTrace::CountStatHandle<F64Bytes> LLFileSystem::sBytesMapped("cache_bytes_mapped", "Asset cache bytes served through memory mapped views");
+LLTrace::CountStatHandle<F64Bytes> LLFileSystem::sBytesCopied("cache_bytes_copied", "Asset cache bytes served by copying");
+
+// Below this size a plain read is cheaper than setting up (and faulting
+// in) a mapping, so views of small ranges are copied instead.
+static const S32 MIN_MAPPED_VIEW_BYTES = 16 * 1024;
+
+static bool allocate_view_buffer(std::vector<U8>& buffer, S32 bytes)
+{
+    try
+    {
+        buffer.resize(bytes);
+    }
+    catch (const std::bad_alloc&)
+    {
+        LL_WARNS() << "Failed to allocate " << bytes << " bytes for a cache view" << LL_ENDL;
+        return false;
+    }
+    return true;
+}
+
 LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_type, S32 mode)
 {
     mFileType = file_type;
@@ -54,6 +75,12 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
     // we decided to follow Henri's suggestion and move the code to update the last access time here.
     if (mode == LLFileSystem::READ)
     {
+        if (LLDiskPack* pack = LLDiskCache::getInstance()->getPack())
+        {
+            pack->touch(mFileID, mFileType);
+            return;
+        }
+
         // build the filename (TODO: we do this in a few places - perhaps we should factor into a single function)
         std::string id;
         mFileID.toString(id);
@@ -80,6 +107,11 @@ LLFileSystem::~LLFileSystem()
 bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    if (LLDiskPack* pack = LLDiskCache::getInstance()->getPack())
+    {
+        return pack->exists(file_id, file_type);
+    }
+
     std::string id_str;
     file_id.toString(id_str);
     const std::string extra_info = "";
@@ -106,6 +138,12 @@ bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType fil
 bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType file_type, int suppress_error /*= 0*/)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    if (LLDiskPack* pack = LLDiskCache::getInstance()->getPack())
+    {
+        pack->remove(file_id, file_type);
+        return true;
+    }
+
     std::string id_str;
     file_id.toString(id_str);
     const std::string extra_info = "";
@@ -121,6 +159,16 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
                               const LLUUID& new_file_id, const LLAssetType::EType new_file_type)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    if (LLDiskPack* pack = LLDiskCache::getInstance()->getPack())
+    {
+        // Same as below, a failed rename is logged but not reported
+        if (!pack->rename(old_file_id, old_file_type, new_file_id, new_file_type))
+        {
+            LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_file_id << " in asset pack" << LL_ENDL;
+        }
+        return TRUE;
+    }
+
     std::string old_id_str;
     old_file_id.toString(old_id_str);
     const std::string extra_info = "";
@@ -149,6 +197,11 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
 S32 LLFileSystem::getFileSize(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    if (LLDiskPack* pack = LLDiskCache::getInstance()->getPack())
+    {
+        return pack->getSize(file_id, file_type);
+    }
+
     std::string id_str;
     file_id.toString(id_str);
     const std::string extra_info = "";
@@ -177,6 +230,14 @@ BOOL LLFileSystem::read(U8* buffer, S32 bytes)
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
     BOOL success = FALSE;
 
+    if (LLDiskPack* pack = LLDiskCache::getInstance()->getPack())
+    {
+        mBytesRead = pack->read(mFileID, mFileType, mPosition, buffer, bytes);
+        mPosition += mBytesRead;
+        add(sBytesCopied, F64Bytes(mBytesRead));
+        return mBytesRead ? TRUE : FALSE;
+    }
+
     std::string id;
     mFileID.toString(id);
     const std::string extra_info = "";
@@ -214,6 +275,7 @@ BOOL LLFileSystem::read(U8* buffer, S32 bytes)
         {
             mBytesRead = fread(buffer, 1, bytes, file);
             fclose(file);
+            add(sBytesCopied, F64Bytes(mBytesRead));
 
             mPosition += mBytesRead;
             // It probably would be correct to check for mBytesRead == bytes,
@@ -229,6 +291,62 @@ BOOL LLFileSystem::read(U8* buffer, S32 bytes)
     return success;
 }
 
+LLFileSystemView::ptr_t LLFileSystem::getView(S32 offset, S32 bytes)
+{
+    LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    if (bytes < 0)
+    {
+        bytes = getSize() - offset;
+    }
+    if (offset < 0 || bytes <= 0)
+    {
+        return LLFileSystemView::ptr_t();
+    }
+
+    std::vector<U8> buffer;
+    if (LLDiskPack* pack = LLDiskCache::getInstance()->getPack())
+    {
+        // Pack slots get reused once evicted, never map them
+        if (!allocate_view_buffer(buffer, bytes) ||
+            pack->read(mFileID, mFileType, offset, buffer.data(), bytes) != bytes)
+        {
+            return LLFileSystemView::ptr_t();
+        }
+        add(sBytesCopied, F64Bytes(bytes));
+        return LLFileSystemView::fromBuffer(std::move(buffer));
+    }
+
+    std::string id;
+    mFileID.toString(id);
+    const std::string extra_info = "";
+    const std::string filename = LLDiskCache::getInstance()->metaDataToFilepath(id, mFileType, extra_info);
+
+    if (bytes >= MIN_MAPPED_VIEW_BYTES)
+    {
+        LLFileSystemView::ptr_t view = LLFileSystemView::mapFile(filename, offset, bytes);
+        if (view)
+        {
+            add(sBytesMapped, F64Bytes(bytes));
+            return view;
+        }
+    }
+
+    LLFILE* file = LLFile::fopen(filename, "rb");
+    if (!file)
+    {
+        return LLFileSystemView::ptr_t();
+    }
+    bool success = allocate_view_buffer(buffer, bytes) &&
+                   fseek(file, offset, SEEK_SET) == 0 && fread(buffer.data(), 1, bytes, file) == (size_t)bytes;
+    fclose(file);
+    if (!success)
+    {
+        return LLFileSystemView::ptr_t();
+    }
+    add(sBytesCopied, F64Bytes(bytes));
+    return LLFileSystemView::fromBuffer(std::move(buffer));
+}
+
 S32 LLFileSystem::getLastBytesRead()
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
@@ -244,6 +362,27 @@ BOOL LLFileSystem::eof()
 BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    if (LLDiskPack* pack = LLDiskCache::getInstance()->getPack())
+    {
+        // Mirror the file based modes below: WRITE replaces the asset,
+        // APPEND adds at the end and READ_WRITE writes at mPosition.
+        S32 offset = 0;
+        if (mMode == APPEND)
+        {
+            offset = pack->getSize(mFileID, mFileType);
+        }
+        else if (mMode == READ_WRITE)
+        {
+            offset = mPosition;
+        }
+        if (!pack->write(mFileID, mFileType, offset, buffer, bytes, mMode == WRITE))
+        {
+            return FALSE;
+        }
+        mPosition = offset + bytes;
+        return TRUE;
+    }
+
     std::string id_str;
     mFileID.toString(id_str);
     const std::string extra_info = "";
@@ -33,6 +33,8 @@
 #include "lluuid.h"
 #include "llassettype.h"
 #include "lldiskcache.h"
+#include "llfilesystemview.h"
+#include "lltrace.h"
 
 class LLFileSystem
 {
@@ -41,6 +43,16 @@ class LLFileSystem
         ~LLFileSystem();
 
         BOOL read(U8* buffer, S32 bytes);
+
+        /**
+         * Zero-copy alternative to seek() + read(): returns a read-only view
+         * of 'bytes' bytes starting at 'offset' (bytes < 0 means up to the
+         * end of the file), or a null pointer if the range is not cached.
+         * Large ranges are memory mapped from the cache file, small ones and
+         * pack file entries are copied once into the view. Does not move
+         * the read position.
+         */
+        LLFileSystemView::ptr_t getView(S32 offset = 0, S32 bytes = -1);
         S32  getLastBytesRead();
         BOOL eof();
 
@@ -60,6 +72,13 @@ class LLFileSystem
         static S32 getFileSize(const LLUUID& file_id, const LLAssetType::EType file_type);
 
     public:
+        /**
+         * Cache bytes handed out through mapped views and through copies
+         * (read() and small or pack file backed views)
+         */
+        static LLTrace::CountStatHandle<F64Bytes> sBytesMapped;
+        static LLTrace::CountStatHandle<F64Bytes> sBytesCopied;
+
         static const S32 READ;
         static const S32 WRITE;
         static const S32 READ_WRITE;
@@ -0,0 +1,140 @@
+/**
+ * @file llfilesystemview.cpp
+ * @brief Read-only, reference counted view of cached asset data.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llfilesystemview.h"
+
+#if LL_WINDOWS
+#include "llstring.h"
+#include "llwin32headerslean.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LLFileSystemView::~LLFileSystemView()
+{
+    if (mMapBase)
+    {
+#if LL_WINDOWS
+        UnmapViewOfFile(mMapBase);
+#else
+        munmap(mMapBase, mMapLength);
+#endif
+    }
+}
+
+//static
+LLFileSystemView::ptr_t LLFileSystemView::mapFile(const std::string& filename, S32 offset, S32 bytes)
+{
+    if (offset < 0 || bytes <= 0)
+    {
+        return ptr_t();
+    }
+
+#if LL_WINDOWS
+    HANDLE file = CreateFileW(utf8str_to_utf16str(filename).c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return ptr_t();
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < (LONGLONG)offset + bytes)
+    {
+        CloseHandle(file);
+        return ptr_t();
+    }
+
+    // The view keeps the mapping object (and the file) alive
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping)
+    {
+        return ptr_t();
+    }
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const S32 aligned_offset = offset - (offset % (S32)info.dwAllocationGranularity);
+    const size_t map_length = (size_t)(offset - aligned_offset) + bytes;
+    void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, (DWORD)aligned_offset, map_length);
+    CloseHandle(mapping);
+    if (!base)
+    {
+        return ptr_t();
+    }
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return ptr_t();
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t)offset + bytes)
+    {
+        ::close(fd);
+        return ptr_t();
+    }
+
+    static const S32 page_size = (S32)sysconf(_SC_PAGESIZE);
+    const S32 aligned_offset = offset - (offset % page_size);
+    const size_t map_length = (size_t)(offset - aligned_offset) + bytes;
+    void* base = mmap(nullptr, map_length, PROT_READ, MAP_PRIVATE, fd, aligned_offset);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (base == MAP_FAILED)
+    {
+        return ptr_t();
+    }
+    // Consumers parse the whole range front to back
+    madvise(base, map_length, MADV_WILLNEED);
+#endif
+
+    ptr_t view = new LLFileSystemView();
+    view->mMapBase = base;
+    view->mMapLength = map_length;
+    view->mData = (const U8*)base + (offset - aligned_offset);
+    view->mSize = bytes;
+    return view;
+}
+
+//static
+LLFileSystemView::ptr_t LLFileSystemView::fromBuffer(std::vector<U8>&& buffer)
+{
+    ptr_t view = new LLFileSystemView();
+    view->mBuffer = std::move(buffer);
+    view->mData = view->mBuffer.data();
+    view->mSize = (S32)view->mBuffer.size();
+    return view;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file llfilesystemview.h
+ * @brief Read-only, reference counted view of cached asset data.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_FILESYSTEMVIEW_H
+#define LL_FILESYSTEMVIEW_H
+
+#include "llpointer.h"
+#include "llrefcount.h"
+
+#include <vector>
+
+/**
+ * A read-only window on (a range of) a cached asset, returned by
+ * LLFileSystem::getView(). Depending on its size and on the cache
+ * backend, the data is either memory mapped straight from the cache file
+ * or copied once into a buffer owned by the view. Either way, consumers
+ * can parse directly from getData() for as long as they hold the pointer.
+ *
+ * The mapping is read-only: writing through getData() faults.
+ */
+class LLFileSystemView : public LLThreadSafeRefCount
+{
+    public:
+        typedef LLPointer<LLFileSystemView> ptr_t;
+
+        const U8* getData() const { return mData; }
+        S32 getSize() const { return mSize; }
+
+        /**
+         * True when the data is backed by a file mapping rather than a copy
+         */
+        bool isMapped() const { return mMapBase != nullptr; }
+
+        /**
+         * Map 'bytes' bytes of filename starting at 'offset'. Returns a null
+         * pointer if the file cannot be opened or is too short.
+         */
+        static ptr_t mapFile(const std::string& filename, S32 offset, S32 bytes);
+
+        /**
+         * Take ownership of an already filled buffer.
+         */
+        static ptr_t fromBuffer(std::vector<U8>&& buffer);
+
+    protected:
+        ~LLFileSystemView();
+
+    private:
+        LLFileSystemView() = default;
+
+        const U8*       mData{ nullptr };
+        S32             mSize{ 0 };
+
+        void*           mMapBase{ nullptr };
+        size_t          mMapLength{ 0 };
+
+        std::vector<U8> mBuffer;
+};
+
+#endif  // LL_FILESYSTEMVIEW_H
@@ -0,0 +1,324 @@
+/**
+ * @file lldiskpack_test.cpp
+ * @brief LLDiskPack test cases.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "lltut.h"
+#include "stringize.h"
+#include "../lldiskpack.h"
+
+#include <vector>
+
+namespace tut
+{
+    struct LLDiskPackFixture
+    {
+        LLDiskPackFixture()
+        {
+            LLUUID random;
+            random.generate();
+            mBasePath = STRINGIZE(LLFile::tmpdir() << "lldiskpack-test-" << random);
+        }
+
+        ~LLDiskPackFixture()
+        {
+            LLDiskPack::deleteFiles(mBasePath);
+        }
+
+        static std::vector<U8> makeData(size_t size, U8 seed)
+        {
+            std::vector<U8> data(size);
+            for (size_t i = 0; i < size; ++i)
+            {
+                data[i] = (U8)(seed + i * 7);
+            }
+            return data;
+        }
+
+        static std::vector<U8> readAll(LLDiskPack& pack, const LLUUID& id, LLAssetType::EType type)
+        {
+            std::vector<U8> data(pack.getSize(id, type));
+            if (!data.empty())
+            {
+                data.resize(pack.read(id, type, 0, data.data(), (S32)data.size()));
+            }
+            return data;
+        }
+
+        std::string mBasePath;
+    };
+    typedef test_group<LLDiskPackFixture> LLDiskPackTest_factory;
+    typedef LLDiskPackTest_factory::object LLDiskPackTest_t;
+    LLDiskPackTest_factory tf("LLDiskPack");
+
+    template<> template<>
+    void LLDiskPackTest_t::test<1>()
+    {
+        set_test_name("write, read and remove");
+
+        LLDiskPack pack(mBasePath);
+        bool created = false;
+        ensure("open", pack.open(created));
+        ensure("new pack", created);
+
+        LLUUID id;
+        id.generate();
+        const std::vector<U8> data = makeData(10000, 1);
+        ensure("missing", !pack.exists(id, LLAssetType::AT_MESH));
+        ensure("write", pack.write(id, LLAssetType::AT_MESH, 0, data.data(), (S32)data.size(), true));
+        ensure("exists", pack.exists(id, LLAssetType::AT_MESH));
+        ensure("keyed by type", !pack.exists(id, LLAssetType::AT_SOUND));
+        ensure_equals("size", pack.getSize(id, LLAssetType::AT_MESH), (S32)data.size());
+        ensure("content", readAll(pack, id, LLAssetType::AT_MESH) == data);
+
+        U8 tail[100];
+        ensure_equals("short read at end", pack.read(id, LLAssetType::AT_MESH, 9950, tail, sizeof(tail)), 50);
+        ensure_equals("tail content", tail[0], data[9950]);
+
+        ensure("remove", pack.remove(id, LLAssetType::AT_MESH));
+        ensure("removed", !pack.exists(id, LLAssetType::AT_MESH));
+        ensure_equals("no space used", pack.getUsedBytes(), (uintmax_t)0);
+    }
+
+    template<> template<>
+    void LLDiskPackTest_t::test<2>()
+    {
+        set_test_name("append and in-place writes");
+
+        LLDiskPack pack(mBasePath);
+        bool created = false;
+        ensure("open", pack.open(created));
+
+        LLUUID id;
+        id.generate();
+        // Grow well past the first slot so that the entry has to move
+        std::vector<U8> expected;
+        for (U8 i = 0; i < 20; ++i)
+        {
+            const std::vector<U8> chunk = makeData(3000, i);
+            ensure("append", pack.write(id, LLAssetType::AT_SOUND, pack.getSize(id, LLAssetType::AT_SOUND),
+                                        chunk.data(), (S32)chunk.size(), false));
+            expected.insert(expected.end(), chunk.begin(), chunk.end());
+        }
+        ensure("appended content", readAll(pack, id, LLAssetType::AT_SOUND) == expected);
+
+        const std::vector<U8> patch = makeData(500, 99);
+        ensure("overwrite", pack.write(id, LLAssetType::AT_SOUND, 1000, patch.data(), (S32)patch.size(), false));
+        std::copy(patch.begin(), patch.end(), expected.begin() + 1000);
+        ensure("patched content", readAll(pack, id, LLAssetType::AT_SOUND) == expected);
+
+        const std::vector<U8> replacement = makeData(100, 42);
+        ensure("truncate", pack.write(id, LLAssetType::AT_SOUND, 0, replacement.data(), (S32)replacement.size(), true));
+        ensure("replaced content", readAll(pack, id, LLAssetType::AT_SOUND) == replacement);
+    }
+
+    template<> template<>
+    void LLDiskPackTest_t::test<3>()
+    {
+        set_test_name("index survives reopen");
+
+        LLUUID kept, removed, renamed, target;
+        kept.generate();
+        removed.generate();
+        renamed.generate();
+        target.generate();
+        const std::vector<U8> data = makeData(70000, 3);
+        // Bigger than a slab, so its slot is not shared with anything else
+        const std::vector<U8> big = makeData(1500000, 4);
+        {
+            LLDiskPack pack(mBasePath);
+            bool created = false;
+            ensure("open", pack.open(created));
+            pack.write(kept, LLAssetType::AT_TEXTURE, 0, data.data(), (S32)data.size(), true);
+            pack.write(removed, LLAssetType::AT_TEXTURE, 0, big.data(), (S32)big.size(), true);
+            pack.write(renamed, LLAssetType::AT_TEXTURE, 0, data.data(), 200, true);
+            pack.remove(removed, LLAssetType::AT_TEXTURE);
+            ensure("rename", pack.rename(renamed, LLAssetType::AT_TEXTURE, target, LLAssetType::AT_OBJECT));
+        }
+
+        LLDiskPack pack(mBasePath);
+        bool created = true;
+        ensure("reopen", pack.open(created));
+        ensure("existing pack", !created);
+        ensure_equals("entries", pack.getEntryCount(), (size_t)2);
+        ensure("kept content", readAll(pack, kept, LLAssetType::AT_TEXTURE) == data);
+        ensure("removed", !pack.exists(removed, LLAssetType::AT_TEXTURE));
+        ensure("old name", !pack.exists(renamed, LLAssetType::AT_TEXTURE));
+        ensure_equals("new name", pack.getSize(target, LLAssetType::AT_OBJECT), 200);
+
+        // The slot freed by the removal is reused instead of growing the pack
+        const uintmax_t pack_bytes = pack.getPackBytes();
+        LLUUID reuse;
+        reuse.generate();
+        pack.write(reuse, LLAssetType::AT_TEXTURE, 0, big.data(), (S32)big.size(), true);
+        ensure_equals("slot reused", pack.getPackBytes(), pack_bytes);
+    }
+
+    template<> template<>
+    void LLDiskPackTest_t::test<4>()
+    {
+        set_test_name("LRU purge");
+
+        LLDiskPack pack(mBasePath);
+        bool created = false;
+        ensure("open", pack.open(created));
+
+        const std::vector<U8> data = makeData(4096, 5);
+        LLUUID ids[4];
+        for (LLUUID& id : ids)
+        {
+            id.generate();
+            pack.write(id, LLAssetType::AT_ANIMATION, 0, data.data(), (S32)data.size(), true);
+        }
+        const uintmax_t per_entry = pack.getUsedBytes() / 4;
+
+        // ids[0] is the oldest, but was used recently; ids[1] is pinned
+        pack.touch(ids[0], LLAssetType::AT_ANIMATION);
+        pack.setPinned(ids[1], LLAssetType::AT_ANIMATION, true);
+
+        ensure_equals("below high water", pack.purge(per_entry * 5, per_entry), 0U);
+        ensure_equals("evicted", pack.purge(per_entry * 4, per_entry * 2), 2U);
+        ensure("recently used kept", pack.exists(ids[0], LLAssetType::AT_ANIMATION));
+        ensure("pinned kept", pack.exists(ids[1], LLAssetType::AT_ANIMATION));
+        ensure("oldest evicted", !pack.exists(ids[2], LLAssetType::AT_ANIMATION));
+        ensure("next oldest evicted", !pack.exists(ids[3], LLAssetType::AT_ANIMATION));
+    }
+
+    template<> template<>
+    void LLDiskPackTest_t::test<5>()
+    {
+        set_test_name("torn journal tail is ignored");
+
+        LLUUID id;
+        id.generate();
+        const std::vector<U8> data = makeData(1234, 9);
+        {
+            LLDiskPack pack(mBasePath);
+            bool created = false;
+            ensure("open", pack.open(created));
+            pack.write(id, LLAssetType::AT_MESH, 0, data.data(), (S32)data.size(), true);
+        }
+
+        // Simulate a crash in the middle of appending a record
+        LLFILE* journal = LLFile::fopen(mBasePath + ".journal", "ab");
+        ensure("journal", journal != nullptr);
+        const std::vector<U8> garbage = makeData(30, 77);
+        fwrite(garbage.data(), 1, garbage.size(), journal);
+        fclose(journal);
+
+        LLDiskPack pack(mBasePath);
+        bool created = true;
+        ensure("reopen", pack.open(created));
+        ensure("existing pack", !created);
+        ensure("content", readAll(pack, id, LLAssetType::AT_MESH) == data);
+    }
+
+    template<> template<>
+    void LLDiskPackTest_t::test<6>()
+    {
+        set_test_name("compaction shrinks the pack file");
+
+        const std::vector<U8> small = makeData(3000, 11);
+        const std::vector<U8> medium = makeData(10000, 12);
+        const std::vector<U8> large = makeData(60000, 13);
+        LLUUID small_id, large_id;
+        small_id.generate();
+        large_id.generate();
+        std::vector<LLUUID> medium_ids(200);
+        {
+            LLDiskPack pack(mBasePath);
+            bool created = false;
+            ensure("open", pack.open(created));
+
+            // One slab of small slots, two of medium ones, then one of large
+            // ones at the end of the pack
+            pack.write(small_id, LLAssetType::AT_TEXTURE, 0, small.data(), (S32)small.size(), true);
+            for (LLUUID& id : medium_ids)
+            {
+                id.generate();
+                pack.write(id, LLAssetType::AT_TEXTURE, 0, medium.data(), (S32)medium.size(), true);
+            }
+            pack.write(large_id, LLAssetType::AT_TEXTURE, 0, large.data(), (S32)large.size(), true);
+            const uintmax_t full_bytes = pack.getPackBytes();
+
+            for (const LLUUID& id : medium_ids)
+            {
+                pack.remove(id, LLAssetType::AT_TEXTURE);
+            }
+            ensure_equals("nothing released by removal", pack.getPackBytes(), full_bytes);
+
+            const U64 released = pack.compact();
+            ensure("released", released > 0);
+            ensure_equals("pack bytes", (U64)pack.getPackBytes(), (U64)full_bytes - released);
+            ensure("two slabs left", pack.getPackBytes() <= 2 * 1024 * 1024);
+            llstat data_stat;
+            ensure("stat", LLFile::stat(mBasePath + ".data", &data_stat) == 0);
+            ensure_equals("file truncated", (U64)data_stat.st_size, (U64)pack.getPackBytes());
+            ensure("moved content", readAll(pack, large_id, LLAssetType::AT_TEXTURE) == large);
+            ensure("kept content", readAll(pack, small_id, LLAssetType::AT_TEXTURE) == small);
+            ensure_equals("nothing left to do", pack.compact(), (U64)0);
+        }
+
+        LLDiskPack pack(mBasePath);
+        bool created = true;
+        ensure("reopen", pack.open(created));
+        ensure("existing pack", !created);
+        ensure("moved content after reopen", readAll(pack, large_id, LLAssetType::AT_TEXTURE) == large);
+        ensure("kept content after reopen", readAll(pack, small_id, LLAssetType::AT_TEXTURE) == small);
+    }
+
+    template<> template<>
+    void LLDiskPackTest_t::test<7>()
+    {
+        set_test_name("released slabs are reused by other size classes");
+
+        LLDiskPack pack(mBasePath);
+        bool created = false;
+        ensure("open", pack.open(created));
+
+        // A 10K slab, then a 4K slab that is slightly bigger and cannot
+        // move into the space the first one leaves
+        const std::vector<U8> medium = makeData(10000, 21);
+        const std::vector<U8> small = makeData(3000, 22);
+        LLUUID medium_id, small_id, other_id;
+        medium_id.generate();
+        small_id.generate();
+        other_id.generate();
+        pack.write(medium_id, LLAssetType::AT_MESH, 0, medium.data(), (S32)medium.size(), true);
+        pack.write(small_id, LLAssetType::AT_MESH, 0, small.data(), (S32)small.size(), true);
+        const uintmax_t pack_bytes = pack.getPackBytes();
+
+        pack.remove(medium_id, LLAssetType::AT_MESH);
+        ensure_equals("tail slab cannot move", pack.compact(), (U64)0);
+
+        // A 20K slab fits in the hole
+        const std::vector<U8> other = makeData(20000, 23);
+        pack.write(other_id, LLAssetType::AT_MESH, 0, other.data(), (S32)other.size(), true);
+        ensure_equals("hole reused", pack.getPackBytes(), pack_bytes);
+        ensure("content", readAll(pack, other_id, LLAssetType::AT_MESH) == other);
+        ensure("kept content", readAll(pack, small_id, LLAssetType::AT_MESH) == small);
+    }
+}
@@ -43,6 +43,36 @@ LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl();
 LLImageCompressionTester* LLImageJ2C::sTesterp = NULL ;
 const std::string sTesterName("ImageCompressionTester");
 
+std::atomic<S64> LLImageJ2C::sRetainedDecoderBudget(0);
+std::atomic<S64> LLImageJ2C::sRetainedDecoderBytes(0);
+
+//static
+void LLImageJ2C::setRetainedDecoderBudget(S64 max_bytes)
+{
+	sRetainedDecoderBudget = llmax(max_bytes, (S64)0);
+}
+
+//static
+bool LLImageJ2C::reserveRetainedDecoder(S64 bytes)
+{
+	S64 used = sRetainedDecoderBytes;
+	do
+	{
+		if (used + bytes > sRetainedDecoderBudget)
+		{
+			return false;
+		}
+	}
+	while (!sRetainedDecoderBytes.compare_exchange_weak(used, used + bytes));
+	return true;
+}
+
+//static
+void LLImageJ2C::releaseRetainedDecoder(S64 bytes)
+{
+	sRetainedDecoderBytes -= bytes;
+}
+
 //static
 std::string LLImageJ2C::getEngineInfo()
 {
@@ -31,6 +31,7 @@
 #include "llassettype.h"
 #include "llmetricperformancetester.h"
 #include <boost/scoped_ptr.hpp>
+#include <atomic>
 
 // JPEG2000 : compression rate used in j2c conversion.
 const F32 DEFAULT_COMPRESSION_RATE = 1.f/8.f;
@@ -79,6 +80,14 @@ public:
 
 	static std::string getEngineInfo();
 
+	// Implementations may keep their decoder state alive between two
+	// decodes of the same data, so that decoding it again at another
+	// discard level, or decoding the aux channel after the others,
+	// doesn't start from scratch.  max_bytes bounds the memory held by
+	// all retained decoders together; 0 disables retention.
+	static void setRetainedDecoderBudget(S64 max_bytes);
+	static bool getRetainDecoders() { return sRetainedDecoderBudget > 0; }
+
 protected:
 	friend class LLImageJ2CImpl;
 	friend class LLImageJ2COJ;
@@ -100,6 +109,14 @@ protected:
 
     // Image compression/decompression tester
 	static LLImageCompressionTester* sTesterp;
+
+	// Retained decoder accounting, see setRetainedDecoderBudget().
+	// reserveRetainedDecoder() returns false when over budget.
+	static bool reserveRetainedDecoder(S64 bytes);
+	static void releaseRetainedDecoder(S64 bytes);
+
+	static std::atomic<S64> sRetainedDecoderBudget;
+	static std::atomic<S64> sRetainedDecoderBytes;
 };
 
 // Derive from this class to implement JPEG2000 decoding
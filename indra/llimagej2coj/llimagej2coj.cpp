@@ -26,6 +26,7 @@
 
 #include "linden_common.h"
 #include "llimagej2coj.h"
+#include "hbxxh.h"
 
 // this is defined so that we get static linking.
 #include "openjpeg.h"
@@ -386,6 +387,12 @@ public:
             return false;
         }
 
+        if (codestream_info)
+        {
+            opj_destroy_cstr_info(&codestream_info);
+        }
+        codestream_info = opj_get_cstr_info(decoder);
+
         // needs to happen before decode which may fail
         if (channels)
         {
@@ -407,6 +414,66 @@ public:
         return true;
     }
 
+    // Decode again at another discard level after a successful decode(),
+    // given the same bytes decode() had.  OpenJPEG keeps the tile data of
+    // single-tiled codestreams around, so this doesn't parse the codestream
+    // again.  It can't be fed more data though: when the data changes, start
+    // over with decode().
+    bool redecode(U8* data, U32 dataSize, U32* channels, U8 discard_level)
+    {
+        if (!decoder || !image || !image->numcomps || !isSingleTile() || !stream || dataSize != size)
+        {
+            return false;
+        }
+
+        // The stream reads through this object, which still points at the
+        // buffer of the first decode and that one may be gone by now.  Read
+        // from the caller's copy, from where the stream left off.
+        buffer = data;
+        offset = llclamp(offset, (OPJ_OFF_T)0, (OPJ_OFF_T)dataSize);
+        opj_stream_set_user_data_length(stream, dataSize);
+
+        if (channels)
+        {
+            *channels = image->numcomps;
+        }
+
+        if (image->comps[0].factor == discard_level && image->comps[0].data)
+        {
+            // Already there, e.g. decoding the aux channel after the others
+            return true;
+        }
+
+        if (!opj_set_decoded_resolution_factor(decoder, discard_level) ||
+            !opj_set_decode_area(decoder, image, 0, 0, 0, 0))
+        {
+            return false;
+        }
+
+        OPJ_BOOL decoded = opj_decode(decoder, stream, image);
+        opj_end_decompress(decoder, stream);
+        return decoded && image->numcomps;
+    }
+
+    bool isSingleTile() const
+    {
+        return codestream_info && codestream_info->tw == 1 && codestream_info->th == 1;
+    }
+
+    // Memory held by the decoded component planes
+    S64 getImageBytes() const
+    {
+        S64 bytes = 0;
+        if (image)
+        {
+            for (OPJ_UINT32 comp = 0; comp < image->numcomps; comp++)
+            {
+                bytes += (S64)image->comps[comp].w * image->comps[comp].h * sizeof(OPJ_INT32);
+            }
+        }
+        return bytes;
+    }
+
     opj_image_t* getImage() { return image; }
 
 private:
@@ -711,13 +778,87 @@ private:
 
 
 LLImageJ2COJ::LLImageJ2COJ()
-	: LLImageJ2CImpl()
+	: LLImageJ2CImpl(),
+	  mDecoderDataSize(0),
+	  mDecoderDataHash(0),
+	  mDecoderBytes(0)
 {
 }
 
 
 LLImageJ2COJ::~LLImageJ2COJ()
 {
+	releaseDecoder();
+}
+
+std::mutex LLImageJ2COJ::sRetainedMutex;
+std::list<LLImageJ2COJ*> LLImageJ2COJ::sRetained;
+
+std::unique_ptr<JPEG2KDecode> LLImageJ2COJ::unretainLocked()
+{
+	std::unique_ptr<JPEG2KDecode> decoder(std::move(mDecoder));
+	if (decoder)
+	{
+		sRetained.erase(mRetainedPos);
+		LLImageJ2C::releaseRetainedDecoder(mDecoderBytes);
+	}
+	mDecoderDataSize = 0;
+	mDecoderDataHash = 0;
+	mDecoderBytes = 0;
+	return decoder;
+}
+
+std::unique_ptr<JPEG2KDecode> LLImageJ2COJ::takeDecoder(S32 data_size, U64 data_hash)
+{
+	std::unique_ptr<JPEG2KDecode> decoder;
+	{
+		std::lock_guard<std::mutex> lock(sRetainedMutex);
+		bool same_data = (mDecoderDataSize == data_size && mDecoderDataHash == data_hash);
+		decoder = unretainLocked();
+		if (same_data)
+		{
+			return decoder;
+		}
+	}
+	// Outdated, destroyed outside the lock
+	return nullptr;
+}
+
+void LLImageJ2COJ::retainDecoder(std::unique_ptr<JPEG2KDecode> decoder, S32 data_size, U64 data_hash)
+{
+	S64 bytes = (S64)data_size + decoder->getImageBytes();
+	// Evicted decoders, destroyed outside the lock
+	std::vector<std::unique_ptr<JPEG2KDecode> > evicted;
+	{
+		std::lock_guard<std::mutex> lock(sRetainedMutex);
+		evicted.push_back(unretainLocked());
+		// Least recently used first
+		while (!LLImageJ2C::reserveRetainedDecoder(bytes))
+		{
+			if (sRetained.empty())
+			{
+				// Larger than the whole budget
+				evicted.push_back(std::move(decoder));
+				return;
+			}
+			evicted.push_back(sRetained.back()->unretainLocked());
+		}
+		mDecoder = std::move(decoder);
+		mDecoderDataSize = data_size;
+		mDecoderDataHash = data_hash;
+		mDecoderBytes = bytes;
+		mRetainedPos = sRetained.insert(sRetained.begin(), this);
+	}
+}
+
+void LLImageJ2COJ::releaseDecoder()
+{
+	// destroyed outside the lock
+	std::unique_ptr<JPEG2KDecode> decoder;
+	{
+		std::lock_guard<std::mutex> lock(sRetainedMutex);
+		decoder = unretainLocked();
+	}
 }
 
 bool LLImageJ2COJ::initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level, int* region)
@@ -735,8 +876,6 @@ bool LLImageJ2COJ::initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int block
 
 bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decode_time, S32 first_channel, S32 max_channel_count)
 {
-    JPEG2KDecode decoder(0);
-
     // <FS:Techwolf Lupindo> texture comment metadata reader
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;	// <FS:Beq> instrument image decodes
     U8* c_data = base.getData();
@@ -781,7 +920,21 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     U32 image_channels = 0;
     S32 data_size = base.getDataSize();
     S32 max_bytes = (base.getMaxBytes() ? base.getMaxBytes() : data_size);
-    bool decoded = decoder.decode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel);
+
+    // Reuse the decoder kept from the last decode if the data didn't change
+    // since.  The hash is cheap next to a decode and, unlike the data
+    // pointer, can't be fooled by a new buffer landing at the same address.
+    // The decoder leaves the retained list while in use, so other decodes
+    // can't evict it from under this one.
+    bool retain = LLImageJ2C::getRetainDecoders();
+    U64 data_hash = retain ? HBXXH64::digest(base.getData(), max_bytes) : 0;
+    std::unique_ptr<JPEG2KDecode> decoder = takeDecoder(max_bytes, data_hash);
+    bool decoded = retain && decoder && decoder->redecode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel);
+    if (!decoded)
+    {
+        decoder.reset(new JPEG2KDecode(0));
+        decoded = decoder->decode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel);
+    }
 
     // set correct channel count early so failed decodes don't miss it...
     S32 channels = (S32)image_channels - first_channel;
@@ -802,7 +955,7 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
         return true; // done
     }
 
-    opj_image_t *image = decoder.getImage();
+    opj_image_t *image = decoder->getImage();
 
     // Component buffers are allocated in an image width by height buffer.
     // The image placed in that buffer is ceil(width/2^factor) by
@@ -860,6 +1013,14 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 
     base.setDiscardLevel(f);
 
+    // Once the full resolution is out with its last channel, nothing is
+    // left to decode from this data: don't hold on to the decoder.
+    bool final_decode = (f == 0) && (first_channel + channels >= (S32)image_channels);
+    if (retain && !final_decode && decoder->isSingleTile())
+    {
+        retainDecoder(std::move(decoder), max_bytes, data_hash);
+    }
+
     return true; // done
 }
 
@@ -29,6 +29,11 @@
 
 #include "llimagej2c.h"
 
+#include <list>
+#include <mutex>
+
+class JPEG2KDecode;
+
 class LLImageJ2COJ : public LLImageJ2CImpl
 {	
 public:
@@ -42,6 +47,29 @@ protected:
 	virtual bool initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level = -1, int* region = NULL);
 	virtual bool initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int blocks_size = -1, int precincts_size = -1, int levels = 0);
     virtual std::string getEngineInfo() const;
+
+private:
+	// Hands the retained decoder over to a decode of the given data, or
+	// returns null if there is none or it was for other data.
+	std::unique_ptr<JPEG2KDecode> takeDecoder(S32 data_size, U64 data_hash);
+	// Keeps a decoder for later decodes of the same data, evicting the least
+	// recently used ones to stay within the budget.
+	void retainDecoder(std::unique_ptr<JPEG2KDecode> decoder, S32 data_size, U64 data_hash);
+	void releaseDecoder();
+	// Unlinks the retained decoder and returns its budget, with sRetainedMutex held.
+	std::unique_ptr<JPEG2KDecode> unretainLocked();
+
+	// Decoder kept from the last decode of single-tiled data, reused
+	// while the data doesn't change.  See LLImageJ2C::setRetainedDecoderBudget().
+	// Guarded by sRetainedMutex, since any decode thread may evict it.
+	std::unique_ptr<JPEG2KDecode> mDecoder;
+	S32 mDecoderDataSize;
+	U64 mDecoderDataHash;
+	S64 mDecoderBytes;
+	std::list<LLImageJ2COJ*>::iterator mRetainedPos;	// valid while mDecoder is set
+
+	static std::mutex sRetainedMutex;
+	static std::list<LLImageJ2COJ*> sRetained;			// most recently used first
 };
 
 #endif
@@ -96,6 +96,14 @@ public:
 	// Return true if all components are finite and the quaternion is normalized
 	inline bool isOkRotation() const;
 
+	/////////////////////////
+	// Interpolation
+	/////////////////////////
+
+	// Blend count pairs of quaternions the way nlerp(u[i], a[i], b[i]) does,
+	// with the component math done in one vector op. out may alias a or b.
+	static inline void nlerp(U32 count, const F32* u, const LLQuaternion* a, const LLQuaternion* b, LLQuaternion* out);
+
 protected:
 
 	LLVector4a mQ;
@@ -100,3 +100,44 @@ inline bool LLQuaternion2::isOkRotation() const
 	return mQ.isFinite4() && mQ.isNormalized4();
 }
 
+/////////////////////////
+// Interpolation
+/////////////////////////
+
+inline void LLQuaternion2::nlerp(U32 count, const F32* u, const LLQuaternion* a, const LLQuaternion* b, LLQuaternion* out)
+{
+	LLVector4a qa, qb, blend;
+	for (U32 i = 0; i < count; ++i)
+	{
+		qa.loadua(a[i].mQ);
+		qb.loadua(b[i].mQ);
+
+		F32 alpha = u[i];
+		F32 beta = 1.f - alpha;
+		F32 cos_t = qa.dot4(qb).getF32();
+		if (cos_t < 0.f)
+		{
+			// Opposite hemispheres go the slerp() way, which blends towards
+			// -a and is unit length without renormalizing
+			cos_t = -cos_t;
+			if (1.f - cos_t >= 0.00001f)
+			{
+				F32 theta = acosf(cos_t);
+				F32 sin_t = sinf(theta);
+				beta = sinf(theta - alpha * theta) / sin_t;
+				alpha = sinf(alpha * theta) / sin_t;
+			}
+			qa.mul(-beta);
+			qb.mul(alpha);
+			blend.setAdd(qa, qb);
+		}
+		else
+		{
+			qa.mul(beta);
+			qb.mul(alpha);
+			blend.setAdd(qa, qb);
+			blend.normalize4();
+		}
+		_mm_storeu_ps(out[i].mQ, blend);
+	}
+}
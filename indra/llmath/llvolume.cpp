@@ -2064,6 +2064,8 @@ LLProfile::~LLProfile()
 
 
 S32 LLVolume::sNumMeshPoints = 0;
+bool LLVolume::sDirectLODDecode = false;
+LLAtomicU32 LLVolume::sDirectLODFallbacks(0);
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
 	: mParams(params)
@@ -2402,415 +2404,870 @@ bool LLVolumeFace::VertexData::compareNormal(const LLVolumeFace::VertexData& rhs
 	return retval;
 }
 
-bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
+namespace
 {
-	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+	// A quantized array of a mesh LOD face, pointing into an LLSD binary or
+	// into the buffers of LLMeshLODDecoder
+	struct LLMeshLODArray
+	{
+		const U8* mData = NULL;
+		size_t mSize = 0;
 
-	//input stream is now pointing at a zlib compressed block of LLSD
-	//decompress block
-	LLSD mdl;
-	U32 uzip_result = LLUZipHelper::unzip_llsd(mdl, is, size);
-	if (uzip_result != LLUZipHelper::ZR_OK)
+		bool empty() const	{ return !mSize; }
+	};
+
+	// One face of a mesh LOD the way the asset stores it
+	struct LLMeshLODFace
+	{
+		bool mNoGeometry = false;
+		bool mHasWeights = false;
+		bool mHasNormalizedScale = false;
+
+		LLMeshLODArray mPosition;
+		LLMeshLODArray mNormal;
+		LLMeshLODArray mTangent;
+		LLMeshLODArray mTexCoord0;
+		LLMeshLODArray mTriangleList;
+		LLMeshLODArray mWeights;
+
+		LLVector3 mPositionMin;
+		LLVector3 mPositionMax;
+		LLVector2 mTexCoord0Min;
+		LLVector2 mTexCoord0Max;
+		LLVector3 mNormalizedScale;
+	};
+
+	// out = (F32)q / 65535 * scale + offset for count U16 triplets q, with
+	// a 0 for the fourth component. These are the operations of the
+	// LLVector4a code this replaced, in the same order, so the results are
+	// the same bit for bit.
+	void dequantize_u16x3(LLVector4a* out, const U8* in, U32 count, const LLVector4a& scale, const LLVector4a& offset)
 	{
-		LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
-		return false;
+		if (!count)
+		{
+			return;
+		}
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+		const __m128 max = _mm_set1_ps(65535.f);
+
+		// 8 byte loads take x of the next triplet along, masked off below
+		for (U32 i = 0; i < count - 1; ++i)
+		{
+			__m128i q = _mm_loadl_epi64((const __m128i*)(in + i * 6));
+			__m128 v = _mm_and_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(q, zero)), xyz);
+			v = _mm_div_ps(v, max);
+			v = _mm_mul_ps(v, scale);
+			out[i] = _mm_add_ps(v, offset);
+		}
+
+		U16 last[4] = { 0, 0, 0, 0 };
+		memcpy(last, in + (count - 1) * 6, 6);
+		__m128i q = _mm_loadl_epi64((const __m128i*)last);
+		__m128 v = _mm_cvtepi32_ps(_mm_unpacklo_epi16(q, zero));
+		v = _mm_div_ps(v, max);
+		v = _mm_mul_ps(v, scale);
+		out[count - 1] = _mm_add_ps(v, offset);
 	}
-	return unpackVolumeFacesInternal(mdl);
-}
 
-bool LLVolume::unpackVolumeFaces(U8* in_data, S32 size)
-{
-	//input data is now pointing at a zlib compressed block of LLSD
-	//decompress block
-	LLSD mdl;
-	U32 uzip_result = LLUZipHelper::unzip_llsd(mdl, in_data, size);
-	if (uzip_result != LLUZipHelper::ZR_OK)
+	// Texture coordinates, two U16 pairs to each LLVector4a. An odd last
+	// vertex gets 0, 0 for the pair after it.
+	void dequantize_u16x2(LLVector4a* out, const U8* in, U32 count, const LLVector4a& scale, const LLVector4a& offset)
 	{
-		LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
-		return false;
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 max = _mm_set1_ps(65535.f);
+
+		U32 quads = (count + 1) / 2;
+		for (U32 i = 0; i < quads; ++i)
+		{
+			__m128i q;
+			if (i * 2 + 1 < count)
+			{
+				q = _mm_loadl_epi64((const __m128i*)(in + i * 8));
+			}
+			else
+			{
+				U16 last[4] = { 0, 0, 0, 0 };
+				memcpy(last, in + i * 8, 4);
+				q = _mm_loadl_epi64((const __m128i*)last);
+			}
+			__m128 v = _mm_cvtepi32_ps(_mm_unpacklo_epi16(q, zero));
+			v = _mm_div_ps(v, max);
+			v = _mm_mul_ps(v, scale);
+			out[i] = _mm_add_ps(v, offset);
+		}
 	}
-	return unpackVolumeFacesInternal(mdl);
-}
 
-bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
-{
+	void unpack_mesh_lod_face(LLVolumeFace& face, const LLMeshLODFace& lod_face, size_t i, size_t face_count, bool do_mirror, bool do_invert)
 	{
-		U32 face_count = mdl.size();
-
-		if (face_count == 0)
-		{ //no faces unpacked, treat as failed decode
-			LL_WARNS() << "found no faces!" << LL_ENDL;
-			return false;
+		if (lod_face.mNoGeometry)
+		{ //face has no geometry, continue
+			face.resizeIndices(3);
+			face.resizeVertices(1);
+			face.mPositions->clear();
+			face.mNormals->clear();
+			face.mTexCoords->setZero();
+			memset(face.mIndices, 0, sizeof(U16)*3);
+			return;
 		}
 
-		mVolumeFaces.resize(face_count);
+		const LLMeshLODArray& pos = lod_face.mPosition;
+		const LLMeshLODArray& norm = lod_face.mNormal;
+		const LLMeshLODArray& tc = lod_face.mTexCoord0;
+		const LLMeshLODArray& idx = lod_face.mTriangleList;
 
-		for (size_t i = 0; i < face_count; ++i)
+		//copy out indices
+		S32 num_indices = idx.mSize / 2;
+		const S32 indices_to_discard = num_indices % 3;
+		if (indices_to_discard > 0)
 		{
-			LLVolumeFace& face = mVolumeFaces[i];
+			// Invalid number of triangle indices
+			LL_WARNS() << "Incomplete triangle discarded from face! Indices count " << num_indices << " was not divisible by 3. face index: " << i << " Total: " << face_count << LL_ENDL;
+			num_indices -= indices_to_discard;
+		}
+		face.resizeIndices(num_indices);
 
-			if (mdl[i].has("NoGeometry"))
-			{ //face has no geometry, continue
-				face.resizeIndices(3);
-				face.resizeVertices(1);
-				face.mPositions->clear();
-				face.mNormals->clear();
-				face.mTexCoords->setZero();
-				memset(face.mIndices, 0, sizeof(U16)*3);
-				continue;
-			}
+		if (num_indices > 2 && !face.mIndices)
+		{
+			LL_WARNS() << "Failed to allocate " << num_indices << " indices for face index: " << i << " Total: " << face_count << LL_ENDL;
+			return;
+		}
 
-			LLSD::Binary pos = mdl[i]["Position"];
-			LLSD::Binary norm = mdl[i]["Normal"];
-            LLSD::Binary tangent = mdl[i]["Tangent"];
-			LLSD::Binary tc = mdl[i]["TexCoord0"];
-			LLSD::Binary idx = mdl[i]["TriangleList"];
+		if (idx.empty() || face.mNumIndices < 3)
+		{ //why is there an empty index list?
+			LL_WARNS() << "Empty face present! Face index: " << i << " Total: " << face_count << LL_ENDL;
+			return;
+		}
 
-			//copy out indices
-            S32 num_indices = idx.size() / 2;
-            const S32 indices_to_discard = num_indices % 3;
-            if (indices_to_discard > 0)
-            {
-                // Invalid number of triangle indices
-                LL_WARNS() << "Incomplete triangle discarded from face! Indices count " << num_indices << " was not divisible by 3. face index: " << i << " Total: " << face_count << LL_ENDL;
-                num_indices -= indices_to_discard;
-            }
-            face.resizeIndices(num_indices);
+		memcpy(face.mIndices, idx.mData, num_indices * sizeof(U16));
 
-            if (num_indices > 2 && !face.mIndices)
-            {
-                LL_WARNS() << "Failed to allocate " << num_indices << " indices for face index: " << i << " Total: " << face_count << LL_ENDL;
-                continue;
-            }
-			
-			if (idx.empty() || face.mNumIndices < 3)
-			{ //why is there an empty index list?
-				LL_WARNS() << "Empty face present! Face index: " << i << " Total: " << face_count << LL_ENDL;
-				continue;
-			}
+		//copy out vertices
+		U32 num_verts = pos.mSize/(3*2);
+		face.resizeVertices(num_verts);
 
-			U16* indices = (U16*) &(idx[0]);
-            for (U32 j = 0; j < num_indices; ++j)
-			{
-				face.mIndices[j] = indices[j];
-			}
+		if (num_verts > 0 && !face.mPositions)
+		{
+			LL_WARNS() << "Failed to allocate " << num_verts << " vertices for face index: " << i << " Total: " << face_count << LL_ENDL;
+			face.resizeIndices(0);
+			return;
+		}
 
-			//copy out vertices
-			U32 num_verts = pos.size()/(3*2);
-			face.resizeVertices(num_verts);
+		LLVector4a min_pos, max_pos;
+		min_pos.load3(lod_face.mPositionMin.mV);
+		max_pos.load3(lod_face.mPositionMax.mV);
 
-            if (num_verts > 0 && !face.mPositions)
-            {
-                LL_WARNS() << "Failed to allocate " << num_verts << " vertices for face index: " << i << " Total: " << face_count << LL_ENDL;
-                face.resizeIndices(0);
-                continue;
-            }
+		const LLVector2& min_tc = lod_face.mTexCoord0Min;
+		const LLVector2& max_tc = lod_face.mTexCoord0Max;
 
-			LLVector3 minp;
-			LLVector3 maxp;
-			LLVector2 min_tc; 
-			LLVector2 max_tc; 
-		
-			minp.setValue(mdl[i]["PositionDomain"]["Min"]);
-			maxp.setValue(mdl[i]["PositionDomain"]["Max"]);
-			LLVector4a min_pos, max_pos;
-			min_pos.load3(minp.mV);
-			max_pos.load3(maxp.mV);
+		//unpack normalized scale/translation
+		if (lod_face.mHasNormalizedScale)
+		{
+			face.mNormalizedScale = lod_face.mNormalizedScale;
+		}
+		else
+		{
+			face.mNormalizedScale.set(1, 1, 1);
+		}
 
-			min_tc.setValue(mdl[i]["TexCoord0Domain"]["Min"]);
-			max_tc.setValue(mdl[i]["TexCoord0Domain"]["Max"]);
+		LLVector4a pos_range;
+		pos_range.setSub(max_pos, min_pos);
+		LLVector2 tc_range2 = max_tc - min_tc;
 
-            //unpack normalized scale/translation
-            if (mdl[i].has("NormalizedScale"))
-            {
-                face.mNormalizedScale.setValue(mdl[i]["NormalizedScale"]);
-            }
-            else
-            {
-                face.mNormalizedScale.set(1, 1, 1);
-            }
-            
-			LLVector4a pos_range;
-			pos_range.setSub(max_pos, min_pos);
-			LLVector2 tc_range2 = max_tc - min_tc;
+		LLVector4a tc_range;
+		tc_range.set(tc_range2[0], tc_range2[1], tc_range2[0], tc_range2[1]);
+		LLVector4a min_tc4(min_tc[0], min_tc[1], min_tc[0], min_tc[1]);
 
-			LLVector4a tc_range;
-			tc_range.set(tc_range2[0], tc_range2[1], tc_range2[0], tc_range2[1]);
-			LLVector4a min_tc4(min_tc[0], min_tc[1], min_tc[0], min_tc[1]);
+		dequantize_u16x3(face.mPositions, pos.mData, num_verts, pos_range, min_pos);
 
-			LLVector4a* pos_out = face.mPositions;
-			LLVector4a* norm_out = face.mNormals;
-			LLVector4a* tc_out = (LLVector4a*) face.mTexCoords;
+		// Short arrays read as missing ones instead of past their end
+		if (norm.mSize >= num_verts * 6)
+		{
+			dequantize_u16x3(face.mNormals, norm.mData, num_verts, LLVector4a(2.f), LLVector4a(-1.f));
+		}
+		else
+		{
+			for (U32 j = 0; j < num_verts; ++j)
+			{
+				face.mNormals[j].clear();
+			}
+		}
 
+#if 0 // keep this code for now in case we decide to add support for on-the-wire tangents
+		{
+			const LLMeshLODArray& tangent = lod_face.mTangent;
+			if (!tangent.empty())
 			{
-				U16* v = (U16*) &(pos[0]);
+				face.allocateTangents(face.mNumVertices);
+				U16* t = (U16*)tangent.mData;
+
+				// NOTE: tangents coming from the asset may not be mikkt space, but they should always be used by the GLTF shaders to 
+				// maintain compliance with the GLTF spec
+				LLVector4a* t_out = face.mTangents; 
+
 				for (U32 j = 0; j < num_verts; ++j)
 				{
-					pos_out->set((F32) v[0], (F32) v[1], (F32) v[2]);
-					pos_out->div(65535.f);
-					pos_out->mul(pos_range);
-					pos_out->add(min_pos);
-					pos_out++;
-					v += 3;
+					t_out->set((F32)t[0], (F32)t[1], (F32)t[2], (F32) t[3]);
+					t_out->div(65535.f);
+					t_out->mul(2.f);
+					t_out->sub(1.f);
+
+					F32* tp = t_out->getF32ptr();
+					tp[3] = tp[3] < 0.f ? -1.f : 1.f;
+
+					t_out++;
+					t += 4;
 				}
+			}
+		}
+#endif
+
+		LLVector4a* tc_out = (LLVector4a*) face.mTexCoords;
+		if (tc.mSize >= num_verts * 4)
+		{
+			dequantize_u16x2(tc_out, tc.mData, num_verts, tc_range, min_tc4);
+		}
+		else
+		{
+			for (U32 j = 0; j < num_verts; j += 2)
+			{
+				tc_out->clear();
+				tc_out++;
+			}
+		}
 
+		if (lod_face.mHasWeights)
+		{
+			face.allocateWeights(num_verts);
+			if (!face.mWeights && num_verts)
+			{
+				LL_WARNS() << "Failed to allocate " << num_verts << " weights for face index: " << i << " Total: " << face_count << LL_ENDL;
+				face.resizeIndices(0);
+				face.resizeVertices(0);
+				return;
 			}
 
+			const U8* weights = lod_face.mWeights.mData;
+			const size_t weights_size = lod_face.mWeights.mSize;
+
+			U32 idx = 0;
+
+			U32 cur_vertex = 0;
+			while (idx < weights_size && cur_vertex < num_verts)
 			{
-				if (!norm.empty())
+				const U8 END_INFLUENCES = 0xFF;
+				U8 joint = weights[idx++];
+
+				U32 cur_influence = 0;
+				LLVector4 wght(0,0,0,0);
+				U32 joints[4] = {0,0,0,0};
+				LLVector4 joints_with_weights(0,0,0,0);
+
+				while (joint != END_INFLUENCES && idx < weights_size)
 				{
-					U16* n = (U16*) &(norm[0]);
-					for (U32 j = 0; j < num_verts; ++j)
+					U16 influence = weights[idx++];
+					// A truncated array reads 0 where it ended
+					influence |= (idx < weights_size ? (U16) weights[idx] << 8 : 0);
+					idx++;
+
+					F32 w = llclamp((F32) influence / 65535.f, 0.001f, 0.999f);
+					wght.mV[cur_influence] = w;
+					joints[cur_influence] = joint;
+					cur_influence++;
+
+					if (cur_influence >= 4)
 					{
-						norm_out->set((F32) n[0], (F32) n[1], (F32) n[2]);
-						norm_out->div(65535.f);
-						norm_out->mul(2.f);
-						norm_out->sub(1.f);
-						norm_out++;
-						n += 3;
+						joint = END_INFLUENCES;
 					}
-				}
-				else
-				{
-					for (U32 j = 0; j < num_verts; ++j)
+					else
 					{
-						norm_out->clear();
-						norm_out++; // or just norm_out[j].clear();
+						joint = idx < weights_size ? weights[idx] : 0;
+						idx++;
 					}
 				}
+				F32 wsum = wght.mV[VX] + wght.mV[VY] + wght.mV[VZ] + wght.mV[VW];
+				if (wsum <= 0.f)
+				{
+					wght = LLVector4(0.999f,0.f,0.f,0.f);
+				}
+				for (U32 k=0; k<4; k++)
+				{
+					F32 f_combined = (F32) joints[k] + wght[k];
+					joints_with_weights[k] = f_combined;
+					// Any weights we added above should wind up non-zero and applied to a specific bone.
+					// A failure here would indicate a floating point precision error in the math.
+					llassert((k >= cur_influence) || (f_combined - S32(f_combined) > 0.0f));
+				}
+				face.mWeights[cur_vertex].loadua(joints_with_weights.mV);
+
+				cur_vertex++;
 			}
 
-#if 0 // keep this code for now in case we decide to add support for on-the-wire tangents
-            {
-                if (!tangent.empty())
-                {
-                    face.allocateTangents(face.mNumVertices);
-                    U16* t = (U16*)&(tangent[0]);
-
-                    // NOTE: tangents coming from the asset may not be mikkt space, but they should always be used by the GLTF shaders to 
-                    // maintain compliance with the GLTF spec
-                    LLVector4a* t_out = face.mTangents; 
-
-                    for (U32 j = 0; j < num_verts; ++j)
-                    {
-                        t_out->set((F32)t[0], (F32)t[1], (F32)t[2], (F32) t[3]);
-                        t_out->div(65535.f);
-                        t_out->mul(2.f);
-                        t_out->sub(1.f);
-
-                        F32* tp = t_out->getF32ptr();
-                        tp[3] = tp[3] < 0.f ? -1.f : 1.f;
-
-                        t_out++;
-                        t += 4;
-                    }
-                }
-            }
-#endif
+			if (cur_vertex != num_verts || idx != weights_size)
+			{
+				LL_WARNS() << "Vertex weight count does not match vertex count!" << LL_ENDL;
+			}
+		}
+
+		// translate to actions:
+		bool do_reflect_x = false;
+		bool do_reverse_triangles = false;
+		bool do_invert_normals = false;
+
+		if (do_mirror)
+		{
+			do_reflect_x = true;
+			do_reverse_triangles = !do_reverse_triangles;
+		}
+
+		if (do_invert)
+		{
+			do_invert_normals = true;
+			do_reverse_triangles = !do_reverse_triangles;
+		}
 
+		// now do the work
+
+		if (do_reflect_x)
+		{
+			LLVector4a* p = (LLVector4a*) face.mPositions;
+			LLVector4a* n = (LLVector4a*) face.mNormals;
+
+			for (S32 i = 0; i < face.mNumVertices; i++)
 			{
-				if (!tc.empty())
-				{
-					U16* t = (U16*) &(tc[0]);
-					for (U32 j = 0; j < num_verts; j+=2)
-					{
-						if (j < num_verts-1)
-						{
-							tc_out->set((F32) t[0], (F32) t[1], (F32) t[2], (F32) t[3]);
-						}
-						else
-						{
-							tc_out->set((F32) t[0], (F32) t[1], 0.f, 0.f);
-						}
+				p[i].mul(-1.0f);
+				n[i].mul(-1.0f);
+			}
+		}
 
-						t += 4;
+		if (do_invert_normals)
+		{
+			LLVector4a* n = (LLVector4a*) face.mNormals;
 
-						tc_out->div(65535.f);
-						tc_out->mul(tc_range);
-						tc_out->add(min_tc4);
+			for (S32 i = 0; i < face.mNumVertices; i++)
+			{
+				n[i].mul(-1.0f);
+			}
+		}
 
-						tc_out++;
-					}
-				}
-				else
-				{
-					for (U32 j = 0; j < num_verts; j += 2)
-					{
-						tc_out->clear();
-						tc_out++;
-					}
-				}
+		if (do_reverse_triangles)
+		{
+			for (U32 j = 0; j < face.mNumIndices; j += 3)
+			{
+				// swap the 2nd and 3rd index
+				S32 swap = face.mIndices[j+1];
+				face.mIndices[j+1] = face.mIndices[j+2];
+				face.mIndices[j+2] = swap;
 			}
+		}
+
+		//calculate bounding box
+		// VFExtents change
+		LLVector4a& min = face.mExtents[0];
+		LLVector4a& max = face.mExtents[1];
 
-			if (mdl[i].has("Weights"))
+		if (face.mNumVertices < 3)
+		{ //empty face, use a dummy 1cm (at 1m scale) bounding box
+			min.splat(-0.005f);
+			max.splat(0.005f);
+		}
+		else
+		{
+			min = max = face.mPositions[0];
+
+			for (S32 i = 1; i < face.mNumVertices; ++i)
 			{
-				face.allocateWeights(num_verts);
-                if (!face.mWeights && num_verts)
-                {
-                    LL_WARNS() << "Failed to allocate " << num_verts << " weights for face index: " << i << " Total: " << face_count << LL_ENDL;
-                    face.resizeIndices(0);
-                    face.resizeVertices(0);
-                    continue;
-                }
+				min.setMin(min, face.mPositions[i]);
+				max.setMax(max, face.mPositions[i]);
+			}
 
-				LLSD::Binary weights = mdl[i]["Weights"];
+			if (face.mTexCoords)
+			{
+				LLVector2& min_tc = face.mTexCoordExtents[0];
+				LLVector2& max_tc = face.mTexCoordExtents[1];
 
-				U32 idx = 0;
+				min_tc = face.mTexCoords[0];
+				max_tc = face.mTexCoords[0];
 
-				U32 cur_vertex = 0;
-				while (idx < weights.size() && cur_vertex < num_verts)
+				for (U32 j = 1; j < face.mNumVertices; ++j)
 				{
-					const U8 END_INFLUENCES = 0xFF;
-					U8 joint = weights[idx++];
+					update_min_max(min_tc, max_tc, face.mTexCoords[j]);
+				}
+			}
+			else
+			{
+				face.mTexCoordExtents[0].set(0,0);
+				face.mTexCoordExtents[1].set(1,1);
+			}
+		}
+	}
 
-					U32 cur_influence = 0;
-					LLVector4 wght(0,0,0,0);
-                    U32 joints[4] = {0,0,0,0};
-					LLVector4 joints_with_weights(0,0,0,0);
+	void get_mesh_lod_array(const LLSD& sd, LLMeshLODArray& array)
+	{
+		const LLSD::Binary& binary = sd.asBinary();
+		array.mData = binary.empty() ? NULL : &binary[0];
+		array.mSize = binary.size();
+	}
 
-					while (joint != END_INFLUENCES && idx < weights.size())
-					{
-						U16 influence = weights[idx++];
-						influence |= ((U16) weights[idx++] << 8);
+	const U32 MESH_LOD_MAX_FACES = 1024;			// more would be a bad asset
+	const U32 MESH_LOD_MAX_ARRAY = 16 * 1024 * 1024;
+	const S32 MESH_LOD_MAX_DEPTH = 32;
 
-						F32 w = llclamp((F32) influence / 65535.f, 0.001f, 0.999f);
-						wght.mV[cur_influence] = w;
-						joints[cur_influence] = joint;
-						cur_influence++;
+	// Reads the binary LLSD of a mesh LOD, an array with a map for each
+	// face, as it inflates. Quantized arrays go into buffers reused from
+	// face to face and are dequantized from there, no LLSD is built.
+	// Anything it doesn't expect, the deprecated header, notation style
+	// strings, a value of an unexpected type or a bad block, makes decode()
+	// fail and the caller falls back to unzip_llsd().
+	class LLMeshLODDecoder
+	{
+	public:
+		LLMeshLODDecoder(const U8* in, S32 size)
+		:	mReader(in, size)
+		{
+		}
 
-						if (cur_influence >= 4)
-						{
-							joint = END_INFLUENCES;
-						}
-						else
-						{
-							joint = weights[idx++];
-						}
-					}
-                    F32 wsum = wght.mV[VX] + wght.mV[VY] + wght.mV[VZ] + wght.mV[VW];
-                    if (wsum <= 0.f)
-                    {
-                        wght = LLVector4(0.999f,0.f,0.f,0.f);
-                    }
-                    for (U32 k=0; k<4; k++)
-                    {
-                        F32 f_combined = (F32) joints[k] + wght[k];
-                        joints_with_weights[k] = f_combined;
-                        // Any weights we added above should wind up non-zero and applied to a specific bone.
-                        // A failure here would indicate a floating point precision error in the math.
-                        llassert((k >= cur_influence) || (f_combined - S32(f_combined) > 0.0f));
-                    }
-					face.mWeights[cur_vertex].loadua(joints_with_weights.mV);
-
-					cur_vertex++;
-				}
+		bool decode(LLVolume::face_list_t& faces, bool do_mirror, bool do_invert)
+		{
+			char marker;
+			U32 count;
+			if (!readMarker(marker) || marker != '[' || !readU32(count)
+				|| !count || count > MESH_LOD_MAX_FACES)
+			{
+				return false;
+			}
 
-				if (cur_vertex != num_verts || idx != weights.size())
+			faces.resize(count);
+			for (U32 i = 0; i < count; ++i)
+			{
+				LLMeshLODFace face;
+				if (!readFace(face))
 				{
-					LL_WARNS() << "Vertex weight count does not match vertex count!" << LL_ENDL;
+					return false;
 				}
-					
+				unpack_mesh_lod_face(faces[i], face, i, count, do_mirror, do_invert);
 			}
+			return readMarker(marker) && marker == ']' && mReader.finish();
+		}
 
-			// modifier flags?
-			bool do_mirror = (mParams.getSculptType() & LL_SCULPT_FLAG_MIRROR);
-			bool do_invert = (mParams.getSculptType() &LL_SCULPT_FLAG_INVERT);
-			
-			
-			// translate to actions:
-			bool do_reflect_x = false;
-			bool do_reverse_triangles = false;
-			bool do_invert_normals = false;
-			
-			if (do_mirror)
+	private:
+		bool readMarker(char& marker)
+		{
+			return mReader.read(&marker, 1);
+		}
+
+		// Network byte order
+		bool readU32(U32& value)
+		{
+			U8 bytes[4];
+			if (!mReader.read(bytes, sizeof(bytes)))
 			{
-				do_reflect_x = true;
-				do_reverse_triangles = !do_reverse_triangles;
+				return false;
 			}
-			
-			if (do_invert)
+			value = ((U32)bytes[0] << 24) | ((U32)bytes[1] << 16) | ((U32)bytes[2] << 8) | bytes[3];
+			return true;
+		}
+
+		bool readKey()
+		{
+			char marker;
+			U32 length;
+			if (!readMarker(marker) || marker != 'k' || !readU32(length) || length > 1024)
 			{
-				do_invert_normals = true;
-				do_reverse_triangles = !do_reverse_triangles;
+				return false;
 			}
-			
-			// now do the work
+			mKey.resize(length);
+			return !length || mReader.read(&mKey[0], length);
+		}
 
-			if (do_reflect_x)
+		bool skipValue(char marker, S32 depth)
+		{
+			U32 count;
+			switch (marker)
 			{
-				LLVector4a* p = (LLVector4a*) face.mPositions;
-				LLVector4a* n = (LLVector4a*) face.mNormals;
-				
-				for (S32 i = 0; i < face.mNumVertices; i++)
+			case '!':
+			case '0':
+			case '1':
+				return true;
+			case 'i':
+				return mReader.skip(4);
+			case 'r':
+			case 'd':
+				return mReader.skip(8);
+			case 'u':
+				return mReader.skip(16);
+			case 's':
+			case 'l':
+			case 'b':
+				return readU32(count) && mReader.skip(count);
+			case '[':
+				if (!depth || !readU32(count))
+				{
+					return false;
+				}
+				for (U32 i = 0; i < count; ++i)
 				{
-					p[i].mul(-1.0f);
-					n[i].mul(-1.0f);
+					if (!readMarker(marker) || !skipValue(marker, depth - 1))
+					{
+						return false;
+					}
+				}
+				return readMarker(marker) && marker == ']';
+			case '{':
+				if (!depth || !readU32(count))
+				{
+					return false;
+				}
+				for (U32 i = 0; i < count; ++i)
+				{
+					if (!readKey() || !readMarker(marker) || !skipValue(marker, depth - 1))
+					{
+						return false;
+					}
 				}
+				return readMarker(marker) && marker == '}';
+			default:
+				return false;
 			}
+		}
 
-			if (do_invert_normals)
+		// What LLSD::asReal() makes of the value
+		bool readReal(char marker, F32& value)
+		{
+			U8 bytes[8];
+			switch (marker)
 			{
-				LLVector4a* n = (LLVector4a*) face.mNormals;
-				
-				for (S32 i = 0; i < face.mNumVertices; i++)
+			case 'r':
+			{
+				if (!mReader.read(bytes, sizeof(bytes)))
+				{
+					return false;
+				}
+				U64 bits = 0;
+				for (S32 i = 0; i < 8; ++i)
 				{
-					n[i].mul(-1.0f);
+					bits = (bits << 8) | bytes[i];
 				}
+				F64 real;
+				memcpy(&real, &bits, sizeof(real));
+				value = (F32) real;
+				return true;
 			}
+			case 'i':
+			{
+				U32 integer;
+				if (!readU32(integer))
+				{
+					return false;
+				}
+				value = (F32) (F64) (S32) integer;
+				return true;
+			}
+			case '1':
+				value = 1.f;
+				return true;
+			case '0':
+			case '!':
+				value = 0.f;
+				return true;
+			default:
+				return false;
+			}
+		}
 
-			if (do_reverse_triangles)
+		// Like LLVector3::setValue(), missing components are 0
+		bool readVector(char marker, F32* values, S32 size)
+		{
+			U32 count;
+			if (marker != '[' || !readU32(count))
 			{
-				for (U32 j = 0; j < face.mNumIndices; j += 3)
+				return false;
+			}
+			for (U32 i = 0; i < count; ++i)
+			{
+				if (!readMarker(marker))
+				{
+					return false;
+				}
+				if (i < (U32)size ? !readReal(marker, values[i]) : !skipValue(marker, MESH_LOD_MAX_DEPTH))
 				{
-					// swap the 2nd and 3rd index
-					S32 swap = face.mIndices[j+1];
-					face.mIndices[j+1] = face.mIndices[j+2];
-					face.mIndices[j+2] = swap;
+					return false;
 				}
 			}
+			return readMarker(marker) && marker == ']';
+		}
 
-			//calculate bounding box
-			// VFExtents change
-			LLVector4a& min = face.mExtents[0];
-			LLVector4a& max = face.mExtents[1];
+		bool readDomain(char marker, F32* min, F32* max, S32 size)
+		{
+			U32 count;
+			if (marker != '{' || !readU32(count))
+			{
+				return false;
+			}
+			bool has_min = false;
+			bool has_max = false;
+			for (U32 i = 0; i < count; ++i)
+			{
+				if (!readKey() || !readMarker(marker))
+				{
+					return false;
+				}
+				// Duplicate keys would need LLSD's first one wins, not worth it
+				bool ok;
+				if (mKey == "Min")
+				{
+					ok = !has_min && readVector(marker, min, size);
+					has_min = true;
+				}
+				else if (mKey == "Max")
+				{
+					ok = !has_max && readVector(marker, max, size);
+					has_max = true;
+				}
+				else
+				{
+					ok = skipValue(marker, MESH_LOD_MAX_DEPTH);
+				}
+				if (!ok)
+				{
+					return false;
+				}
+			}
+			return readMarker(marker) && marker == '}';
+		}
 
-			if (face.mNumVertices < 3)
-			{ //empty face, use a dummy 1cm (at 1m scale) bounding box
-				min.splat(-0.005f);
-				max.splat(0.005f);
+		bool readArray(char marker, std::vector<U8>& buffer, LLMeshLODArray& array)
+		{
+			U32 size;
+			if (marker != 'b' || !readU32(size) || size > MESH_LOD_MAX_ARRAY)
+			{
+				return false;
 			}
-			else
+			if (buffer.size() < size)
 			{
-				min = max = face.mPositions[0];
+				buffer.resize(size);
+			}
+			array.mData = size ? &buffer[0] : NULL;
+			array.mSize = size;
+			return !size || mReader.read(&buffer[0], size);
+		}
 
-				for (S32 i = 1; i < face.mNumVertices; ++i)
+		bool readFace(LLMeshLODFace& face)
+		{
+			enum
+			{
+				NO_GEOMETRY			= 1 << 0,
+				POSITION			= 1 << 1,
+				NORMAL				= 1 << 2,
+				TEX_COORD0			= 1 << 3,
+				TRIANGLE_LIST		= 1 << 4,
+				WEIGHTS				= 1 << 5,
+				POSITION_DOMAIN		= 1 << 6,
+				TEX_COORD0_DOMAIN	= 1 << 7,
+				NORMALIZED_SCALE	= 1 << 8,
+				OTHER				= 0
+			};
+
+			char marker;
+			U32 count;
+			if (!readMarker(marker) || marker != '{' || !readU32(count))
+			{
+				return false;
+			}
+			U32 seen = 0;
+			for (U32 i = 0; i < count; ++i)
+			{
+				if (!readKey() || !readMarker(marker))
 				{
-					min.setMin(min, face.mPositions[i]);
-					max.setMax(max, face.mPositions[i]);
+					return false;
 				}
 
-				if (face.mTexCoords)
+				U32 key = OTHER;
+				bool ok;
+				if (mKey == "NoGeometry")
 				{
-					LLVector2& min_tc = face.mTexCoordExtents[0];
-					LLVector2& max_tc = face.mTexCoordExtents[1];
-
-					min_tc = face.mTexCoords[0];
-					max_tc = face.mTexCoords[0];
-
-					for (U32 j = 1; j < face.mNumVertices; ++j)
-					{
-						update_min_max(min_tc, max_tc, face.mTexCoords[j]);
-					}
+					key = NO_GEOMETRY;
+					face.mNoGeometry = true;
+					ok = skipValue(marker, MESH_LOD_MAX_DEPTH);
+				}
+				else if (mKey == "Position")
+				{
+					key = POSITION;
+					ok = readArray(marker, mPosition, face.mPosition);
+				}
+				else if (mKey == "Normal")
+				{
+					key = NORMAL;
+					ok = readArray(marker, mNormal, face.mNormal);
+				}
+				else if (mKey == "TexCoord0")
+				{
+					key = TEX_COORD0;
+					ok = readArray(marker, mTexCoord0, face.mTexCoord0);
+				}
+				else if (mKey == "TriangleList")
+				{
+					key = TRIANGLE_LIST;
+					ok = readArray(marker, mTriangleList, face.mTriangleList);
+				}
+				else if (mKey == "Weights")
+				{
+					key = WEIGHTS;
+					face.mHasWeights = true;
+					ok = readArray(marker, mWeights, face.mWeights);
+				}
+				else if (mKey == "PositionDomain")
+				{
+					key = POSITION_DOMAIN;
+					ok = readDomain(marker, face.mPositionMin.mV, face.mPositionMax.mV, 3);
+				}
+				else if (mKey == "TexCoord0Domain")
+				{
+					key = TEX_COORD0_DOMAIN;
+					ok = readDomain(marker, face.mTexCoord0Min.mV, face.mTexCoord0Max.mV, 2);
+				}
+				else if (mKey == "NormalizedScale")
+				{
+					key = NORMALIZED_SCALE;
+					face.mHasNormalizedScale = true;
+					ok = readVector(marker, face.mNormalizedScale.mV, 3);
 				}
 				else
 				{
-					face.mTexCoordExtents[0].set(0,0);
-					face.mTexCoordExtents[1].set(1,1);
+					ok = skipValue(marker, MESH_LOD_MAX_DEPTH);
 				}
+
+				// Duplicate keys would need LLSD's first one wins, not worth it
+				if (!ok || (seen & key))
+				{
+					return false;
+				}
+				seen |= key;
+			}
+			return readMarker(marker) && marker == '}';
+		}
+
+		LLUZipReader mReader;
+		std::string mKey;
+		std::vector<U8> mPosition;
+		std::vector<U8> mNormal;
+		std::vector<U8> mTexCoord0;
+		std::vector<U8> mTriangleList;
+		std::vector<U8> mWeights;
+	};
+}
+
+bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
+	//input stream is now pointing at a zlib compressed block of LLSD
+	std::unique_ptr<U8[]> in = std::unique_ptr<U8[]>(new(std::nothrow) U8[size]);
+	if (!in)
+	{
+		LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << LLUZipHelper::ZR_MEM_ERROR << " , will probably fetch from sim again." << LL_ENDL;
+		return false;
+	}
+	is.read((char*) in.get(), size);
+	return unpackVolumeFaces(in.get(), size);
+}
+
+bool LLVolume::unpackVolumeFaces(const U8* in_data, S32 size)
+{
+	if (sDirectLODDecode)
+	{
+		if (unpackVolumeFacesDirect(in_data, size))
+		{
+			return true;
+		}
+		sDirectLODFallbacks++;
+	}
+
+	//input data is now pointing at a zlib compressed block of LLSD
+	//decompress block
+	LLSD mdl;
+	U32 uzip_result = LLUZipHelper::unzip_llsd(mdl, in_data, size);
+	if (uzip_result != LLUZipHelper::ZR_OK)
+	{
+		LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
+		return false;
+	}
+	return unpackVolumeFacesInternal(mdl);
+}
+
+bool LLVolume::unpackVolumeFacesDirect(const U8* in_data, S32 size)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
+	bool do_mirror = (mParams.getSculptType() & LL_SCULPT_FLAG_MIRROR);
+	bool do_invert = (mParams.getSculptType() & LL_SCULPT_FLAG_INVERT);
+
+	// Faces are resized in place like unpackVolumeFacesInternal() does, so
+	// whatever they keep from before is the same on both paths. A LOD the
+	// decoder gives up on half way has every face unpacked again by the
+	// LLSD path.
+	LLMeshLODDecoder decoder(in_data, size);
+	if (!decoder.decode(mVolumeFaces, do_mirror, do_invert))
+	{
+		return false;
+	}
+	return finishUnpackVolumeFaces();
+}
+
+bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
+{
+	U32 face_count = mdl.size();
+
+	if (face_count == 0)
+	{ //no faces unpacked, treat as failed decode
+		LL_WARNS() << "found no faces!" << LL_ENDL;
+		return false;
+	}
+
+	mVolumeFaces.resize(face_count);
+
+	// modifier flags?
+	bool do_mirror = (mParams.getSculptType() & LL_SCULPT_FLAG_MIRROR);
+	bool do_invert = (mParams.getSculptType() &LL_SCULPT_FLAG_INVERT);
+
+	for (size_t i = 0; i < face_count; ++i)
+	{
+		const LLSD& sd = mdl[i];
+		LLMeshLODFace face;
+
+		face.mNoGeometry = sd.has("NoGeometry");
+		if (!face.mNoGeometry)
+		{
+			get_mesh_lod_array(sd["Position"], face.mPosition);
+			get_mesh_lod_array(sd["Normal"], face.mNormal);
+			get_mesh_lod_array(sd["TexCoord0"], face.mTexCoord0);
+			get_mesh_lod_array(sd["TriangleList"], face.mTriangleList);
+
+			face.mPositionMin.setValue(sd["PositionDomain"]["Min"]);
+			face.mPositionMax.setValue(sd["PositionDomain"]["Max"]);
+			face.mTexCoord0Min.setValue(sd["TexCoord0Domain"]["Min"]);
+			face.mTexCoord0Max.setValue(sd["TexCoord0Domain"]["Max"]);
+
+			face.mHasNormalizedScale = sd.has("NormalizedScale");
+			if (face.mHasNormalizedScale)
+			{
+				face.mNormalizedScale.setValue(sd["NormalizedScale"]);
+			}
+
+			face.mHasWeights = sd.has("Weights");
+			if (face.mHasWeights)
+			{
+				get_mesh_lod_array(sd["Weights"], face.mWeights);
 			}
 		}
+
+		unpack_mesh_lod_face(mVolumeFaces[i], face, i, face_count, do_mirror, do_invert);
 	}
 
+	return finishUnpackVolumeFaces();
+}
+
+bool LLVolume::finishUnpackVolumeFaces()
+{
 	if (!cacheOptimize(true))
 	{
 		// Out of memory?
@@ -2818,12 +3275,260 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 		mVolumeFaces.clear();
 		return false;
 	}
-	
+
 	mSculptLevel = 0;  // success!
 
 	return true;
 }
 
+namespace
+{
+	const U32 DECODED_FACES_MAGIC = 0x46444c4c;	// "LLDF"
+
+	struct LLDecodedFacesHeader
+	{
+		U32 mMagic;
+		U32 mVersion;
+		U32 mFaceCount;
+		U32 mSize;					// of the whole blob
+	};
+
+	struct LLDecodedFaceRecord
+	{
+		enum { HAS_TANGENTS = 1, HAS_WEIGHTS = 2 };
+
+		F32 mExtents[3][4];			// min, max and center
+		F32 mTexCoordExtents[2][2];
+		F32 mNormalizedScale[3];
+		S32 mNumVertices;
+		S32 mNumIndices;
+		U32 mFlags;
+		// offsets from the start of the blob; positions, normals and texture
+		// coordinates are one block laid out like LLVolumeFace::resizeVertices()
+		U32 mVertices;
+		U32 mTangents;
+		U32 mWeights;
+		U32 mIndices;
+		U32 mPad[2];
+	};
+
+	static_assert(sizeof(LLDecodedFacesHeader) % 16 == 0, "decoded faces header must keep arrays aligned");
+	static_assert(sizeof(LLDecodedFaceRecord) % 16 == 0, "decoded face records must keep arrays aligned");
+
+	U32 decoded_tc_size(S32 num_verts)
+	{
+		return ((num_verts * sizeof(LLVector2)) + 0xF) & ~0xF;
+	}
+
+	U32 decoded_vertices_size(S32 num_verts)
+	{
+		return sizeof(LLVector4a) * 2 * num_verts + decoded_tc_size(num_verts);
+	}
+
+	U32 decoded_indices_size(S32 num_indices)
+	{
+		return ((num_indices * sizeof(U16)) + 0xF) & ~0xF;
+	}
+
+	// An array of 'size' bytes at 'offset' lies within a blob of 'blob_size'
+	bool decoded_range_ok(U32 offset, U32 size, U32 blob_size)
+	{
+		return offset && !(offset & 0xF) && offset <= blob_size && size <= blob_size - offset;
+	}
+}
+
+void LLVolume::packDecodedFaces(std::vector<U8>& out) const
+{
+	const U32 face_count = mVolumeFaces.size();
+
+	U32 size = sizeof(LLDecodedFacesHeader) + face_count * sizeof(LLDecodedFaceRecord);
+	for (const LLVolumeFace& face : mVolumeFaces)
+	{
+		if (face.mNumVertices > 0)
+		{
+			size += decoded_vertices_size(face.mNumVertices);
+			size += face.mTangents ? sizeof(LLVector4a) * face.mNumVertices : 0;
+			size += face.mWeights ? sizeof(LLVector4a) * face.mNumVertices : 0;
+		}
+		size += decoded_indices_size(face.mNumIndices);
+	}
+
+	out.assign(size, 0);
+	U8* base = &out[0];
+
+	LLDecodedFacesHeader* header = (LLDecodedFacesHeader*)base;
+	header->mMagic = DECODED_FACES_MAGIC;
+	header->mVersion = DECODED_FACES_VERSION;
+	header->mFaceCount = face_count;
+	header->mSize = size;
+
+	LLDecodedFaceRecord* records = (LLDecodedFaceRecord*)(base + sizeof(LLDecodedFacesHeader));
+	U32 offset = sizeof(LLDecodedFacesHeader) + face_count * sizeof(LLDecodedFaceRecord);
+	for (U32 i = 0; i < face_count; ++i)
+	{
+		const LLVolumeFace& face = mVolumeFaces[i];
+		LLDecodedFaceRecord& record = records[i];
+
+		for (U32 j = 0; j < 3; ++j)
+		{
+			memcpy(record.mExtents[j], face.mExtents[j].getF32ptr(), sizeof(record.mExtents[j]));
+		}
+		memcpy(record.mTexCoordExtents, face.mTexCoordExtents, sizeof(record.mTexCoordExtents));
+		memcpy(record.mNormalizedScale, face.mNormalizedScale.mV, sizeof(record.mNormalizedScale));
+		record.mNumVertices = face.mNumVertices;
+		record.mNumIndices = face.mNumIndices;
+
+		const S32 num_verts = face.mNumVertices;
+		if (num_verts > 0)
+		{
+			record.mVertices = offset;
+			memcpy(base + offset, face.mPositions, sizeof(LLVector4a) * num_verts);
+			offset += sizeof(LLVector4a) * num_verts;
+			memcpy(base + offset, face.mNormals, sizeof(LLVector4a) * num_verts);
+			offset += sizeof(LLVector4a) * num_verts;
+			memcpy(base + offset, face.mTexCoords, sizeof(LLVector2) * num_verts);
+			offset += decoded_tc_size(num_verts);
+
+			if (face.mTangents)
+			{
+				record.mFlags |= LLDecodedFaceRecord::HAS_TANGENTS;
+				record.mTangents = offset;
+				memcpy(base + offset, face.mTangents, sizeof(LLVector4a) * num_verts);
+				offset += sizeof(LLVector4a) * num_verts;
+			}
+
+			if (face.mWeights)
+			{
+				record.mFlags |= LLDecodedFaceRecord::HAS_WEIGHTS;
+				record.mWeights = offset;
+				memcpy(base + offset, face.mWeights, sizeof(LLVector4a) * num_verts);
+				offset += sizeof(LLVector4a) * num_verts;
+			}
+		}
+
+		if (face.mNumIndices > 0)
+		{
+			record.mIndices = offset;
+			memcpy(base + offset, face.mIndices, sizeof(U16) * face.mNumIndices);
+			offset += decoded_indices_size(face.mNumIndices);
+		}
+	}
+	llassert(offset == size);
+}
+
+bool LLVolume::unpackDecodedFaces(const U8* data, S32 size)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
+	if (!data || size < (S32)sizeof(LLDecodedFacesHeader))
+	{
+		return false;
+	}
+
+	LLDecodedFacesHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (header.mMagic != DECODED_FACES_MAGIC || header.mVersion != DECODED_FACES_VERSION
+		|| header.mSize != (U32)size || header.mFaceCount == 0 || header.mFaceCount > MESH_LOD_MAX_FACES
+		|| sizeof(header) + header.mFaceCount * sizeof(LLDecodedFaceRecord) > (U32)size)
+	{
+		return false;
+	}
+
+	// Faces are resized in place like the LOD decoders do, so whatever
+	// they keep from before matches a fresh decode
+	mVolumeFaces.resize(header.mFaceCount);
+
+	const U8* records = data + sizeof(header);
+	for (U32 i = 0; i < header.mFaceCount; ++i)
+	{
+		LLDecodedFaceRecord record;
+		memcpy(&record, records + i * sizeof(record), sizeof(record));
+
+		const S32 num_verts = record.mNumVertices;
+		const S32 num_indices = record.mNumIndices;
+		if (num_verts < 0 || num_verts > 65536 || num_indices < 0 || num_indices % 3
+			|| (num_indices && !num_verts)
+			|| (num_verts && !decoded_range_ok(record.mVertices, decoded_vertices_size(num_verts), size))
+			|| ((record.mFlags & LLDecodedFaceRecord::HAS_TANGENTS) && !decoded_range_ok(record.mTangents, sizeof(LLVector4a) * num_verts, size))
+			|| ((record.mFlags & LLDecodedFaceRecord::HAS_WEIGHTS) && !decoded_range_ok(record.mWeights, sizeof(LLVector4a) * num_verts, size))
+			|| (num_indices && !decoded_range_ok(record.mIndices, decoded_indices_size(num_indices), size)))
+		{
+			return false;
+		}
+
+		// An index past the vertices would be read by the renderer
+		const U8* indices = data + record.mIndices;
+		for (S32 j = 0; j < num_indices; ++j)
+		{
+			U16 index;
+			memcpy(&index, indices + j * sizeof(U16), sizeof(index));
+			if (index >= num_verts)
+			{
+				return false;
+			}
+		}
+
+		LLVolumeFace& face = mVolumeFaces[i];
+
+		face.resizeVertices(num_verts);
+		if (num_verts && !face.mPositions)
+		{
+			return false;
+		}
+		if (num_verts)
+		{
+			memcpy(face.mPositions, data + record.mVertices, decoded_vertices_size(num_verts));
+		}
+
+		if (num_verts && (record.mFlags & LLDecodedFaceRecord::HAS_TANGENTS))
+		{
+			face.allocateTangents(num_verts);
+			if (!face.mTangents)
+			{
+				return false;
+			}
+			memcpy(face.mTangents, data + record.mTangents, sizeof(LLVector4a) * num_verts);
+		}
+
+		if (num_verts && (record.mFlags & LLDecodedFaceRecord::HAS_WEIGHTS))
+		{
+			face.allocateWeights(num_verts);
+			if (!face.mWeights)
+			{
+				return false;
+			}
+			memcpy(face.mWeights, data + record.mWeights, sizeof(LLVector4a) * num_verts);
+		}
+		else
+		{
+			ll_aligned_free_16(face.mWeights);
+			face.mWeights = NULL;
+		}
+
+		face.resizeIndices(num_indices);
+		if (num_indices && !face.mIndices)
+		{
+			return false;
+		}
+		if (num_indices)
+		{
+			memcpy(face.mIndices, indices, sizeof(U16) * num_indices);
+		}
+
+		for (U32 j = 0; j < 3; ++j)
+		{
+			face.mExtents[j].loadua(record.mExtents[j]);
+		}
+		memcpy(face.mTexCoordExtents, record.mTexCoordExtents, sizeof(record.mTexCoordExtents));
+		face.mNormalizedScale.set(record.mNormalizedScale);
+		face.mOptimized = TRUE;
+	}
+
+	mSculptLevel = 0;
+
+	return true;
+}
+
 
 bool LLVolume::isMeshAssetLoaded()
 {
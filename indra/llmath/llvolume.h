@@ -59,6 +59,7 @@ class LLVolumeTriangle;
 #include "llfile.h"
 #include "llalignedarray.h"
 #include "llrigginginfo.h"
+#include "llatomic.h"
 
 //============================================================================
 
@@ -1078,6 +1079,10 @@ public:
 
 	BOOL isFaceMaskValid(LLFaceID face_mask);
 	static S32 sNumMeshPoints;
+	// Decode mesh LODs straight from the inflated binary LLSD instead of
+	// through an LLSD tree, falling back to the tree for anything unusual
+	static bool sDirectLODDecode;
+	static LLAtomicU32 sDirectLODFallbacks;	// LODs that fell back
 
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);		// HACK to bypass Windoze confusion over 
@@ -1118,9 +1123,19 @@ protected:
 	void createVolumeFaces();
 public:
 	bool unpackVolumeFaces(std::istream& is, S32 size);
-	bool unpackVolumeFaces(U8* in_data, S32 size);
+	bool unpackVolumeFaces(const U8* in_data, S32 size);
+
+	// Faces of an unpacked mesh LOD as they are after cacheOptimize(), in a
+	// flat layout for the decoded mesh cache. Arrays sit 16 byte aligned at
+	// offsets from the start, so they copy straight out of a mapped file.
+	// Blobs of another DECODED_FACES_VERSION are refused.
+	static const U32 DECODED_FACES_VERSION = 1;
+	void packDecodedFaces(std::vector<U8>& out) const;
+	bool unpackDecodedFaces(const U8* data, S32 size);
 private:
+	bool unpackVolumeFacesDirect(const U8* in_data, S32 size);
 	bool unpackVolumeFacesInternal(const LLSD& mdl);
+	bool finishUnpackVolumeFaces();
 
 public:
 	virtual void setMeshAssetLoaded(bool loaded);
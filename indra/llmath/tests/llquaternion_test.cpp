@@ -35,6 +35,8 @@
 #include "../m4math.h"
 #include "../m3math.h"
 #include "../llquaternion.h"
+#include "../llmath.h"
+#include "../llsimdmath.h"
 
 namespace tut
 {
@@ -657,4 +659,51 @@ namespace tut
 			is_approx_equal(1.000f, llquat.mQ[3]));
 	}
 
+	template<> template<>
+	void llquat_test_object_t::test<23>()
+	{
+		//test case for static void LLQuaternion2::nlerp(U32 count, const F32* u, const LLQuaternion* a, const LLQuaternion* b, LLQuaternion* out) fn
+		const U32 count = 64;
+		LLQuaternion a[count];
+		LLQuaternion b[count];
+		LLQuaternion out[count];
+		F32 u[count];
+		for (U32 i = 0; i < count; ++i)
+		{
+			a[i] = LLQuaternion(0.1f * i, LLVector3(cosf((F32)i), sinf(0.7f * i), 0.3f));
+			b[i] = LLQuaternion(2.f - 0.05f * i, LLVector3(0.2f, cosf(1.3f * i), sinf((F32)i)));
+			switch (i % 4)
+			{
+			case 2:
+				// opposite hemisphere
+				b[i] = -b[i];
+				break;
+			case 3:
+				// nearly the same rotation, on either side
+				b[i] = a[i] * LLQuaternion(0.001f, LLVector3(0.f, 0.f, 1.f));
+				if (i % 8 == 7)
+				{
+					b[i] = -b[i];
+				}
+				break;
+			}
+			u[i] = (F32)(i % 7) / 6.f;
+		}
+
+		LLQuaternion2::nlerp(count, u, a, b, out);
+		for (U32 i = 0; i < count; ++i)
+		{
+			LLQuaternion expected = nlerp(u[i], a[i], b[i]);
+			for (U32 j = 0; j < 4; ++j)
+			{
+				ensure_approximately_equals("LLQuaternion2::nlerp() differs from nlerp()", out[i].mQ[j], expected.mQ[j], 16);
+			}
+		}
+
+		LLQuaternion2::nlerp(count, u, a, b, a);
+		for (U32 i = 0; i < count; ++i)
+		{
+			ensure("LLQuaternion2::nlerp() in place failed", a[i] == out[i]);
+		}
+	}
 }
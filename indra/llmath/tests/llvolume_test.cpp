@@ -0,0 +1,544 @@
+/**
+ * @file llvolume_test.cpp
+ * @brief Mesh LOD decoding straight from binary LLSD against the LLSD tree
+ * path, and the decoded mesh cache layout.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+
+#include "../llvolume.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+
+#include "llsdserialize.h"
+#include "stringize.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	typedef std::vector<U8> bytes_t;
+
+	const char* LOD_NAMES[] = { "lowest_lod", "low_lod", "medium_lod", "high_lod" };
+
+	U32 next_random(U32& seed)
+	{
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	}
+
+	LLSD::Binary random_u16(U32 count, U32& seed)
+	{
+		LLSD::Binary data(count * 2);
+		for (size_t i = 0; i < data.size(); ++i)
+		{
+			data[i] = (U8)next_random(seed);
+		}
+		return data;
+	}
+
+	LLSD vector_sd(F32 x, F32 y, F32 z)
+	{
+		LLSD sd = LLSD::emptyArray();
+		sd.append(x);
+		sd.append(y);
+		sd.append(z);
+		return sd;
+	}
+
+	// A LOD the way LLModel writes one. Odd vertex counts, weights, missing
+	// normals and NoGeometry faces come and go with the seed.
+	LLSD make_lod(U32 faces, U32 verts, U32 seed)
+	{
+		LLSD lod = LLSD::emptyArray();
+		for (U32 i = 0; i < faces; ++i)
+		{
+			LLSD face;
+			if (i && !(next_random(seed) % 7))
+			{
+				face["NoGeometry"] = true;
+				lod.append(face);
+				continue;
+			}
+
+			U32 num_verts = verts + next_random(seed) % 17;
+			U32 num_triangles = num_verts + next_random(seed) % 5;
+			face["Position"] = random_u16(num_verts * 3, seed);
+			if (next_random(seed) % 5)
+			{
+				face["Normal"] = random_u16(num_verts * 3, seed);
+			}
+			face["TexCoord0"] = random_u16(num_verts * 2, seed);
+
+			LLSD::Binary indices(num_triangles * 6);
+			for (U32 j = 0; j < num_triangles * 3; ++j)
+			{
+				U16 index = next_random(seed) % num_verts;
+				memcpy(&indices[j * 2], &index, sizeof(index));
+			}
+			face["TriangleList"] = indices;
+
+			face["PositionDomain"]["Min"] = vector_sd(-0.5f, -0.25f, -1.f);
+			face["PositionDomain"]["Max"] = vector_sd(0.5f, 0.75f, 1.f);
+			face["TexCoord0Domain"]["Min"] = vector_sd(-1.f, 0.f, 0.f);
+			face["TexCoord0Domain"]["Max"] = vector_sd(2.f, 1.5f, 0.f);
+			if (next_random(seed) % 2)
+			{
+				face["NormalizedScale"] = vector_sd(1.5f, 2.f, 0.25f);
+			}
+
+			if (next_random(seed) % 3 == 0)
+			{
+				LLSD::Binary weights;
+				for (U32 j = 0; j < num_verts; ++j)
+				{
+					U32 influences = 1 + next_random(seed) % 4;
+					for (U32 k = 0; k < influences; ++k)
+					{
+						weights.push_back((U8)(next_random(seed) % 60));
+						U16 weight = next_random(seed);
+						weights.push_back(weight & 0xff);
+						weights.push_back(weight >> 8);
+					}
+					if (influences < 4)
+					{
+						weights.push_back(0xff);
+					}
+				}
+				face["Weights"] = weights;
+			}
+			lod.append(face);
+		}
+		return lod;
+	}
+
+	bytes_t zip(LLSD lod)
+	{
+		std::string zipped = zip_llsd(lod);
+		return bytes_t(zipped.begin(), zipped.end());
+	}
+
+	LLPointer<LLVolume> make_volume(U8 sculpt_type)
+	{
+		LLVolumeParams params;
+		params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+		params.setSculptID(LLUUID("bd6a1bd5-4ab6-4aed-8e84-6f5fa2e5ab6c"), sculpt_type);
+		return new LLVolume(params, 0);
+	}
+
+	// fell_back tells whether the direct decoder left the LOD to unzip_llsd()
+	LLPointer<LLVolume> decode(const bytes_t& zipped, bool direct, U8 sculpt_type = LL_SCULPT_TYPE_MESH, bool* fell_back = NULL)
+	{
+		LLVolume::sDirectLODDecode = direct;
+		U32 fallbacks = LLVolume::sDirectLODFallbacks.CurrentValue();
+		LLPointer<LLVolume> volume = make_volume(sculpt_type);
+		if (!volume->unpackVolumeFaces(&zipped[0], (S32)zipped.size()))
+		{
+			volume = NULL;
+		}
+		LLVolume::sDirectLODDecode = false;
+		if (fell_back)
+		{
+			*fell_back = LLVolume::sDirectLODFallbacks.CurrentValue() != fallbacks;
+		}
+		return volume;
+	}
+
+	bool same_bytes(const void* a, const void* b, size_t size)
+	{
+		return (!a && !b) || (a && b && !memcmp(a, b, size));
+	}
+
+	bool same_faces(const LLVolume* a, const LLVolume* b)
+	{
+		if (a->getNumVolumeFaces() != b->getNumVolumeFaces())
+		{
+			return false;
+		}
+		for (S32 i = 0; i < a->getNumVolumeFaces(); ++i)
+		{
+			const LLVolumeFace& fa = a->getVolumeFace(i);
+			const LLVolumeFace& fb = b->getVolumeFace(i);
+			S32 verts = fa.mNumVertices;
+			if (verts != fb.mNumVertices || fa.mNumIndices != fb.mNumIndices
+				|| !same_bytes(fa.mPositions, fb.mPositions, verts * sizeof(LLVector4a))
+				|| !same_bytes(fa.mNormals, fb.mNormals, verts * sizeof(LLVector4a))
+				|| !same_bytes(fa.mTangents, fb.mTangents, verts * sizeof(LLVector4a))
+				|| !same_bytes(fa.mTexCoords, fb.mTexCoords, verts * sizeof(LLVector2))
+				|| !same_bytes(fa.mWeights, fb.mWeights, verts * sizeof(LLVector4a))
+				|| !same_bytes(fa.mIndices, fb.mIndices, fa.mNumIndices * sizeof(U16))
+				|| !same_bytes(fa.mExtents, fb.mExtents, 2 * sizeof(LLVector4a))
+				|| !same_bytes(fa.mTexCoordExtents, fb.mTexCoordExtents, 2 * sizeof(LLVector2))
+				|| fa.mNormalizedScale != fb.mNormalizedScale)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The LODs of the mesh assets in LL_MESH_LOD_CORPUS, a directory of
+	// .slm or cached mesh files, otherwise made up ones
+	std::vector<bytes_t> load_corpus()
+	{
+		std::vector<bytes_t> corpus;
+		const char* dir = getenv("LL_MESH_LOD_CORPUS");
+		if (dir)
+		{
+			boost::system::error_code ec;
+			for (boost::filesystem::directory_iterator iter(dir, ec), end; !ec && iter != end; iter.increment(ec))
+			{
+				std::ifstream file(iter->path().string(), std::ios::binary);
+				std::string asset((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+				std::istringstream stream(asset);
+				LLSD header;
+				if (asset.empty() || !LLSDSerialize::fromBinary(header, stream, asset.size()))
+				{
+					continue;
+				}
+				size_t header_size = (size_t)stream.tellg();
+				for (const char* lod : LOD_NAMES)
+				{
+					size_t offset = header_size + header[lod]["offset"].asInteger();
+					size_t size = header[lod]["size"].asInteger();
+					if (header.has(lod) && size && offset + size <= asset.size())
+					{
+						corpus.push_back(bytes_t(asset.begin() + offset, asset.begin() + offset + size));
+					}
+				}
+			}
+		}
+		if (corpus.empty())
+		{
+			for (U32 i = 0; i < 64; ++i)
+			{
+				corpus.push_back(zip(make_lod(1 + i % 8, 24 << (i % 7), i)));
+			}
+		}
+		return corpus;
+	}
+}
+
+namespace tut
+{
+	struct volume_data
+	{
+	};
+	typedef test_group<volume_data> volume_test;
+	typedef volume_test::object volume_object;
+	tut::volume_test volume_testcase("llvolume");
+
+	template<> template<>
+	void volume_object::test<1>()
+	{
+		set_test_name("direct LOD decoding matches the LLSD path");
+		const U8 sculpt_types[] = {
+			LL_SCULPT_TYPE_MESH,
+			LL_SCULPT_TYPE_MESH | LL_SCULPT_FLAG_MIRROR,
+			LL_SCULPT_TYPE_MESH | LL_SCULPT_FLAG_INVERT
+		};
+		for (U32 i = 0; i < 90; ++i)
+		{
+			bytes_t zipped = zip(make_lod(1 + i % 9, 1 + (i * 13) % 300, i));
+			ensure(STRINGIZE("zipped " << i), !zipped.empty());
+
+			U8 sculpt_type = sculpt_types[i % 3];
+			bool fell_back;
+			LLPointer<LLVolume> tree = decode(zipped, false, sculpt_type);
+			LLPointer<LLVolume> direct = decode(zipped, true, sculpt_type, &fell_back);
+			ensure(STRINGIZE("decoded " << i), tree.notNull() && direct.notNull());
+			ensure(STRINGIZE("decoded directly " << i), !fell_back);
+			ensure(STRINGIZE("same faces " << i), same_faces(tree, direct));
+		}
+	}
+
+	template<> template<>
+	void volume_object::test<2>()
+	{
+		set_test_name("SSE2 dequantization matches the LLVector4a arithmetic");
+		// One vertex at a time, with x running over the range of a U16
+		for (U32 q = 0; q <= 0xffff; q += 7)
+		{
+			LLSD face;
+			U16 position[3] = { (U16)q, (U16)(0xffff - q), (U16)(q * 31) };
+			U16 tc[2] = { (U16)(q * 3), (U16)q };
+			U16 indices[3] = { 0, 0, 0 };
+			face["Position"] = LLSD::Binary((U8*)position, (U8*)(position + 3));
+			face["Normal"] = LLSD::Binary((U8*)position, (U8*)(position + 3));
+			face["TexCoord0"] = LLSD::Binary((U8*)tc, (U8*)(tc + 2));
+			face["TriangleList"] = LLSD::Binary((U8*)indices, (U8*)(indices + 3));
+			face["PositionDomain"]["Min"] = vector_sd(-0.37f, -2.f, 0.1f);
+			face["PositionDomain"]["Max"] = vector_sd(0.71f, 3.f, 0.3f);
+			face["TexCoord0Domain"]["Min"] = vector_sd(-0.25f, 0.125f, 0.f);
+			face["TexCoord0Domain"]["Max"] = vector_sd(1.3f, 0.9f, 0.f);
+			LLSD lod = LLSD::emptyArray();
+			lod.append(face);
+
+			bool fell_back;
+			LLPointer<LLVolume> volume = decode(zip(lod), true, LL_SCULPT_TYPE_MESH, &fell_back);
+			ensure(STRINGIZE("decoded " << q), volume.notNull() && !fell_back);
+			const LLVolumeFace& out = volume->getVolumeFace(0);
+
+			LLVector4a min_pos(-0.37f, -2.f, 0.1f);
+			LLVector4a range;
+			range.setSub(LLVector4a(0.71f, 3.f, 0.3f), min_pos);
+			LLVector4a expected;
+			expected.set((F32)position[0], (F32)position[1], (F32)position[2]);
+			expected.div(65535.f);
+			expected.mul(range);
+			expected.add(min_pos);
+			ensure(STRINGIZE("position " << q), !memcmp(&expected, &out.mPositions[0], sizeof(expected)));
+
+			expected.set((F32)position[0], (F32)position[1], (F32)position[2]);
+			expected.div(65535.f);
+			expected.mul(2.f);
+			expected.sub(1.f);
+			// cacheOptimize() normalizes them
+			expected.normalize3fast();
+			for (S32 i = 0; i < 3; ++i)
+			{
+				ensure_approximately_equals(STRINGIZE("normal " << q).c_str(), out.mNormals[0][i], expected[i], 12);
+			}
+
+			LLVector2 min_tc(-0.25f, 0.125f);
+			LLVector2 tc_range = LLVector2(1.3f, 0.9f) - min_tc;
+			expected.set((F32)tc[0], (F32)tc[1], 0.f, 0.f);
+			expected.div(65535.f);
+			expected.mul(LLVector4a(tc_range[0], tc_range[1], tc_range[0], tc_range[1]));
+			expected.add(LLVector4a(min_tc[0], min_tc[1], min_tc[0], min_tc[1]));
+			ensure(STRINGIZE("texture coordinate " << q), !memcmp(expected.getF32ptr(), out.mTexCoords[0].mV, sizeof(LLVector2)));
+		}
+	}
+
+	template<> template<>
+	void volume_object::test<3>()
+	{
+		set_test_name("direct LOD decoding leaves unusual LODs to the LLSD path");
+		LLSD lod = make_lod(3, 40, 7);
+		bytes_t zipped = zip(lod);
+
+		// Unknown keys holding containers and integers in a domain are
+		// read, a string where a number goes is left to the LLSD path
+		LLSD odd = lod;
+		odd[1]["Extra"]["Nested"] = LLSD::emptyArray();
+		odd[1]["Extra"]["Nested"].append(LLSD::emptyMap());
+		odd[2]["TexCoord0Domain"]["Max"][0] = 2;
+		for (S32 strings = 0; strings <= 1; ++strings)
+		{
+			if (strings)
+			{
+				odd[0]["PositionDomain"]["Min"][0] = "-0.5";
+			}
+			bool fell_back;
+			LLPointer<LLVolume> tree = decode(zip(odd), false);
+			LLPointer<LLVolume> direct = decode(zip(odd), true, LL_SCULPT_TYPE_MESH, &fell_back);
+			ensure("odd LOD decoded", tree.notNull() && direct.notNull());
+			ensure_equals("odd LOD fell back", fell_back, (bool)strings);
+			ensure("odd LOD same faces", same_faces(tree, direct));
+		}
+
+		// Truncated and corrupted blocks fail the same way on both paths
+		for (U32 i = 0; i < 200; ++i)
+		{
+			bytes_t bad = zipped;
+			U32 seed = i;
+			if (i % 2)
+			{
+				bad.resize(1 + next_random(seed) % (bad.size() - 1));
+			}
+			else
+			{
+				bad[2 + next_random(seed) % (bad.size() - 2)] ^= 1 << (i % 8);
+			}
+			LLPointer<LLVolume> bad_tree = decode(bad, false);
+			LLPointer<LLVolume> bad_direct = decode(bad, true);
+			ensure_equals(STRINGIZE("result " << i), bad_direct.notNull(), bad_tree.notNull());
+			if (bad_tree.notNull())
+			{
+				ensure(STRINGIZE("same faces " << i), same_faces(bad_tree, bad_direct));
+			}
+		}
+
+		// Empty LODs are still a failure
+		ensure("no faces", decode(zip(LLSD::emptyArray()), true).isNull());
+	}
+
+	template<> template<>
+	void volume_object::test<4>()
+	{
+		set_test_name("mesh LOD decoding throughput");
+		typedef std::chrono::steady_clock clock_t;
+		typedef std::chrono::duration<double, std::milli> ms_t;
+
+		std::vector<bytes_t> corpus = load_corpus();
+		size_t bytes = 0;
+		for (const bytes_t& lod : corpus)
+		{
+			bytes += lod.size();
+		}
+
+		const S32 ROUNDS = 5;
+		for (S32 direct = 0; direct <= 1; ++direct)
+		{
+			LLVolume::sDirectLODDecode = direct;
+			U32 fallbacks = LLVolume::sDirectLODFallbacks.CurrentValue();
+			S32 faces = 0;
+			double ms = 0.;
+			for (S32 round = 0; round < ROUNDS; ++round)
+			{
+				std::vector<LLPointer<LLVolume> > volumes;
+				for (size_t i = 0; i < corpus.size(); ++i)
+				{
+					volumes.push_back(make_volume(LL_SCULPT_TYPE_MESH));
+				}
+				auto start = clock_t::now();
+				for (size_t i = 0; i < corpus.size(); ++i)
+				{
+					if (volumes[i]->unpackVolumeFaces(&corpus[i][0], (S32)corpus[i].size()))
+					{
+						faces += volumes[i]->getNumVolumeFaces();
+					}
+				}
+				ms += ms_t(clock_t::now() - start).count();
+			}
+			LLVolume::sDirectLODDecode = false;
+			ensure("decoded", faces > 0);
+
+			std::cout << (direct ? "direct" : "LLSD") << " decoding of " << corpus.size() << " LODs, "
+					  << ms / (ROUNDS * corpus.size()) << " ms per LOD, "
+					  << (double)bytes * ROUNDS / (1024. * 1024.) / (ms / 1000.) << " compressed MB/s, "
+					  << LLVolume::sDirectLODFallbacks.CurrentValue() - fallbacks << " fell back" << std::endl;
+		}
+	}
+
+	template<> template<>
+	void volume_object::test<5>()
+	{
+		set_test_name("decoded faces come back as they were packed");
+		for (U32 seed = 0; seed < 16; ++seed)
+		{
+			U8 sculpt_type = LL_SCULPT_TYPE_MESH | (seed % 2 ? LL_SCULPT_FLAG_MIRROR : 0) | (seed % 3 ? 0 : LL_SCULPT_FLAG_INVERT);
+			LLPointer<LLVolume> decoded = decode(zip(make_lod(1 + seed % 8, 30 + seed * 5, seed)), true, sculpt_type);
+			ensure("decoded", decoded.notNull());
+
+			std::vector<U8> packed;
+			decoded->packDecodedFaces(packed);
+			ensure_equals("packed size", packed.size() % 16, (size_t)0);
+
+			LLPointer<LLVolume> unpacked = make_volume(sculpt_type);
+			ensure(STRINGIZE("unpacked " << seed), unpacked->unpackDecodedFaces(&packed[0], (S32)packed.size()));
+			ensure(STRINGIZE("same faces " << seed), same_faces(decoded, unpacked));
+			for (S32 i = 0; i < unpacked->getNumVolumeFaces(); ++i)
+			{
+				const LLVolumeFace& face = unpacked->getVolumeFace(i);
+				ensure("optimized", face.mOptimized);
+				ensure("same center", same_bytes(face.mCenter, decoded->getVolumeFace(i).mCenter, sizeof(LLVector4a)));
+			}
+		}
+
+		LLPointer<LLVolume> decoded = decode(zip(make_lod(4, 50, 3)), true);
+		std::vector<U8> packed;
+		decoded->packDecodedFaces(packed);
+
+		// Another version, a short blob or an index past the vertices is refused
+		std::vector<U8> bad = packed;
+		bad[4] ^= 1;
+		ensure("other version", !make_volume(LL_SCULPT_TYPE_MESH)->unpackDecodedFaces(&bad[0], (S32)bad.size()));
+		ensure("truncated", !make_volume(LL_SCULPT_TYPE_MESH)->unpackDecodedFaces(&packed[0], (S32)packed.size() - 16));
+		ensure("empty", !make_volume(LL_SCULPT_TYPE_MESH)->unpackDecodedFaces(NULL, 0));
+
+		// the indices of the last face are the last block
+		const LLVolumeFace& last = decoded->getVolumeFace(decoded->getNumVolumeFaces() - 1);
+		size_t last_indices = packed.size() - ((last.mNumIndices * sizeof(U16) + 0xF) & ~0xF);
+		bad = packed;
+		U16 index = (U16)last.mNumVertices;
+		memcpy(&bad[last_indices], &index, sizeof(index));
+		ensure("index past the vertices", !make_volume(LL_SCULPT_TYPE_MESH)->unpackDecodedFaces(&bad[0], (S32)bad.size()));
+
+		for (U32 i = 0; i < 64; ++i)
+		{
+			bad = packed;
+			U32 seed = i;
+			U32 at = 16 + next_random(seed) % (bad.size() - 16);
+			bad[at] ^= 0x80;
+			LLPointer<LLVolume> volume = make_volume(LL_SCULPT_TYPE_MESH);
+			if (volume->unpackDecodedFaces(&bad[0], (S32)bad.size()))
+			{
+				// whatever got through must still index inside its vertices
+				for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+				{
+					const LLVolumeFace& vf = volume->getVolumeFace(f);
+					for (S32 j = 0; j < vf.mNumIndices; ++j)
+					{
+						ensure("index in range", vf.mIndices[j] < vf.mNumVertices);
+					}
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void volume_object::test<6>()
+	{
+		set_test_name("decoded mesh cache throughput");
+		typedef std::chrono::steady_clock clock_t;
+		typedef std::chrono::duration<double, std::milli> ms_t;
+
+		std::vector<bytes_t> corpus = load_corpus();
+		std::vector<std::vector<U8> > packed(corpus.size());
+		double decode_ms = 0.;
+		for (size_t i = 0; i < corpus.size(); ++i)
+		{
+			LLPointer<LLVolume> volume = make_volume(LL_SCULPT_TYPE_MESH);
+			auto start = clock_t::now();
+			if (volume->unpackVolumeFaces(&corpus[i][0], (S32)corpus[i].size()))
+			{
+				decode_ms += ms_t(clock_t::now() - start).count();
+				volume->packDecodedFaces(packed[i]);
+			}
+		}
+
+		double unpack_ms = 0.;
+		for (size_t i = 0; i < corpus.size(); ++i)
+		{
+			if (!packed[i].empty())
+			{
+				LLPointer<LLVolume> volume = make_volume(LL_SCULPT_TYPE_MESH);
+				auto start = clock_t::now();
+				ensure("unpacked", volume->unpackDecodedFaces(&packed[i][0], (S32)packed[i].size()));
+				unpack_ms += ms_t(clock_t::now() - start).count();
+			}
+		}
+
+		std::cout << "decoding and optimizing " << corpus.size() << " LODs took " << decode_ms
+				  << " ms, reading them back from the decoded layout " << unpack_ms << " ms" << std::endl;
+	}
+}
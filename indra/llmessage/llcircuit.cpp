@@ -107,6 +107,11 @@ LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id,
 	mExistenceTimer(),
 	mAckCreationTime(0.f),
 	mCurrentResendCount(0),
+	mResendCount(0),
+	mFastRetransmitCount(0),
+	mSpuriousResendCount(0),
+	mDeferredResendCount(0),
+	mAdaptiveRetransmit(FALSE),
 	mLastPacketGap(0),
 	mHeartbeatInterval(circuit_heartbeat_interval), 
 	mHeartbeatTimeout(circuit_timeout)
@@ -225,6 +230,11 @@ void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 			}
 		}
 
+		if (mAdaptiveRetransmit)
+		{
+			noteReliableAck(packetp);
+		}
+
 		// Update stats
 		mUnackedPacketCount--;
 		mUnackedPacketBytes -= packetp->mBufferLength;
@@ -259,6 +269,11 @@ void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 			}
 		}
 
+		if (mAdaptiveRetransmit)
+		{
+			noteReliableAck(packetp);
+		}
+
 		// Update stats
 		mUnackedPacketCount--;
 		mUnackedPacketBytes -= packetp->mBufferLength;
@@ -274,6 +289,58 @@ void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 	}
 }
 
+void LLCircuitData::noteReliableAck(const LLReliablePacket* packetp)
+{
+	// Message system time, like the ping. Sends and acks are stamped with
+	// the start of their frame's message pass, so a sample can be off by up
+	// to a frame, which the estimator's clock granularity covers.
+	F32Seconds rtt(LLMessageSystem::getMessageTimeSeconds() - packetp->mSentTime);
+	if (!packetp->mResendCount)
+	{
+		mRTT.addSample(rtt);
+	}
+	else if (mRTT.hasSamples() && rtt < mRTT.getSmoothedRTT() * 0.5f)
+	{
+		// Too soon to answer the resend, the first send got through
+		mSpuriousResendCount++;
+	}
+
+	// Packets sent before this one that are still unacked were most likely
+	// lost. Resend them on the next pass instead of waiting for the timeout.
+	S32 scanned = 0;
+	for (reliable_iter iter = mUnackedPackets.begin();
+		 iter != mUnackedPackets.end() && iter->first < packetp->mPacketID && scanned < LL_FAST_RETRANSMIT_SCAN;
+		 ++iter, ++scanned)
+	{
+		LLReliablePacket* unackedp = iter->second;
+		if (unackedp->mSentTime < packetp->mSentTime
+			&& ++unackedp->mLaterAckCount == LL_FAST_RETRANSMIT_ACKS)
+		{
+			unackedp->mExpirationTime = F64Seconds(0.0);
+		}
+	}
+}
+
+F64Seconds LLCircuitData::getResendExpirationTime(const LLReliablePacket* packetp, const F64Seconds now)
+{
+	if (!packetp->mPingBasedRetry)
+	{
+		// custom, constant retry time
+		return now + packetp->mTimeout;
+	}
+	// The new method, retry time based on ping
+	F32Seconds timeout = llmax(LL_MINIMUM_RELIABLE_TIMEOUT_SECONDS, F32Seconds(LL_RELIABLE_TIMEOUT_FACTOR * getPingDelayAveraged()));
+	if (mAdaptiveRetransmit && mRTT.hasSamples())
+	{
+		// Measured round trip time, doubled on each resend. The wait after
+		// the last resend stays as long as before, so short timeouts don't
+		// give up on packets sooner.
+		F32Seconds rtt_timeout = mRTT.getTimeout(packetp->mResendCount);
+		timeout = packetp->mRetries ? rtt_timeout : llmax(rtt_timeout, timeout);
+	}
+	return now + timeout;
+}
+
 
 
 S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
@@ -290,6 +357,8 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 
 	reliable_iter iter;
 	BOOL have_resend_overflow = FALSE;
+	// Paced, a burst of expired packets goes out over several frames
+	S32 resends_left = mAdaptiveRetransmit ? LL_MAX_RESENDS_PER_CIRCUIT_FRAME : S32_MAX;
 	for (iter = mUnackedPackets.begin(); iter != mUnackedPackets.end();)
 	{
 		packetp = iter->second;
@@ -336,10 +405,29 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 
 		if (now > packetp->mExpirationTime)
 		{
+			if (resends_left <= 0)
+			{
+				// Counted once per packet, not on every pass it waits
+				if (!packetp->mResendDeferred)
+				{
+					packetp->mResendDeferred = TRUE;
+					mDeferredResendCount++;
+				}
+				++iter;
+				continue;
+			}
+			resends_left--;
+			packetp->mResendDeferred = FALSE;
+			if (packetp->mLaterAckCount >= LL_FAST_RETRANSMIT_ACKS)
+			{
+				mFastRetransmitCount++;
+			}
+
 			packetp->mRetries--;
 			
 			// retry		
 			mCurrentResendCount++;
+			mResendCount++;
 
 			gMessageSystem->mResentPackets++;
 
@@ -359,16 +447,10 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 
 			mThrottles.throttleOverflow(TC_RESEND, packetp->mBufferLength * 8.f);
 
-			// The new method, retry time based on ping
-			if (packetp->mPingBasedRetry)
-			{
-				packetp->mExpirationTime = now + llmax(LL_MINIMUM_RELIABLE_TIMEOUT_SECONDS, F32Seconds(LL_RELIABLE_TIMEOUT_FACTOR * getPingDelayAveraged()));
-			}
-			else
-			{
-				// custom, constant retry time
-				packetp->mExpirationTime = now + packetp->mTimeout;
-			}
+			packetp->mSentTime = now;
+			packetp->mResendCount++;
+			packetp->mLaterAckCount = 0;
+			packetp->mExpirationTime = getResendExpirationTime(packetp, now);
 
 			if (!packetp->mRetries)
 			{
@@ -436,7 +518,8 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 LLCircuit::LLCircuit(const F32Seconds circuit_heartbeat_interval, const F32Seconds circuit_timeout) 
 :	mLastCircuit(NULL),  
 	mHeartbeatInterval(circuit_heartbeat_interval), 
-	mHeartbeatTimeout(circuit_timeout)
+	mHeartbeatTimeout(circuit_timeout),
+	mAdaptiveRetransmit(FALSE)
 {}
 
 LLCircuit::~LLCircuit()
@@ -453,6 +536,7 @@ LLCircuitData *LLCircuit::addCircuitData(const LLHost &host, TPACKETID in_id)
 	// This should really validate if one already exists
 	LL_INFOS() << "LLCircuit::addCircuitData for " << host << LL_ENDL;
 	LLCircuitData *tempp = new LLCircuitData(host, in_id, mHeartbeatInterval, mHeartbeatTimeout);
+	tempp->setAdaptiveRetransmit(mAdaptiveRetransmit);
 	mCircuitData.insert(circuit_data_map::value_type(host, tempp));
 	mPingSet.insert(tempp);
 
@@ -577,6 +661,11 @@ void LLCircuitData::addReliablePacket(S32 mSocket, U8 *buf_ptr, S32 buf_len, LLR
 	mUnackedPacketCount++;
 	mUnackedPacketBytes += packet_info->mBufferLength;
 
+	if (mAdaptiveRetransmit && packet_info->mPingBasedRetry && mRTT.hasSamples())
+	{
+		packet_info->mExpirationTime = packet_info->mSentTime + mRTT.getTimeout();
+	}
+
 	if (params && params->mRetries)
 	{
 		mUnackedPackets[packet_info->mPacketID] = packet_info;
@@ -1212,6 +1301,23 @@ void LLCircuitData::getInfo(LLSD& info) const
 	info["Host"] = mHost.getIPandPort();
 	info["Alive"] = mbAlive;
 	info["Age"] = mExistenceTimer.getElapsedTimeF32();
+	info["PingDelay"] = (S32)mPingDelay.value();
+	info["PingDelayAveraged"] = mPingDelayAveraged.value();
+	info["UnackedPackets"] = mUnackedPacketCount;
+	info["UnackedBytes"] = mUnackedPacketBytes;
+	info["Resends"] = (S32)mResendCount;
+	info["AdaptiveRetransmit"] = (bool)mAdaptiveRetransmit;
+	if (mAdaptiveRetransmit)
+	{
+		// milliseconds, like the ping
+		info["SmoothedRTT"] = mRTT.getSmoothedRTT().value() * 1000.f;
+		info["RTTVariation"] = mRTT.getRTTVariation().value() * 1000.f;
+		info["RetransmitTimeout"] = mRTT.getTimeout().value() * 1000.f;
+		info["RTTSamples"] = (S32)mRTT.getSampleCount();
+		info["FastRetransmits"] = (S32)mFastRetransmitCount;
+		info["SpuriousResends"] = (S32)mSpuriousResendCount;
+		info["DeferredResends"] = (S32)mDeferredResendCount;
+	}
 }
 
 void LLCircuitData::dumpResendCountAndReset()
@@ -1247,6 +1353,15 @@ void LLCircuit::getInfo(LLSD& info) const
 	}
 }
 
+void LLCircuit::setAdaptiveRetransmit(BOOL adaptive)
+{
+	mAdaptiveRetransmit = adaptive;
+	for (circuit_data_map::iterator it = mCircuitData.begin(); it != mCircuitData.end(); ++it)
+	{
+		it->second->setAdaptiveRetransmit(adaptive);
+	}
+}
+
 void LLCircuit::getCircuitRange(
 	const LLHost& key,
 	LLCircuit::circuit_data_map::iterator& first,
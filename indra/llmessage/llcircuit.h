@@ -37,6 +37,7 @@
 #include "net.h"
 #include "llhost.h"
 #include "llpacketack.h"
+#include "llrttestimator.h"
 #include "lluuid.h"
 #include "llthrottle.h"
 
@@ -62,6 +63,11 @@ const S32 LL_MAX_RESENT_PACKETS_PER_FRAME = 100;
 const S32 LL_MAX_ACKED_PACKETS_PER_FRAME = 200;
 const F32 LL_COLLECT_ACK_TIME_MAX = 2.f;
 
+// Adaptive retransmit
+const S32 LL_FAST_RETRANSMIT_ACKS = 3;			// acks of later packets before an unacked packet is resent early
+const S32 LL_FAST_RETRANSMIT_SCAN = 32;			// oldest unacked packets checked on each ack
+const S32 LL_MAX_RESENDS_PER_CIRCUIT_FRAME = 16;	// the rest wait for the next frame
+
 //
 // Prototypes and Predefines
 //
@@ -94,6 +100,12 @@ public:
 	void		pingTimerStop(const U8 ping_id);
 	void			ackReliablePacket(TPACKETID packet_num);
 
+	// Resend timeouts from the measured round trip time of reliable
+	// packets instead of the ping, fast retransmit and paced resends.
+	void		setAdaptiveRetransmit(BOOL adaptive)	{ mAdaptiveRetransmit = adaptive; }
+	BOOL		getAdaptiveRetransmit() const			{ return mAdaptiveRetransmit; }
+	const LLRTTEstimator& getRTTEstimator() const		{ return mRTT; }
+
 	// remote computer information
 	const LLUUID& getRemoteID() const { return mRemoteID; }
 	const LLUUID& getRemoteSessionID() const { return mRemoteSessionID; }
@@ -176,6 +188,8 @@ protected:
 	BOOL			updateWatchDogTimers(LLMessageSystem *msgsys);	// Return FALSE if the circuit is dead and should be cleaned up
 
 	void			addReliablePacket(S32 mSocket, U8 *buf_ptr, S32 buf_len, LLReliablePacketParams *params);
+	void			noteReliableAck(const LLReliablePacket* packetp);
+	F64Seconds		getResendExpirationTime(const LLReliablePacket* packetp, const F64Seconds now);
 	BOOL			isDuplicateResend(TPACKETID packetnum);
 	// Call this method when a reliable message comes in - this will
 	// correctly place the packet in the correct list to be acked
@@ -275,6 +289,13 @@ protected:
 	LLTimer	mExistenceTimer;	    // initialized when circuit created, used to track bandwidth numbers
 
 	S32		mCurrentResendCount;	// Number of resent packets since last spam
+	U32		mResendCount;			// Total resent packets
+	U32		mFastRetransmitCount;	// Resent before their timeout, see LL_FAST_RETRANSMIT_ACKS
+	U32		mSpuriousResendCount;	// Acked too soon after the resend to be an ack of it
+	U32		mDeferredResendCount;	// Packets whose resend was held back, see LL_MAX_RESENDS_PER_CIRCUIT_FRAME
+
+	BOOL			mAdaptiveRetransmit;
+	LLRTTEstimator	mRTT;
     U32     mLastPacketGap;         // Gap in sequence number of last packet.
 
 	const F32Seconds mHeartbeatInterval;
@@ -316,6 +337,9 @@ public:
 
 	void			dumpResends();
 
+	// Applies to current and new circuits, see LLCircuitData::setAdaptiveRetransmit()
+	void			setAdaptiveRetransmit(BOOL adaptive);
+
 	typedef std::map<LLHost, LLCircuitData*> circuit_data_map;
 
 	/**
@@ -351,5 +375,6 @@ protected:
 private:
 	const F32Seconds mHeartbeatInterval;
 	const F32Seconds mHeartbeatTimeout;
+	BOOL mAdaptiveRetransmit;
 };
 #endif
@@ -118,9 +118,11 @@ bool responseToLLSD(HttpResponse * response, bool log, LLSD & out_llsd)
         return false;
     }
 
-    LLCore::BufferArrayStream bas(body);
+    // Parse the body blocks in place rather than through a stream
+    BufferArray::span_list_t spans;
+    body->getSpans(spans);
     LLSD body_llsd;
-    S32 parse_status(LLSDSerialize::fromXML(body_llsd, bas, log));
+    S32 parse_status(LLSDSerialize::fromXML(body_llsd, spans, log));
     if (LLSDParser::PARSE_FAILURE == parse_status){
         return false;
     }
@@ -511,22 +513,29 @@ LLSD HttpCoroRawHandler::handleSuccess(LLCore::HttpResponse * response, LLCore::
 
     size_t size = body->size();
 
-    LLCore::BufferArrayStream bas(body);
-
 #if 1
     // This is the slower implementation.  It is safe vis-a-vi the const_cast<> and modification
     // of a LLSD managed array but contains an extra (potentially large) copy.
     // 
     // *TODO: https://jira.secondlife.com/browse/MAINT-5221
     
+    // Copy the body a block at a time rather than a byte at a time
+    // through a BufferArrayStream.
     LLSD::Binary data;
     data.reserve(size);
-    bas >> std::noskipws;
-    data.assign(std::istream_iterator<U8>(bas), std::istream_iterator<U8>());
+    BufferArray::span_list_t spans;
+    body->getSpans(spans);
+    for (const BufferArray::span_t& span : spans)
+    {
+        const U8* block = reinterpret_cast<const U8*>(span.first);
+        data.insert(data.end(), block, block + span.second);
+    }
 
     result[HttpCoroutineAdapter::HTTP_RESULTS_RAW] = data;
 
 #else
+    LLCore::BufferArrayStream bas(body);
+
     // This is disabled because it's dangerous.  See the other case for an 
     // alternate implementation.
     // We create a new LLSD::Binary object and assign it to the result map.
@@ -551,6 +560,45 @@ LLSD HttpCoroRawHandler::parseBody(LLCore::HttpResponse *response, bool &success
     return LLSD();
 }
 
+//========================================================================
+/// The HttpCoroBufferHandler is a specialization of the HttpCoroRawHandler
+/// which holds on to the body of the response rather than copying it into
+/// the returned LLSD.  The caller reads it in place through getBody().
+///                      
+class HttpCoroBufferHandler : public HttpCoroRawHandler
+{
+public:
+    HttpCoroBufferHandler(LLEventStream &reply);
+
+    virtual LLSD handleSuccess(LLCore::HttpResponse * response, LLCore::HttpStatus &status);
+
+    const BufferArray::ptr_t &getBody() const
+    {
+        return mBody;
+    }
+
+private:
+    BufferArray::ptr_t mBody;
+};
+
+//-------------------------------------------------------------------------
+HttpCoroBufferHandler::HttpCoroBufferHandler(LLEventStream &reply):
+    HttpCoroRawHandler(reply)
+{
+}
+
+LLSD HttpCoroBufferHandler::handleSuccess(LLCore::HttpResponse * response, LLCore::HttpStatus &status)
+{
+    BufferArray * body(response->getBody());
+    if (body && body->size())
+    {
+        body->addRef();
+        mBody = BufferArray::ptr_t(body);
+    }
+
+    return LLSD::emptyMap();
+}
+
 //========================================================================
 /// The HttpCoroJSONHandler is a specialization of the LLCore::HttpHandler for 
 /// interacting with coroutines. 
@@ -671,7 +719,8 @@ HttpCoroutineAdapter::HttpCoroutineAdapter(const std::string &name,
     mPolicyId(policyId),
     mYieldingHandle(LLCORE_HTTP_HANDLE_INVALID),
     mWeakRequest(),
-    mWeakHandler()
+    mWeakHandler(),
+    mRawBuffer()
 {
 }
 
@@ -945,6 +994,28 @@ LLSD HttpCoroutineAdapter::getRawAndSuspend(LLCore::HttpRequest::ptr_t request,
     return getAndSuspend_(request, url, options, headers, httpHandler);
 }
 
+LLSD HttpCoroutineAdapter::getRawBufferAndSuspend(LLCore::HttpRequest::ptr_t request,
+    const std::string & url,
+    LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
+{
+    LLEventStream  replyPump(mAdapterName + "Reply", true);
+    std::shared_ptr<HttpCoroBufferHandler> bufferHandler(new HttpCoroBufferHandler(replyPump));
+    HttpCoroHandler::ptr_t httpHandler(bufferHandler);
+
+    mRawBuffer.reset();
+    LLSD results = getAndSuspend_(request, url, options, headers, httpHandler);
+    mRawBuffer = bufferHandler->getBody();
+
+    return results;
+}
+
+LLCore::BufferArray::ptr_t HttpCoroutineAdapter::takeRawBuffer()
+{
+    LLCore::BufferArray::ptr_t body;
+    body.swap(mRawBuffer);
+    return body;
+}
+
 LLSD HttpCoroutineAdapter::getJsonAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
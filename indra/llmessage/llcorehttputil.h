@@ -467,6 +467,19 @@ public:
             headers);
     }
 
+    /// Same as @getRawAndSuspend() but the body of a successful response is
+    /// not copied into the "raw" entry. It is kept as received and handed
+    /// out by @takeRawBuffer(), so that large responses can be parsed from
+    /// the BufferArray segments in place.
+    LLSD getRawBufferAndSuspend(LLCore::HttpRequest::ptr_t request,
+        const std::string & url,
+        LLCore::HttpOptions::ptr_t options = LLCore::HttpOptions::ptr_t(new LLCore::HttpOptions()),
+        LLCore::HttpHeaders::ptr_t headers = LLCore::HttpHeaders::ptr_t(new LLCore::HttpHeaders()));
+
+    /// The body kept by the last @getRawBufferAndSuspend(), NULL when the
+    /// request failed or the body was empty. The adapter drops its reference.
+    LLCore::BufferArray::ptr_t takeRawBuffer();
+
     /// These methods have the same behavior as @getAndSuspend() however they are 
     /// expecting the server to return the results formatted in a JSON string. 
     /// On a successful GET call the JSON results will be converted into LLSD 
@@ -672,6 +685,7 @@ private:
     LLCore::HttpHandle              mYieldingHandle;
     LLCore::HttpRequest::wptr_t     mWeakRequest;
     HttpCoroHandler::wptr_t         mWeakHandler;
+    LLCore::BufferArray::ptr_t      mRawBuffer;
 };
 
 
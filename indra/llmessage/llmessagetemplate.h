@@ -97,10 +97,11 @@ public:
 		mMemberVarData[name] = tmp;
 	}
 
-	void addData(char *name, const void *data, S32 size, EMsgVariableType type, S32 data_size = -1)
+	const LLMsgVarData* addData(char *name, const void *data, S32 size, EMsgVariableType type, S32 data_size = -1)
 	{
 		LLMsgVarData* temp = &mMemberVarData[name]; // creates a new entry if one doesn't exist
 		temp->addData(data, size, type, data_size);
+		return temp;
 	}
 
 	S32									mBlockNumber;
@@ -0,0 +1,263 @@
+/**
+ * @file llmessageview.cpp
+ * @brief Typed views of decoded template messages with bound field offsets.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmessageview.h"
+
+#include "llmessagetemplate.h"
+#include "llmessagereader.h"
+#include "message.h"
+
+LLMessageViewField::LLMessageViewField(const char* blockname, const char* varname) :
+	mBlockName(blockname),
+	mVarName(varname),
+	mTemplate(NULL),
+	mBlockIndex(-1),
+	mVarIndex(-1)
+{
+}
+
+bool LLMessageViewField::bind(const LLMessageTemplate* templatep)
+{
+	if (templatep == mTemplate)
+	{
+		return mBlockIndex >= 0;
+	}
+
+	mTemplate = templatep;
+	mBlockIndex = -1;
+	mVarIndex = -1;
+
+	const LLMessageTemplate::message_block_map_t& blocks = templatep->mMemberBlocks;
+	LLMessageTemplate::message_block_map_t::const_iterator block_iter = blocks.find(const_cast<char*>(mBlockName));
+	if (block_iter == blocks.end())
+	{
+		return false;
+	}
+
+	const LLMessageBlock::message_variable_map_t& variables = (*block_iter)->mMemberVariables;
+	LLMessageBlock::message_variable_map_t::const_iterator var_iter = variables.find(mVarName);
+	if (var_iter == variables.end())
+	{
+		return false;
+	}
+
+	mBlockIndex = (S32)(block_iter - blocks.begin());
+	mVarIndex = (S32)(var_iter - variables.begin());
+	return true;
+}
+
+LLMessageView::LLMessageView(LLMessageSystem* msg)
+{
+	init(msg->getMessageReader(), msg->getTemplateMessageReader());
+}
+
+LLMessageView::LLMessageView(LLTemplateMessageReader* reader)
+{
+	init(reader, reader);
+}
+
+void LLMessageView::init(LLMessageReader* named, const LLTemplateMessageReader* reader)
+{
+	mNamed = named;
+	mReader = reader;
+	const LLMessageTemplate* templatep = mReader ? mReader->getCurrentTemplate() : NULL;
+	if (!templatep || mReader->getDecodedBlocks() != (S32)templatep->mMemberBlocks.size())
+	{
+		// Nothing decoded to index
+		mReader = NULL;
+	}
+}
+
+const LLTemplateMessageReader::LLMsgField* LLMessageView::find(LLMessageViewField& field, S32 blocknum)
+{
+	if (!mReader || !field.bind(mReader->getCurrentTemplate()))
+	{
+		return NULL;
+	}
+	if (blocknum < 0 || blocknum >= mReader->getBlockRepeats(field.getBlockIndex()))
+	{
+		return NULL;
+	}
+	return &mReader->getField(field.getBlockIndex(), blocknum, field.getVarIndex());
+}
+
+bool LLMessageView::copyFixed(LLMessageViewField& field, void* datap, S32 size, S32 blocknum)
+{
+	const LLTemplateMessageReader::LLMsgField* fieldp = find(field, blocknum);
+	if (!fieldp || fieldp->mSize != size)
+	{
+		return false;
+	}
+	// Already in host order, the decode swizzled it
+	memcpy(datap, fieldp->mData, size);
+	return true;
+}
+
+S32 LLMessageView::getNumberOfBlocks(LLMessageViewField& field)
+{
+	if (mReader && field.bind(mReader->getCurrentTemplate()))
+	{
+		return mReader->getBlockRepeats(field.getBlockIndex());
+	}
+	return mNamed->getNumberOfBlocks(field.getBlockName());
+}
+
+S32 LLMessageView::getSize(LLMessageViewField& field, S32 blocknum)
+{
+	const LLTemplateMessageReader::LLMsgField* fieldp = find(field, blocknum);
+	if (fieldp)
+	{
+		return fieldp->mSize;
+	}
+	return mNamed->getSize(field.getBlockName(), blocknum, field.getVarName());
+}
+
+void LLMessageView::getBinaryData(LLMessageViewField& field, void* datap, S32 size, S32 blocknum, S32 max_size)
+{
+	const LLTemplateMessageReader::LLMsgField* fieldp = find(field, blocknum);
+	if (fieldp && (!size || size == fieldp->mSize) && max_size >= fieldp->mSize)
+	{
+		memcpy(datap, fieldp->mData, fieldp->mSize);
+		return;
+	}
+	// Mismatches and truncation report as before
+	mNamed->getBinaryData(field.getBlockName(), field.getVarName(), datap, size, blocknum, max_size);
+}
+
+void LLMessageView::getU8(LLMessageViewField& field, U8& data, S32 blocknum)
+{
+	if (!copyFixed(field, &data, sizeof(data), blocknum))
+	{
+		mNamed->getU8(field.getBlockName(), field.getVarName(), data, blocknum);
+	}
+}
+
+void LLMessageView::getU32(LLMessageViewField& field, U32& data, S32 blocknum)
+{
+	if (!copyFixed(field, &data, sizeof(data), blocknum))
+	{
+		mNamed->getU32(field.getBlockName(), field.getVarName(), data, blocknum);
+	}
+}
+
+void LLMessageView::getU64(LLMessageViewField& field, U64& data, S32 blocknum)
+{
+	if (!copyFixed(field, &data, sizeof(data), blocknum))
+	{
+		mNamed->getU64(field.getBlockName(), field.getVarName(), data, blocknum);
+	}
+}
+
+void LLMessageView::getUUID(LLMessageViewField& field, LLUUID& uuid, S32 blocknum)
+{
+	if (!copyFixed(field, uuid.mData, UUID_BYTES, blocknum))
+	{
+		mNamed->getUUID(field.getBlockName(), field.getVarName(), uuid, blocknum);
+	}
+}
+
+namespace
+{
+	// Built on first use, after the _PREHASH_ names exist
+	struct LLObjectUpdateFields
+	{
+		LLObjectUpdateFields() :
+			mRegionHandle(_PREHASH_RegionData, _PREHASH_RegionHandle),
+			mID(_PREHASH_ObjectData, _PREHASH_ID),
+			mFullID(_PREHASH_ObjectData, _PREHASH_FullID),
+			mPCode(_PREHASH_ObjectData, _PREHASH_PCode),
+			mUpdateFlags(_PREHASH_ObjectData, _PREHASH_UpdateFlags),
+			mData(_PREHASH_ObjectData, _PREHASH_Data)
+		{
+		}
+
+		LLMessageViewField mRegionHandle;
+		LLMessageViewField mID;
+		LLMessageViewField mFullID;
+		LLMessageViewField mPCode;
+		LLMessageViewField mUpdateFlags;
+		LLMessageViewField mData;
+	};
+
+	LLObjectUpdateFields& object_update_fields()
+	{
+		static LLObjectUpdateFields fields;
+		return fields;
+	}
+}
+
+U64 LLObjectUpdateView::getRegionHandle()
+{
+	U64 region_handle = 0;
+	getU64(object_update_fields().mRegionHandle, region_handle);
+	return region_handle;
+}
+
+S32 LLObjectUpdateView::getObjectCount()
+{
+	return getNumberOfBlocks(object_update_fields().mData);
+}
+
+U32 LLObjectUpdateView::getLocalID(S32 object)
+{
+	U32 local_id = 0;
+	getU32(object_update_fields().mID, local_id, object);
+	return local_id;
+}
+
+LLUUID LLObjectUpdateView::getFullID(S32 object)
+{
+	LLUUID full_id;
+	getUUID(object_update_fields().mFullID, full_id, object);
+	return full_id;
+}
+
+U8 LLObjectUpdateView::getPCode(S32 object)
+{
+	U8 pcode = 0;
+	getU8(object_update_fields().mPCode, pcode, object);
+	return pcode;
+}
+
+U32 LLObjectUpdateView::getUpdateFlags(S32 object)
+{
+	U32 flags = 0;
+	getU32(object_update_fields().mUpdateFlags, flags, object);
+	return flags;
+}
+
+S32 LLObjectUpdateView::getDataSize(S32 object)
+{
+	return getSize(object_update_fields().mData, object);
+}
+
+void LLObjectUpdateView::getData(S32 object, U8* datap, S32 max_size)
+{
+	getBinaryData(object_update_fields().mData, datap, 0, object, max_size);
+}
@@ -0,0 +1,118 @@
+/**
+ * @file llmessageview.h
+ * @brief Typed views of decoded template messages with bound field offsets.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESSAGEVIEW_H
+#define LL_LLMESSAGEVIEW_H
+
+#include "lluuid.h"
+#include "lltemplatemessagereader.h"
+
+class LLMessageReader;
+class LLMessageSystem;
+
+// A variable of a template message, named like the get*Fast() calls name
+// it. The first message read through it binds the names to the block and
+// variable positions in that message's template, so later reads index the
+// decoded fields instead of looking names up. A field used by several
+// messages rebinds whenever the template changes. Templates are identified
+// by address, as they live as long as the message system.
+class LLMessageViewField
+{
+public:
+	// Both names must be canonical, that is _PREHASH_ strings
+	LLMessageViewField(const char* blockname, const char* varname);
+
+	const char* getBlockName() const	{ return mBlockName; }
+	const char* getVarName() const		{ return mVarName; }
+
+	// False when the template has no such block and variable
+	bool bind(const LLMessageTemplate* templatep);
+	S32 getBlockIndex() const			{ return mBlockIndex; }
+	S32 getVarIndex() const				{ return mVarIndex; }
+
+private:
+	const char*					mBlockName;
+	const char*					mVarName;
+	const LLMessageTemplate*	mTemplate;
+	S32							mBlockIndex;	// -1 when unbound
+	S32							mVarIndex;
+};
+
+// Reads the message being handled through bound fields. Anything the bound
+// fields cannot serve, such as LLSD messages, a missing block or a size
+// mismatch, goes through the named reader calls, which report errors as they
+// always did.
+class LLMessageView
+{
+public:
+	// Views the message msg is handling
+	LLMessageView(LLMessageSystem* msg);
+	// Views the message a reader outside the message system has read
+	LLMessageView(LLTemplateMessageReader* reader);
+
+	S32 getNumberOfBlocks(LLMessageViewField& field);
+	S32 getSize(LLMessageViewField& field, S32 blocknum = 0);
+
+	void getBinaryData(LLMessageViewField& field, void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX);
+	void getU8(LLMessageViewField& field, U8& data, S32 blocknum = 0);
+	void getU32(LLMessageViewField& field, U32& data, S32 blocknum = 0);
+	void getU64(LLMessageViewField& field, U64& data, S32 blocknum = 0);
+	void getUUID(LLMessageViewField& field, LLUUID& uuid, S32 blocknum = 0);
+
+private:
+	// The decoded field, NULL when the named calls have to serve it
+	const LLTemplateMessageReader::LLMsgField* find(LLMessageViewField& field, S32 blocknum);
+	// Copies a fixed size field, false when it is not that size
+	bool copyFixed(LLMessageViewField& field, void* datap, S32 size, S32 blocknum);
+
+	void init(LLMessageReader* named, const LLTemplateMessageReader* reader);
+
+	LLMessageReader*				mNamed;
+	const LLTemplateMessageReader*	mReader;	// NULL when only mNamed serves
+};
+
+// ObjectUpdate, ObjectUpdateCompressed and ImprovedTerseObjectUpdate, which
+// LLViewerObjectList::processObjectUpdate() reads for every object a region
+// sends. Variables a message lacks read through the named calls.
+class LLObjectUpdateView : public LLMessageView
+{
+public:
+	LLObjectUpdateView(LLMessageSystem* msg) : LLMessageView(msg) {}
+	LLObjectUpdateView(LLTemplateMessageReader* reader) : LLMessageView(reader) {}
+
+	U64 getRegionHandle();
+	S32 getObjectCount();
+
+	U32 getLocalID(S32 object);
+	LLUUID getFullID(S32 object);
+	U8 getPCode(S32 object);
+	U32 getUpdateFlags(S32 object);
+	S32 getDataSize(S32 object);
+	void getData(S32 object, U8* datap, S32 max_size);
+};
+
+#endif // LL_LLMESSAGEVIEW_H
@@ -65,7 +65,12 @@ LLReliablePacket::LLReliablePacket(
 		mMessageName = NULL;
 	}
 
-	mExpirationTime = (F64Seconds)totalTime() + mTimeout;
+	// Same clock as the resend pass and the ping, see LLCircuitData::noteReliableAck()
+	mSentTime = LLMessageSystem::getMessageTimeSeconds();
+	mExpirationTime = mSentTime + mTimeout;
+	mResendCount = 0;
+	mLaterAckCount = 0;
+	mResendDeferred = FALSE;
 	mPacketID = ntohl(*((U32*)(&buf_ptr[PHL_PACKET_ID])));
 
 	mSocket = socket;
@@ -110,6 +110,12 @@ protected:
 	TPACKETID mPacketID;
 
 	F64Seconds mExpirationTime;
+
+	// Adaptive retransmit bookkeeping, see LLCircuitData::ackReliablePacket()
+	F64Seconds mSentTime;		// message system time of the last send
+	S32 mResendCount;
+	S32 mLaterAckCount;			// acks of packets sent after this one
+	BOOL mResendDeferred;		// expired and held back by the resend pacing
 };
 
 #endif
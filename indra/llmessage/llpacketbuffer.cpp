@@ -59,6 +59,10 @@ LLPacketBuffer::LLPacketBuffer (S32 hSocket)
 	init(hSocket);
 }
 
+LLPacketBuffer::LLPacketBuffer() : mSize(0)
+{
+}
+
 ///////////////////////////////////////////////////////////
 
 LLPacketBuffer::~LLPacketBuffer ()
@@ -74,3 +78,28 @@ void LLPacketBuffer::init (S32 hSocket)
 	mReceivingIF = ::get_receiving_interface();
 }
 
+LLNetDatagram LLPacketBuffer::getDatagram()
+{
+	LLNetDatagram datagram;
+	datagram.mData = mData;
+	datagram.mSize = mSize;
+	datagram.mAddress = mHost.getAddress();
+	datagram.mPort = mHost.getPort();
+	datagram.mReceivingIF = mReceivingIF.getAddress();
+	return datagram;
+}
+
+void LLPacketBuffer::init(const LLNetDatagram& received)
+{
+	mSize = received.mSize;
+	mHost.set(received.mAddress, received.mPort);
+	mReceivingIF.set(received.mReceivingIF, INVALID_PORT);
+}
+
+void LLPacketBuffer::init(const LLHost &host, const char *datap, const S32 size)
+{
+	mHost = host;
+	mSize = llmax(0, llmin(size, NET_BUFFER_SIZE));
+	memcpy(mData, datap, mSize);	/* Flawfinder: ignore */
+}
+
@@ -36,6 +36,7 @@ class LLPacketBuffer
 public:
 	LLPacketBuffer(const LLHost &host, const char *datap, const S32 size);
 	LLPacketBuffer(S32 hSocket);           // receive a packet
+	LLPacketBuffer();                      // empty, for batched receives and sends
 	~LLPacketBuffer();
 
 	S32			getSize() const					{ return mSize; }
@@ -44,6 +45,11 @@ public:
 	LLHost		getReceivingInterface() const	{ return mReceivingIF; }
 	void init(S32 hSocket);
 
+	// Datagram receiving into or sending from this buffer
+	LLNetDatagram getDatagram();
+	void init(const LLNetDatagram& received);
+	void init(const LLHost &host, const char *datap, const S32 size);
+
 protected:
 	char	mData[NET_BUFFER_SIZE];        // packet data		/* Flawfinder : ignore */
 	S32		mSize;          // size of buffer in bytes
@@ -0,0 +1,138 @@
+/**
+ * @file llpacketcapture.cpp
+ * @brief Files of received datagrams, for replaying them later.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketcapture.h"
+
+#include "llerror.h"
+
+static const char CAPTURE_SIGNATURE[8] = { 'L', 'L', 'P', 'C', 'A', 'P', 0, 1 };
+
+LLPacketCaptureWriter::LLPacketCaptureWriter() :
+	mFile(NULL)
+{
+}
+
+LLPacketCaptureWriter::~LLPacketCaptureWriter()
+{
+	close();
+}
+
+bool LLPacketCaptureWriter::open(const std::string& filename)
+{
+	close();
+	mFile = LLFile::fopen(filename, "wb");
+	if (!mFile)
+	{
+		LL_WARNS("Messaging") << "Cannot create packet capture " << filename << LL_ENDL;
+		return false;
+	}
+	if (fwrite(CAPTURE_SIGNATURE, sizeof(CAPTURE_SIGNATURE), 1, mFile) != 1)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void LLPacketCaptureWriter::close()
+{
+	if (mFile)
+	{
+		LLFile::close(mFile);
+		mFile = NULL;
+	}
+}
+
+bool LLPacketCaptureWriter::write(const LLNetDatagram& datagram)
+{
+	if (!mFile || datagram.mSize <= 0)
+	{
+		return false;
+	}
+	U32 header[4] = { datagram.mAddress, (U32)datagram.mPort, datagram.mReceivingIF, (U32)datagram.mSize };
+	return fwrite(header, sizeof(header), 1, mFile) == 1 &&
+		fwrite(datagram.mData, datagram.mSize, 1, mFile) == 1;
+}
+
+LLPacketCaptureReader::LLPacketCaptureReader() :
+	mFile(NULL)
+{
+}
+
+LLPacketCaptureReader::~LLPacketCaptureReader()
+{
+	close();
+}
+
+bool LLPacketCaptureReader::open(const std::string& filename)
+{
+	close();
+	mFile = LLFile::fopen(filename, "rb");
+	if (!mFile)
+	{
+		return false;
+	}
+	char signature[sizeof(CAPTURE_SIGNATURE)];
+	if (fread(signature, sizeof(signature), 1, mFile) != 1 ||
+		memcmp(signature, CAPTURE_SIGNATURE, sizeof(signature)))
+	{
+		LL_WARNS("Messaging") << filename << " is not a packet capture" << LL_ENDL;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void LLPacketCaptureReader::close()
+{
+	if (mFile)
+	{
+		LLFile::close(mFile);
+		mFile = NULL;
+	}
+}
+
+bool LLPacketCaptureReader::read(LLNetDatagram& datagram)
+{
+	U32 header[4];
+	if (!mFile || fread(header, sizeof(header), 1, mFile) != 1)
+	{
+		return false;
+	}
+	if (!header[3] || header[3] > (U32)NET_BUFFER_SIZE ||
+		fread(datagram.mData, header[3], 1, mFile) != 1)
+	{
+		return false;
+	}
+	datagram.mAddress = header[0];
+	datagram.mPort = (S32)header[1];
+	datagram.mReceivingIF = header[2];
+	datagram.mSize = (S32)header[3];
+	return true;
+}
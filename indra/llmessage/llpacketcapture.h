@@ -0,0 +1,74 @@
+/**
+ * @file llpacketcapture.h
+ * @brief Files of received datagrams, for replaying them later.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETCAPTURE_H
+#define LL_LLPACKETCAPTURE_H
+
+#include "llfile.h"
+#include "net.h"
+
+// A capture file is a signature followed by one record per datagram: the
+// sender address and port, the receiving interface and the size, each a
+// U32 in host byte order, then the datagram bytes.
+
+class LLPacketCaptureWriter
+{
+public:
+	LLPacketCaptureWriter();
+	~LLPacketCaptureWriter();
+
+	bool open(const std::string& filename);
+	void close();
+	bool isOpen() const		{ return mFile != NULL; }
+
+	bool write(const LLNetDatagram& datagram);
+
+private:
+	LLFILE* mFile;
+};
+
+class LLPacketCaptureReader
+{
+public:
+	LLPacketCaptureReader();
+	~LLPacketCaptureReader();
+
+	// Fails on a missing file or a file without the capture signature
+	bool open(const std::string& filename);
+	void close();
+	bool isOpen() const		{ return mFile != NULL; }
+
+	// Reads the next datagram into datagram.mData, which holds
+	// NET_BUFFER_SIZE bytes. Returns false at the end of the capture or
+	// on a truncated record.
+	bool read(LLNetDatagram& datagram);
+
+private:
+	LLFILE* mFile;
+};
+
+#endif // LL_LLPACKETCAPTURE_H
@@ -0,0 +1,234 @@
+/**
+ * @file llpacketreceivethread.cpp
+ * @brief Reads and zero-expands message system packets off the main thread.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketreceivethread.h"
+
+#include "llerror.h"
+#include "llstl.h"
+#include "lltimer.h"
+
+// How long the thread blocks waiting for datagrams, which bounds how long
+// shutting it down takes
+static const S32 RECEIVE_WAIT_MS = 20;
+
+// Stop reading while this many packets wait for the main thread, so a stalled
+// main thread pushes back on the socket buffer as it did without the thread
+static const size_t RECEIVE_QUEUE_LIMIT = 1024;
+
+LLReceivedPacket::LLReceivedPacket() :
+	mMessage(NULL),
+	mMessageSize(0),
+	mCompressedSize(0),
+	mOverflowed(FALSE)
+{
+}
+
+void LLReceivedPacket::decode()
+{
+	mMessage = (U8*)mData;
+	mMessageSize = 0;
+	mCompressedSize = 0;
+	mOverflowed = FALSE;
+
+	S32 size = mSize;
+	if (size < LL_MINIMUM_VALID_PACKET_SIZE)
+	{
+		return;
+	}
+
+	if (mMessage[0] & LL_ACK_FLAG)
+	{
+		S32 acks = mMessage[--size];
+		if (size < (S32)(acks * sizeof(TPACKETID) + LL_MINIMUM_VALID_PACKET_SIZE))
+		{
+			// Malformed, checkMessages() discards it
+			return;
+		}
+		size -= acks * sizeof(TPACKETID);
+	}
+
+	mMessageSize = size;
+	if (mMessage[0] & LL_ZERO_CODE_FLAG)
+	{
+		mMessage[0] &= (~LL_ZERO_CODE_FLAG);
+		mCompressedSize = size;
+		mMessageSize = zero_code_expand(mMessage, size, mExpanded, mOverflowed);
+		mMessage = mExpanded;
+	}
+}
+
+LLPacketReceiveThread::LLPacketReceiveThread(S32 socket, const std::string& capture_file) :
+	LLThread("PacketReceiveThread", nullptr),
+	mSocket(socket),
+	mBypassed(false),
+	mReading(false)
+{
+	if (!capture_file.empty() && mCapture.open(capture_file))
+	{
+		LL_INFOS("Messaging") << "Capturing received packets to " << capture_file << LL_ENDL;
+	}
+}
+
+LLPacketReceiveThread::~LLPacketReceiveThread()
+{
+	shutdown();
+
+	LLMutexLock lock(&mQueueMutex);
+	std::for_each(mReceived.begin(), mReceived.end(), DeletePointer());
+	mReceived.clear();
+	delete_and_clear(mFree);
+}
+
+LLReceivedPacket* LLPacketReceiveThread::popPacket()
+{
+	LLMutexLock lock(&mQueueMutex);
+	if (mReceived.empty())
+	{
+		return NULL;
+	}
+	LLReceivedPacket* packetp = mReceived.front();
+	mReceived.pop_front();
+	return packetp;
+}
+
+void LLPacketReceiveThread::recyclePacket(LLReceivedPacket* packetp)
+{
+	LLMutexLock lock(&mQueueMutex);
+	mFree.push_back(packetp);
+}
+
+size_t LLPacketReceiveThread::getQueuedCount()
+{
+	LLMutexLock lock(&mQueueMutex);
+	return mReceived.size();
+}
+
+LLReceivedPacket* LLPacketReceiveThread::allocatePacket()
+{
+	{
+		LLMutexLock lock(&mQueueMutex);
+		if (!mFree.empty())
+		{
+			LLReceivedPacket* packetp = mFree.back();
+			mFree.pop_back();
+			return packetp;
+		}
+	}
+	return new LLReceivedPacket();
+}
+
+void LLPacketReceiveThread::setBypassed(bool bypassed)
+{
+	std::unique_lock<std::mutex> lock(mReadMutex);
+	mBypassed = bypassed;
+	// Blocks at most one RECEIVE_WAIT_MS, the longest a read waits
+	mReadDone.wait(lock, [this] { return !mReading || !mBypassed; });
+}
+
+bool LLPacketReceiveThread::beginReading()
+{
+	std::lock_guard<std::mutex> lock(mReadMutex);
+	if (mBypassed)
+	{
+		return false;
+	}
+	mReading = true;
+	return true;
+}
+
+void LLPacketReceiveThread::endReading()
+{
+	{
+		std::lock_guard<std::mutex> lock(mReadMutex);
+		mReading = false;
+	}
+	mReadDone.notify_all();
+}
+
+S32 LLPacketReceiveThread::readDatagrams(LLNetDatagram* datagrams, S32 count)
+{
+	if (!wait_for_packets(mSocket, RECEIVE_WAIT_MS))
+	{
+		return 0;
+	}
+	return receive_packets(mSocket, datagrams, count);
+}
+
+void LLPacketReceiveThread::run()
+{
+	LLReceivedPacket* packets[NET_MAX_BATCH_PACKETS] = { NULL };
+	LLNetDatagram datagrams[NET_MAX_BATCH_PACKETS];
+
+	while (!isQuitting())
+	{
+		if (getQueuedCount() >= RECEIVE_QUEUE_LIMIT)
+		{
+			ms_sleep(RECEIVE_WAIT_MS);
+			continue;
+		}
+
+		for (S32 i = 0; i < NET_MAX_BATCH_PACKETS; ++i)
+		{
+			if (!packets[i])
+			{
+				packets[i] = allocatePacket();
+			}
+			datagrams[i] = packets[i]->getDatagram();
+		}
+
+		if (!beginReading())
+		{
+			ms_sleep(RECEIVE_WAIT_MS);
+			continue;
+		}
+		S32 count = readDatagrams(datagrams, NET_MAX_BATCH_PACKETS);
+		endReading();
+		if (count <= 0)
+		{
+			continue;
+		}
+
+		for (S32 i = 0; i < count; ++i)
+		{
+			mCapture.write(datagrams[i]);
+			packets[i]->init(datagrams[i]);
+			packets[i]->decode();
+		}
+
+		LLMutexLock lock(&mQueueMutex);
+		mReceived.insert(mReceived.end(), packets, packets + count);
+		std::fill(packets, packets + count, (LLReceivedPacket*)NULL);
+	}
+
+	for (S32 i = 0; i < NET_MAX_BATCH_PACKETS; ++i)
+	{
+		delete packets[i];
+	}
+	mCapture.close();
+}
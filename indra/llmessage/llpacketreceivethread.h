@@ -0,0 +1,115 @@
+/**
+ * @file llpacketreceivethread.h
+ * @brief Reads and zero-expands message system packets off the main thread.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETRECEIVETHREAD_H
+#define LL_LLPACKETRECEIVETHREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "llmutex.h"
+#include "llthread.h"
+#include "llpacketbuffer.h"
+#include "llpacketcapture.h"
+#include "message.h"
+
+// A datagram as received plus its message, ready for checkMessages()
+class LLReceivedPacket : public LLPacketBuffer
+{
+public:
+	LLReceivedPacket();
+
+	// Finds the message ahead of the appended acks and expands it when it
+	// is zero coded, the same way LLMessageSystem::checkMessages() does.
+	void decode();
+
+	U8*		getTrueData()				{ return (U8*)mData; }
+	U8*		getMessage()				{ return mMessage; }
+	S32		getMessageSize() const		{ return mMessageSize; }	// 0 when malformed
+	S32		getCompressedSize() const	{ return mCompressedSize; }	// 0 when not zero coded
+	BOOL	hasOverflowed() const		{ return mOverflowed; }
+
+private:
+	U8		mExpanded[MAX_BUFFER_SIZE];
+	U8*		mMessage;
+	S32		mMessageSize;
+	S32		mCompressedSize;
+	BOOL	mOverflowed;
+};
+
+// Only the socket reads and the zero expansion move to this thread. Circuits,
+// acks, duplicate suppression and the template decode with its handlers stay
+// on the main thread, which owns that state.
+class LLPacketReceiveThread : public LLThread
+{
+public:
+	// Writes every datagram read to capture_file, when it is not empty
+	LLPacketReceiveThread(S32 socket, const std::string& capture_file = LLStringUtil::null);
+	~LLPacketReceiveThread();
+
+	// The next packet in arrival order, NULL if none is waiting. Hand it
+	// back with recyclePacket() once dispatched.
+	LLReceivedPacket* popPacket();
+	void recyclePacket(LLReceivedPacket* packetp);
+	size_t getQueuedCount();
+
+	// While bypassed the thread stops reading, leaving the socket to the
+	// packet ring. Bypassing waits for a read in progress to finish, so
+	// the socket is never read from both threads.
+	void setBypassed(bool bypassed);
+	bool isBypassed() const				{ return mBypassed; }
+
+protected:
+	void run() override;
+
+	// Waits a little for datagrams, then reads up to count of them.
+	// Returns how many were read.
+	virtual S32 readDatagrams(LLNetDatagram* datagrams, S32 count);
+
+private:
+	LLReceivedPacket* allocatePacket();
+
+	// Claims the socket for one readDatagrams() call, false when bypassed
+	bool beginReading();
+	void endReading();
+
+	S32 mSocket;
+	std::atomic<bool> mBypassed;
+	std::mutex mReadMutex;
+	std::condition_variable mReadDone;
+	bool mReading;
+	LLPacketCaptureWriter mCapture;
+
+	LLMutex mQueueMutex;
+	std::deque<LLReceivedPacket*> mReceived;
+	std::vector<LLReceivedPacket*> mFree;
+};
+
+#endif // LL_LLPACKETRECEIVETHREAD_H
@@ -40,9 +40,23 @@
 #include "lltimer.h"
 #include "llproxy.h"
 #include "llrand.h"
+#include "lltrace.h"
 #include "message.h"
 #include "u64.h"
 
+static LLTrace::CountStatHandle<> sReceiveCalls("udpreceivecalls", "System calls made to receive UDP packets");
+static LLTrace::CountStatHandle<> sSendCalls("udpsendcalls", "System calls made to send UDP packets");
+
+// System calls made by receive_packets() or send_packets() for count packets
+static S32 batch_calls(S32 count)
+{
+#if LL_LINUX
+	return 1;
+#else
+	return count;
+#endif
+}
+
 ///////////////////////////////////////////////////////////
 LLPacketRing::LLPacketRing () :
 	mUseInThrottle(FALSE),
@@ -55,7 +69,11 @@ LLPacketRing::LLPacketRing () :
 	mInBufferLength(0),
 	mOutBufferLength(0),
 	mDropPercentage(0.0f),
-	mPacketsToDrop(0x0)
+	mPacketsToDrop(0x0),
+	mBatchIO(FALSE),
+	mBatchReceivedCount(0),
+	mBatchReceivedNext(0),
+	mBatchSendCount(0)
 {
 }
 
@@ -83,6 +101,10 @@ void LLPacketRing::cleanup ()
 		delete packetp;
 		mSendQueue.pop();
 	}
+
+	delete_and_clear(mBatchReceived);
+	delete_and_clear(mBatchSends);
+	mBatchReceivedCount = mBatchReceivedNext = mBatchSendCount = 0;
 }
 
 ///////////////////////////////////////////////////////////
@@ -116,6 +138,51 @@ void LLPacketRing::setOutBandwidth(const F32 bps)
 {
 	mOutThrottle.setRate(bps);
 }
+
+void LLPacketRing::setBatchIO(const BOOL batch_io)
+{
+	mBatchIO = batch_io;
+	if (mBatchIO && mBatchReceived.empty())
+	{
+		for (S32 i = 0; i < NET_MAX_BATCH_PACKETS; ++i)
+		{
+			mBatchReceived.push_back(new LLPacketBuffer());
+			mBatchSends.push_back(new LLPacketBuffer());
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+S32 LLPacketRing::receiveFromBatch(S32 socket, char *datap)
+{
+	if (mBatchReceivedNext >= mBatchReceivedCount)
+	{
+		// Used them all, read what is waiting now
+		LLNetDatagram datagrams[NET_MAX_BATCH_PACKETS];
+		for (S32 i = 0; i < NET_MAX_BATCH_PACKETS; ++i)
+		{
+			datagrams[i] = mBatchReceived[i]->getDatagram();
+		}
+		mBatchReceivedCount = receive_packets(socket, datagrams, NET_MAX_BATCH_PACKETS);
+		mBatchReceivedNext = 0;
+		add(sReceiveCalls, batch_calls(llmin(mBatchReceivedCount + 1, NET_MAX_BATCH_PACKETS)));
+		for (S32 i = 0; i < mBatchReceivedCount; ++i)
+		{
+			mBatchReceived[i]->init(datagrams[i]);
+		}
+		if (!mBatchReceivedCount)
+		{
+			return 0;
+		}
+	}
+
+	LLPacketBuffer *packetp = mBatchReceived[mBatchReceivedNext++];
+	S32 packet_size = packetp->getSize();
+	memcpy(datap, packetp->getData(), packet_size);	/*Flawfinder: ignore*/
+	mLastSender = packetp->getHost();
+	mLastReceivingIF = packetp->getReceivingInterface();
+	return packet_size;
+}
 ///////////////////////////////////////////////////////////
 S32 LLPacketRing::receiveFromRing (S32 socket, char *datap)
 {
@@ -168,6 +235,7 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 		{
 			LLPacketBuffer *packetp;
 			packetp = new LLPacketBuffer(socket);
+			add(sReceiveCalls, 1);
 
 			if (packetp->getSize())
 			{
@@ -228,6 +296,7 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 		{
 			U8 buffer[NET_BUFFER_SIZE + SOCKS_HEADER_SIZE];
 			packet_size = receive_packet(socket, static_cast<char*>(static_cast<void*>(buffer)));
+			add(sReceiveCalls, 1);
 			
 			if (packet_size > SOCKS_HEADER_SIZE)
 			{
@@ -243,38 +312,53 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 			{
 				packet_size = 0;
 			}
+			mLastReceivingIF = ::get_receiving_interface();
+		}
+		else if (mBatchIO)
+		{
+			packet_size = receiveFromBatch(socket, datap);
 		}
 		else
 		{
 			packet_size = receive_packet(socket, datap);
+			add(sReceiveCalls, 1);
 			mLastSender = ::get_sender();
+			mLastReceivingIF = ::get_receiving_interface();
 		}
 
-		mLastReceivingIF = ::get_receiving_interface();
-
-		if (packet_size)  // did we actually get a packet?
+		if (packet_size && dropReceived())  // did we actually get a packet?
 		{
-			if (mDropPercentage && (ll_frand(100.f) < mDropPercentage))
-			{
-				mPacketsToDrop++;
-			}
-
-			if (mPacketsToDrop)
-			{
-				packet_size = 0;
-				mPacketsToDrop--;
-			}
+			packet_size = 0;
 		}
 	}
 
 	return packet_size;
 }
 
+BOOL LLPacketRing::dropReceived()
+{
+	if (mDropPercentage && (ll_frand(100.f) < mDropPercentage))
+	{
+		mPacketsToDrop++;
+	}
+
+	if (mPacketsToDrop)
+	{
+		mPacketsToDrop--;
+		return TRUE;
+	}
+	return FALSE;
+}
+
 BOOL LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host)
 {
 	BOOL status = TRUE;
 	if (!mUseOutThrottle)
 	{
+		if (mBatchIO && !LLProxy::isSOCKSProxyEnabled())
+		{
+			return queueSend(h_socket, send_buffer, buf_size, host);
+		}
 		return sendPacketImpl(h_socket, send_buffer, buf_size, host );
 	}
 	else
@@ -344,9 +428,40 @@ BOOL LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LL
 	return status;
 }
 
+BOOL LLPacketRing::queueSend(int h_socket, const char * send_buffer, S32 buf_size, LLHost host)
+{
+	BOOL status = TRUE;
+	if (mBatchSendCount >= NET_MAX_BATCH_PACKETS)
+	{
+		status = (flushSends(h_socket) == 0);
+	}
+	mBatchSends[mBatchSendCount++]->init(host, send_buffer, buf_size);
+	return status;
+}
+
+S32 LLPacketRing::flushSends(int h_socket)
+{
+	if (!mBatchSendCount)
+	{
+		return 0;
+	}
+
+	LLNetDatagram datagrams[NET_MAX_BATCH_PACKETS];
+	for (S32 i = 0; i < mBatchSendCount; ++i)
+	{
+		datagrams[i] = mBatchSends[i]->getDatagram();
+	}
+	S32 sent = send_packets(h_socket, datagrams, mBatchSendCount);
+	add(sSendCalls, batch_calls(mBatchSendCount));
+
+	S32 failed = mBatchSendCount - sent;
+	mBatchSendCount = 0;
+	return failed;
+}
+
 BOOL LLPacketRing::sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host)
 {
-	
+	add(sSendCalls, 1);
 	if (!LLProxy::isSOCKSProxyEnabled())
 	{
 		return send_packet(h_socket, send_buffer, buf_size, host.getAddress(), host.getPort());
@@ -29,6 +29,7 @@
 #define LL_LLPACKETRING_H
 
 #include <queue>
+#include <vector>
 
 #include "llhost.h"
 #include "llpacketbuffer.h"
@@ -47,14 +48,24 @@ public:
 	void dropPackets(U32);	
 	void setDropPercentage (F32 percent_to_drop);
 	void setUseInThrottle(const BOOL use_throttle);
+	BOOL getUseInThrottle() const				{ return mUseInThrottle; }
 	void setUseOutThrottle(const BOOL use_throttle);
 	void setInBandwidth(const F32 bps);
 	void setOutBandwidth(const F32 bps);
 	S32  receivePacket (S32 socket, char *datap);
 	S32  receiveFromRing (S32 socket, char *datap);
+	// Simulated packet loss for a packet received, TRUE to drop it
+	BOOL dropReceived();
 
 	BOOL sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host);
 
+	// Batched I/O reads up to NET_MAX_BATCH_PACKETS waiting packets per
+	// system call, and queues the packets sent until flushSends(). It is
+	// bypassed by the simulated throttles and with a SOCKS proxy.
+	void setBatchIO(const BOOL batch_io);
+	// Sends the queued packets, returns how many of them failed.
+	S32  flushSends(int h_socket);
+
 	inline LLHost getLastSender();
 	inline LLHost getLastReceivingInterface();
 
@@ -80,11 +91,20 @@ protected:
 	std::queue<LLPacketBuffer *> mReceiveQueue;
 	std::queue<LLPacketBuffer *> mSendQueue;
 
+	BOOL mBatchIO;
+	std::vector<LLPacketBuffer *> mBatchReceived;	// pool, mBatchReceivedCount filled
+	S32 mBatchReceivedCount;
+	S32 mBatchReceivedNext;
+	std::vector<LLPacketBuffer *> mBatchSends;		// pool, mBatchSendCount queued
+	S32 mBatchSendCount;
+
 	LLHost mLastSender;
 	LLHost mLastReceivingIF;
 
 private:
 	BOOL sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
+	S32  receiveFromBatch(S32 socket, char *datap);
+	BOOL queueSend(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
 };
 
 
@@ -0,0 +1,78 @@
+/**
+ * @file llrttestimator.cpp
+ * @brief Round trip time estimation for reliable packet resends.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+
+#include "llrttestimator.h"
+
+const F32 RTT_ALPHA = 0.125f;
+const F32 RTT_BETA = 0.25f;
+const F32 RTT_VARIATION_FACTOR = 4.f;
+
+LLRTTEstimator::LLRTTEstimator()
+{
+	reset();
+}
+
+void LLRTTEstimator::reset()
+{
+	mSmoothedRTT = F32Seconds(0.f);
+	mRTTVariation = F32Seconds(0.f);
+	mTimeout = LL_RTT_INITIAL_TIMEOUT;
+	mSamples = 0;
+}
+
+void LLRTTEstimator::addSample(F32Seconds rtt)
+{
+	F32 sample = llmax(rtt.value(), 0.f);
+	if (!mSamples)
+	{
+		mSmoothedRTT = F32Seconds(sample);
+		mRTTVariation = F32Seconds(sample * 0.5f);
+	}
+	else
+	{
+		F32 error = fabsf(mSmoothedRTT.value() - sample);
+		mRTTVariation = F32Seconds((1.f - RTT_BETA) * mRTTVariation.value() + RTT_BETA * error);
+		mSmoothedRTT = F32Seconds((1.f - RTT_ALPHA) * mSmoothedRTT.value() + RTT_ALPHA * sample);
+	}
+	++mSamples;
+
+	F32 timeout = mSmoothedRTT.value() + llmax(LL_RTT_CLOCK_GRANULARITY.value(), RTT_VARIATION_FACTOR * mRTTVariation.value());
+	mTimeout = F32Seconds(llclamp(timeout, LL_RTT_MIN_TIMEOUT.value(), LL_RTT_MAX_TIMEOUT.value()));
+}
+
+F32Seconds LLRTTEstimator::getTimeout(S32 resends) const
+{
+	F32 timeout = mTimeout.value();
+	for (S32 i = 0; i < resends && timeout < LL_RTT_MAX_TIMEOUT.value(); ++i)
+	{
+		timeout *= 2.f;
+	}
+	return F32Seconds(llmin(timeout, LL_RTT_MAX_TIMEOUT.value()));
+}
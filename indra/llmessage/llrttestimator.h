@@ -0,0 +1,70 @@
+/**
+ * @file llrttestimator.h
+ * @brief Round trip time estimation for reliable packet resends.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+
+#ifndef LL_LLRTTESTIMATOR_H
+#define LL_LLRTTESTIMATOR_H
+
+#include "llunits.h"
+
+const F32Seconds LL_RTT_INITIAL_TIMEOUT(1.f);		// until the first sample
+const F32Seconds LL_RTT_MIN_TIMEOUT(0.25f);
+const F32Seconds LL_RTT_MAX_TIMEOUT(10.f);			// LL_RELIABLE_TIMEOUT_FACTOR * LL_AVERAGED_PING_MAX
+const F32Seconds LL_RTT_CLOCK_GRANULARITY(0.05f);	// acks are processed once a frame
+
+// Smoothed round trip time and variation of a circuit and the resend
+// timeout derived from them, after Jacobson/Karels (RFC 6298):
+//   srtt = 7/8 srtt + 1/8 rtt
+//   rttvar = 3/4 rttvar + 1/4 |srtt - rtt|
+//   timeout = srtt + max(granularity, 4 rttvar)
+// Callers only add samples for packets that were sent once (Karn's
+// rule), an ack of a resent packet can't tell which send it answers.
+class LLRTTEstimator
+{
+public:
+	LLRTTEstimator();
+
+	void		reset();
+	void		addSample(F32Seconds rtt);
+
+	bool		hasSamples() const			{ return mSamples > 0; }
+	U32			getSampleCount() const		{ return mSamples; }
+	F32Seconds	getSmoothedRTT() const		{ return mSmoothedRTT; }
+	F32Seconds	getRTTVariation() const		{ return mRTTVariation; }
+
+	// Timeout of a packet that has been resent resends times. Each resend
+	// doubles it, up to LL_RTT_MAX_TIMEOUT.
+	F32Seconds	getTimeout(S32 resends = 0) const;
+
+private:
+	F32Seconds	mSmoothedRTT;
+	F32Seconds	mRTTVariation;
+	F32Seconds	mTimeout;
+	U32			mSamples;
+};
+
+#endif // LL_LLRTTESTIMATOR_H
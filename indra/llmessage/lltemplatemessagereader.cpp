@@ -63,6 +63,15 @@ void LLTemplateMessageReader::clearMessage()
 	mCurrentRMessageTemplate = NULL;
 	delete mCurrentRMessageData;
 	mCurrentRMessageData = NULL;
+	mFields.clear();
+	mBlockRepeats.clear();
+}
+
+void LLTemplateMessageReader::addField(const LLMsgVarData* vardata)
+{
+	// The copy getData() reads, which lives as long as the message
+	LLMsgField field = { (const U8*)vardata->getData(), vardata->getSize() };
+	mFields.push_back(field);
 }
 
 void LLTemplateMessageReader::getData(const char *blockname, const char *varname, void *datap, S32 size, S32 blocknum, S32 max_size)
@@ -549,6 +558,10 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 
 	// create base working data set
 	mCurrentRMessageData = new LLMsgData(mCurrentRMessageTemplate->mName);
+	mFields.clear();
+	mBlockFirstField.clear();
+	mBlockVariables.clear();
+	mBlockRepeats.clear();
 	
 	// loop through the template building the data structure as we go
 	LLMessageTemplate::message_block_map_t::const_iterator iter;
@@ -599,6 +612,10 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 
 		LLMsgBlkData* cur_data_block = NULL;
 
+		mBlockFirstField.push_back((S32)mFields.size());
+		mBlockVariables.push_back((S32)mbci->mMemberVariables.size());
+		mBlockRepeats.push_back(repeat_number);
+
 		// now loop through the block
 		for (i = 0; i < repeat_number; i++)
 		{
@@ -666,7 +683,7 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 					}
 					decode_pos += data_size;
 
-					cur_data_block->addData(mvci.getName(), &buffer[decode_pos], tsize, mvci.getType());
+					addField(cur_data_block->addData(mvci.getName(), &buffer[decode_pos], tsize, mvci.getType()));
 					decode_pos += tsize;
 				}
 				else
@@ -680,15 +697,15 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 						// default to 0s.
 						U32 size = mvci.getSize();
 						std::vector<U8> data(size, 0);
-						cur_data_block->addData(mvci.getName(), &(data[0]), 
-												size, mvci.getType());
+						addField(cur_data_block->addData(mvci.getName(), &(data[0]), 
+														 size, mvci.getType()));
 					}
 					else
 					{
-						cur_data_block->addData(mvci.getName(), 
-												&buffer[decode_pos], 
-												mvci.getSize(), 
-												mvci.getType());
+						addField(cur_data_block->addData(mvci.getName(), 
+														 &buffer[decode_pos], 
+														 mvci.getSize(), 
+														 mvci.getType()));
 					}
 					decode_pos += mvci.getSize();
 				}
@@ -30,9 +30,11 @@
 #include "llmessagereader.h"
 
 #include <map>
+#include <vector>
 
 class LLMessageTemplate;
 class LLMsgData;
+class LLMsgVarData;
 
 class LLTemplateMessageReader : public LLMessageReader
 {
@@ -105,6 +107,22 @@ public:
 	bool isTrusted() const;
 	bool isBanned(bool trusted_source) const;
 	bool isUdpBanned() const;
+
+	// The variables of the message being read, in template order, for
+	// LLMessageView. Valid until the message is cleared.
+	struct LLMsgField
+	{
+		const U8*	mData;
+		S32			mSize;
+	};
+	const LLMessageTemplate* getCurrentTemplate() const	{ return mCurrentRMessageTemplate; }
+	S32 getDecodedBlocks() const						{ return (S32)mBlockRepeats.size(); }
+	// Repeats of the template's block_index block in the message
+	S32 getBlockRepeats(S32 block_index) const			{ return mBlockRepeats[block_index]; }
+	const LLMsgField& getField(S32 block_index, S32 blocknum, S32 var_index) const
+	{
+		return mFields[mBlockFirstField[block_index] + blocknum * mBlockVariables[block_index] + var_index];
+	}
 	
 private:
 
@@ -117,10 +135,15 @@ private:
 	void logRanOffEndOfPacket( const LLHost& host, const S32 where, const S32 wanted );
 
 	BOOL decodeData(const U8* buffer, const LLHost& sender );
+	void addField(const LLMsgVarData* vardata);
 
 	S32	mReceiveSize;
 	LLMessageTemplate* mCurrentRMessageTemplate;
 	LLMsgData* mCurrentRMessageData;
+	std::vector<LLMsgField> mFields;
+	std::vector<S32> mBlockFirstField;
+	std::vector<S32> mBlockVariables;
+	std::vector<S32> mBlockRepeats;
 	message_template_number_map_t& mMessageNumbers;
 };
 
@@ -0,0 +1,449 @@
+/**
+ * @file llzerocode.cpp
+ * @brief Zero coding of message system packets.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llzerocode.h"
+
+#include "message.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LL_ZERO_CODE_SSE2 1
+#include <emmintrin.h>
+#if LL_WINDOWS
+#include <intrin.h>
+#endif
+#else
+#define LL_ZERO_CODE_SSE2 0
+#endif
+
+S32 zero_code_encode_scalar(const U8* in_data, S32 in_size, U8* out_data)
+{
+	S32 count = in_size;
+
+	U8 num_zeroes = 0;
+
+	const U8 *inptr = in_data;
+	U8 *outptr = out_data;
+
+// skip the packet id field
+
+	for (U32 ii = 0; ii < LL_PACKET_ID_SIZE ; ++ii)
+	{
+		count--;
+		*outptr++ = *inptr++;
+	}
+
+// build encoded packet
+
+// sequential zero bytes are encoded as 0 [U8 count] 
+// with 0 0 [count] representing wrap (>256 zeroes)
+
+	while (count--)
+	{
+		if (!(*inptr))   // in a zero count
+		{
+			if (num_zeroes)
+			{
+				if (++num_zeroes > 254)
+				{
+					*outptr++ = num_zeroes;
+					num_zeroes = 0;
+				}
+			}
+			else
+			{
+				*outptr++ = 0;
+				num_zeroes = 1;
+			}
+			inptr++;
+		}
+		else
+		{
+			if (num_zeroes)
+			{
+				*outptr++ = num_zeroes;
+				num_zeroes = 0;
+			}
+			*outptr++ = *inptr++;
+		}
+	}
+
+	if (num_zeroes)
+	{
+		*outptr++ = num_zeroes;
+	}
+
+	return (S32)(outptr - out_data);
+}
+
+S32 zero_code_gain_scalar(const U8* in_data, S32 in_size)
+{
+	S32 count = in_size;
+	
+	S32 net_gain = 0;
+	U8 num_zeroes = 0;
+	
+	const U8 *inptr = in_data;
+
+// skip the packet id field
+
+	for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
+	{
+		count--;
+		inptr++;
+	}
+
+// don't actually build, just test
+
+// sequential zero bytes are encoded as 0 [U8 count] 
+// with 0 0 [count] representing wrap (>256 zeroes)
+
+	while (count--)
+	{
+		if (!(*inptr))   // in a zero count
+		{
+			if (num_zeroes)
+			{
+				if (++num_zeroes > 254)
+				{
+					num_zeroes = 0;
+				}
+				net_gain--;   // subseqent zeroes save one
+			}
+			else
+			{
+				net_gain++;  // starting a zero count adds one
+				num_zeroes = 1;
+			}
+			inptr++;
+		}
+		else
+		{
+			if (num_zeroes)
+			{
+				num_zeroes = 0;
+			}
+			inptr++;
+		}
+	}
+	return net_gain;
+}
+
+S32 zero_code_expand_scalar(const U8* in_data, S32 in_size, U8* out_data, BOOL& overflowed)
+{
+	S32 count = in_size;
+
+	const U8 *inptr = in_data;
+	U8 *outptr = out_data;
+
+// skip the packet id field
+
+	for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
+	{
+		count--;
+		*outptr++ = *inptr++;
+	}
+	out_data[0] &= (~LL_ZERO_CODE_FLAG);
+
+// reconstruct encoded packet, keeping track of net size gain
+
+// sequential zero bytes are encoded as 0 [U8 count] 
+// with 0 0 [count] representing wrap (>256 zeroes)
+
+	while (count--)
+	{
+		if (outptr > (&out_data[MAX_BUFFER_SIZE-1]))
+		{
+			LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 1" << LL_ENDL;
+			overflowed = TRUE;
+			outptr = out_data;
+			break;
+		}
+		if (!((*outptr++ = *inptr++)))
+		{
+			while (((count--)) && (!(*inptr)))
+			{
+				*outptr++ = *inptr++;
+  				if (outptr > (&out_data[MAX_BUFFER_SIZE-256]))
+  				{
+  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 2" << LL_ENDL;
+					overflowed = TRUE;
+					outptr = out_data;
+					count = -1;
+					break;
+  				}
+				memset(outptr,0,255);
+				outptr += 255;
+			}
+			
+			if (count < 0)
+			{
+				break;
+			}
+
+			else
+			{
+  				if (outptr > (&out_data[MAX_BUFFER_SIZE-(*inptr)]))
+				{
+  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 3" << LL_ENDL;
+					overflowed = TRUE;
+					outptr = out_data;
+				}
+				memset(outptr,0,(*inptr) - 1);
+				outptr += ((*inptr) - 1);
+				inptr++;
+			}
+		}		
+	}
+
+	return (S32)(outptr - out_data);
+}
+
+#if LL_ZERO_CODE_SSE2
+
+// Runs are split at this many zeroes
+static const S32 MAX_ZERO_RUN = 255;
+
+static inline U32 first_bit(U32 mask)
+{
+#if LL_WINDOWS
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+// Bit i set when byte i of the 16 at p is zero
+static inline U32 zero_mask(const U8* p)
+{
+	__m128i bytes = _mm_loadu_si128((const __m128i*)p);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+}
+
+static inline const U8* find_zero(const U8* p, const U8* end)
+{
+	for (; end - p >= 16; p += 16)
+	{
+		U32 mask = zero_mask(p);
+		if (mask)
+		{
+			return p + first_bit(mask);
+		}
+	}
+	while (p < end && *p)
+	{
+		++p;
+	}
+	return p;
+}
+
+static inline const U8* find_nonzero(const U8* p, const U8* end)
+{
+	for (; end - p >= 16; p += 16)
+	{
+		U32 mask = zero_mask(p) ^ 0xffff;
+		if (mask)
+		{
+			return p + first_bit(mask);
+		}
+	}
+	while (p < end && !*p)
+	{
+		++p;
+	}
+	return p;
+}
+
+S32 zero_code_encode(const U8* in_data, S32 in_size, U8* out_data)
+{
+	llassert(in_size >= LL_PACKET_ID_SIZE);
+	memcpy(out_data, in_data, LL_PACKET_ID_SIZE);
+
+	const U8* inptr = in_data + LL_PACKET_ID_SIZE;
+	const U8* end = in_data + in_size;
+	U8* outptr = out_data + LL_PACKET_ID_SIZE;
+	while (inptr < end)
+	{
+		// Literal bytes, 16 at a time where the rest of the packet allows.
+		// The coded packet is never past twice the bytes read so far, so
+		// the whole 16 fit in out_data.
+		while (end - inptr >= 16)
+		{
+			_mm_storeu_si128((__m128i*)outptr, _mm_loadu_si128((const __m128i*)inptr));
+			U32 mask = zero_mask(inptr);
+			if (mask)
+			{
+				U32 literal = first_bit(mask);
+				inptr += literal;
+				outptr += literal;
+				break;
+			}
+			inptr += 16;
+			outptr += 16;
+		}
+		const U8* zeroes = find_zero(inptr, end);
+		memcpy(outptr, inptr, zeroes - inptr);
+		outptr += zeroes - inptr;
+		if (zeroes == end)
+		{
+			break;
+		}
+
+		inptr = find_nonzero(zeroes, end);
+		S32 run = (S32)(inptr - zeroes);
+		for (; run >= MAX_ZERO_RUN; run -= MAX_ZERO_RUN)
+		{
+			*outptr++ = 0;
+			*outptr++ = MAX_ZERO_RUN;
+		}
+		if (run)
+		{
+			*outptr++ = 0;
+			*outptr++ = (U8)run;
+		}
+	}
+	return (S32)(outptr - out_data);
+}
+
+S32 zero_code_gain(const U8* in_data, S32 in_size)
+{
+	llassert(in_size >= LL_PACKET_ID_SIZE);
+	const U8* inptr = in_data + LL_PACKET_ID_SIZE;
+	const U8* end = in_data + in_size;
+	S32 net_gain = 0;
+	while ((inptr = find_zero(inptr, end)) < end)
+	{
+		const U8* zeroes = inptr;
+		inptr = find_nonzero(zeroes, end);
+		S32 run = (S32)(inptr - zeroes);
+		// Two bytes for each piece of the run
+		net_gain += 2 * ((run + MAX_ZERO_RUN - 1) / MAX_ZERO_RUN) - run;
+	}
+	return net_gain;
+}
+
+S32 zero_code_expand(const U8* in_data, S32 in_size, U8* out_data, BOOL& overflowed)
+{
+	S32 count = in_size - LL_PACKET_ID_SIZE;
+	const U8* inptr = in_data + LL_PACKET_ID_SIZE;
+	U8* outptr = out_data + LL_PACKET_ID_SIZE;
+	U8* out_end = out_data + MAX_BUFFER_SIZE;
+
+	memcpy(out_data, in_data, LL_PACKET_ID_SIZE);
+	out_data[0] &= (~LL_ZERO_CODE_FLAG);
+
+	// Same steps and overflow handling as zero_code_expand_scalar(), with
+	// the literal bytes copied 16 at a time while they fit
+	while (count > 0)
+	{
+		while (count >= 16 && out_end - outptr >= 16)
+		{
+			_mm_storeu_si128((__m128i*)outptr, _mm_loadu_si128((const __m128i*)inptr));
+			U32 mask = zero_mask(inptr);
+			if (mask)
+			{
+				U32 literal = first_bit(mask);
+				inptr += literal;
+				outptr += literal;
+				count -= literal;
+				break;
+			}
+			inptr += 16;
+			outptr += 16;
+			count -= 16;
+		}
+		if (!count)
+		{
+			break;
+		}
+
+		count--;
+		if (outptr >= out_end)
+		{
+			LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 1" << LL_ENDL;
+			overflowed = TRUE;
+			outptr = out_data;
+			break;
+		}
+		if ((*outptr++ = *inptr++))
+		{
+			continue;
+		}
+
+		while (((count--)) && (!(*inptr)))
+		{
+			*outptr++ = *inptr++;
+			if (outptr > out_end - 256)
+			{
+				LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 2" << LL_ENDL;
+				overflowed = TRUE;
+				outptr = out_data;
+				count = -1;
+				break;
+			}
+			memset(outptr, 0, 255);
+			outptr += 255;
+		}
+		if (count < 0)
+		{
+			break;
+		}
+		if (outptr > out_end - (*inptr))
+		{
+			LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 3" << LL_ENDL;
+			overflowed = TRUE;
+			outptr = out_data;
+		}
+		memset(outptr, 0, (*inptr) - 1);
+		outptr += ((*inptr) - 1);
+		inptr++;
+	}
+
+	return (S32)(outptr - out_data);
+}
+
+#else // !LL_ZERO_CODE_SSE2
+
+S32 zero_code_encode(const U8* in_data, S32 in_size, U8* out_data)
+{
+	return zero_code_encode_scalar(in_data, in_size, out_data);
+}
+
+S32 zero_code_gain(const U8* in_data, S32 in_size)
+{
+	return zero_code_gain_scalar(in_data, in_size);
+}
+
+S32 zero_code_expand(const U8* in_data, S32 in_size, U8* out_data, BOOL& overflowed)
+{
+	return zero_code_expand_scalar(in_data, in_size, out_data, overflowed);
+}
+
+#endif // LL_ZERO_CODE_SSE2
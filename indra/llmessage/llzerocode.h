@@ -0,0 +1,55 @@
+/**
+ * @file llzerocode.h
+ * @brief Zero coding of message system packets.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLZEROCODE_H
+#define LL_LLZEROCODE_H
+
+// Zero coding replaces each run of zero bytes after the packet id with a 0
+// and the run length, splitting runs longer than 255. The expansion also
+// takes 0 0 [count] as 256 more zeroes per extra 0.
+//
+// The kernels find runs with SSE2 compares 16 bytes at a time. The _scalar
+// versions are the byte at a time originals, which builds without SSE2 use
+// and the tests check the kernels against.
+
+// Zero codes in_size bytes of in_data, which starts with the packet id, into
+// out_data, which holds 2 * in_size bytes. Returns the coded size, which can
+// be larger than in_size. Does not set LL_ZERO_CODE_FLAG.
+S32 zero_code_encode(const U8* in_data, S32 in_size, U8* out_data);
+S32 zero_code_encode_scalar(const U8* in_data, S32 in_size, U8* out_data);
+
+// What zero_code_encode() would return less in_size, without coding
+S32 zero_code_gain(const U8* in_data, S32 in_size);
+S32 zero_code_gain_scalar(const U8* in_data, S32 in_size);
+
+// Expands the zero-coded in_size bytes of in_data into out_data, which holds
+// MAX_BUFFER_SIZE bytes, and returns the expanded size. Sets overflowed when
+// the packet expands past the buffer.
+S32 zero_code_expand(const U8* in_data, S32 in_size, U8* out_data, BOOL& overflowed);
+S32 zero_code_expand_scalar(const U8* in_data, S32 in_size, U8* out_data, BOOL& overflowed);
+
+#endif // LL_LLZEROCODE_H
@@ -55,6 +55,7 @@
 #include "llmd5.h"
 #include "llmessagebuilder.h"
 #include "llmessageconfig.h"
+#include "llpacketreceivethread.h"
 #include "lltemplatemessagedispatcher.h"
 #include "llpumpio.h"
 #include "lltemplatemessagebuilder.h"
@@ -193,6 +194,9 @@ void LLMessageSystem::init()
 
 	mMessageBuilder = NULL;
 	LockMessageReader(mMessageReader, NULL);
+
+	mReceiveThread = NULL;
+	mReceivedPacket = NULL;
 }
 
 // Read file and build message templates
@@ -325,8 +329,11 @@ LLMessageSystem::~LLMessageSystem()
 	for_each(mMessageNumbers.begin(), mMessageNumbers.end(), DeletePairedPointer());
 	mMessageNumbers.clear();
 	
+	stopReceiveThread();
+
 	if (!mbError)
 	{
+		flushSends();
 		end_net(mSocket);
 	}
 	mSocket = 0;
@@ -381,6 +388,57 @@ BOOL LLMessageSystem::poll(F32 seconds)
 	}
 }
 
+void LLMessageSystem::startReceiveThread(const std::string& capture_file)
+{
+	if (mbError || mReceiveThread)
+	{
+		return;
+	}
+	mReceiveThread = new LLPacketReceiveThread(mSocket, capture_file);
+	mReceiveThread->start();
+}
+
+void LLMessageSystem::stopReceiveThread()
+{
+	if (mReceiveThread)
+	{
+		if (mReceivedPacket)
+		{
+			mReceiveThread->recyclePacket(mReceivedPacket);
+			mReceivedPacket = NULL;
+		}
+		mReceiveThread->shutdown();
+		delete mReceiveThread;
+		mReceiveThread = NULL;
+	}
+}
+
+LLReceivedPacket* LLMessageSystem::popReceivedPacket()
+{
+	if (!mReceiveThread)
+	{
+		return NULL;
+	}
+	if (mReceivedPacket)
+	{
+		mReceiveThread->recyclePacket(mReceivedPacket);
+		mReceivedPacket = NULL;
+	}
+
+	// The simulated in-throttle and the SOCKS proxy need the packet ring
+	// to read the socket. Packets the thread read already come first.
+	mReceiveThread->setBypassed(mPacketRing.getUseInThrottle() || LLProxy::isSOCKSProxyEnabled());
+	while ((mReceivedPacket = mReceiveThread->popPacket()))
+	{
+		if (!mPacketRing.dropReceived())
+		{
+			break;
+		}
+		mReceiveThread->recyclePacket(mReceivedPacket);
+	}
+	return mReceivedPacket;
+}
+
 bool LLMessageSystem::isTrustedSender(const LLHost& host) const
 {
 	LLCircuitData* cdp = mCircuitInfo.findCircuit(host);
@@ -512,14 +570,31 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 		S32 true_rcv_size = 0;
 
 		U8* buffer = mTrueReceiveBuffer;
-		
-		mTrueReceiveSize = mPacketRing.receivePacket(mSocket, (char *)mTrueReceiveBuffer);
-		// If you want to dump all received packets into SecondLife.log, uncomment this
-		//dumpPacketToLog();
-		
+		U8* true_buffer = mTrueReceiveBuffer;
+
+		LLReceivedPacket* received = popReceivedPacket();
+		if (received)
+		{
+			buffer = true_buffer = received->getTrueData();
+			mTrueReceiveSize = received->getSize();
+			mLastSender = received->getHost();
+			mLastReceivingIF = received->getReceivingInterface();
+		}
+		else if (!mReceiveThread || mReceiveThread->isBypassed())
+		{
+			mTrueReceiveSize = mPacketRing.receivePacket(mSocket, (char *)mTrueReceiveBuffer);
+			// If you want to dump all received packets into SecondLife.log, uncomment this
+			//dumpPacketToLog();
+
+			mLastSender = mPacketRing.getLastSender();
+			mLastReceivingIF = mPacketRing.getLastReceivingInterface();
+		}
+		else
+		{
+			// Nothing decoded yet, the receive thread reads the socket
+			mTrueReceiveSize = 0;
+		}
 		receive_size = mTrueReceiveSize;
-		mLastSender = mPacketRing.getLastSender();
-		mLastReceivingIF = mPacketRing.getLastReceivingInterface();
 		
 		if (receive_size < (S32) LL_MINIMUM_VALID_PACKET_SIZE)
 		{
@@ -560,7 +635,14 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 			}
 
 			// process the message as normal
-			mIncomingCompressedSize = zeroCodeExpand(&buffer, &receive_size);
+			if (received)
+			{
+				mIncomingCompressedSize = zeroCodeExpanded(received, &buffer, &receive_size);
+			}
+			else
+			{
+				mIncomingCompressedSize = zeroCodeExpand(&buffer, &receive_size);
+			}
 			mCurrentRecvPacketID = ntohl(*((U32*)(&buffer[1])));
 			host = getSender();
 
@@ -578,7 +660,7 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 				for(S32 i = 0; i < acks; ++i)
 				{
 					true_rcv_size -= sizeof(TPACKETID);
-					memcpy(&mem_id, &mTrueReceiveBuffer[true_rcv_size], /* Flawfinder: ignore*/
+					memcpy(&mem_id, &true_buffer[true_rcv_size], /* Flawfinder: ignore*/
 					     sizeof(TPACKETID));
 					packet_id = ntohl(mem_id);
 					//LL_INFOS("Messaging") << "got ack: " << packet_id << LL_ENDL;
@@ -827,6 +909,14 @@ void LLMessageSystem::processAcks(LockMessageChecker&, F32 collect_time)
 		mResendDumpTime = mt_sec;
 		mCircuitInfo.dumpResends();
 	}
+
+	// Acks and resends above included
+	flushSends();
+}
+
+void LLMessageSystem::flushSends()
+{
+	mSendPacketFailureCount += mPacketRing.flushSends(mSocket);
 }
 
 void LLMessageSystem::copyMessageReceivedToSend()
@@ -2767,54 +2857,7 @@ S32 LLMessageSystem::zeroCodeAdjustCurrentSendTotal()
 	// TODO: babbage: remove this horror
 	mMessageBuilder->setBuilt(FALSE);
 
-	S32 count = mSendSize;
-	
-	S32 net_gain = 0;
-	U8 num_zeroes = 0;
-	
-	U8 *inptr = (U8 *)mSendBuffer;
-
-// skip the packet id field
-
-	for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
-	{
-		count--;
-		inptr++;
-	}
-
-// don't actually build, just test
-
-// sequential zero bytes are encoded as 0 [U8 count] 
-// with 0 0 [count] representing wrap (>256 zeroes)
-
-	while (count--)
-	{
-		if (!(*inptr))   // in a zero count
-		{
-			if (num_zeroes)
-			{
-				if (++num_zeroes > 254)
-				{
-					num_zeroes = 0;
-				}
-				net_gain--;   // subseqent zeroes save one
-			}
-			else
-			{
-				net_gain++;  // starting a zero count adds one
-				num_zeroes = 1;
-			}
-			inptr++;
-		}
-		else
-		{
-			if (num_zeroes)
-			{
-				num_zeroes = 0;
-			}
-			inptr++;
-		}
-	}
+	S32 net_gain = zero_code_gain(mSendBuffer, mSendSize);
 	if (net_gain < 0)
 	{
 		return net_gain;
@@ -2849,75 +2892,38 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 	
 	*data[0] &= (~LL_ZERO_CODE_FLAG);
 
-	S32 count = (*data_size);  
-	
-	U8 *inptr = (U8 *)*data;
-	U8 *outptr = (U8 *)mEncodedRecvBuffer;
-
-// skip the packet id field
-
-	for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
+	BOOL overflowed = FALSE;
+	*data_size = zero_code_expand(*data, in_size, mEncodedRecvBuffer, overflowed);
+	if (overflowed)
 	{
-		count--;
-		*outptr++ = *inptr++;
+		callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
 	}
+	*data = mEncodedRecvBuffer;
+	mUncompressedBytesIn += *data_size;
 
-// reconstruct encoded packet, keeping track of net size gain
-
-// sequential zero bytes are encoded as 0 [U8 count] 
-// with 0 0 [count] representing wrap (>256 zeroes)
+	return(in_size);
+}
 
-	while (count--)
+S32 LLMessageSystem::zeroCodeExpanded(LLReceivedPacket* packetp, U8** data, S32* data_size)
+{
+	// The receive thread did the expansion, account for it like zeroCodeExpand()
+	mTotalBytesIn += *data_size;
+	*data = packetp->getMessage();
+	if (!packetp->getCompressedSize())
 	{
-		if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-1]))
-		{
-			LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 1" << LL_ENDL;
-			callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-			outptr = mEncodedRecvBuffer;					
-			break;
-		}
-		if (!((*outptr++ = *inptr++)))
-		{
-			while (((count--)) && (!(*inptr)))
-			{
-				*outptr++ = *inptr++;
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-256]))
-  				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 2" << LL_ENDL;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;
-					count = -1;
-					break;
-  				}
-				memset(outptr,0,255);
-				outptr += 255;
-			}
-			
-			if (count < 0)
-			{
-				break;
-			}
+		return 0;
+	}
 
-			else
-			{
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-(*inptr)]))
-				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 3" << LL_ENDL;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;					
-				}
-				memset(outptr,0,(*inptr) - 1);
-				outptr += ((*inptr) - 1);
-				inptr++;
-			}
-		}		
+	mCompressedPacketsIn++;
+	mCompressedBytesIn += packetp->getCompressedSize();
+	if (packetp->hasOverflowed())
+	{
+		callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
 	}
-	
-	*data = mEncodedRecvBuffer;
-	*data_size = (S32)(outptr - mEncodedRecvBuffer);
+	*data_size = packetp->getMessageSize();
 	mUncompressedBytesIn += *data_size;
 
-	return(in_size);
+	return packetp->getCompressedSize();
 }
 
 
@@ -3976,6 +3982,11 @@ S32 LLMessageSystem::getReceiveSize() const
 	return mMessageReader->getMessageSize();
 }
 
+LLTemplateMessageReader* LLMessageSystem::getTemplateMessageReader() const
+{
+	return (mMessageReader == mTemplateMessageReader) ? mTemplateMessageReader : NULL;
+}
+
 //static 
 void LLMessageSystem::setTimeDecodes( BOOL b )
 {
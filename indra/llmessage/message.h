@@ -52,6 +52,7 @@
 #include "message_prehash.h"
 #include "llstl.h"
 #include "llmsgvariabletype.h"
+#include "llzerocode.h"
 #include "llmessagesenderinterface.h"
 
 #include "llstoredmessage.h"
@@ -160,6 +161,8 @@ class LLQuaternion;
 class LLSD;
 class LLUUID;
 class LLMessageSystem;
+class LLPacketReceiveThread;
+class LLReceivedPacket;
 class LLPumpIO;
 
 // message system exceptional condition handlers.
@@ -415,7 +418,15 @@ public:
 
 	BOOL	poll(F32 seconds); // Number of seconds that we want to block waiting for data, returns if data was received
 	BOOL	checkMessages(LockMessageChecker&, S64 frame_count = 0 );
+	// Also sends the packets the batched packet ring queued this frame
 	void	processAcks(LockMessageChecker&, F32 collect_time = 0.f);
+	void	flushSends();
+
+	// Reads and zero-expands packets on a thread of its own, checkMessages()
+	// still dispatches them. Packets are also written to capture_file for
+	// replaying, when it is not empty.
+	void	startReceiveThread(const std::string& capture_file = LLStringUtil::null);
+	void	stopReceiveThread();
 
 	BOOL	isMessageFast(const char *msg);
 	BOOL	isMessage(const char *msg)
@@ -537,6 +548,7 @@ public:
 
 	S32     zeroCode(U8 **data, S32 *data_size);
 	S32		zeroCodeExpand(U8 **data, S32 *data_size);
+	S32		zeroCodeExpanded(LLReceivedPacket* packetp, U8 **data, S32 *data_size);
 	S32		zeroCodeAdjustCurrentSendTotal();
 
 	// Uses ping-based retry
@@ -750,6 +762,10 @@ public:
 	S32		getReceiveSize() const;
 	S32		getReceiveCompressedSize() const { return mIncomingCompressedSize; }
 	S32		getReceiveBytes() const;
+	// The reader of the current message, and the template reader when it is
+	// the one reading it, NULL for LLSD messages. See LLMessageView.
+	LLMessageReader* getMessageReader() const	{ return mMessageReader.operator->(); }
+	LLTemplateMessageReader* getTemplateMessageReader() const;
 
 	S32		getUnackedListSize() const			{ return mUnackedListSize; }
 
@@ -863,6 +879,10 @@ private:
 	U8	mTrueReceiveBuffer[MAX_BUFFER_SIZE];
 	S32	mTrueReceiveSize;
 
+	LLPacketReceiveThread* mReceiveThread;
+	LLReceivedPacket* mReceivedPacket;	// being dispatched, recycled by the next pop
+	LLReceivedPacket* popReceivedPacket();
+
 	// Must be valid during decode
 	
 	BOOL	mbError;
@@ -26,7 +26,7 @@
 
 #include "linden_common.h"
 
-//#include "net.h"
+#include "net.h"
 
 // system library includes
 #include <stdexcept>
@@ -40,6 +40,7 @@
 	#include <arpa/inet.h>
 	#include <fcntl.h>
 	#include <errno.h>
+	#include <sys/select.h>
 #endif
 
 // linden library includes
@@ -658,6 +659,182 @@ BOOL send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient,
 	return success;
 }
 
+#if LL_LINUX
+S32 receive_packets(int hSocket, LLNetDatagram* datagrams, S32 count)
+{
+	count = llmin(count, NET_MAX_BATCH_PACKETS);
+	if (count <= 0)
+	{
+		return 0;
+	}
+	struct mmsghdr msgs[NET_MAX_BATCH_PACKETS];
+	struct iovec iovs[NET_MAX_BATCH_PACKETS];
+	struct sockaddr_in addrs[NET_MAX_BATCH_PACKETS];
+	char cmsgs[NET_MAX_BATCH_PACKETS][CMSG_SPACE(sizeof(struct in_pktinfo))];
+
+	memset(msgs, 0, sizeof(msgs[0]) * count);
+	for (S32 i = 0; i < count; ++i)
+	{
+		iovs[i].iov_base = datagrams[i].mData;
+		iovs[i].iov_len = NET_BUFFER_SIZE;
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_control = cmsgs[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(cmsgs[i]);
+	}
+
+	int received = recvmmsg(hSocket, msgs, count, MSG_DONTWAIT, NULL);
+	if (received <= 0)
+	{
+		// Nothing waiting or an error, same as receive_packet()
+		return 0;
+	}
+
+	for (S32 i = 0; i < received; ++i)
+	{
+		LLNetDatagram& datagram = datagrams[i];
+		datagram.mSize = msgs[i].msg_len;
+		datagram.mAddress = addrs[i].sin_addr.s_addr;
+		datagram.mPort = ntohs(addrs[i].sin_port);
+		datagram.mReceivingIF = INVALID_HOST_IP_ADDRESS;
+		for (struct cmsghdr* cmsgptr = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsgptr != NULL;
+			 cmsgptr = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsgptr))
+		{
+			if (cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_PKTINFO)
+			{
+				// See recvfrom_destip()
+				in_pktinfo* pktinfo = (in_pktinfo*)CMSG_DATA(cmsgptr);
+				datagram.mReceivingIF = pktinfo->ipi_spec_dst.s_addr;
+			}
+		}
+	}
+	return received;
+}
+
+S32 send_packets(int hSocket, const LLNetDatagram* datagrams, S32 count)
+{
+	count = llmin(count, NET_MAX_BATCH_PACKETS);
+	struct mmsghdr msgs[NET_MAX_BATCH_PACKETS];
+	struct iovec iovs[NET_MAX_BATCH_PACKETS];
+	struct sockaddr_in addrs[NET_MAX_BATCH_PACKETS];
+
+	memset(msgs, 0, sizeof(msgs[0]) * count);
+	memset(addrs, 0, sizeof(addrs[0]) * count);
+	for (S32 i = 0; i < count; ++i)
+	{
+		iovs[i].iov_base = datagrams[i].mData;
+		iovs[i].iov_len = datagrams[i].mSize;
+		addrs[i].sin_family = AF_INET;
+		addrs[i].sin_addr.s_addr = datagrams[i].mAddress;
+		addrs[i].sin_port = htons(datagrams[i].mPort);
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	// sendmmsg() stops at the first datagram that fails. Retry it like
+	// send_packet() does, or skip it on any other error.
+	S32 next = 0;
+	S32 sent = 0;
+	S32 send_attempts = 0;
+	while (next < count)
+	{
+		int ret = sendmmsg(hSocket, msgs + next, count - next, 0);
+		if (ret > 0)
+		{
+			next += ret;
+			sent += ret;
+			send_attempts = 0;
+			continue;
+		}
+
+		const LLNetDatagram& failed = datagrams[next];
+		struct in_addr addr;
+		addr.s_addr = failed.mAddress;
+		if ((errno == EAGAIN || errno == ECONNREFUSED) && ++send_attempts < 3)
+		{
+			LL_INFOS() << "sendmmsg() reported " << strerror(errno) << ", resending (attempt " << send_attempts << ")" << LL_ENDL;
+			LL_INFOS() << inet_ntoa(addr) << ":" << failed.mPort << LL_ENDL;
+		}
+		else
+		{
+			LL_INFOS() << "sendmmsg() failed: " << errno << ", " << strerror(errno) << LL_ENDL;
+			LL_INFOS() << inet_ntoa(addr) << ":" << failed.mPort << LL_ENDL;
+			++next;
+			send_attempts = 0;
+		}
+	}
+	return sent;
+}
+#endif // LL_LINUX
+
+#endif
+
+#if !LL_LINUX
+// Reads like receive_packet(), but keeps each sender with its datagram instead
+// of in stSrcAddr, as this runs on the receive thread
+S32 receive_packets(int hSocket, LLNetDatagram* datagrams, S32 count)
+{
+	S32 received = 0;
+	for (; received < count; ++received)
+	{
+		LLNetDatagram& datagram = datagrams[received];
+		struct sockaddr_in addr;
+#if LL_WINDOWS
+		int addr_size = sizeof(addr);
+#else
+		socklen_t addr_size = sizeof(addr);
+#endif
+		int ret = recvfrom(hSocket, datagram.mData, NET_BUFFER_SIZE, 0, (struct sockaddr*)&addr, &addr_size);
+		if (ret <= 0)
+		{
+#if LL_WINDOWS
+			int last_error = WSAGetLastError();
+			if (ret == SOCKET_ERROR && last_error != WSAEWOULDBLOCK && last_error != WSAECONNRESET)
+			{
+				LL_INFOS() << "receive_packets() failed, Error: " << last_error << LL_ENDL;
+			}
 #endif
+			datagram.mSize = 0;
+			break;
+		}
+		datagram.mSize = ret;
+		datagram.mAddress = addr.sin_addr.s_addr;
+		datagram.mPort = ntohs(addr.sin_port);
+		// Only recvfrom_destip() on Linux finds the receiving interface
+		datagram.mReceivingIF = INVALID_HOST_IP_ADDRESS;
+	}
+	return received;
+}
+
+S32 send_packets(int hSocket, const LLNetDatagram* datagrams, S32 count)
+{
+	S32 sent = 0;
+	for (S32 i = 0; i < count; ++i)
+	{
+		const LLNetDatagram& datagram = datagrams[i];
+		if (send_packet(hSocket, datagram.mData, datagram.mSize, datagram.mAddress, datagram.mPort))
+		{
+			++sent;
+		}
+	}
+	return sent;
+}
+#endif // !LL_LINUX
+
+BOOL wait_for_packets(int hSocket, S32 timeout_ms)
+{
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET(hSocket, &readable);
+
+	struct timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+	return select(hSocket + 1, &readable, NULL, NULL, &timeout) > 0;
+}
 
 //EOF
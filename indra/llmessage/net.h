@@ -45,6 +45,30 @@ S32		receive_packet(int hSocket, char * receiveBuffer);
 
 BOOL	send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort);	// Returns TRUE on success.
 
+// Batched datagram I/O. On Linux each call is a single recvmmsg() or
+// sendmmsg() system call, elsewhere it loops over receive_packet() and
+// send_packet().
+const S32 NET_MAX_BATCH_PACKETS = 32;
+
+struct LLNetDatagram
+{
+	char*	mData;			// NET_BUFFER_SIZE bytes to receive into, or the bytes to send
+	S32		mSize;			// bytes received, or to send
+	U32		mAddress;		// sender or recipient
+	S32		mPort;			// sender or recipient
+	U32		mReceivingIF;	// address the datagram was sent to, when received
+};
+
+// Receives up to count (at most NET_MAX_BATCH_PACKETS) waiting datagrams.
+// Returns how many were received, 0 if none were waiting.
+S32		receive_packets(int hSocket, LLNetDatagram* datagrams, S32 count);
+
+// Returns how many of the count datagrams were sent.
+S32		send_packets(int hSocket, const LLNetDatagram* datagrams, S32 count);
+
+// Waits up to timeout_ms for a datagram to arrive, TRUE if one is waiting.
+BOOL	wait_for_packets(int hSocket, S32 timeout_ms);
+
 //void	get_sender(char * tmp);
 LLHost	get_sender();
 U32		get_sender_port();
@@ -0,0 +1,512 @@
+/**
+ * @file llcircuit_test.cpp
+ * @brief Reliable resends of LLCircuitData over a simulated lossy link.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+
+#include "../llcircuit.h"
+
+#include <iostream>
+#include <map>
+#include <queue>
+#include <vector>
+
+#include "../lltransfermanager.h"
+#include "../message.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	F64 sMessageTime = 0.0;		// virtual message system time
+
+	class LLLossyLinkSim;
+	LLLossyLinkSim* sLossyLink = NULL;
+}
+
+//=========================================================================
+// Test doubles. The circuit reaches the socket, its counters and the
+// message system clock through gMessageSystem; the socket leads into
+// the simulated link below and the clock is virtual.
+//=========================================================================
+
+LLPounceable<LLMessageSystem*, LLPounceableStatic> gMessageSystem;
+LLTransferManager gTransferManager;
+
+char const* const _PREHASH_ID = "ID";
+char const* const _PREHASH_OldestUnacked = "OldestUnacked";
+char const* const _PREHASH_PacketAck = "PacketAck";
+char const* const _PREHASH_Packets = "Packets";
+char const* const _PREHASH_PingID = "PingID";
+char const* const _PREHASH_StartPingCheck = "StartPingCheck";
+
+LLMessageSystem::LLMessageSystem(const std::string& filename, U32 port, S32 version_major,
+								 S32 version_minor, S32 version_patch,
+								 bool failure_is_fatal,
+								 const F32 circuit_heartbeat_interval, const F32 circuit_timeout) :
+	mCircuitInfo(F32Seconds(circuit_heartbeat_interval), F32Seconds(circuit_timeout))
+{
+	mVerboseLog = FALSE;
+	mResentPackets = 0;
+	mFailedResendPackets = 0;
+}
+LLMessageSystem::~LLMessageSystem() { }
+S32 LLMessageSystem::sendMessage(const LLHost& host, LLStoredMessagePtr message) { return 0; }
+S32 LLMessageSystem::sendMessage(const LLHost& host) { return 0; }
+void LLMessageSystem::newMessageFast(const char* name) { }
+void LLMessageSystem::nextBlockFast(const char* blockname) { }
+void LLMessageSystem::nextBlock(const char* blockname) { }
+void LLMessageSystem::addU8Fast(const char* varname, U8 u) { }
+void LLMessageSystem::addU32Fast(const char* varname, U32 u) { }
+U64Microseconds LLMessageSystem::getMessageTimeUsecs(const BOOL update) { return U64Microseconds((U64)(sMessageTime * 1000000.0)); }
+F64Seconds LLMessageSystem::getMessageTimeSeconds(const BOOL update) { return F64Seconds(sMessageTime); }
+
+LLMessageStringTable::LLMessageStringTable() { }
+LLMessageStringTable::~LLMessageStringTable() { }
+
+LLTransferManager::LLTransferManager() { }
+LLTransferManager::~LLTransferManager() { }
+void LLTransferManager::cleanupConnection(const LLHost& host) { }
+
+LLThrottle::LLThrottle(const F32 throttle) { }
+LLThrottleGroup::LLThrottleGroup() { }
+BOOL LLThrottleGroup::checkOverflow(S32 throttle_cat, F32 bits) { return FALSE; }
+BOOL LLThrottleGroup::throttleOverflow(S32 throttle_cat, F32 bits) { return FALSE; }
+BOOL LLThrottleGroup::dynamicAdjust() { return FALSE; }
+
+LLPacketRing::LLPacketRing() { }
+LLPacketRing::~LLPacketRing() { }
+
+namespace
+{
+	F32 next_random(U32& seed)
+	{
+		seed = seed * 1103515245 + 12345;
+		return (F32)((seed >> 8) & 0xffff) / 65536.f;
+	}
+
+	// Both directions of a link: a base delay, a uniform random queueing
+	// delay and a loss rate. Packets don't overtake each other.
+	struct LLSimLink
+	{
+		F64 mDelay;
+		F64 mJitter;
+		F32 mLoss;
+	};
+
+	struct LLSimStats
+	{
+		S32 mResends;			// the circuit's counts, from getInfo()
+		S32 mFastRetransmits;
+		S32 mDeferredResends;
+		U32 mSpuriousResends;	// the ack of an earlier send was on its way
+		S32 mMaxFrameResends;
+		U32 mFailed;
+		F64 mAckTimeTotal;		// first send to ack, over acked packets
+		F64 mAckTimeMax;
+		U32 mAcked;
+		F64 mDuration;			// until every packet was acked or failed
+
+		F64 getMeanAckTime() const	{ return mAcked ? mAckTimeTotal / mAcked : 0.0; }
+	};
+
+	// Opens up what LLMessageSystem calls on its circuits
+	class LLTestCircuit : public LLCircuitData
+	{
+	public:
+		LLTestCircuit(const LLHost& host) :
+			LLCircuitData(host, 0, F32Seconds(5.f), F32Seconds(100.f))
+		{
+		}
+
+		using LLCircuitData::addReliablePacket;
+		using LLCircuitData::setPingDelay;
+	};
+
+	// A real LLCircuitData sending reliable packets to a simulated
+	// receiver over a lossy link in virtual time. Both ends run once a
+	// frame like the message system: arrivals first, then new sends, then
+	// the circuit's resend pass, then the acks of everything received that
+	// frame in one packet.
+	class LLLossyLinkSim
+	{
+	public:
+		LLLossyLinkSim(bool adaptive, const LLSimLink& link, U32 seed) :
+			mLink(link),
+			mSeed(seed),
+			mStartTime(sMessageTime),
+			mLastDataArrival(sMessageTime),
+			mLastAckArrival(sMessageTime),
+			mSequence(0),
+			mNextID(1),
+			mFrameResends(0),
+			mHost(0x0100007f, 13000),
+			mCircuit(mHost)
+		{
+			mStats = LLSimStats();
+			sLossyLink = this;
+			mCircuit.setAdaptiveRetransmit(adaptive);
+
+			// Pings have been going for a while, the average has settled
+			// on the link's mean round trip.
+			U32Milliseconds ping((U32)(2000.0 * (mLink.mDelay + 0.5 * mLink.mJitter)));
+			for (S32 i = 0; i < 50; ++i)
+			{
+				mCircuit.setPingDelay(ping);
+			}
+		}
+
+		~LLLossyLinkSim()
+		{
+			sLossyLink = NULL;
+		}
+
+		const LLSimStats& run(U32 packets, U32 packets_per_frame)
+		{
+			while (mNextID <= packets || mCircuit.getUnackedPacketCount() || !mInFlight.empty())
+			{
+				frame(llmin(packets_per_frame, packets + 1 - mNextID));
+			}
+			mStats.mDuration = sMessageTime - mStartTime;
+			return getStats();
+		}
+
+		void frame(U32 new_packets)
+		{
+			const F64 FRAME = 0.02;
+			deliver();
+			for (U32 i = 0; i < new_packets; ++i)
+			{
+				send(mNextID++);
+			}
+			mFrameResends = 0;
+			mCircuit.resendUnackedPackets(LLMessageSystem::getMessageTimeSeconds());
+			mStats.mMaxFrameResends = llmax(mStats.mMaxFrameResends, mFrameResends);
+			sendAcks();
+			sMessageTime += FRAME;
+		}
+
+		const LLSimStats& getStats()
+		{
+			LLSD info;
+			mCircuit.getInfo(info);
+			mStats.mResends = info["Resends"].asInteger();
+			mStats.mFastRetransmits = info["FastRetransmits"].asInteger();
+			mStats.mDeferredResends = info["DeferredResends"].asInteger();
+			return mStats;
+		}
+
+		const LLCircuitData& getCircuit() const	{ return mCircuit; }
+		S32 getFrameResends() const				{ return mFrameResends; }
+
+		// Everything the circuit puts on the wire, see LLPacketRing::sendPacket()
+		void transmit(const U8* buffer, S32 length)
+		{
+			U32 net_id;
+			memcpy(&net_id, &buffer[PHL_PACKET_ID], sizeof(net_id));
+			TPACKETID id = ntohl(net_id);
+			if (buffer[0] & LL_RESENT_FLAG)
+			{
+				mFrameResends++;
+				if (mAcksOnTheirWay.count(id))
+				{
+					mStats.mSpuriousResends++;
+				}
+			}
+			transmit(false, std::vector<TPACKETID>(1, id));
+		}
+
+	private:
+		struct Sent
+		{
+			LLLossyLinkSim* mSim;
+			F64 mFirstSentTime;
+		};
+
+		struct Arrival
+		{
+			F64 mTime;
+			U32 mSequence;		// keeps the send order of equal times
+			bool mIsAck;
+			std::vector<TPACKETID> mIDs;
+
+			bool operator<(const Arrival& rhs) const
+			{
+				return mTime != rhs.mTime ? mTime > rhs.mTime : mSequence > rhs.mSequence;
+			}
+		};
+
+		static void onReliableDone(void** data, S32 result)
+		{
+			Sent* sent = reinterpret_cast<Sent*>(data);
+			LLSimStats& stats = sent->mSim->mStats;
+			if (result == LL_ERR_NOERR)
+			{
+				F64 ack_time = sMessageTime - sent->mFirstSentTime;
+				stats.mAckTimeTotal += ack_time;
+				stats.mAckTimeMax = llmax(stats.mAckTimeMax, ack_time);
+				stats.mAcked++;
+			}
+			else
+			{
+				stats.mFailed++;
+			}
+		}
+
+		void transmit(bool is_ack, const std::vector<TPACKETID>& ids)
+		{
+			if (next_random(mSeed) < mLink.mLoss)
+			{
+				return;
+			}
+			F64& last_arrival = is_ack ? mLastAckArrival : mLastDataArrival;
+			Arrival arrival;
+			arrival.mTime = llmax(last_arrival, sMessageTime + mLink.mDelay + mLink.mJitter * next_random(mSeed));
+			last_arrival = arrival.mTime;
+			arrival.mSequence = mSequence++;
+			arrival.mIsAck = is_ack;
+			if (is_ack)
+			{
+				for (TPACKETID id : ids)
+				{
+					mAcksOnTheirWay[id]++;
+				}
+			}
+			arrival.mIDs = ids;
+			mInFlight.push(arrival);
+		}
+
+		// What LLMessageSystem::sendReliable() and sendMessage() do
+		void send(TPACKETID id)
+		{
+			Sent& sent = mSent[id];
+			sent.mSim = this;
+			sent.mFirstSentTime = sMessageTime;
+
+			U8 buffer[64];
+			memset(buffer, 0, sizeof(buffer));
+			buffer[0] = LL_RELIABLE_FLAG;
+			U32 net_id = htonl(id);
+			memcpy(&buffer[PHL_PACKET_ID], &net_id, sizeof(net_id));
+
+			F32Seconds timeout = llmax(LL_MINIMUM_RELIABLE_TIMEOUT_SECONDS, F32Seconds(LL_RELIABLE_TIMEOUT_FACTOR * mCircuit.getPingDelayAveraged()));
+			LLReliablePacketParams params;
+			params.set(mHost, LL_DEFAULT_RELIABLE_RETRIES, TRUE, timeout,
+					   &LLLossyLinkSim::onReliableDone, reinterpret_cast<void**>(&sent), NULL);
+			mCircuit.addReliablePacket(0, buffer, sizeof(buffer), &params);
+			gMessageSystem->mPacketRing.sendPacket(0, (char*)buffer, sizeof(buffer), mHost);
+		}
+
+		void deliver()
+		{
+			while (!mInFlight.empty() && mInFlight.top().mTime <= sMessageTime)
+			{
+				Arrival arrival = mInFlight.top();
+				mInFlight.pop();
+				for (TPACKETID id : arrival.mIDs)
+				{
+					if (arrival.mIsAck)
+					{
+						if (!--mAcksOnTheirWay[id])
+						{
+							mAcksOnTheirWay.erase(id);
+						}
+						mCircuit.ackReliablePacket(id);
+					}
+					else
+					{
+						// Duplicates are acked again, like collectRAck()
+						mAcks.push_back(id);
+					}
+				}
+			}
+		}
+
+		void sendAcks()
+		{
+			if (!mAcks.empty())
+			{
+				transmit(true, mAcks);
+				mAcks.clear();
+			}
+		}
+
+		LLSimLink mLink;
+		U32 mSeed;
+		F64 mStartTime;
+		LLSimStats mStats;
+		F64 mLastDataArrival;
+		F64 mLastAckArrival;
+		U32 mSequence;
+		TPACKETID mNextID;
+		S32 mFrameResends;
+
+		std::map<TPACKETID, Sent> mSent;
+		std::priority_queue<Arrival> mInFlight;
+		std::map<TPACKETID, S32> mAcksOnTheirWay;
+		std::vector<TPACKETID> mAcks;
+
+		LLHost mHost;
+		LLTestCircuit mCircuit;
+	};
+
+	void print_stats(const std::string& name, bool adaptive, const LLSimStats& stats)
+	{
+		std::cout << name << (adaptive ? " adaptive" : " fixed   ")
+				  << ": resends " << stats.mResends
+				  << " spurious " << stats.mSpuriousResends
+				  << " fast " << stats.mFastRetransmits
+				  << " deferred " << stats.mDeferredResends
+				  << " failed " << stats.mFailed
+				  << " mean ack " << stats.getMeanAckTime() * 1000.0 << "ms"
+				  << " max ack " << stats.mAckTimeMax * 1000.0 << "ms"
+				  << " done in " << stats.mDuration << "s" << std::endl;
+	}
+}
+
+BOOL LLPacketRing::sendPacket(int h_socket, char* send_buffer, S32 buf_size, LLHost host)
+{
+	if (sLossyLink)
+	{
+		sLossyLink->transmit((const U8*)send_buffer, buf_size);
+	}
+	return TRUE;
+}
+
+namespace tut
+{
+	struct circuit_data
+	{
+		circuit_data()
+		{
+			sMessageTime = 0.0;
+			gMessageSystem = new LLMessageSystem("", 0, 0, 0, 0, false, 5.f, 100.f);
+		}
+
+		~circuit_data()
+		{
+			delete static_cast<LLMessageSystem*>(gMessageSystem);
+			gMessageSystem = NULL;
+		}
+	};
+	typedef test_group<circuit_data> circuit_test;
+	typedef circuit_test::object circuit_object;
+	tut::circuit_test circuit_testcase("LLCircuit");
+
+	template<> template<>
+	void circuit_object::test<1>()
+	{
+		set_test_name("lossy link");
+		const U32 PACKETS = 3000;
+		const LLSimLink link = { 0.06, 0.04, 0.05f };
+		LLSimStats stats[2];
+		for (S32 adaptive = 0; adaptive < 2; ++adaptive)
+		{
+			LLLossyLinkSim sim(adaptive, link, 1234);
+			stats[adaptive] = sim.run(PACKETS, 4);
+			print_stats("5% loss", adaptive, stats[adaptive]);
+		}
+		ensure_equals("fixed delivers", stats[0].mAcked + stats[0].mFailed, PACKETS);
+		ensure_equals("adaptive delivers", stats[1].mAcked + stats[1].mFailed, PACKETS);
+		ensure_equals("fixed has no fast retransmit", stats[0].mFastRetransmits, 0);
+		ensure("fast retransmit used", stats[1].mFastRetransmits > 0);
+		ensure("lost packets acked sooner", stats[1].getMeanAckTime() < 0.8 * stats[0].getMeanAckTime());
+		ensure("worst case sooner", stats[1].mAckTimeMax < stats[0].mAckTimeMax);
+		ensure("no more failures", stats[1].mFailed <= stats[0].mFailed + PACKETS / 1000);
+		ensure("few spurious resends", stats[1].mSpuriousResends < (U32)stats[1].mResends / 4);
+	}
+
+	template<> template<>
+	void circuit_object::test<2>()
+	{
+		set_test_name("jittery link without loss");
+		const U32 PACKETS = 3000;
+		const LLSimLink link = { 0.03, 0.1, 0.f };
+		LLLossyLinkSim sim(true, link, 99);
+		LLSimStats stats = sim.run(PACKETS, 4);
+		print_stats("jitter ", true, stats);
+		ensure_equals("all acked", stats.mAcked, PACKETS);
+
+		// Acks of packets sent once are the samples, within a frame of the link
+		const LLRTTEstimator& rtt = sim.getCircuit().getRTTEstimator();
+		ensure("every first send sampled", rtt.getSampleCount() >= PACKETS - (U32)stats.mResends);
+		ensure("srtt above the base delay", rtt.getSmoothedRTT().value() > 2.f * link.mDelay);
+		ensure("srtt below the worst case", rtt.getSmoothedRTT().value() < 2.f * (link.mDelay + link.mJitter) + 0.02f);
+
+		// Every resend on this link is spurious, the variation keeps them rare
+		ensure("rare spurious resends", stats.mSpuriousResends < PACKETS / 100);
+	}
+
+	template<> template<>
+	void circuit_object::test<3>()
+	{
+		set_test_name("paced resends after a burst of loss");
+		const U32 PACKETS = 400;
+		const LLSimLink link = { 0.05, 0.01, 0.2f };
+		LLSimStats stats[2];
+		for (S32 adaptive = 0; adaptive < 2; ++adaptive)
+		{
+			LLLossyLinkSim sim(adaptive, link, 7);
+			stats[adaptive] = sim.run(PACKETS, 100);
+			print_stats("burst  ", adaptive, stats[adaptive]);
+		}
+		ensure("fixed resends in a burst", stats[0].mMaxFrameResends > LL_MAX_RESENDS_PER_CIRCUIT_FRAME);
+		ensure_equals("fixed defers nothing", stats[0].mDeferredResends, 0);
+		ensure_equals("adaptive paces", stats[1].mMaxFrameResends, LL_MAX_RESENDS_PER_CIRCUIT_FRAME);
+		ensure("adaptive defers", stats[1].mDeferredResends > 0);
+		ensure("deferrals counted once a packet", stats[1].mDeferredResends <= stats[1].mResends);
+		ensure_equals("all accounted for", stats[1].mAcked + stats[1].mFailed, PACKETS);
+		ensure("most acked", stats[1].mAcked > PACKETS * 95 / 100);
+		ensure("acked sooner", stats[1].getMeanAckTime() < stats[0].getMeanAckTime());
+	}
+
+	template<> template<>
+	void circuit_object::test<4>()
+	{
+		set_test_name("deferred resends are counted once a packet");
+		// Nothing gets through, every packet expires in the same pass
+		const LLSimLink link = { 0.05, 0.f, 1.f };
+		LLLossyLinkSim sim(true, link, 1);
+		const S32 PACKETS = 40;
+		sim.frame(PACKETS);
+		while (!sim.getFrameResends())
+		{
+			sim.frame(0);
+		}
+		ensure_equals("first pass paced", sim.getFrameResends(), LL_MAX_RESENDS_PER_CIRCUIT_FRAME);
+		ensure_equals("rest deferred", sim.getStats().mDeferredResends, PACKETS - LL_MAX_RESENDS_PER_CIRCUIT_FRAME);
+
+		sim.frame(0);
+		ensure_equals("second pass paced", sim.getFrameResends(), LL_MAX_RESENDS_PER_CIRCUIT_FRAME);
+		ensure_equals("still deferred once", sim.getStats().mDeferredResends, PACKETS - LL_MAX_RESENDS_PER_CIRCUIT_FRAME);
+
+		sim.frame(0);
+		ensure_equals("last of them", sim.getFrameResends(), PACKETS - 2 * LL_MAX_RESENDS_PER_CIRCUIT_FRAME);
+		ensure_equals("all resent", sim.getStats().mResends, PACKETS);
+		ensure_equals("deferred once each", sim.getStats().mDeferredResends, PACKETS - LL_MAX_RESENDS_PER_CIRCUIT_FRAME);
+	}
+}
@@ -0,0 +1,384 @@
+/**
+ * @file llpacketreceivethread_test.cpp
+ * @brief LLPacketReceiveThread tests replaying captured packets.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketreceivethread.h"
+
+#include <atomic>
+#include <vector>
+
+#include "lltimer.h"
+#include "lluuid.h"
+#include "stringize.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	typedef std::vector<U8> bytes_t;
+
+	// Feeds the thread from a capture file instead of the socket
+	class LLReplayThread : public LLPacketReceiveThread
+	{
+	public:
+		LLReplayThread(const std::string& filename) :
+			LLPacketReceiveThread(-1)
+		{
+			mReader.open(filename);
+		}
+
+	protected:
+		S32 readDatagrams(LLNetDatagram* datagrams, S32 count) override
+		{
+			S32 read = 0;
+			// Odd batch sizes, so packets straddle batches
+			while (read < llmin(count, 3) && mReader.read(datagrams[read]))
+			{
+				++read;
+			}
+			if (!read)
+			{
+				ms_sleep(1);
+			}
+			return read;
+		}
+
+	private:
+		LLPacketCaptureReader mReader;
+	};
+
+	// Reads nothing, but takes a while about it, like a read waiting on an
+	// idle socket
+	class LLSlowReadThread : public LLPacketReceiveThread
+	{
+	public:
+		LLSlowReadThread() :
+			LLPacketReceiveThread(-1),
+			mInRead(false),
+			mReads(0)
+		{
+		}
+
+		std::atomic<bool> mInRead;
+		std::atomic<S32> mReads;
+
+	protected:
+		S32 readDatagrams(LLNetDatagram* datagrams, S32 count) override
+		{
+			mInRead = true;
+			++mReads;
+			ms_sleep(50);
+			mInRead = false;
+			return 0;
+		}
+	};
+
+	// Zero codes message like LLMessageSystem::zeroCode(), leaving the
+	// packet id header alone
+	bytes_t zero_code(const bytes_t& message)
+	{
+		bytes_t coded(message.begin(), message.begin() + LL_PACKET_ID_SIZE);
+		coded[0] |= LL_ZERO_CODE_FLAG;
+		U8 zeroes = 0;
+		for (size_t i = LL_PACKET_ID_SIZE; i < message.size(); ++i)
+		{
+			if (!message[i])
+			{
+				if (zeroes == 255)
+				{
+					coded.push_back(0);
+					coded.push_back(zeroes);
+					zeroes = 0;
+				}
+				++zeroes;
+				continue;
+			}
+			if (zeroes)
+			{
+				coded.push_back(0);
+				coded.push_back(zeroes);
+				zeroes = 0;
+			}
+			coded.push_back(message[i]);
+		}
+		if (zeroes)
+		{
+			coded.push_back(0);
+			coded.push_back(zeroes);
+		}
+		return coded;
+	}
+
+	bytes_t make_message(U32 packet_id, size_t size, U32 seed)
+	{
+		bytes_t message(size, 0);
+		message[0] = LL_RELIABLE_FLAG;
+		U32 id = htonl(packet_id);
+		memcpy(&message[1], &id, sizeof(id));
+		for (size_t i = LL_PACKET_ID_SIZE; i < size; ++i)
+		{
+			// Runs of zeroes of all lengths, including longer than 255
+			seed = seed * 1103515245 + 12345;
+			message[i] = ((seed >> 16) % 3) ? 0 : (U8)(seed >> 8);
+			if (i > 600 && i < 1000)
+			{
+				message[i] = 0;
+			}
+		}
+		return message;
+	}
+
+	void append_acks(bytes_t& packet, U8 count)
+	{
+		packet[0] |= LL_ACK_FLAG;
+		for (U8 i = 0; i < count; ++i)
+		{
+			U32 ack = htonl(1000 + i);
+			packet.insert(packet.end(), (U8*)&ack, (U8*)&ack + sizeof(ack));
+		}
+		packet.push_back(count);
+	}
+}
+
+namespace tut
+{
+	struct packet_receive_data
+	{
+		packet_receive_data()
+		{
+			LLUUID random;
+			random.generate();
+			mCaptureFile = STRINGIZE(LLFile::tmpdir() << "llpacketreceive-test-" << random);
+		}
+
+		~packet_receive_data()
+		{
+			LLFile::remove(mCaptureFile);
+		}
+
+		// Captures packets from a few senders, returns the messages they carry,
+		// empty for the packets checkMessages() discards
+		std::vector<bytes_t> writeCapture()
+		{
+			std::vector<bytes_t> messages;
+			LLPacketCaptureWriter writer;
+			ensure("capture created", writer.open(mCaptureFile));
+			for (U32 i = 0; i < 60; ++i)
+			{
+				bytes_t message = make_message(i, 20 + (i * 37) % 1400, i);
+				bytes_t packet = (i % 2) ? zero_code(message) : message;
+				if (i % 3 == 0)
+				{
+					append_acks(packet, (U8)(i % 5));
+				}
+				message[0] = packet[0] & ~LL_ZERO_CODE_FLAG;
+				if (i % 29 == 28)
+				{
+					// Claims more acks than it holds
+					packet.resize(12);
+					packet.push_back(200);
+					packet[0] |= LL_ACK_FLAG;
+					message.clear();
+				}
+				if (i == 40)
+				{
+					packet.resize(LL_MINIMUM_VALID_PACKET_SIZE - 1);
+					message.clear();
+				}
+				messages.push_back(message);
+
+				LLNetDatagram datagram;
+				datagram.mData = (char*)&packet[0];
+				datagram.mSize = (S32)packet.size();
+				datagram.mAddress = 0x0100007f;
+				datagram.mPort = 13000 + (i % 4);
+				datagram.mReceivingIF = 0x0100007f;
+				ensure("packet captured", writer.write(datagram));
+			}
+			return messages;
+		}
+
+		static bytes_t messageOf(LLReceivedPacket* packetp)
+		{
+			if (!packetp->getMessageSize())
+			{
+				return bytes_t();
+			}
+			return bytes_t(packetp->getMessage(), packetp->getMessage() + packetp->getMessageSize());
+		}
+
+		// Replays the capture through a receive thread, returning what the
+		// main thread gets in order
+		std::vector<bytes_t> replay(size_t count, std::vector<U32>* ports = NULL)
+		{
+			std::vector<bytes_t> messages;
+			LLReplayThread thread(mCaptureFile);
+			thread.start();
+			LLTimer timer;
+			while (messages.size() < count && timer.getElapsedTimeF32() < 10.f)
+			{
+				LLReceivedPacket* packetp = thread.popPacket();
+				if (!packetp)
+				{
+					ms_sleep(1);
+					continue;
+				}
+				messages.push_back(messageOf(packetp));
+				if (ports)
+				{
+					ports->push_back(packetp->getHost().getPort());
+				}
+				thread.recyclePacket(packetp);
+			}
+			thread.shutdown();
+			return messages;
+		}
+
+		std::string mCaptureFile;
+	};
+	typedef test_group<packet_receive_data> packet_receive_test;
+	typedef packet_receive_test::object packet_receive_object;
+	tut::packet_receive_test packet_receive_testcase("LLPacketReceiveThread");
+
+	template<> template<>
+	void packet_receive_object::test<1>()
+	{
+		set_test_name("zero_code_expand() inverts zero coding");
+		bytes_t message = make_message(7, 1200, 99);
+		bytes_t coded = zero_code(message);
+		ensure("coding shrinks the message", coded.size() < message.size());
+
+		U8 expanded[MAX_BUFFER_SIZE];
+		BOOL overflowed = FALSE;
+		S32 size = zero_code_expand(&coded[0], (S32)coded.size(), expanded, overflowed);
+		ensure("no overflow", !overflowed);
+		ensure_equals("expanded size", size, (S32)message.size());
+		ensure("expanded bytes", !memcmp(expanded, &message[0], size));
+
+		// A run of zeroes expanding past the buffer
+		bytes_t bomb(coded.begin(), coded.begin() + LL_PACKET_ID_SIZE);
+		for (S32 i = 0; i < MAX_BUFFER_SIZE / 255 + 2; ++i)
+		{
+			bomb.push_back(0);
+			bomb.push_back(255);
+		}
+		zero_code_expand(&bomb[0], (S32)bomb.size(), expanded, overflowed);
+		ensure("overflow reported", overflowed);
+	}
+
+	template<> template<>
+	void packet_receive_object::test<2>()
+	{
+		set_test_name("capture round trip");
+		std::vector<bytes_t> messages = writeCapture();
+
+		LLPacketCaptureReader reader;
+		ensure("capture opened", reader.open(mCaptureFile));
+		char buffer[NET_BUFFER_SIZE];
+		LLNetDatagram datagram;
+		datagram.mData = buffer;
+		size_t count = 0;
+		while (reader.read(datagram))
+		{
+			ensure_equals("port", datagram.mPort, (S32)(13000 + (count % 4)));
+			++count;
+		}
+		ensure_equals("every packet read back", count, messages.size());
+
+		LLPacketCaptureReader not_capture;
+		ensure("missing capture", !not_capture.open(mCaptureFile + ".missing"));
+	}
+
+	template<> template<>
+	void packet_receive_object::test<3>()
+	{
+		set_test_name("replayed packets decode as on the main thread");
+		std::vector<bytes_t> expected = writeCapture();
+
+		std::vector<U32> ports;
+		std::vector<bytes_t> replayed = replay(expected.size(), &ports);
+		ensure_equals("every packet replayed", replayed.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); ++i)
+		{
+			ensure(STRINGIZE("message " << i), replayed[i] == expected[i]);
+			ensure_equals(STRINGIZE("sender " << i), ports[i], (U32)(13000 + (i % 4)));
+		}
+
+		// Decoding the capture inline gives the same
+		LLPacketCaptureReader reader;
+		reader.open(mCaptureFile);
+		LLReceivedPacket packet;
+		LLNetDatagram datagram = packet.getDatagram();
+		for (size_t i = 0; reader.read(datagram); ++i)
+		{
+			packet.init(datagram);
+			packet.decode();
+			ensure(STRINGIZE("inline message " << i), messageOf(&packet) == expected[i]);
+		}
+	}
+
+	template<> template<>
+	void packet_receive_object::test<4>()
+	{
+		set_test_name("replay is deterministic");
+		std::vector<bytes_t> expected = writeCapture();
+		std::vector<bytes_t> first = replay(expected.size());
+		std::vector<bytes_t> second = replay(expected.size());
+		ensure_equals("every packet replayed", first.size(), expected.size());
+		ensure("same packets both times", first == second);
+	}
+
+	template<> template<>
+	void packet_receive_object::test<5>()
+	{
+		set_test_name("bypassing waits for the read in progress");
+		LLSlowReadThread thread;
+		thread.start();
+		LLTimer timer;
+		while (!thread.mInRead && timer.getElapsedTimeF32() < 10.f)
+		{
+			ms_sleep(1);
+		}
+		ensure("thread reading", thread.mInRead);
+
+		thread.setBypassed(true);
+		ensure("read finished before bypassing", !thread.mInRead);
+		S32 reads = thread.mReads;
+		ms_sleep(200);
+		ensure_equals("no reads while bypassed", (S32)thread.mReads, reads);
+
+		thread.setBypassed(false);
+		timer.reset();
+		while (thread.mReads == reads && timer.getElapsedTimeF32() < 10.f)
+		{
+			ms_sleep(1);
+		}
+		ensure("reading again", thread.mReads > reads);
+		thread.shutdown();
+	}
+}
@@ -0,0 +1,94 @@
+/**
+ * @file llrttestimator_test.cpp
+ * @brief Round trip estimation for reliable resends.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+
+#include "linden_common.h"
+
+#include "../llrttestimator.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct rtt_estimator_data
+	{
+	};
+	typedef test_group<rtt_estimator_data> rtt_estimator_test;
+	typedef rtt_estimator_test::object rtt_estimator_object;
+	tut::rtt_estimator_test rtt_estimator_testcase("llrttestimator");
+
+	template<> template<>
+	void rtt_estimator_object::test<1>()
+	{
+		set_test_name("estimate follows the samples");
+		LLRTTEstimator rtt;
+		ensure("no samples", !rtt.hasSamples());
+		ensure_equals("initial timeout", rtt.getTimeout().value(), LL_RTT_INITIAL_TIMEOUT.value());
+
+		rtt.addSample(F32Seconds(0.2f));
+		ensure_approximately_equals("first srtt", rtt.getSmoothedRTT().value(), 0.2f, 16);
+		ensure_approximately_equals("first rttvar", rtt.getRTTVariation().value(), 0.1f, 16);
+		ensure_approximately_equals("first timeout", rtt.getTimeout().value(), 0.6f, 16);
+
+		for (S32 i = 0; i < 200; ++i)
+		{
+			rtt.addSample(F32Seconds(0.2f));
+		}
+		ensure_approximately_equals("steady srtt", rtt.getSmoothedRTT().value(), 0.2f, 12);
+		ensure("steady rttvar decays", rtt.getRTTVariation().value() < 0.001f);
+		// Variation gone, the granularity is what's left over the srtt
+		ensure_approximately_equals("steady timeout", rtt.getTimeout().value(),
+									0.2f + LL_RTT_CLOCK_GRANULARITY.value(), 12);
+
+		F32Seconds steady = rtt.getTimeout();
+		rtt.addSample(F32Seconds(0.6f));
+		ensure("spike raises the timeout", rtt.getTimeout() > steady);
+		ensure("srtt moves an eighth", fabsf(rtt.getSmoothedRTT().value() - 0.25f) < 0.001f);
+
+		rtt.reset();
+		ensure("reset", !rtt.hasSamples());
+	}
+
+	template<> template<>
+	void rtt_estimator_object::test<2>()
+	{
+		set_test_name("timeout clamps and backs off");
+		LLRTTEstimator rtt;
+		rtt.addSample(F32Seconds(0.001f));
+		ensure_equals("min", rtt.getTimeout().value(), LL_RTT_MIN_TIMEOUT.value());
+		ensure_equals("doubled", rtt.getTimeout(1).value(), 2.f * LL_RTT_MIN_TIMEOUT.value());
+		ensure_equals("doubled twice", rtt.getTimeout(2).value(), 4.f * LL_RTT_MIN_TIMEOUT.value());
+		ensure_equals("capped", rtt.getTimeout(20).value(), LL_RTT_MAX_TIMEOUT.value());
+
+		rtt.addSample(F32Seconds(60.f));
+		ensure_equals("max", rtt.getTimeout().value(), LL_RTT_MAX_TIMEOUT.value());
+		ensure_equals("max backed off", rtt.getTimeout(3).value(), LL_RTT_MAX_TIMEOUT.value());
+
+		rtt.addSample(F32Seconds(-1.f));
+		ensure("negative samples count as zero", rtt.getSmoothedRTT().value() > 0.f);
+	}
+}
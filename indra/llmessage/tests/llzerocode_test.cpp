@@ -0,0 +1,240 @@
+/**
+ * @file llzerocode_test.cpp
+ * @brief Zero coding kernels against the byte at a time originals.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llzerocode.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "../llpacketreceivethread.h"
+#include "stringize.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	typedef std::vector<U8> bytes_t;
+
+	U32 next_random(U32& seed)
+	{
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	}
+
+	// A message of size bytes whose zero runs follow shape: sparse,
+	// dense, or long runs around the 255 split
+	bytes_t make_message(size_t size, U32 seed, S32 shape)
+	{
+		bytes_t message(size, 0);
+		message[0] = LL_RELIABLE_FLAG;
+		for (size_t i = 1; i < size; )
+		{
+			U32 r = next_random(seed);
+			size_t run = (shape == 2) ? 250 + r % 12 : 1 + r % (shape ? 24 : 3);
+			bool zeroes = (r >> 12) % (shape ? 2 : 4) == 0;
+			for (size_t end = llmin(size, i + run); i < end; ++i)
+			{
+				message[i] = zeroes ? 0 : (U8)(1 + (next_random(seed) % 255));
+			}
+		}
+		return message;
+	}
+
+	bytes_t encode(const bytes_t& message, bool scalar)
+	{
+		bytes_t coded(2 * message.size());
+		S32 size = scalar ? zero_code_encode_scalar(&message[0], (S32)message.size(), &coded[0])
+						  : zero_code_encode(&message[0], (S32)message.size(), &coded[0]);
+		coded.resize(size);
+		return coded;
+	}
+
+	bytes_t expand(const bytes_t& coded, bool scalar, BOOL& overflowed)
+	{
+		bytes_t expanded(MAX_BUFFER_SIZE);
+		overflowed = FALSE;
+		S32 size = scalar ? zero_code_expand_scalar(&coded[0], (S32)coded.size(), &expanded[0], overflowed)
+						  : zero_code_expand(&coded[0], (S32)coded.size(), &expanded[0], overflowed);
+		expanded.resize(size);
+		return expanded;
+	}
+
+	// The messages of a capture written with FSNetReceiveCaptureFile, when
+	// LL_ZERO_CODE_CAPTURE names one, otherwise made up ones
+	std::vector<bytes_t> load_corpus()
+	{
+		std::vector<bytes_t> corpus;
+		const char* capture = getenv("LL_ZERO_CODE_CAPTURE");
+		LLPacketCaptureReader reader;
+		if (capture && reader.open(capture))
+		{
+			LLReceivedPacket packet;
+			LLNetDatagram datagram = packet.getDatagram();
+			while (reader.read(datagram))
+			{
+				packet.init(datagram);
+				packet.decode();
+				if (packet.getMessageSize() >= LL_MINIMUM_VALID_PACKET_SIZE && !packet.hasOverflowed())
+				{
+					corpus.push_back(bytes_t(packet.getMessage(), packet.getMessage() + packet.getMessageSize()));
+				}
+			}
+		}
+		if (corpus.empty())
+		{
+			for (U32 i = 0; i < 2000; ++i)
+			{
+				corpus.push_back(make_message(LL_PACKET_ID_SIZE + 20 + (i * 37) % 1150, i, i % 3));
+			}
+		}
+		return corpus;
+	}
+}
+
+namespace tut
+{
+	struct zero_code_data
+	{
+	};
+	typedef test_group<zero_code_data> zero_code_test;
+	typedef zero_code_test::object zero_code_object;
+	tut::zero_code_test zero_code_testcase("llzerocode");
+
+	template<> template<>
+	void zero_code_object::test<1>()
+	{
+		set_test_name("kernels code and expand like the originals");
+		for (U32 i = 0; i < 3000; ++i)
+		{
+			// Sizes on both sides of the 16 byte blocks, up to a full packet
+			U32 seed = i;
+			size_t size = LL_PACKET_ID_SIZE + ((i < 100) ? i : next_random(seed) % (MAX_BUFFER_SIZE - LL_PACKET_ID_SIZE - 1));
+			bytes_t message = make_message(size, seed, i % 3);
+
+			bytes_t coded = encode(message, false);
+			ensure(STRINGIZE("coded " << i), coded == encode(message, true));
+			ensure_equals(STRINGIZE("gain " << i), zero_code_gain(&message[0], (S32)size),
+						  zero_code_gain_scalar(&message[0], (S32)size));
+			ensure_equals(STRINGIZE("gain matches coding " << i), zero_code_gain(&message[0], (S32)size),
+						  (S32)coded.size() - (S32)size);
+
+			coded[0] |= LL_ZERO_CODE_FLAG;
+			BOOL overflowed;
+			bytes_t expanded = expand(coded, false, overflowed);
+			ensure(STRINGIZE("no overflow " << i), !overflowed);
+			ensure(STRINGIZE("round trip " << i), expanded == message);
+			ensure(STRINGIZE("expanded " << i), expanded == expand(coded, true, overflowed));
+		}
+	}
+
+	template<> template<>
+	void zero_code_object::test<2>()
+	{
+		set_test_name("kernels expand malformed packets like the originals");
+		for (U32 i = 0; i < 3000; ++i)
+		{
+			// Random bytes, zero heavy, with 0 0 [count] wraps. Every tenth
+			// has long runs, which mostly expand past the buffer.
+			U32 seed = i * 7919;
+			bytes_t coded(LL_PACKET_ID_SIZE + next_random(seed) % 600);
+			for (size_t j = 0; j < coded.size(); ++j)
+			{
+				U32 r = next_random(seed);
+				if (j && !coded[j - 1] && i % 10)
+				{
+					coded[j] = (U8)(r % 12);
+				}
+				else
+				{
+					coded[j] = (r % 3) ? (U8)(r >> 8) : 0;
+				}
+			}
+			coded[0] |= LL_ZERO_CODE_FLAG;
+
+			BOOL overflowed;
+			BOOL scalar_overflowed;
+			bytes_t expanded = expand(coded, false, overflowed);
+			bytes_t scalar = expand(coded, true, scalar_overflowed);
+			ensure_equals(STRINGIZE("overflow " << i), overflowed, scalar_overflowed);
+			ensure(STRINGIZE("expanded " << i), expanded == scalar);
+		}
+	}
+
+	template<> template<>
+	void zero_code_object::test<3>()
+	{
+		set_test_name("zero coding throughput");
+		typedef std::chrono::steady_clock clock_t;
+		typedef std::chrono::duration<double, std::milli> ms_t;
+
+		std::vector<bytes_t> corpus = load_corpus();
+		std::vector<bytes_t> coded;
+		size_t bytes = 0;
+		for (const bytes_t& message : corpus)
+		{
+			coded.push_back(encode(message, true));
+			coded.back()[0] |= LL_ZERO_CODE_FLAG;
+			bytes += message.size();
+		}
+
+		const S32 ROUNDS = 50;
+		U8 out[2 * MAX_BUFFER_SIZE];
+		for (S32 scalar = 1; scalar >= 0; --scalar)
+		{
+			S64 check = 0;
+			auto start = clock_t::now();
+			for (S32 round = 0; round < ROUNDS; ++round)
+			{
+				for (const bytes_t& message : corpus)
+				{
+					check += scalar ? zero_code_encode_scalar(&message[0], (S32)message.size(), out)
+									: zero_code_encode(&message[0], (S32)message.size(), out);
+				}
+			}
+			auto middle = clock_t::now();
+			for (S32 round = 0; round < ROUNDS; ++round)
+			{
+				for (const bytes_t& packet : coded)
+				{
+					BOOL overflowed = FALSE;
+					check += scalar ? zero_code_expand_scalar(&packet[0], (S32)packet.size(), out, overflowed)
+									: zero_code_expand(&packet[0], (S32)packet.size(), out, overflowed);
+				}
+			}
+			auto end = clock_t::now();
+			ensure("coded and expanded", check > 0);
+
+			double mb = (double)bytes * ROUNDS / (1024. * 1024.);
+			std::cout << (scalar ? "scalar" : "kernel") << " zero coding of " << corpus.size()
+					  << " messages, encode: " << mb / (ms_t(middle - start).count() / 1000.)
+					  << " MB/s, expand: " << mb / (ms_t(end - middle).count() / 1000.) << " MB/s" << std::endl;
+		}
+	}
+}
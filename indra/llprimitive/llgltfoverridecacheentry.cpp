@@ -0,0 +1,254 @@
+/**
+ * @file llgltfoverridecacheentry.cpp
+ * @brief Cached GLTF material overrides of an object
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llgltfoverridecacheentry.h"
+
+#include "llregionhandle.h"
+#include "llsdserialize.h"
+
+// <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
+const std::string LLGLTFOverrideCacheEntry::VERSION_LABEL = {"GLTFCacheVer"};
+// </FS:Beq>
+// Version 1 and older are LLSD text files, they are still read so that the
+// extras of a region survive the switch to the binary format.
+const int LLGLTFOverrideCacheEntry::VERSION = 2;
+const char LLGLTFOverrideCacheEntry::BINARY_MAGIC[4] = { 'G', 'L', 'X', 'B' };
+
+bool LLGLTFOverrideCacheEntry::fromLLSD(const LLSD& data)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+    
+    llassert(data.has("local_id"));
+    llassert(data.has("object_id"));
+    llassert(data.has("region_handle_x") && data.has("region_handle_y"));
+
+    if (!data.has("local_id"))
+    {
+        return false;
+    }
+
+    if (data.has("region_handle_x") && data.has("region_handle_y"))
+    {
+        // TODO start requiring this once server sends this for all messages
+        U32 region_handle_y = data["region_handle_y"].asInteger();
+        U32 region_handle_x = data["region_handle_x"].asInteger();
+        mRegionHandle = to_region_handle(region_handle_x, region_handle_y);
+    }
+    else
+    {
+        return false;
+    }
+
+    mLocalId = data["local_id"].asInteger();
+    mObjectId = data["object_id"];
+
+    // message should be interpreted thusly:
+    ///  sides is a list of face indices
+    //   gltf_llsd is a list of corresponding GLTF override LLSD
+    //   any side not represented in "sides" has no override
+    if (data.has("sides") && data.has("gltf_llsd"))
+    {
+        LLSD const& sides = data.get("sides");
+        LLSD const& gltf_llsd = data.get("gltf_llsd");
+
+        if (sides.isArray() && gltf_llsd.isArray() &&
+            sides.size() != 0 &&
+            sides.size() == gltf_llsd.size())
+        {
+            for (int i = 0; i < sides.size(); ++i)
+            {
+                S32 side_idx = sides[i].asInteger();
+                mSides[side_idx] = gltf_llsd[i];
+                LLGLTFMaterial* override_mat = new LLGLTFMaterial();
+                override_mat->applyOverrideLLSD(gltf_llsd[i]);
+                mGLTFMaterial[side_idx] = override_mat;
+            }
+        }
+        else
+        {
+            LL_WARNS_IF(sides.size() != 0, "GLTF") << "broken override cache entry" << LL_ENDL;
+        }
+    }
+
+    llassert(mSides.size() == mGLTFMaterial.size());
+#ifdef SHOW_ASSERT
+    for (auto const & side : mSides)
+    {
+        // check that mSides and mGLTFMaterial have exactly the same keys present
+        llassert(mGLTFMaterial.count(side.first) == 1);
+    }
+#endif
+
+    return true;
+}
+
+LLSD LLGLTFOverrideCacheEntry::toLLSD() const
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+    LLSD data;
+    U32 region_handle_x, region_handle_y;
+    from_region_handle(mRegionHandle, &region_handle_x, &region_handle_y);
+    data["region_handle_y"] = LLSD::Integer(region_handle_y);
+    data["region_handle_x"] = LLSD::Integer(region_handle_x);
+
+    data["object_id"] = mObjectId;
+    data["local_id"] = (LLSD::Integer) mLocalId;
+
+    llassert(mSides.size() == mGLTFMaterial.size());
+    for (auto const & side : mSides)
+    {
+        // check that mSides and mGLTFMaterial have exactly the same keys present
+        llassert(mGLTFMaterial.count(side.first) == 1);
+        data["sides"].append(LLSD::Integer(side.first));
+        data["gltf_llsd"].append(side.second);
+    }
+
+    return data;
+}
+
+// Binary extras cache format (version 2), values in host byte order like the
+// object cache files:
+//   file:  BINARY_MAGIC, S32 version, region id, U32 entry count, entries
+//   entry: U32 length of the rest of the entry, U32 local id, object id,
+//          U32 side count, then per side S32 side index, U32 length and the
+//          override as binary LLSD
+namespace
+{
+    template<typename T>
+    void append_value(std::string& out, const T& value)
+    {
+        out.append((const char*)&value, sizeof(T));
+    }
+
+    template<typename T>
+    bool read_value(const U8*& data, const U8* end, T& value)
+    {
+        if (end - data < (std::ptrdiff_t)sizeof(T))
+        {
+            return false;
+        }
+        memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return true;
+    }
+}
+
+void LLGLTFOverrideCacheEntry::writeBinary(std::string& out) const
+{
+    size_t start = out.size();
+    append_value(out, (U32)0); // entry length, filled in below
+    append_value(out, mLocalId);
+    out.append((const char*)mObjectId.mData, UUID_BYTES);
+
+    if (isPacked())
+    {
+        // never used since it was read, write it back as it was
+        out.append(mPackedSides);
+    }
+    else
+    {
+        append_value(out, (U32)mSides.size());
+        for (auto const & side : mSides)
+        {
+            std::ostringstream ostr;
+            LLSDSerialize::toBinary(side.second, ostr);
+            const std::string side_data(ostr.str());
+            append_value(out, side.first);
+            append_value(out, (U32)side_data.size());
+            out.append(side_data);
+        }
+    }
+
+    U32 length = (U32)(out.size() - start - sizeof(U32));
+    memcpy(&out[start], &length, sizeof(U32));
+}
+
+bool LLGLTFOverrideCacheEntry::readBinary(const U8*& data, const U8* end)
+{
+    U32 length = 0;
+    if (!read_value(data, end, length) ||
+        length < sizeof(U32) + UUID_BYTES ||
+        (U32)(end - data) < length)
+    {
+        return false;
+    }
+
+    const U8* entry_end = data + length;
+    read_value(data, entry_end, mLocalId);
+    memcpy(mObjectId.mData, data, UUID_BYTES);
+    data += UUID_BYTES;
+
+    mSides.clear();
+    mGLTFMaterial.clear();
+    mPackedSides.assign((const char*)data, entry_end - data);
+    data = entry_end;
+    return true;
+}
+
+bool LLGLTFOverrideCacheEntry::unpack()
+{
+    if (!isPacked())
+    {
+        return true;
+    }
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+
+    const U8* data = (const U8*)mPackedSides.data();
+    const U8* end = data + mPackedSides.size();
+    U32 count = 0;
+    bool success = read_value(data, end, count);
+    for (U32 i = 0; success && i < count; ++i)
+    {
+        S32 side_idx = 0;
+        U32 size = 0;
+        success = read_value(data, end, side_idx) && read_value(data, end, size) && (U32)(end - data) >= size;
+        if (success)
+        {
+            LLSD side_llsd;
+            std::istringstream istr(std::string((const char*)data, size));
+            success = LLSDSerialize::fromBinary(side_llsd, istr, size) != LLSDParser::PARSE_FAILURE;
+            data += size;
+            if (success)
+            {
+                mSides[side_idx] = side_llsd;
+                LLGLTFMaterial* override_mat = new LLGLTFMaterial();
+                override_mat->applyOverrideLLSD(side_llsd);
+                mGLTFMaterial[side_idx] = override_mat;
+            }
+        }
+    }
+    mPackedSides.clear();
+
+    if (!success)
+    {
+        LL_WARNS("GLTF") << "broken override cache entry for local id " << mLocalId << LL_ENDL;
+        mSides.clear();
+        mGLTFMaterial.clear();
+    }
+    return success;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file llgltfoverridecacheentry.h
+ * @brief Cached GLTF material overrides of an object
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLGLTFOVERRIDECACHEENTRY_H
+#define LL_LLGLTFOVERRIDECACHEENTRY_H
+
+#include "llgltfmaterial.h"
+#include "llpointer.h"
+#include "llsd.h"
+#include "lluuid.h"
+
+#include <unordered_map>
+
+// GLTF material overrides of an object as kept in the region object cache
+// extras file, see LLVOCache
+class LLGLTFOverrideCacheEntry
+{
+public:
+    static const std::string VERSION_LABEL;
+    static const int VERSION;
+    static const char BINARY_MAGIC[4];
+    bool fromLLSD(const LLSD& data);
+    LLSD toLLSD() const;
+
+    // Binary extras cache record: record length, local id, object id and the
+    // override data. readBinary() keeps the override data packed until
+    // unpack() is called, when the object actually uses it.
+    void writeBinary(std::string& out) const;
+    bool readBinary(const U8*& data, const U8* end);
+    bool unpack();
+    bool isPacked() const { return !mPackedSides.empty(); }
+
+    LLUUID mObjectId;
+    U32    mLocalId = 0;
+    std::unordered_map<S32, LLSD> mSides; //override LLSD per side
+    std::unordered_map<S32, LLPointer<LLGLTFMaterial> > mGLTFMaterial; //GLTF material per side
+    U64 mRegionHandle = 0;
+    std::string mPackedSides; //override data read from the cache and not decoded yet
+};
+
+#endif // LL_LLGLTFOVERRIDECACHEENTRY_H
@@ -0,0 +1,116 @@
+/**
+ * @file llgltfoverridecacheentry_test.cpp
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "lltut.h"
+
+#include "../llgltfoverridecacheentry.h"
+#include "llregionhandle.h"
+#include "lluuid.cpp"
+#include "v4color.h"
+
+// llgltfmaterial.cpp needs the gltf implementation, see llgltfmaterial_test.cpp
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_USE_CPP14
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define TINYGLTF_NO_EXTERNAL_IMAGE 1
+
+#include "tinygltf/tiny_gltf.h"
+
+namespace tut
+{
+    struct override_cache
+    {
+    };
+    typedef test_group<override_cache> override_cache_t;
+    typedef override_cache_t::object override_cache_object_t;
+    tut::override_cache_t tut_override_cache("LLGLTFOverrideCacheEntry");
+
+    template<> template<>
+    void override_cache_object_t::test<1>()
+    {
+        set_test_name("binary round trip");
+
+        LLSD side_override;
+        side_override["bc"] = LLColor4(0.5f, 0.25f, 1.f, 1.f).getValue();
+        side_override["mf"] = 0.75;
+        side_override["tex"].append(LLUUID::generateNewID());
+
+        LLSD entry_llsd;
+        entry_llsd["local_id"] = 1234;
+        entry_llsd["object_id"] = LLUUID::generateNewID();
+        entry_llsd["region_handle_x"] = 140 * 256;
+        entry_llsd["region_handle_y"] = 81 * 256;
+        entry_llsd["sides"].append(0);
+        entry_llsd["sides"].append(3);
+        entry_llsd["gltf_llsd"].append(side_override);
+        entry_llsd["gltf_llsd"].append(LLSD::emptyMap());
+
+        LLGLTFOverrideCacheEntry entry;
+        ensure("fromLLSD", entry.fromLLSD(entry_llsd));
+
+        std::string data;
+        entry.writeBinary(data);
+        LLGLTFOverrideCacheEntry other;
+        other.mLocalId = 99;
+        other.mSides[1] = side_override;
+        other.mGLTFMaterial[1] = new LLGLTFMaterial();
+        other.writeBinary(data);
+
+        const U8* ptr = (const U8*)data.data();
+        const U8* end = ptr + data.size();
+        LLGLTFOverrideCacheEntry read;
+        ensure("readBinary", read.readBinary(ptr, end));
+        ensure("override data stays packed", read.isPacked() && read.mSides.empty());
+        ensure_equals("local id", read.mLocalId, entry.mLocalId);
+        ensure_equals("object id", read.mObjectId, entry.mObjectId);
+
+        // a packed entry is written back unchanged
+        std::string second;
+        read.writeBinary(second);
+        ensure("packed rewrite", second == data.substr(0, second.size()));
+
+        ensure("unpack", read.unpack());
+        read.mRegionHandle = entry.mRegionHandle;
+        ensure_equals("sides count", read.mSides.size(), (size_t)2);
+        ensure_equals("materials count", read.mGLTFMaterial.size(), (size_t)2);
+        // toLLSD() lists the sides in hash order, compare them one by one
+        ensure_equals("side 0", read.mSides[0], side_override);
+        ensure_equals("side 3", read.mSides[3], LLSD::emptyMap());
+        ensure_equals("material", read.mGLTFMaterial[0]->mMetallicFactor, entry.mGLTFMaterial[0]->mMetallicFactor);
+
+        LLGLTFOverrideCacheEntry next;
+        ensure("second entry", next.readBinary(ptr, end));
+        ensure_equals("second local id", next.mLocalId, (U32)99);
+        ensure("second unpack", next.unpack());
+        ensure_equals("second override", next.mSides[1], side_override);
+        ensure("end of data", ptr == end);
+
+        LLGLTFOverrideCacheEntry truncated;
+        ptr = (const U8*)data.data();
+        ensure("truncated entry", !truncated.readBinary(ptr, ptr + 10));
+    }
+}
@@ -39,6 +39,7 @@
 #include "llagentui.h"
 #include "llappearancemgr.h"
 #include "llanimationstates.h"
+#include "llappviewer.h"
 #include "llavatarappearancedefines.h"
 #include "llcallingcard.h"
 #include "llchannelmanager.h"
@@ -79,6 +80,7 @@
 #include "llstartup.h"
 #include "llstatusbar.h"
 #include "llteleportflags.h"
+#include "lltexturefetch.h"
 #include "lltool.h"
 #include "lltoolbarview.h"
 #include "lltoolpie.h"
@@ -5581,6 +5583,11 @@ void LLAgent::setTeleportState(ETeleportState state)
 		case TELEPORT_MOVING:
 		// We're outa here. Save "back" slurl.
 		LLAgentUI::buildSLURL(*mTeleportSourceSLURL);
+		// Textures requested around the old location go behind the new ones
+		if (LLAppViewer::getTextureFetch())
+		{
+			LLAppViewer::getTextureFetch()->commandDowngradeRequests();
+		}
 			break;
 
 		case TELEPORT_ARRIVING:
@@ -59,6 +59,36 @@ const S32 MAX_SIMULTANEOUS_COROUTINES = 2048;
 // Specify own depth to be able to anticipate it and mark folders as incomplete
 const S32 MAX_FOLDER_DEPTH_REQUEST = 50;
 
+// Folder fetches can return whole inventories. Their responses are fetched
+// raw and read into the AISUpdate while they are parsed, rather than being
+// turned into an LLSD tree first. See AISUpdate::parseStream().
+static bool is_streamed(AISAPI::COMMAND_TYPE type)
+{
+    switch (type)
+    {
+    case AISAPI::FETCHCATEGORYCHILDREN:
+    case AISAPI::FETCHCATEGORYCATEGORIES:
+    case AISAPI::FETCHCATEGORYSUBSET:
+    case AISAPI::FETCHCOF:
+    case AISAPI::FETCHCATEGORYLINKS:
+    case AISAPI::FETCHORPHANS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// True if the viewer knows a newer version of the category than the one
+// AIS sent.
+static bool is_stale_category(const LLViewerInventoryCategory* curr_cat, S32 version)
+{
+    return curr_cat
+        && curr_cat->getVersion() > LLViewerInventoryCategory::VERSION_UNKNOWN
+        && curr_cat->getDescendentCount() != LLViewerInventoryCategory::DESCENDENT_COUNT_UNKNOWN
+        && version > LLViewerInventoryCategory::VERSION_UNKNOWN
+        && version < curr_cat->getVersion();
+}
+
 //-------------------------------------------------------------------------
 /*static*/
 bool AISAPI::isAvailable()
@@ -488,7 +518,7 @@ void AISAPI::FetchCategoryChildren(const LLUUID &catId, ITEM_TYPE type, bool rec
         // _4 -> body 
         // _5 -> httpOptions
         // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+        (&LLCoreHttpUtil::HttpCoroutineAdapter::getRawBufferAndSuspend), _1, _2, _3, _5, _6);
 
     // get doesn't use body, can pass additional data
     LLSD body;
@@ -541,7 +571,7 @@ void AISAPI::FetchCategoryChildren(const std::string &identifier, bool recursive
         // _4 -> body 
         // _5 -> httpOptions
         // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+        (&LLCoreHttpUtil::HttpCoroutineAdapter::getRawBufferAndSuspend), _1, _2, _3, _5, _6);
 
     // get doesn't use body, can pass additional data
     LLSD body;
@@ -592,7 +622,7 @@ void AISAPI::FetchCategoryCategories(const LLUUID &catId, ITEM_TYPE type, bool r
         // _4 -> body 
         // _5 -> httpOptions
         // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+        (&LLCoreHttpUtil::HttpCoroutineAdapter::getRawBufferAndSuspend), _1, _2, _3, _5, _6);
 
     // get doesn't use body, can pass additional data
     LLSD body;
@@ -669,7 +699,7 @@ void AISAPI::FetchCategorySubset(const LLUUID& catId,
         // _4 -> body 
         // _5 -> httpOptions
         // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+        (&LLCoreHttpUtil::HttpCoroutineAdapter::getRawBufferAndSuspend), _1, _2, _3, _5, _6);
 
     // get doesn't use body, can pass additional data
     LLSD body;
@@ -706,7 +736,7 @@ void AISAPI::FetchCOF(completion_t callback)
         // _4 -> body 
         // _5 -> httpOptions
         // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend), _1, _2, _3, _5, _6);
+        (&LLCoreHttpUtil::HttpCoroutineAdapter::getRawBufferAndSuspend), _1, _2, _3, _5, _6);
 
     LLSD body;
     // Only cof folder will be full, but cof can contain an outfit
@@ -743,7 +773,7 @@ void AISAPI::FetchCategoryLinks(const LLUUID &catId, completion_t callback)
         // _4 -> body
         // _5 -> httpOptions
         // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend),
+        (&LLCoreHttpUtil::HttpCoroutineAdapter::getRawBufferAndSuspend),
         _1, _2, _3, _5, _6);
 
     LLSD body;
@@ -779,7 +809,7 @@ void AISAPI::FetchOrphans(completion_t callback)
         // _4 -> body 
         // _5 -> httpOptions
         // _6 -> httpHeaders
-        (&LLCoreHttpUtil::HttpCoroutineAdapter::getAndSuspend) , _1 , _2 , _3 , _5 , _6);
+        (&LLCoreHttpUtil::HttpCoroutineAdapter::getRawBufferAndSuspend) , _1 , _2 , _3 , _5 , _6);
 
     LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro ,
                                                          _1 , getFn , url , LLUUID::null , LLSD() , callback , FETCHORPHANS));
@@ -852,6 +882,37 @@ void AISAPI::onUpdateReceived(const LLSD& update, COMMAND_TYPE type, const LLSD&
     LL_DEBUGS("Inventory", "AIS3") << "Elapsed processing: " << timer.getElapsedTimeF32() << LL_ENDL;
 }
 
+/*static*/
+void AISAPI::onStreamReceived(LLSD& result, const LLCore::BufferArray::ptr_t& raw,
+    COMMAND_TYPE type, const LLSD& request_body)
+{
+    LLTimer timer;
+    LLSD top_level = LLSD::emptyMap();
+    if (raw)
+    {
+        // Parse the body segments where they are rather than gathering
+        // them into one block first
+        LLSDSpanList spans;
+        raw->getSpans(spans);
+        AISUpdate ais_update(type, request_body);
+        if (ais_update.parseStream(spans, top_level))
+        {
+            ais_update.doUpdate(); // execute the updates in the appropriate order.
+        }
+        else
+        {
+            LL_WARNS("Inventory") << "Malformed response contents" << LL_ENDL;
+            top_level = LLSD::emptyMap();
+        }
+    }
+
+    // The callers only want the top level values
+    top_level[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS] =
+        result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS];
+    result = top_level;
+    LL_DEBUGS("Inventory", "AIS3") << "Elapsed processing: " << timer.getElapsedTimeF32() << LL_ENDL;
+}
+
 /*static*/
 void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter, 
         invokationFn_t invoke, std::string url, 
@@ -879,9 +940,24 @@ void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t ht
     LLCore::HttpStatus status;
 
     result = invoke(httpAdapter , httpRequest , url , body , httpOptions , httpHeaders);
+    // Streamed fetches leave the body of the response with the adapter
+    LLCore::BufferArray::ptr_t raw = httpAdapter->takeRawBuffer();
     httpResults = result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS];
     status = LLCoreHttpUtil::HttpCoroutineAdapter::getStatusFromLLSD(httpResults);
 
+    const bool streamed = is_streamed(type);
+    if (streamed && !status)
+    {
+        // Unlike the LLSD handler, the raw one leaves error bodies alone
+        LLSD error_content;
+        std::istringstream error_body(httpResults["error_body"].asString());
+        if ((LLSDSerialize::fromXML(error_content, error_body) > 0) && error_content.isMap())
+        {
+            error_content[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS] = httpResults;
+            result = error_content;
+        }
+    }
+
     if (!status || !result.isMap())
     {
         if (!result.isMap())
@@ -952,8 +1028,16 @@ void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t ht
         LL_WARNS("Inventory") << ll_pretty_print_sd(result) << LL_ENDL;
     }
 
-	LL_DEBUGS("Inventory", "AIS3") << "Result: " << result << LL_ENDL;
-    onUpdateReceived(result, type, body);
+    if (streamed && status)
+    {
+        onStreamReceived(result, raw, type, body);
+        LL_DEBUGS("Inventory", "AIS3") << "Result: " << result << LL_ENDL;
+    }
+    else
+    {
+        LL_DEBUGS("Inventory", "AIS3") << "Result: " << result << LL_ENDL;
+        onUpdateReceived(result, type, body);
+    }
 
     if (callback && !callback.empty())
     {
@@ -1081,13 +1165,25 @@ void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t ht
 AISUpdate::AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD& request_body)
 : mType(type)
 {
-    mFetch = (type == AISAPI::FETCHITEM)
-        || (type == AISAPI::FETCHCATEGORYCHILDREN)
-        || (type == AISAPI::FETCHCATEGORYCATEGORIES)
-        || (type == AISAPI::FETCHCATEGORYSUBSET)
-        || (type == AISAPI::FETCHCOF)
-        || (type == AISAPI::FETCHCATEGORYLINKS)
-        || (type == AISAPI::FETCHORPHANS);
+    init(request_body);
+	parseUpdate(update);
+}
+
+AISUpdate::AISUpdate(AISAPI::COMMAND_TYPE type, const LLSD& request_body)
+: mType(type)
+{
+    init(request_body);
+}
+
+void AISUpdate::init(const LLSD& request_body)
+{
+    mFetch = (mType == AISAPI::FETCHITEM)
+        || (mType == AISAPI::FETCHCATEGORYCHILDREN)
+        || (mType == AISAPI::FETCHCATEGORYCATEGORIES)
+        || (mType == AISAPI::FETCHCATEGORYSUBSET)
+        || (mType == AISAPI::FETCHCOF)
+        || (mType == AISAPI::FETCHCATEGORYLINKS)
+        || (mType == AISAPI::FETCHORPHANS);
     // parse update llsd into stuff to do or parse received items.
     mFetchDepth = MAX_FOLDER_DEPTH_REQUEST;
     if (mFetch && request_body.has("depth"))
@@ -1097,7 +1193,6 @@ AISUpdate::AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD&
 
     mTimer.setTimerExpirySec(AIS_EXPIRY_SECONDS);
     mTimer.start();
-	parseUpdate(update);
 }
 
 void AISUpdate::clearParseResults()
@@ -1132,6 +1227,405 @@ void AISUpdate::parseUpdate(const LLSD& update)
 	parseContent(update);
 }
 
+// Walks the events of a fetch response. Objects are parsed as soon as their
+// map closes, with parseItem(), parseLink() and parseCategoryFields(), so
+// only the fields of the objects still open are held at any time.
+// Embedded content is therefore parsed before the object holding it. When a
+// category turns out to be stale, what was parsed from its content is taken
+// back, as parseCategory() would never have looked at it.
+class AISUpdate::StreamParser : public LLSDReader::Handler
+{
+public:
+    StreamParser(AISUpdate& update, LLSD& top_level)
+    :   mUpdate(update),
+        mTopLevel(top_level),
+        mExpect(EXPECT_OBJECT),
+        mExpectKind(OBJECT_TOP),
+        mExpectDepth(update.mFetchDepth),
+        mBuilding(false),
+        mKeep(false),
+        mComplete(false)
+    {
+    }
+
+    bool isComplete() const { return mComplete; }
+
+    bool startMap() override
+    {
+        if (mBuilding)
+        {
+            return mBuilder.startMap();
+        }
+        switch (mExpect)
+        {
+        case EXPECT_OBJECT:
+            mFrames.push_back(Frame(FRAME_OBJECT, mExpectKind, mExpectDepth));
+            mFrames.back().mJournalStart = mJournal.size();
+            return true;
+        case EXPECT_EMBEDDED:
+            mUpdate.checkTimeout();
+            mFrames.push_back(Frame(FRAME_EMBEDDED, mExpectKind, mExpectDepth));
+            return true;
+        case EXPECT_OBJECT_MAP:
+            mFrames.push_back(Frame(FRAME_OBJECT_MAP, mExpectKind, mExpectDepth));
+            return true;
+        default:
+            return build(true) && mBuilder.startMap();
+        }
+    }
+
+    EAction key(const std::string& key) override
+    {
+        if (mBuilding)
+        {
+            return mBuilder.key(key);
+        }
+        if (mFrames.empty())
+        {
+            return STOP;
+        }
+        Frame& frame = mFrames.back();
+        mKey = key;
+        switch (frame.mType)
+        {
+        case FRAME_OBJECT:
+            if (key == "_embedded")
+            {
+                return expectEmbedded(frame);
+            }
+            mExpect = EXPECT_FIELD;
+            return READ_VALUE;
+        case FRAME_EMBEDDED:
+            return expectContent(frame, key);
+        case FRAME_OBJECT_MAP:
+        default:
+            ++frame.mSize;
+            mExpect = EXPECT_OBJECT;
+            mExpectKind = frame.mObject;
+            mExpectDepth = frame.mDepth;
+            return READ_VALUE;
+        }
+    }
+
+    bool endMap() override
+    {
+        if (mBuilding)
+        {
+            return mBuilder.endMap() && built();
+        }
+        if (mFrames.empty())
+        {
+            return false;
+        }
+        Frame frame = mFrames.back();
+        mFrames.pop_back();
+        switch (frame.mType)
+        {
+        case FRAME_OBJECT:
+            dispatch(frame);
+            break;
+        case FRAME_EMBEDDED:
+            if (!mFrames.empty())
+            {
+                mFrames.back().mCounts = frame.mCounts;
+                mFrames.back().mEmbedded = true;
+            }
+            break;
+        case FRAME_OBJECT_MAP:
+        default:
+            if (!mFrames.empty())
+            {
+                EmbeddedCounts& counts = mFrames.back().mCounts;
+                switch (frame.mObject)
+                {
+                case CATEGORY:
+                    counts.mCategories = frame.mSize;
+                    break;
+                case LINK:
+                    counts.mLinks = frame.mSize;
+                    break;
+                default:
+                    counts.mItems = frame.mSize;
+                    break;
+                }
+            }
+            break;
+        }
+        mComplete = mFrames.empty();
+        return true;
+    }
+
+    bool startArray() override
+    {
+        if (mBuilding)
+        {
+            return mBuilder.startArray();
+        }
+        // Only fields are expected to hold arrays, drop anything else
+        return build(mExpect == EXPECT_FIELD) && mBuilder.startArray();
+    }
+
+    bool endArray() override
+    {
+        return mBuilding && mBuilder.endArray() && built();
+    }
+
+    bool value(const LLSD& value) override
+    {
+        if (mBuilding)
+        {
+            return mBuilder.value(value) && built();
+        }
+        if (mFrames.empty())
+        {
+            // Top level is not a map
+            return false;
+        }
+        if (mExpect == EXPECT_FIELD)
+        {
+            mFrames.back().mFields[mKey] = value;
+        }
+        return true;
+    }
+
+private:
+    enum EFrameType
+    {
+        FRAME_OBJECT,       // An item, link or category map
+        FRAME_EMBEDDED,     // The "_embedded" map of an object
+        FRAME_OBJECT_MAP    // "categories", "links" or "items" of "_embedded"
+    };
+
+    enum EObjectKind
+    {
+        OBJECT_TOP,
+        CATEGORY,
+        LINK,
+        ITEM,
+        EMBEDDED_CATEGORY,  // "category" of a link
+        EMBEDDED_ITEM       // "item" of a link
+    };
+
+    enum EExpect
+    {
+        EXPECT_FIELD,
+        EXPECT_OBJECT,
+        EXPECT_EMBEDDED,
+        EXPECT_OBJECT_MAP
+    };
+
+    struct Frame
+    {
+        Frame(EFrameType type, EObjectKind object, S32 depth)
+        :   mType(type), mObject(object), mDepth(depth), mFields(LLSD::emptyMap()),
+            mEmbedded(false), mSize(0), mJournalStart(0)
+        {
+        }
+
+        EFrameType mType;
+        EObjectKind mObject;
+        S32 mDepth;
+        LLSD mFields;
+        EmbeddedCounts mCounts;
+        bool mEmbedded;
+        S32 mSize;
+        size_t mJournalStart;
+    };
+
+    // Ids parsed so far, to take the content of a stale category back.
+    typedef std::pair<bool, LLUUID> journal_entry_t; // is category, id
+
+    EAction expectEmbedded(const Frame& frame)
+    {
+        S32 depth = frame.mDepth;
+        switch (frame.mObject)
+        {
+        case ITEM:
+        case EMBEDDED_ITEM:
+            // parseItem() never looks at it
+            return SKIP_VALUE;
+        case CATEGORY:
+        case EMBEDDED_CATEGORY:
+            if (frame.mFields.has("category_id") && frame.mFields.has("version")
+                && is_stale_category(gInventory.getCategory(frame.mFields["category_id"].asUUID()),
+                                     frame.mFields["version"].asInteger()))
+            {
+                return SKIP_VALUE;
+            }
+            depth--;
+            break;
+        case OBJECT_TOP:
+            // The top level of a fetch response is the category fetched,
+            // but for orphans. The subset's category is only a container.
+            if (mUpdate.mType != AISAPI::FETCHORPHANS)
+            {
+                depth--;
+            }
+            break;
+        case LINK:
+        default:
+            break;
+        }
+        mExpect = EXPECT_EMBEDDED;
+        mExpectDepth = depth;
+        return READ_VALUE;
+    }
+
+    EAction expectContent(const Frame& frame, const std::string& key)
+    {
+        mExpectDepth = frame.mDepth;
+        if (key == "categories" || key == "links" || key == "items")
+        {
+            mExpect = EXPECT_OBJECT_MAP;
+            mExpectKind = (key == "categories") ? CATEGORY : ((key == "links") ? LINK : ITEM);
+            return READ_VALUE;
+        }
+        if (key == "category" || key == "item")
+        {
+            mExpect = EXPECT_OBJECT;
+            mExpectKind = (key == "category") ? EMBEDDED_CATEGORY : EMBEDDED_ITEM;
+            return READ_VALUE;
+        }
+        return SKIP_VALUE;
+    }
+
+    bool build(bool keep)
+    {
+        if (mFrames.empty())
+        {
+            // Top level is not a map
+            return false;
+        }
+        mBuilder.reset();
+        mBuilding = true;
+        mKeep = keep;
+        return true;
+    }
+
+    bool built()
+    {
+        if (mBuilder.isComplete())
+        {
+            mBuilding = false;
+            if (mKeep)
+            {
+                mFrames.back().mFields[mKey] = mBuilder.getLLSD();
+            }
+        }
+        return true;
+    }
+
+    void dispatch(const Frame& frame)
+    {
+        const LLSD& fields = frame.mFields;
+        const EmbeddedCounts* counts = frame.mEmbedded ? &frame.mCounts : NULL;
+        switch (frame.mObject)
+        {
+        case OBJECT_TOP:
+            mTopLevel = fields;
+            mUpdate.parseMeta(fields);
+            // Same as parseContent()
+            if (fields.has("linked_id") && fields.has("parent_id"))
+            {
+                parseLink(fields, frame.mDepth);
+            }
+            else if (fields.has("item_id") && fields.has("parent_id"))
+            {
+                parseItem(fields);
+            }
+            if (mUpdate.mType != AISAPI::FETCHCATEGORYSUBSET
+                && fields.has("category_id") && fields.has("parent_id"))
+            {
+                parseCategory(frame, counts);
+            }
+            break;
+        case LINK:
+            parseLink(fields, frame.mDepth);
+            break;
+        case ITEM:
+            parseItem(fields);
+            break;
+        case EMBEDDED_ITEM:
+            if (fields.has("item_id"))
+            {
+                parseItem(fields);
+            }
+            break;
+        case EMBEDDED_CATEGORY:
+            if (!fields.has("category_id"))
+            {
+                break;
+            }
+            // fall through
+        case CATEGORY:
+        default:
+            parseCategory(frame, counts);
+            break;
+        }
+    }
+
+    void parseItem(const LLSD& fields)
+    {
+        mUpdate.parseItem(fields);
+        mJournal.push_back(journal_entry_t(false, fields["item_id"].asUUID()));
+    }
+
+    void parseLink(const LLSD& fields, S32 depth)
+    {
+        mUpdate.parseLink(fields, depth);
+        mJournal.push_back(journal_entry_t(false, fields["item_id"].asUUID()));
+    }
+
+    void parseCategory(const Frame& frame, const EmbeddedCounts* counts)
+    {
+        if (mUpdate.parseCategoryFields(frame.mFields, frame.mDepth, counts))
+        {
+            mJournal.push_back(journal_entry_t(true, frame.mFields["category_id"].asUUID()));
+            return;
+        }
+
+        // Stale, drop its content
+        for (size_t i = frame.mJournalStart; i < mJournal.size(); ++i)
+        {
+            const LLUUID& id = mJournal[i].second;
+            if (mJournal[i].first)
+            {
+                mUpdate.mCategoriesCreated.erase(id);
+                mUpdate.mCatDescendentsKnown.erase(id);
+            }
+            else
+            {
+                mUpdate.mItemsCreated.erase(id);
+                mUpdate.mItemsLost.erase(id);
+            }
+        }
+        mJournal.resize(frame.mJournalStart);
+    }
+
+    AISUpdate& mUpdate;
+    LLSD& mTopLevel;
+    std::vector<Frame> mFrames;
+    std::vector<journal_entry_t> mJournal;
+    EExpect mExpect;
+    EObjectKind mExpectKind;
+    S32 mExpectDepth;
+    std::string mKey;
+    LLSDReader::Builder mBuilder;
+    bool mBuilding;
+    bool mKeep;
+    bool mComplete;
+};
+
+bool AISUpdate::parseStream(const LLSDSpanList& spans, LLSD& top_level)
+{
+    // Only fetches are streamed, the other commands filter their content
+    // with the ids of the meta values
+    llassert(mFetch);
+    clearParseResults();
+    StreamParser parser(*this, top_level);
+    return LLSDReader::parseXML(spans, parser) && parser.isComplete();
+}
+
 void AISUpdate::parseMeta(const LLSD& update)
 {
 	// parse _categories_removed -> mObjectsDeletedIds
@@ -1359,6 +1853,23 @@ void AISUpdate::parseLink(const LLSD& link_map, S32 depth)
 
 
 void AISUpdate::parseCategory(const LLSD& category_map, S32 depth)
+{
+    if (!category_map.has("_embedded"))
+    {
+        parseCategoryFields(category_map, depth, NULL);
+        return;
+    }
+
+    const LLSD& embedded = category_map["_embedded"];
+    EmbeddedCounts counts(embedded);
+    if (parseCategoryFields(category_map, depth, &counts))
+    {
+        // Check for more embedded content.
+        parseEmbedded(embedded, depth - 1);
+    }
+}
+
+bool AISUpdate::parseCategoryFields(const LLSD& category_map, S32 depth, const EmbeddedCounts* counts)
 {
     LLUUID category_id = category_map["category_id"].asUUID();
     S32 version = LLViewerInventoryCategory::VERSION_UNKNOWN;
@@ -1370,11 +1881,7 @@ void AISUpdate::parseCategory(const LLSD& category_map, S32 depth)
 
     LLViewerInventoryCategory *curr_cat = gInventory.getCategory(category_id);
 
-    if (curr_cat
-        && curr_cat->getVersion() > LLViewerInventoryCategory::VERSION_UNKNOWN
-        && curr_cat->getDescendentCount() != LLViewerInventoryCategory::DESCENDENT_COUNT_UNKNOWN
-        && version > LLViewerInventoryCategory::VERSION_UNKNOWN
-        && version < curr_cat->getVersion())
+    if (is_stale_category(curr_cat, version))
     {
         LL_WARNS() << "Got stale folder, known: " << curr_cat->getVersion()
             << ", received: " << version << LL_ENDL;
@@ -1387,7 +1894,7 @@ void AISUpdate::parseCategory(const LLSD& category_map, S32 depth)
             curr_cat->fetch();
         }
         // </FS:Beq>
-        return;
+        return false;
     }
 
 	LLPointer<LLViewerInventoryCategory> new_cat;
@@ -1414,9 +1921,9 @@ void AISUpdate::parseCategory(const LLSD& category_map, S32 depth)
 	{
         // Check descendent count first, as it may be needed
         // to populate newly created categories
-        if (category_map.has("_embedded"))
+        if (counts)
         {
-            parseDescendentCount(category_id, new_cat->getPreferredType(), category_map["_embedded"]);
+            parseDescendentCount(category_id, new_cat->getPreferredType(), *counts);
         }
 
         if (mFetch)
@@ -1500,29 +2007,29 @@ void AISUpdate::parseCategory(const LLSD& category_map, S32 depth)
 		// *TODO: Wow, harsh.  Should we just complain and get out?
 		LL_ERRS() << "unpack failed" << LL_ENDL;
 	}
+	return rv;
+}
 
-	// Check for more embedded content.
-	if (category_map.has("_embedded"))
-	{
-		parseEmbedded(category_map["_embedded"], depth - 1);
-	}
+AISUpdate::EmbeddedCounts::EmbeddedCounts(const LLSD& embedded)
+:   mCategories(embedded.has("categories") ? embedded["categories"].size() : -1),
+    mLinks(embedded.has("links") ? embedded["links"].size() : -1),
+    mItems(embedded.has("items") ? embedded["items"].size() : -1)
+{
 }
 
-void AISUpdate::parseDescendentCount(const LLUUID& category_id, LLFolderType::EType type, const LLSD& embedded)
+void AISUpdate::parseDescendentCount(const LLUUID& category_id, LLFolderType::EType type, const EmbeddedCounts& counts)
 {
     // We can only determine true descendent count if this contains all descendent types.
-    if (embedded.has("categories") &&
-        embedded.has("links") &&
-        embedded.has("items"))
+    if (counts.mCategories >= 0 &&
+        counts.mLinks >= 0 &&
+        counts.mItems >= 0)
     {
-        mCatDescendentsKnown[category_id] = embedded["categories"].size();
-        mCatDescendentsKnown[category_id] += embedded["links"].size();
-        mCatDescendentsKnown[category_id] += embedded["items"].size();
+        mCatDescendentsKnown[category_id] = counts.mCategories + counts.mLinks + counts.mItems;
     }
-    else if (mFetch && embedded.has("links") && (type == LLFolderType::FT_CURRENT_OUTFIT || type == LLFolderType::FT_OUTFIT))
+    else if (mFetch && counts.mLinks >= 0 && (type == LLFolderType::FT_CURRENT_OUTFIT || type == LLFolderType::FT_OUTFIT))
     {
         // COF and outfits contain links only
-        mCatDescendentsKnown[category_id] = embedded["links"].size();
+        mCatDescendentsKnown[category_id] = counts.mLinks;
     }
 }
 
@@ -34,6 +34,7 @@
 #include "llviewerinventory.h"
 #include "llcorehttputil.h"
 #include "llcoproceduremanager.h"
+#include "llsdserialize.h"
 
 class AISAPI
 {
@@ -95,6 +96,8 @@ private:
     static void EnqueueAISCommand(const std::string &procName, LLCoprocedureManager::CoProcedure_t proc);
     static void onIdle(void *userdata); // launches postponed AIS commands
     static void onUpdateReceived(const LLSD& update, COMMAND_TYPE type, const LLSD& request_body);
+    static void onStreamReceived(LLSD& result, const LLCore::BufferArray::ptr_t& raw,
+        COMMAND_TYPE type, const LLSD& request_body);
 
     static std::string getInvCap();
     static std::string getLibCap();
@@ -111,7 +114,11 @@ class AISUpdate
 {
 public:
 	AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD& request_body);
+	AISUpdate(AISAPI::COMMAND_TYPE type, const LLSD& request_body);
 	void parseUpdate(const LLSD& update);
+	// Reads a fetch response as it is parsed, without building the whole
+	// LLSD. top_level receives the top level values but for "_embedded".
+	bool parseStream(const LLSDSpanList& spans, LLSD& top_level);
 	void parseMeta(const LLSD& update);
 	void parseContent(const LLSD& update);
 // [SL:KB] - Patch: Appearance-SyncAttach | Checked: Catznip-3.7
@@ -121,7 +128,18 @@ public:
 	void parseLink(const LLSD& link_map, S32 depth);
 	void parseItem(const LLSD& link_map);
 	void parseCategory(const LLSD& link_map, S32 depth);
-	void parseDescendentCount(const LLUUID& category_id, LLFolderType::EType type, const LLSD& embedded);
+
+	// Sizes of the maps embedded in a category, -1 when missing.
+	struct EmbeddedCounts
+	{
+		EmbeddedCounts() : mCategories(-1), mLinks(-1), mItems(-1) {}
+		EmbeddedCounts(const LLSD& embedded);
+		S32 mCategories;
+		S32 mLinks;
+		S32 mItems;
+	};
+	void parseDescendentCount(const LLUUID& category_id, LLFolderType::EType type, const EmbeddedCounts& counts);
+
 	void parseEmbedded(const LLSD& embedded, S32 depth);
 	void parseEmbeddedLinks(const LLSD& links, S32 depth);
 	void parseEmbeddedItems(const LLSD& items);
@@ -130,8 +148,14 @@ public:
 	void parseEmbeddedCategory(const LLSD& category, S32 depth);
 	void doUpdate();
 private:
+	class StreamParser;
+
+	void init(const LLSD& request_body);
 	void clearParseResults();
     void checkTimeout();
+	// Everything parseCategory() does but for the embedded content.
+	// Returns false if the category was stale or could not be unpacked.
+	bool parseCategoryFields(const LLSD& category_map, S32 depth, const EmbeddedCounts* counts);
 
     // Fetch can return large packets of data, throttle it to not cause lags
     // Todo: make throttle work over all fetch requests isntead of per-request
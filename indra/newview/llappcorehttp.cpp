@@ -240,6 +240,21 @@ void LLAppCoreHttp::init()
 															trace_level, NULL);
 	}
 	
+	// HTTP/2 multiplexing over one connection per host for all
+	// policy classes (see PO_HTTP2).  Takes effect on restart.
+	static const std::string http2_mode("FSHttp2Mode");
+	if (gSavedSettings.controlExists(http2_mode))
+	{
+		status = LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_HTTP2,
+															LLCore::HttpRequest::GLOBAL_POLICY_ID,
+															long(gSavedSettings.getU32(http2_mode)), NULL);
+		if (! status)
+		{
+			LL_WARNS("Init") << "Failed to set HTTP/2 mode.  Reason:  " << status.toString()
+							 << LL_ENDL;
+		}
+	}
+	
 	// Setup default policy and constrain if directed to
 	mHttpClasses[AP_DEFAULT].mPolicy = LLCore::HttpRequest::DEFAULT_POLICY_ID;
 
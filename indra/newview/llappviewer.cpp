@@ -2557,6 +2557,7 @@ bool LLAppViewer::initThreads()
 	static const bool enable_threads = true;
 
 	LLImage::initClass(gSavedSettings.getBOOL("TextureNewByteRange"),gSavedSettings.getS32("TextureReverseByteRange"));
+	LLImageJ2C::setRetainedDecoderBudget((S64)gSavedSettings.getU32("FSJ2CRetainedDecoderBudgetMB") * 1024 * 1024);
 
 	LLLFSThread::initClass(enable_threads && true); // TODO: fix crashes associated with this shutdo
 
@@ -4943,7 +4944,7 @@ U32 LLAppViewer::getObjectCacheVersion()
 {
 	// Viewer object cache version, change if object update
 	// format changes. JC
-	const U32 INDRA_OBJECT_CACHE_VERSION = 17;
+	const U32 INDRA_OBJECT_CACHE_VERSION = 18;
 
 	return INDRA_OBJECT_CACHE_VERSION;
 }
@@ -5056,7 +5057,7 @@ bool LLAppViewer::initCache()
     const std::string cache_dir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, cache_dir_name);
 	// <FS:Beq> Improve cache purge triggering
     // LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info);
-    LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info, gSavedSettings.getF32("FSDiskCacheHighWaterPercent"), gSavedSettings.getF32("FSDiskCacheLowWaterPercent"));
+    LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info, gSavedSettings.getF32("FSDiskCacheHighWaterPercent"), gSavedSettings.getF32("FSDiskCacheLowWaterPercent"), gSavedSettings.getBOOL("FSDiskCacheUsePackFile"));
 	// </FS:Beq>
 
 	if (!read_only)
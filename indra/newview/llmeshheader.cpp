@@ -0,0 +1,67 @@
+/**
+ * @file llmeshheader.cpp
+ * @brief Mesh asset header, the offsets and sizes of the blocks of a mesh.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llmeshheader.h"
+
+#include "llvolumemgr.h"
+
+// With FSMeshSimplifyLODs, a LOD that is missing or holds more than this
+// share of the bytes of the LOD above it is replaced by a simplified copy
+// of that LOD
+const F32 SUBSTITUTE_LOD_SIZE_RATIO = 0.75f;
+
+S32 LLMeshHeader::getSubstituteSourceLOD(S32 lod) const
+{
+	if (lod < 0 || lod >= LLVolumeLODGroup::NUM_LODS - 1 || m404 || mVersion > MAX_MESH_VERSION)
+	{
+		return -1;
+	}
+
+	// Walk up past missing LODs and LODs that are barely smaller than the
+	// one above them, so a mesh uploaded with every LOD set to the high one
+	// is simplified from the high LOD and not from a copy of it
+	S32 source = -1;
+	S32 size = mLodSize[lod];
+	for (S32 i = lod + 1; i < LLVolumeLODGroup::NUM_LODS; ++i)
+	{
+		S32 source_size = mLodSize[i];
+		if (source_size <= 0)
+		{
+			continue;
+		}
+		if (size > 0 && size < source_size * SUBSTITUTE_LOD_SIZE_RATIO)
+		{
+			break;
+		}
+		source = i;
+		size = source_size;
+	}
+
+	return source;
+}
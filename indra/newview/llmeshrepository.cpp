@@ -44,11 +44,13 @@
 #include "llimagej2c.h"
 #include "llhost.h"
 #include "llmath.h"
+#include "llmeshoptimizer.h"
 #include "llnotificationsutil.h"
 #include "llsd.h"
 #include "llsdutil_math.h"
 #include "llsdserialize.h"
 #include "llthread.h"
+#include "threadpool.h"
 #include "llfilesystem.h"
 #include "llviewercontrol.h"
 #include "llviewerinventory.h"
@@ -117,6 +119,8 @@
 //   main     Main rendering thread, very sensitive to locking and other stalls
 //   repo     Overseeing worker thread associated with the LLMeshRepoThread class
 //   decom    Worker thread for mesh decomposition requests
+//   decodeN  0-N "MeshDecode" pool threads decoding LODs and skin info
+//            for the repo thread (width from FSMeshDecodeThreads, none by default)
 //   core     HTTP worker thread:  does the work but doesn't intrude here
 //   uploadN  0-N temporary mesh upload threads (0-1 in practice)
 //
@@ -156,12 +160,13 @@
 //                             ...
 //                             onCompleted() invoked for GET
 //                               data copied
-//                               lodReceived() invoked
+//                               lodReceived() invoked, on a decodeN
+//                               thread when there is a pool
 //                                 unpack data into LLVolume
-//                                 append LoadedMesh to mLoadedQ
+//                                 enqueue DecodedMesh on mDecodedQ
 //                             ...
 //         notifyLoadedMeshes() invoked again
-//           scan mLoadedQ
+//           drain mDecodedQ
 //           notifyMeshLoaded() for LOD
 //             setMeshAssetLoaded() invoked for system volume
 //             notifyMeshLoaded() invoked for each interested object
@@ -232,6 +237,10 @@
 //     sCacheBytesWritten              "
 //     sCacheReads                     "
 //     sCacheWrites                    "
+//     sDecodedCacheReads              "
+//     sDecodedCacheWrites             "
+//     sSimplifiedLODs                 "
+//     sSimplifiedTris                 "
 //     mLoadingMeshes                  mMeshMutex [4]  rw.main.none, rw.any.mMeshMutex
 //     mSkinMap                        none            rw.main.none
 //     mDecompositionMap               none            rw.main.none
@@ -255,14 +264,13 @@
 //     sMaxConcurrentRequests   mMutex        wo.main.none, ro.repo.none, ro.main.mMutex
 //     mMeshHeader              mHeaderMutex  rw.repo.mHeaderMutex, ro.main.mHeaderMutex, ro.main.none [0]
 //     mSkinRequests            mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mDecompositionRequests   mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mPhysicsShapeRequests    mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mDecompositionQ          mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mHeaderReqQ              mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mLODReqQ                 mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex
-//     mLoadedQ                 mMutex        rw.repo.mMutex, ro.main.none [5], rw.main.mMutex
+//     mDecodedQ                none          wo.repo.none, wo.decodeN.none, rw.main.none (lock-free queue)
+//     mCacheWriteQ             mMutex        wo.decodeN.mMutex, rw.repo.mMutex, ro.repo.none [5]
 //     mPendingLOD              mMutex        rw.repo.mMutex, rw.any.mMutex
 //     mGetMeshCapability       mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMesh2Capability      mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
@@ -377,13 +385,12 @@ const F32 DOWNLOAD_RETRY_DELAY = 0.5f; // seconds
 // upload retries to the user as in the past.  SH-4667.
 const long UPLOAD_RETRY_LIMIT = 0L;
 
-// Maximum mesh version to support.  Three least significant digits are reserved for the minor version, 
-// with major version changes indicating a format change that is not backwards compatible and should not
-// be parsed by viewers that don't specifically support that version. For example, if the integer "1" is 
-// present, the version is 0.001. A viewer that can parse version 0.001 can also parse versions up to 0.999, 
-// but not 1.0 (integer 1000).
-// See wiki at https://wiki.secondlife.com/wiki/Mesh/Mesh_Asset_Format
-const S32 MAX_MESH_VERSION = 999;
+// With FSMeshSimplifyLODs, each substitute LOD (see
+// LLMeshHeader::getSubstituteSourceLOD()) keeps a third of the triangles of
+// the LOD above it, the uploader's default when it generates LODs, and like
+// the uploader's triangle limit mode the triangle count is the only limit.
+const F32 SUBSTITUTE_LOD_DECIMATION = 3.f;
+const F32 SUBSTITUTE_LOD_ERROR = 1.f;
 
 //<FS:TS> FIRE-11451: Cap concurrent mesh requests at a sane value 
 const U32 MESH_CONCURRENT_REQUEST_LIMIT = 64;  // upper limit 
@@ -406,7 +413,17 @@ U32 LLMeshRepository::sCacheBytesSkins = 0;
 U32 LLMeshRepository::sCacheBytesDecomps = 0;
 U32 LLMeshRepository::sCacheReads = 0;
 U32 LLMeshRepository::sCacheWrites = 0;
+U32 LLMeshRepository::sDecodedCacheReads = 0;
+U32 LLMeshRepository::sDecodedCacheWrites = 0;
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
+
+LLTrace::SampleStatHandle<F32Seconds> LLMeshRepository::sDecodeQueueLatency("mesh_decode_queue_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLMeshRepository::sLODDecodeLatency("mesh_lod_decode_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLMeshRepository::sSkinDecodeLatency("mesh_skin_decode_latency");
+LLTrace::SampleStatHandle<F32Seconds> LLMeshRepository::sDecodeHandoffLatency("mesh_decode_handoff_latency");
+LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> > LLMeshRepository::sSimplifiedTrianglesStat("mesh_simplified_triangles");
+U32 LLMeshRepository::sSimplifiedLODs = 0;
+U32 LLMeshRepository::sSimplifiedTris = 0;
 	
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);	// true -> gather cpu metrics
 
@@ -568,6 +585,9 @@ U32	LLMeshRepoThread::sMaxConcurrentRequests = 1;
 S32 LLMeshRepoThread::sRequestLowWater = REQUEST2_LOW_WATER_MIN;
 S32 LLMeshRepoThread::sRequestHighWater = REQUEST2_HIGH_WATER_MIN;
 S32 LLMeshRepoThread::sRequestWaterLevel = 0;
+U32 LLMeshRepoThread::sDecodeThreads = 0;
+bool LLMeshRepoThread::sDecodedCache = false;
+bool LLMeshRepoThread::sSimplifyLODs = false;
 
 // Base handler class for all mesh users of llcorehttp.
 // This is roughly equivalent to a Responder class in
@@ -656,9 +676,10 @@ class LLMeshLODHandler : public LLMeshHandlerBase
 {
 public:
 	LOG_CLASS(LLMeshLODHandler);
-	LLMeshLODHandler(const LLVolumeParams & mesh_params, S32 lod, U32 offset, U32 requested_bytes)
+	LLMeshLODHandler(const LLVolumeParams & mesh_params, S32 lod, U32 offset, U32 requested_bytes, S32 source_lod = -1)
 		: LLMeshHandlerBase(offset, requested_bytes),
-		  mLOD(lod)
+		  mLOD(lod),
+		  mSourceLOD(source_lod)
 	{
 			mMeshParams = mesh_params;
 			LLMeshRepoThread::incActiveLODRequests();
@@ -675,6 +696,7 @@ public:
 
 public:
 	S32 mLOD;
+	S32 mSourceLOD;		// LOD the fetched bytes belong to when building a substitute for mLOD
 };
 
 
@@ -876,6 +898,12 @@ LLMeshRepoThread::LLMeshRepoThread()
 	mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH2);
 	mHttpLegacyPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH1); // <FS:Ansariel> [UDP Assets]
 	mHttpLargePolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_LARGE_MESH);
+
+	if (sDecodeThreads > 0)
+	{
+		mDecodePool.reset(new LL::ThreadPool("MeshDecode", sDecodeThreads));
+		mDecodePool->start();
+	}
 }
 
 
@@ -886,20 +914,26 @@ LLMeshRepoThread::~LLMeshRepoThread()
 					   << ", Max Lock Holdoffs:  " << LLMeshRepository::sMaxLockHoldoffs
 					   << LL_ENDL;
 
+	// Closing the pool finishes whatever it is decoding before we tear down
+	if (mDecodePool)
+	{
+		mDecodePool->close();
+		mDecodePool.reset();
+	}
+
 	mHttpRequestSet.clear();
     mHttpHeaders.reset();
 
-	while (!mSkinInfoQ.empty())
-    {
-        delete mSkinInfoQ.front();
-        mSkinInfoQ.pop_front();
-    }
-
-    while (!mDecompositionQ.empty())
-    {
-        delete mDecompositionQ.front();
-        mDecompositionQ.pop_front();
-    }
+	DecodedMesh decoded;
+	while (mDecodedQ.try_dequeue(decoded))
+	{
+		if (decoded.mVolume)
+		{
+			decoded.mVolume->unref();
+		}
+		delete decoded.mSkinInfo;
+		delete decoded.mDecomposition;
+	}
 
     delete mHttpRequest;
 	mHttpRequest = NULL;
@@ -947,6 +981,11 @@ void LLMeshRepoThread::run()
 			mHttpRequest->update(0L);
 		}
 		sRequestWaterLevel = mHttpRequestSet.size();			// Stats data update
+
+		if (!mCacheWriteQ.empty())
+		{
+			writeQueuedCache();
+		}
 			
 		// NOTE: order of queue processing intentionally favors LOD requests over header requests
 		// Todo: we are processing mLODReqQ, mHeaderReqQ, mSkinRequests, mDecompositionRequests and mPhysicsShapeRequests
@@ -973,7 +1012,7 @@ void LLMeshRepoThread::run()
                     // failed to load before, wait a bit
                     incomplete.push_front(req);
                 }
-                else if (!fetchMeshLOD(req.mMeshParams, req.mLOD, req.canRetry()))
+                else if (!fetchMeshLOD(req.mMeshParams, req.mLOD, req.canRetry(), req.mSkipCache))
                 {
                     if (req.canRetry())
                     {
@@ -1073,7 +1112,7 @@ void LLMeshRepoThread::run()
 					{
 						incomplete.emplace_back(req);
 					}
-					else if (!fetchMeshSkinInfo(req.mId, req.canRetry()))
+					else if (!fetchMeshSkinInfo(req.mId, req.canRetry(), req.mSkipCache))
 					{
 						if (req.canRetry())
 						{
@@ -1390,7 +1429,96 @@ LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url, int l
 }
 
 
-bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
+// Returns a view of [offset, offset + size) of a cached mesh asset, or null
+// if the range could not be read or was reserved but never written.
+static LLFileSystemView::ptr_t get_cached_mesh_range(LLFileSystem& file, S32 offset, S32 size)
+{
+	LLFileSystemView::ptr_t view = file.getView(offset, size);
+	if (!view)
+	{
+		return view;
+	}
+
+	LLMeshRepository::sCacheBytesRead += size;
+	++LLMeshRepository::sCacheReads;
+
+	// make sure buffer isn't all 0's by checking the first 1KB (reserved block but not written)
+	const U8* data = view->getData();
+	const S32 check = llmin(size, 1024);
+	for (S32 i = 0; i < check; ++i)
+	{
+		if (data[i] != 0)
+		{
+			return view;
+		}
+	}
+	return LLFileSystemView::ptr_t();
+}
+
+// Key of a LOD in the decoded mesh cache, which shares the asset cache and
+// its eviction with the mesh assets. Mirrored and inverted meshes decode
+// differently, and a new layout version starts over with new keys.
+// Substitute LODs are kept apart from the LODs as uploaded.
+static LLUUID get_decoded_mesh_id(const LLVolumeParams& mesh_params, S32 lod, bool substitute = false)
+{
+	static const LLUUID DECODED_MESH_SALT("3c0e5d2a-91b4-4f6e-8a27-d6f1b40c9e53");
+
+	LLUUID salt = DECODED_MESH_SALT;
+	salt.mData[0] ^= (U8)lod;
+	salt.mData[1] ^= mesh_params.getSculptType() & LL_SCULPT_FLAG_MASK;
+	salt.mData[2] ^= (U8)LLVolume::DECODED_FACES_VERSION;
+	if (substitute)
+	{
+		salt.mData[3] ^= 0xff;
+	}
+	return mesh_params.getSculptID().combine(salt);
+}
+
+// Simplifies each face of volume down to 1/decimator of its triangles.
+// Only the indices change, so skin weights and tangents stay valid.
+// Returns the number of triangles removed.
+static U32 simplify_volume_faces(LLVolume* volume, F32 decimator)
+{
+	U32 removed = 0;
+	for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+	{
+		LLVolumeFace& face = volume->getVolumeFace(i);
+		S32 num_indices = face.mNumIndices;
+		S32 target_indices = llclamp(llfloor(num_indices / decimator), 3, num_indices); // leave at least one triangle
+		if (target_indices >= num_indices)
+		{
+			continue;
+		}
+
+		U16* simplified = (U16*)ll_aligned_malloc_16((num_indices * sizeof(U16) + 0xF) & ~0xF);
+		S32 new_indices = (S32)LLMeshOptimizer::simplify(simplified,
+			face.mIndices,
+			num_indices,
+			face.mPositions,
+			face.mNumVertices,
+			sizeof(LLVector4a),
+			target_indices,
+			SUBSTITUTE_LOD_ERROR,
+			false,
+			NULL);
+
+		// a face simplified away keeps its triangles rather than vanish
+		if (new_indices >= 3 && new_indices < num_indices)
+		{
+			face.resizeIndices(new_indices);
+			if (face.mIndices)
+			{
+				LLMeshOptimizer::optimizeVertexCacheU16(face.mIndices, simplified, new_indices, face.mNumVertices);
+				removed += (num_indices - new_indices) / 3;
+			}
+		}
+		ll_aligned_free_16(simplified);
+	}
+
+	return removed;
+}
+
+bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry, bool skip_cache)
 {
 	
 	if (!mHeaderMutex)
@@ -1425,36 +1553,30 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
 		{
 			//check cache for mesh skin info
 			LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
-			if (file.getSize() >= offset+size)
+			if (!skip_cache && file.getSize() >= offset+size)
 			{
-				U8* buffer = new(std::nothrow) U8[size];
-				if (!buffer)
+				LLFileSystemView::ptr_t view = get_cached_mesh_range(file, offset, size);
+				if (view && mDecodePool)
 				{
-					LL_WARNS(LOG_MESH) << "Failed to allocate memory for skin info, size: " << size << LL_ENDL;
-					return false;
+					// The view keeps the cached bytes alive until the pool gets to them
+					F64 posted_time = LLTimer::getTotalSeconds();
+					postDecode([this, mesh_id, view, size, posted_time]()
+					{
+						if (!skinInfoReceived(mesh_id, view->getData(), size, posted_time))
+						{
+							// cached copy is bad, ask the sim for it instead
+							UUIDBasedRequest req(mesh_id);
+							req.mSkipCache = true;
+							LLMutexLock lock(mMutex);
+							mSkinRequests.push_back(req);
+						}
+					});
+					return true;
 				}
-				LLMeshRepository::sCacheBytesRead += size;
-				++LLMeshRepository::sCacheReads;
-				file.seek(offset);
-				file.read(buffer, size);
-
-				//make sure buffer isn't all 0's by checking the first 1KB (reserved block but not written)
-				bool zero = true;
-				for (S32 i = 0; i < llmin(size, 1024) && zero; ++i)
+				if (view && skinInfoReceived(mesh_id, view->getData(), size))
 				{
-					zero = buffer[i] > 0 ? false : true;
-				}
-
-				if (!zero)
-				{ //attempt to parse
-					if (skinInfoReceived(mesh_id, buffer, size))
-					{						
-						delete[] buffer;
-						return true;
-					}
+					return true;
 				}
-
-				delete[] buffer;
 			}
 
 			//reading from cache failed for whatever reason, fetch from sim
@@ -1547,35 +1669,11 @@ bool LLMeshRepoThread::fetchMeshDecomposition(const LLUUID& mesh_id)
 			LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
 			if (file.getSize() >= offset+size)
 			{
-				U8* buffer = new(std::nothrow) U8[size];
-				if (!buffer)
-				{
-					LL_WARNS(LOG_MESH) << "Failed to allocate memory for mesh decomposition, size: " << size << LL_ENDL;
-					return false;
-				}
-				LLMeshRepository::sCacheBytesRead += size;
-				++LLMeshRepository::sCacheReads;
-
-				file.seek(offset);
-				file.read(buffer, size);
-
-				//make sure buffer isn't all 0's by checking the first 1KB (reserved block but not written)
-				bool zero = true;
-				for (S32 i = 0; i < llmin(size, 1024) && zero; ++i)
+				LLFileSystemView::ptr_t view = get_cached_mesh_range(file, offset, size);
+				if (view && decompositionReceived(mesh_id, view->getData(), size))
 				{
-					zero = buffer[i] > 0 ? false : true;
-				}
-
-				if (!zero)
-				{ //attempt to parse
-					if (decompositionReceived(mesh_id, buffer, size))
-					{
-						delete[] buffer;
-						return true;
-					}
+					return true;
 				}
-
-				delete[] buffer;
 			}
 
 			//reading from cache failed for whatever reason, fetch from sim
@@ -1653,34 +1751,11 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
 			LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
 			if (file.getSize() >= offset+size)
 			{
-				LLMeshRepository::sCacheBytesRead += size;
-				++LLMeshRepository::sCacheReads;
-				file.seek(offset);
-				U8* buffer = new(std::nothrow) U8[size];
-				if (!buffer)
+				LLFileSystemView::ptr_t view = get_cached_mesh_range(file, offset, size);
+				if (view && physicsShapeReceived(mesh_id, view->getData(), size) == MESH_OK)
 				{
-					LL_WARNS(LOG_MESH) << "Failed to allocate memory for physics shape, size: " << size << LL_ENDL;
-					return false;
-				}
-				file.read(buffer, size);
-
-				//make sure buffer isn't all 0's by checking the first 1KB (reserved block but not written)
-				bool zero = true;
-				for (S32 i = 0; i < llmin(size, 1024) && zero; ++i)
-				{
-					zero = buffer[i] > 0 ? false : true;
-				}
-
-				if (!zero)
-				{ //attempt to parse
-					if (physicsShapeReceived(mesh_id, buffer, size) == MESH_OK)
-					{
-						delete[] buffer;
-						return true;
-					}
+					return true;
 				}
-
-				delete[] buffer;
 			}
 
 			//reading from cache failed for whatever reason, fetch from sim
@@ -1769,12 +1844,11 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
 		if (size > 0)
 		{
 			// *NOTE:  if the header size is ever more than 4KB, this will break
-			U8 buffer[MESH_HEADER_SIZE];
 			S32 bytes = llmin(size, MESH_HEADER_SIZE);
+			LLFileSystemView::ptr_t view = file.getView(0, bytes);
 			LLMeshRepository::sCacheBytesRead += bytes;	
 			++LLMeshRepository::sCacheReads;
-			file.read(buffer, bytes);
-			if (headerReceived(mesh_params, buffer, bytes) == MESH_OK)
+			if (view && headerReceived(mesh_params, view->getData(), bytes) == MESH_OK)
 			{
 				std::string mid;
 				mesh_params.getSculptID().toString(mid);
@@ -1830,7 +1904,7 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
 }
 
 //return false if failed to get mesh lod.
-bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry)
+bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry, bool skip_cache)
 {
 	if (!mHeaderMutex)
 	{
@@ -1854,52 +1928,57 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 	{
 		const auto& header = header_it->second.second;
         S32 version = header.mVersion;
-        S32 offset = header_size + header.mLodOffset[lod];
-        S32 size = header.mLodSize[lod];
+		// a substitute LOD is built from the bytes of its source LOD
+		S32 source_lod = sSimplifyLODs ? header.getSubstituteSourceLOD(lod) : -1;
+		S32 fetch_lod = source_lod >= 0 ? source_lod : lod;
+        S32 offset = header_size + header.mLodOffset[fetch_lod];
+        S32 size = header.mLodSize[fetch_lod];
 		mHeaderMutex->unlock();
 				
 		if (version <= MAX_MESH_VERSION && offset >= 0 && size > 0)
 		{
+			if (source_lod >= 0)
+			{
+				if (!skip_cache && fetchDecodedLOD(mesh_params, lod, true))
+				{
+					return true;
+				}
+			}
+			else if (sDecodedCache && !skip_cache && fetchDecodedLOD(mesh_params, lod))
+			{
+				return true;
+			}
 
 			//check cache for mesh asset
 			LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
-			if (file.getSize() >= offset+size)
+			if (!skip_cache && file.getSize() >= offset+size)
 			{
-				U8* buffer = new(std::nothrow) U8[size];
-				if (!buffer)
+				LLFileSystemView::ptr_t view = get_cached_mesh_range(file, offset, size);
+				if (view && mDecodePool)
 				{
-					LL_WARNS(LOG_MESH) << "Can't allocate memory for mesh " << mesh_id << " LOD " << lod << ", size: " << size << LL_ENDL;
-					// todo: for now it will result in indefinite constant retries, should result in timeout
-					// or in retry-count and disabling mesh. (but usually viewer is beyond saving at this point)
-					return false;
+					// The view keeps the cached bytes alive until the pool gets to them
+					F64 posted_time = LLTimer::getTotalSeconds();
+					postDecode([this, mesh_params, lod, view, size, posted_time, source_lod]()
+					{
+						if (lodReceived(mesh_params, lod, view->getData(), size, posted_time, source_lod) != MESH_OK)
+						{
+							// cached copy is bad, ask the sim for it instead
+							LODRequest req(mesh_params, lod);
+							req.mSkipCache = true;
+							LLMutexLock lock(mMutex);
+							mLODReqQ.push(req);
+							++LLMeshRepository::sLODProcessing;
+						}
+					});
+					return true;
 				}
-				LLMeshRepository::sCacheBytesRead += size;
-				++LLMeshRepository::sCacheReads;
-				file.seek(offset);
-				file.read(buffer, size);
-
-				//make sure buffer isn't all 0's by checking the first 1KB (reserved block but not written)
-				bool zero = true;
-				for (S32 i = 0; i < llmin(size, 1024) && zero; ++i)
+				if (view && lodReceived(mesh_params, lod, view->getData(), size, 0.0, source_lod) == MESH_OK)
 				{
-					zero = buffer[i] > 0 ? false : true;
+					std::string mid;
+					mesh_id.toString(mid);
+					LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mid << " - was retrieved from the cache." << LL_ENDL;
+					return true;
 				}
-
-				if (!zero)
-				{ //attempt to parse
-					if (lodReceived(mesh_params, lod, buffer, size) == MESH_OK)
-					{
-						delete[] buffer;
-
-						std::string mid;
-						mesh_id.toString(mid);
-						LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mid << " - was retrieved from the cache." << LL_ENDL;
-
-						return true;
-					}
-				}
-
-				delete[] buffer;
 			}
 
 			//reading from cache failed for whatever reason, fetch from sim
@@ -1916,7 +1995,7 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 				mesh_id.toString(mid);
 				LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mid << " - was retrieved from the simulator." << LL_ENDL;
 
-                LLMeshHandlerBase::ptr_t handler(new LLMeshLODHandler(mesh_params, lod, offset, size));
+                LLMeshHandlerBase::ptr_t handler(new LLMeshLODHandler(mesh_params, lod, offset, size, source_lod));
 				// <FS:Ansariel> [UDP Assets]
 				//LLCore::HttpHandle handle = getByteRange(http_url, offset, size, handler);
 				LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, offset, size, handler);
@@ -1961,7 +2040,7 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 	return retval;
 }
 
-EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size)
+EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, const U8* data, S32 data_size)
 {
 	const LLUUID mesh_id = mesh_params.getSculptID();
 	LLSD header_data;
@@ -2038,29 +2117,34 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 	return MESH_OK;
 }
 
-EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size)
+EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, const U8* data, S32 data_size, F64 posted_time, S32 source_lod)
 {
 	if (data == NULL || data_size == 0)
 	{
 		return MESH_NO_DATA;
 	}
 
+	F64 start_time = LLTimer::getTotalSeconds();
 	LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
 	if (volume->unpackVolumeFaces(data, data_size))
 	{
 		if (volume->getNumFaces() > 0)
 		{
-			LoadedMesh mesh(volume, mesh_params, lod);
+			bool substitute = source_lod >= 0 && source_lod != lod;
+			U32 simplified_tris = 0;
+			if (substitute)
 			{
-				LLMutexLock lock(mMutex);
-				mLoadedQ.push_back(mesh);
-				// LLPointer is not thread safe, since we added this pointer into
-				// threaded list, make sure counter gets decreased inside mutex lock
-				// and won't affect mLoadedQ processing
-				volume = NULL;
-				// might be good idea to turn mesh into pointer to avoid making a copy
-				mesh.mVolume = NULL;
+				simplified_tris = simplify_volume_faces(volume, powf(SUBSTITUTE_LOD_DECIMATION, (F32)(source_lod - lod)));
 			}
+
+			// substitutes are always kept, building them again costs more than a decode
+			if (sDecodedCache || substitute)
+			{
+				std::shared_ptr<std::vector<U8> > decoded(new std::vector<U8>());
+				volume->packDecodedFaces(*decoded);
+				queueCacheWrite(get_decoded_mesh_id(mesh_params, lod, substitute), -1, decoded);
+			}
+			queueLoadedLOD(volume, mesh_params, start_time, posted_time, simplified_tris);
 			return MESH_OK;
 		}
 	}
@@ -2068,8 +2152,72 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
 	return MESH_UNKNOWN;
 }
 
-bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
+EMeshProcessingResult LLMeshRepoThread::decodedLODReceived(const LLVolumeParams& mesh_params, S32 lod, const U8* data, S32 data_size, F64 posted_time)
 {
+	F64 start_time = LLTimer::getTotalSeconds();
+	LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
+	if (volume->unpackDecodedFaces(data, data_size) && volume->getNumFaces() > 0)
+	{
+		queueLoadedLOD(volume, mesh_params, start_time, posted_time);
+		return MESH_OK;
+	}
+
+	return MESH_UNKNOWN;
+}
+
+bool LLMeshRepoThread::fetchDecodedLOD(const LLVolumeParams& mesh_params, S32 lod, bool substitute)
+{
+	LLFileSystem file(get_decoded_mesh_id(mesh_params, lod, substitute), LLAssetType::AT_MESH);
+	S32 size = file.getSize();
+	LLFileSystemView::ptr_t view = size > 0 ? file.getView(0, size) : LLFileSystemView::ptr_t();
+	if (!view)
+	{
+		return false;
+	}
+	++LLMeshRepository::sDecodedCacheReads;
+
+	if (mDecodePool)
+	{
+		F64 posted_time = LLTimer::getTotalSeconds();
+		postDecode([this, mesh_params, lod, view, size, posted_time]()
+		{
+			if (decodedLODReceived(mesh_params, lod, view->getData(), size, posted_time) != MESH_OK)
+			{
+				// stale or damaged entry, fetching from the sim writes a new one
+				LODRequest req(mesh_params, lod);
+				req.mSkipCache = true;
+				LLMutexLock lock(mMutex);
+				mLODReqQ.push(req);
+				++LLMeshRepository::sLODProcessing;
+			}
+		});
+		return true;
+	}
+
+	return decodedLODReceived(mesh_params, lod, view->getData(), size) == MESH_OK;
+}
+
+void LLMeshRepoThread::queueLoadedLOD(LLPointer<LLVolume>& volume, const LLVolumeParams& mesh_params, F64 start_time, F64 posted_time, U32 simplified_tris)
+{
+	DecodedMesh mesh;
+	mesh.mType = DecodedMesh::LOD;
+	mesh.mMeshParams = mesh_params;
+	// LLPointer is not thread safe, so the queue carries a raw pointer
+	// with a reference of its own and this thread lets go of the rest
+	// before the main thread can see it
+	mesh.mVolume = volume.get();
+	mesh.mVolume->ref();
+	volume = NULL;
+	mesh.mDoneTime = LLTimer::getTotalSeconds();
+	mesh.mDecodeTime = (F32)(mesh.mDoneTime - start_time);
+	mesh.mQueueTime = posted_time > 0.0 ? (F32)(start_time - posted_time) : 0.f;
+	mesh.mSimplifiedTris = simplified_tris;
+	mDecodedQ.enqueue(mesh);
+}
+
+bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, const U8* data, S32 data_size, F64 posted_time)
+{
+	F64 start_time = LLTimer::getTotalSeconds();
 	LLSD skin;
 
 	if (data_size > 0)
@@ -2105,16 +2253,19 @@ bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 dat
 		}
 
         // LL_DEBUGS(LOG_MESH) << "info pelvis offset" << info.mPelvisOffset << LL_ENDL;
-		{
-			LLMutexLock lock(mMutex);
-			mSkinInfoQ.push_back(info);
-		}
+		DecodedMesh decoded;
+		decoded.mType = DecodedMesh::SKIN_INFO;
+		decoded.mSkinInfo = info;
+		decoded.mDoneTime = LLTimer::getTotalSeconds();
+		decoded.mDecodeTime = (F32)(decoded.mDoneTime - start_time);
+		decoded.mQueueTime = posted_time > 0.0 ? (F32)(start_time - posted_time) : 0.f;
+		mDecodedQ.enqueue(decoded);
 	}
 
 	return true;
 }
 
-bool LLMeshRepoThread::decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
+bool LLMeshRepoThread::decompositionReceived(const LLUUID& mesh_id, const U8* data, S32 data_size)
 {
 	LLSD decomp;
 
@@ -2141,16 +2292,17 @@ bool LLMeshRepoThread::decompositionReceived(const LLUUID& mesh_id, U8* data, S3
 	{
 		LLModel::Decomposition* d = new LLModel::Decomposition(decomp);
 		d->mMeshID = mesh_id;
-		{
-			LLMutexLock lock(mMutex);
-			mDecompositionQ.push_back(d);
-		}
+		DecodedMesh decoded;
+		decoded.mType = DecodedMesh::DECOMPOSITION;
+		decoded.mDecomposition = d;
+		decoded.mDoneTime = LLTimer::getTotalSeconds();
+		mDecodedQ.enqueue(decoded);
 	}
 
 	return true;
 }
 
-EMeshProcessingResult LLMeshRepoThread::physicsShapeReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
+EMeshProcessingResult LLMeshRepoThread::physicsShapeReceived(const LLUUID& mesh_id, const U8* data, S32 data_size)
 {
 	LLSD physics_shape;
 
@@ -2190,11 +2342,79 @@ EMeshProcessingResult LLMeshRepoThread::physicsShapeReceived(const LLUUID& mesh_
 		}
 	}
 
+	DecodedMesh decoded;
+	decoded.mType = DecodedMesh::DECOMPOSITION;
+	decoded.mDecomposition = d;
+	decoded.mDoneTime = LLTimer::getTotalSeconds();
+	mDecodedQ.enqueue(decoded);
+	return MESH_OK;
+}
+
+void LLMeshRepoThread::postDecode(const std::function<void()>& work)
+{
+	if (!mDecodePool || !mDecodePool->getQueue().post(work))
+	{
+		work();
+	}
+}
+
+// Thread:  decodeN
+void LLMeshRepoThread::queueCacheWrite(const LLUUID& mesh_id, S32 offset, const std::shared_ptr<std::vector<U8> >& data)
+{
+	CacheWrite write;
+	write.mId = mesh_id;
+	write.mOffset = offset;
+	write.mData = data;
+
+	LLMutexLock lock(mMutex);
+	mCacheWriteQ.push_back(write);
+}
+
+// Thread:  repo
+void LLMeshRepoThread::writeQueuedCache()
+{
+	std::deque<CacheWrite> writes;
 	{
 		LLMutexLock lock(mMutex);
-		mDecompositionQ.push_back(d);
+		writes.swap(mCacheWriteQ);
+	}
+
+	for (const CacheWrite& write : writes)
+	{
+		S32 size = (S32)write.mData->size();
+		if (write.mOffset < 0)
+		{
+			// Decoded entries may be mapped by fetchDecodedLOD() right now, so
+			// never truncate one in place: write a new file and rename it over
+			// the old one. A live mapping keeps the replaced file around on
+			// POSIX, on Windows the rename fails and the old entry stays.
+			LLUUID temp_id;
+			temp_id.generate();
+			LLFileSystem file(temp_id, LLAssetType::AT_MESH, LLFileSystem::WRITE);
+			if (file.write(write.mData->data(), size))
+			{
+				LLFileSystem::renameFile(temp_id, LLAssetType::AT_MESH, write.mId, LLAssetType::AT_MESH);
+			}
+			if (LLFileSystem::getExists(temp_id, LLAssetType::AT_MESH))
+			{
+				LLFileSystem::removeFile(temp_id, LLAssetType::AT_MESH);
+			}
+			else
+			{
+				++LLMeshRepository::sDecodedCacheWrites;
+			}
+			continue;
+		}
+
+		LLFileSystem file(write.mId, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
+		if (file.getSize() >= write.mOffset + size)
+		{
+			file.seek(write.mOffset);
+			file.write(write.mData->data(), size);
+			LLMeshRepository::sCacheBytesWritten += size;
+			++LLMeshRepository::sCacheWrites;
+		}
 	}
-	return MESH_OK;
 }
 
 LLMeshUploadThread::LLMeshUploadThread(LLMeshUploadThread::instance_list& data, LLVector3& scale, bool upload_textures,
@@ -2979,30 +3199,58 @@ void LLMeshRepoThread::notifyLoadedMeshes()
 		return;
 	}
 
-	if (!mLoadedQ.empty())
+	// Take what has been decoded so far, anything finishing meanwhile waits
+	// for the next frame
+	size_t decoded_count = mDecodedQ.size_approx();
+	if (decoded_count > 0)
 	{
-		std::deque<LoadedMesh> loaded_queue;
-
-		mMutex->lock();
-		if (!mLoadedQ.empty())
+		F64 now = LLTimer::getTotalSeconds();
+		DecodedMesh decoded;
+		while (decoded_count-- > 0 && mDecodedQ.try_dequeue(decoded))
 		{
-			loaded_queue.swap(mLoadedQ);
-			mMutex->unlock();
+			sample(LLMeshRepository::sDecodeHandoffLatency, F32Seconds((F32)(now - decoded.mDoneTime)));
 
-			update_metrics = true;
-
-			// Process the elements free of the lock
-			for (const auto& mesh : loaded_queue)
+			switch (decoded.mType)
+			{
+			case DecodedMesh::LOD:
 			{
-				if (mesh.mVolume->getNumVolumeFaces() > 0)
+				// take over the reference the decoder left in the queue
+				LLPointer<LLVolume> volume = decoded.mVolume;
+				decoded.mVolume->unref();
+				decoded.mVolume = nullptr;
+
+				sample(LLMeshRepository::sDecodeQueueLatency, F32Seconds(decoded.mQueueTime));
+				sample(LLMeshRepository::sLODDecodeLatency, F32Seconds(decoded.mDecodeTime));
+				update_metrics = true;
+
+				if (decoded.mSimplifiedTris > 0)
 				{
-					gMeshRepo.notifyMeshLoaded(mesh.mMeshParams, mesh.mVolume);
+					++LLMeshRepository::sSimplifiedLODs;
+					LLMeshRepository::sSimplifiedTris += decoded.mSimplifiedTris;
+					add(LLMeshRepository::sSimplifiedTrianglesStat, LLUnits::Triangles::fromValue(decoded.mSimplifiedTris));
+				}
+
+				if (volume->getNumVolumeFaces() > 0)
+				{
+					gMeshRepo.notifyMeshLoaded(decoded.mMeshParams, volume);
 				}
 				else
 				{
-					gMeshRepo.notifyMeshUnavailable(mesh.mMeshParams,
-						LLVolumeLODGroup::getVolumeDetailFromScale(mesh.mVolume->getDetail()));
+					gMeshRepo.notifyMeshUnavailable(decoded.mMeshParams,
+						LLVolumeLODGroup::getVolumeDetailFromScale(volume->getDetail()));
 				}
+				break;
+			}
+			case DecodedMesh::SKIN_INFO:
+				sample(LLMeshRepository::sDecodeQueueLatency, F32Seconds(decoded.mQueueTime));
+				sample(LLMeshRepository::sSkinDecodeLatency, F32Seconds(decoded.mDecodeTime));
+				gMeshRepo.notifySkinInfoReceived(decoded.mSkinInfo);
+				decoded.mSkinInfo = nullptr;
+				break;
+			case DecodedMesh::DECOMPOSITION:
+				gMeshRepo.notifyDecompositionReceived(decoded.mDecomposition);
+				decoded.mDecomposition = nullptr;
+				break;
 			}
 		}
 	}
@@ -3027,48 +3275,20 @@ void LLMeshRepoThread::notifyLoadedMeshes()
 		}
 	}
 
-	if (!mSkinInfoQ.empty() || !mSkinUnavailableQ.empty() || ! mDecompositionQ.empty())
+	if (!mSkinUnavailableQ.empty())
 	{
 		if (mMutex->trylock())
 		{
-			std::deque<LLMeshSkinInfo*> skin_info_q;
 			std::deque<UUIDBasedRequest> skin_info_unavail_q;
-			std::list<LLModel::Decomposition*> decomp_q;
-
-			if (! mSkinInfoQ.empty())
-			{
-				skin_info_q.swap(mSkinInfoQ);
-			}
-
-			if (! mSkinUnavailableQ.empty())
-			{
-				skin_info_unavail_q.swap(mSkinUnavailableQ);
-			}
-
-			if (! mDecompositionQ.empty())
-			{
-				decomp_q.swap(mDecompositionQ);
-			}
-
+			skin_info_unavail_q.swap(mSkinUnavailableQ);
 			mMutex->unlock();
 
 			// Process the elements free of the lock
-			while (! skin_info_q.empty())
-			{
-				gMeshRepo.notifySkinInfoReceived(skin_info_q.front());
-				skin_info_q.pop_front();
-			}
 			while (! skin_info_unavail_q.empty())
 			{
 				gMeshRepo.notifySkinInfoUnavailable(skin_info_unavail_q.front().mId);
 				skin_info_unavail_q.pop_front();
 			}
-
-			while (! decomp_q.empty())
-			{
-				gMeshRepo.notifyDecompositionReceived(decomp_q.front());
-				decomp_q.pop_front();
-			}
 		}
 	}
 
@@ -3089,6 +3309,11 @@ S32 LLMeshRepoThread::getActualMeshLOD(const LLVolumeParams& mesh_params, S32 lo
 	{
 		auto& header = iter->second.second;
 
+		if (sSimplifyLODs && header.getSubstituteSourceLOD(lod) >= 0)
+		{ //fetchMeshLOD() builds it from a higher LOD
+			return lod;
+		}
+
 		return LLMeshRepository::getActualMeshLOD(header, lod);
 	}
 
@@ -3435,9 +3660,41 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
 								   U8 * data, S32 data_size)
 {
 	if ((!MESH_LOD_PROCESS_FAILED)
+		&& data != NULL && data_size > 0
+		&& gMeshRepo.mThread->mDecodePool)
+	{
+		// Decode on the pool from a copy, the cache write comes back to the repo thread
+		LLMeshRepoThread* thread = gMeshRepo.mThread;
+		std::shared_ptr<std::vector<U8> > buffer(new std::vector<U8>(data, data + llmin(data_size, (S32)mRequestedBytes)));
+		LLVolumeParams mesh_params = mMeshParams;
+		S32 lod = mLOD;
+		S32 source_lod = mSourceLOD;
+		S32 offset = mOffset;
+		F64 posted_time = LLTimer::getTotalSeconds();
+		thread->postDecode([thread, buffer, mesh_params, lod, source_lod, offset, posted_time]()
+		{
+			EMeshProcessingResult result = thread->lodReceived(mesh_params, lod, buffer->data(), (S32)buffer->size(), posted_time, source_lod);
+			if (result == MESH_OK)
+			{
+				thread->queueCacheWrite(mesh_params.getSculptID(), offset, buffer);
+			}
+			else
+			{
+				LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mesh_params.getSculptID()
+								   << ", Reason: " << result
+								   << " LOD: " << lod
+								   << " Data size: " << buffer->size()
+								   << " Not retrying."
+								   << LL_ENDL;
+				LLMutexLock lock(thread->mMutex);
+				thread->mUnavailableQ.push_back(LLMeshRepoThread::LODRequest(mesh_params, lod));
+			}
+		});
+	}
+	else if ((!MESH_LOD_PROCESS_FAILED)
 		&& ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
 	{
-		EMeshProcessingResult result = gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size);
+		EMeshProcessingResult result = gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size, 0.0, mSourceLOD);
 		if (result == MESH_OK)
 		{
 			// good fetch from sim, write to cache
@@ -3502,6 +3759,32 @@ void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /*
 										U8 * data, S32 data_size)
 {
 	if ((!MESH_SKIN_INFO_PROCESS_FAILED)
+		&& data != NULL && data_size > 0
+		&& gMeshRepo.mThread->mDecodePool)
+	{
+		// Decode on the pool from a copy, the cache write comes back to the repo thread
+		LLMeshRepoThread* thread = gMeshRepo.mThread;
+		std::shared_ptr<std::vector<U8> > buffer(new std::vector<U8>(data, data + llmin(data_size, (S32)mRequestedBytes)));
+		LLUUID mesh_id = mMeshID;
+		S32 offset = mOffset;
+		F64 posted_time = LLTimer::getTotalSeconds();
+		thread->postDecode([thread, buffer, mesh_id, offset, posted_time]()
+		{
+			if (thread->skinInfoReceived(mesh_id, buffer->data(), (S32)buffer->size(), posted_time))
+			{
+				thread->queueCacheWrite(mesh_id, offset, buffer);
+			}
+			else
+			{
+				LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mesh_id
+								   << ", Unknown reason.  Not retrying."
+								   << LL_ENDL;
+				LLMutexLock lock(thread->mMutex);
+				thread->mSkinUnavailableQ.emplace_back(mesh_id);
+			}
+		});
+	}
+	else if ((!MESH_SKIN_INFO_PROCESS_FAILED)
 		&& ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
 		&& gMeshRepo.mThread->skinInfoReceived(mMeshID, data, data_size))
 	{
@@ -3661,6 +3944,11 @@ void LLMeshRepository::init()
 
 	metrics_teleport_started_signal = LLViewerMessage::getInstance()->setTeleportStartedCallback(teleport_started);
 	
+	LLVolume::sDirectLODDecode = gSavedSettings.getBOOL("FSMeshDirectLODDecode");
+	LLMeshRepoThread::sDecodeThreads = gSavedSettings.getU32("FSMeshDecodeThreads");
+	LLMeshRepoThread::sDecodedCache = gSavedSettings.getBOOL("FSMeshDecodedCache");
+	LLMeshRepoThread::sSimplifyLODs = gSavedSettings.getBOOL("FSMeshSimplifyLODs");
+
 	mThread = new LLMeshRepoThread();
 	mThread->start();
 }
@@ -40,10 +40,14 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "llthread.h"
+#include "lltrace.h"
+#include "concurrentqueue.h"
+#include "threadpool_fwd.h"
 
 #define LLCONVEXDECOMPINTER_STATIC 1
 
 #include "llconvexdecomposition.h"
+#include "llmeshheader.h"
 #include "lluploadfloaterobservers.h"
 
 class LLVOVolume;
@@ -194,73 +198,6 @@ private:
     LLFrameTimer mTimer;
 };
 
-class LLMeshHeader
-{
-public:
-
-    LLMeshHeader() {}
-
-    explicit LLMeshHeader(const LLSD& header)
-    {
-        fromLLSD(header);
-    }
-
-    void fromLLSD(const LLSD& header)
-    {
-        const char* lod[] =
-        {
-            "lowest_lod",
-            "low_lod",
-            "medium_lod",
-            "high_lod"
-        };
-
-        mVersion = header["version"].asInteger();
-
-        for (U32 i = 0; i < 4; ++i)
-        {
-            mLodOffset[i] = header[lod[i]]["offset"].asInteger();
-            mLodSize[i] = header[lod[i]]["size"].asInteger();
-        }
-
-        mSkinOffset = header["skin"]["offset"].asInteger();
-        mSkinSize = header["skin"]["size"].asInteger();
-
-        mPhysicsConvexOffset = header["physics_convex"]["offset"].asInteger();
-        mPhysicsConvexSize = header["physics_convex"]["size"].asInteger();
-
-        mPhysicsMeshOffset = header["physics_mesh"]["offset"].asInteger();
-        mPhysicsMeshSize = header["physics_mesh"]["size"].asInteger();
-
-        m404 = header.has("404");
-
-		// <FS:Ansariel> DAE export
-		if (header.has("creator") && header["creator"].isUUID())
-		{
-			mCreatorId = header["creator"].asUUID();
-		}
-		// </FS:Ansariel>
-    }
-
-    S32 mVersion = -1;
-    S32 mSkinOffset = -1;
-    S32 mSkinSize = -1;
-
-    S32 mPhysicsConvexOffset = -1;
-    S32 mPhysicsConvexSize = -1;
-
-    S32 mPhysicsMeshOffset = -1;
-    S32 mPhysicsMeshSize = -1;
-
-    S32 mLodOffset[4] = { -1 };
-    S32 mLodSize[4] = { -1 };
-
-    bool m404 = false;
-
-	// <FS:Ansariel> DAE export
-	LLUUID mCreatorId{ LLUUID::null };
-};
-
 class LLMeshRepoThread : public LLThread
 {
 public:
@@ -271,6 +208,9 @@ public:
 	static S32 sRequestLowWater;
 	static S32 sRequestHighWater;
 	static S32 sRequestWaterLevel;			// Stats-use only, may read outside of thread
+	static U32 sDecodeThreads;				// Width of the decode pool, 0 decodes on the repo thread
+	static bool sDecodedCache;				// Keep optimized LOD faces in the asset cache
+	static bool sSimplifyLODs;				// Build missing or oversized LODs from the LOD above
 
 	LLMutex*	mMutex;
 	LLMutex*	mHeaderMutex;
@@ -302,9 +242,10 @@ public:
 		LLVolumeParams  mMeshParams;
 		S32 mLOD;
 		F32 mScore;
+		bool mSkipCache;	// cached copy failed to decode, go to the sim
 
 		LODRequest(const LLVolumeParams&  mesh_params, S32 lod)
-			: RequestStats(), mMeshParams(mesh_params), mLOD(lod), mScore(0.f)
+			: RequestStats(), mMeshParams(mesh_params), mLOD(lod), mScore(0.f), mSkipCache(false)
 		{
 		}
 	};
@@ -321,9 +262,10 @@ public:
 	{
 	public:
 		LLUUID mId;
+		bool mSkipCache;	// cached copy failed to decode, go to the sim
 
 		UUIDBasedRequest(const LLUUID& id)
-			: RequestStats(), mId(id)
+			: RequestStats(), mId(id), mSkipCache(false)
 		{
         }
 
@@ -333,25 +275,35 @@ public:
         }
 	};
 
-	class LoadedMesh
+	// Result of a decode on its way to notifyLoadedMeshes().  Owns what it
+	// points to until the main thread takes it.
+	class DecodedMesh
 	{
 	public:
-		LLPointer<LLVolume> mVolume;
-		LLVolumeParams mMeshParams;
-		S32 mLOD;
-
-		LoadedMesh(LLVolume* volume, const LLVolumeParams&  mesh_params, S32 lod)
-			: mVolume(volume), mMeshParams(mesh_params), mLOD(lod)
-		{
-		}
+		enum EType { LOD, SKIN_INFO, DECOMPOSITION };
+
+		EType mType = LOD;
+		LLVolume* mVolume = nullptr;		// LOD, holds one reference taken by the decoder
+		LLVolumeParams mMeshParams;			// LOD
+		LLMeshSkinInfo* mSkinInfo = nullptr;
+		LLModel::Decomposition* mDecomposition = nullptr;	// decomposition or physics shape
+		F32 mQueueTime = 0.f;				// seconds spent waiting for a decode thread
+		F32 mDecodeTime = 0.f;				// seconds spent decoding
+		F64 mDoneTime = 0.0;				// LLTimer::getTotalSeconds() when the decode finished
+		U32 mSimplifiedTris = 0;			// LOD, triangles removed building a substitute LOD
+	};
 
+	// Cache write for data decoded on the pool, done back on the repo thread
+	class CacheWrite
+	{
+	public:
+		LLUUID mId;
+		S32 mOffset;		// negative replaces the whole file
+		std::shared_ptr<std::vector<U8> > mData;
 	};
 
 	//set of requested skin info
 	std::deque<UUIDBasedRequest> mSkinRequests;
-	
-	// list of completed skin info requests
-	std::deque<LLMeshSkinInfo*> mSkinInfoQ;
 
 	// list of skin info requests that have failed or are unavailaibe
 	std::deque<UUIDBasedRequest> mSkinUnavailableQ;
@@ -362,9 +314,6 @@ public:
 	//set of requested physics shapes
 	std::set<UUIDBasedRequest> mPhysicsShapeRequests;
 
-	// list of completed Decomposition info requests
-	std::list<LLModel::Decomposition*> mDecompositionQ;
-
 	//queue of requested headers
 	std::queue<HeaderRequest> mHeaderReqQ;
 
@@ -374,8 +323,14 @@ public:
 	//queue of unavailable LODs (either asset doesn't exist or asset doesn't have desired LOD)
 	std::deque<LODRequest> mUnavailableQ;
 
-	//queue of successfully loaded meshes
-	std::deque<LoadedMesh> mLoadedQ;
+	//completed LODs, skin info and decompositions, filled by the repo thread and the decode pool
+	moodycamel::ConcurrentQueue<DecodedMesh> mDecodedQ;
+
+	//cache writes waiting for the repo thread
+	std::deque<CacheWrite> mCacheWriteQ;
+
+	//decode pool, null when sDecodeThreads is 0
+	std::unique_ptr<LL::ThreadPool> mDecodePool;
 
 	//map of pending header requests and currently desired LODs
 	typedef boost::unordered_map<LLUUID, std::vector<S32> > pending_lod_map;
@@ -410,12 +365,14 @@ public:
 	void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 
 	bool fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry = true);
-	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true);
-	EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
-	EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
-	bool skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
-	bool decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
-	EMeshProcessingResult physicsShapeReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
+	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true, bool skip_cache = false);
+	EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, const U8* data, S32 data_size);
+	// A source_lod other than lod is simplified down to a substitute for lod
+	EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, const U8* data, S32 data_size, F64 posted_time = 0.0, S32 source_lod = -1);
+	EMeshProcessingResult decodedLODReceived(const LLVolumeParams& mesh_params, S32 lod, const U8* data, S32 data_size, F64 posted_time = 0.0);
+	bool skinInfoReceived(const LLUUID& mesh_id, const U8* data, S32 data_size, F64 posted_time = 0.0);
+	bool decompositionReceived(const LLUUID& mesh_id, const U8* data, S32 data_size);
+	EMeshProcessingResult physicsShapeReceived(const LLUUID& mesh_id, const U8* data, S32 data_size);
 	bool hasPhysicsShapeInHeader(const LLUUID& mesh_id);
     bool hasSkinInfoInHeader(const LLUUID& mesh_id);
     bool hasHeader(const LLUUID& mesh_id);
@@ -429,7 +386,7 @@ public:
 
 	//send request for skin info, returns true if header info exists 
 	//  (should hold onto mesh_id and try again later if header info does not exist)
-	bool fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry = true);
+	bool fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry = true, bool skip_cache = false);
 
 	//send request for decomposition, returns true if header info exists 
 	//  (should hold onto mesh_id and try again later if header info does not exist)
@@ -439,6 +396,19 @@ public:
 	//  (should hold onto mesh_id and try again later if header info does not exist)
 	bool fetchMeshPhysicsShape(const LLUUID& mesh_id);
 
+	// Runs work on the decode pool, or right here when there is no pool
+	// or it has been closed
+	void postDecode(const std::function<void()>& work);
+
+	// Loads a LOD from the decoded mesh cache, returns false on a miss
+	bool fetchDecodedLOD(const LLVolumeParams& mesh_params, S32 lod, bool substitute = false);
+	void queueLoadedLOD(LLPointer<LLVolume>& volume, const LLVolumeParams& mesh_params, F64 start_time, F64 posted_time, U32 simplified_tris = 0);
+
+	// Writes of data decoded on the pool are queued here and done by run(),
+	// a negative offset replaces the whole file
+	void queueCacheWrite(const LLUUID& mesh_id, S32 offset, const std::shared_ptr<std::vector<U8> >& data);
+	void writeQueuedCache();
+
 	static void incActiveLODRequests();
 	static void decActiveLODRequests();
 	static void incActiveHeaderRequests();
@@ -645,7 +615,18 @@ public:
     static U32 sCacheBytesDecomps;
 	static U32 sCacheReads;						
 	static U32 sCacheWrites;
+	static U32 sDecodedCacheReads;				// LODs read from the decoded mesh cache
+	static U32 sDecodedCacheWrites;
+	static U32 sSimplifiedLODs;					// Substitute LODs built by simplifying a higher LOD
+	static U32 sSimplifiedTris;					// Triangles those substitutes left out
 	static U32 sMaxLockHoldoffs;				// Maximum sequential locking failures
+
+	// Decode stages, sampled on the main thread as results are taken
+	static LLTrace::SampleStatHandle<F32Seconds> sDecodeQueueLatency;	// Waiting for a decode thread
+	static LLTrace::SampleStatHandle<F32Seconds> sLODDecodeLatency;
+	static LLTrace::SampleStatHandle<F32Seconds> sSkinDecodeLatency;
+	static LLTrace::SampleStatHandle<F32Seconds> sDecodeHandoffLatency;	// Decoded until notifyLoadedMeshes()
+	static LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> > sSimplifiedTrianglesStat;
 	
 	static LLDeadmanTimer sQuiescentTimer;		// Time-to-complete-mesh-downloads after significant events
 
@@ -892,6 +892,12 @@ bool idle_startup()
 
 			F32 dropPercent = gSavedSettings.getF32("PacketDropPercentage");
 			msg->mPacketRing.setDropPercentage(dropPercent);
+			msg->mPacketRing.setBatchIO(gSavedSettings.getBOOL("FSNetBatchedIO"));
+			msg->mCircuitInfo.setAdaptiveRetransmit(gSavedSettings.getBOOL("FSNetAdaptiveRetransmit"));
+			if (gSavedSettings.getBOOL("FSNetReceiveThread"))
+			{
+				msg->startReceiveThread(gSavedSettings.getString("FSNetReceiveCaptureFile"));
+			}
 
             F32 inBandwidth = gSavedSettings.getF32("InBandwidth"); 
             F32 outBandwidth = gSavedSettings.getF32("OutBandwidth"); 
@@ -38,6 +38,13 @@
 // Included to allow LLTextureCache::purgeTextures() to pause watchdog timeout
 #include "llappviewer.h" 
 #include "llmemory.h"
+#include "threadpool.h"
+
+#ifdef LL_USESYSTEMLIBS
+#include <zlib.h>
+#else
+#include "zlib-ng/zlib.h"
+#endif
 
 // Cache organization:
 // cache/texture.entries
@@ -51,11 +58,14 @@
 const S32 TEXTURE_CACHE_ENTRY_SIZE = FIRST_PACKET_SIZE;//1024;
 const F32 TEXTURE_CACHE_PURGE_AMOUNT = .20f; // % amount to reduce the cache by when it exceeds its limit
 const F32 TEXTURE_CACHE_LRU_SIZE = .10f; // % amount for LRU list (low overhead to regenerate)
-const S32 TEXTURE_FAST_CACHE_ENTRY_OVERHEAD = sizeof(S32) * 4; //w, h, c, level
-const S32 TEXTURE_FAST_CACHE_DATA_SIZE = 16 * 16 * 4;
-const S32 TEXTURE_FAST_CACHE_ENTRY_SIZE = TEXTURE_FAST_CACHE_DATA_SIZE + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD;
+const S32 TEXTURE_FAST_CACHE_ENTRY_OVERHEAD = sizeof(S32) * 4; //version, w/h, c/level/codec, data size
+const S32 TEXTURE_FAST_CACHE_ENTRY_SIZE = 2048;
+const S32 TEXTURE_FAST_CACHE_DATA_SIZE = TEXTURE_FAST_CACHE_ENTRY_SIZE - TEXTURE_FAST_CACHE_ENTRY_OVERHEAD;
+const S32 TEXTURE_FAST_CACHE_MAX_DIMENSION = 64; // largest level of the pyramid that is tried
+const U32 TEXTURE_FAST_CACHE_VERSION = 0x32764346; // "FCv2", older entries start with their width
 const F32 TEXTURE_LAZY_PURGE_TIME_LIMIT = .004f; // 4ms. Would be better to autoadjust, but there is a major cache rework in progress.
 const F32 TEXTURE_PRUNING_MAX_TIME = 15.f;
+const S32 TEXTURE_CACHE_ENTRIES_PER_PAGE = 128; // header entries are written back in blocks of this many
 
 class LLTextureCacheWorker : public LLWorkerClass
 {
@@ -793,22 +803,31 @@ LLTextureCache::LLTextureCache(bool threaded)
 	: LLWorkerThread("TextureCache", threaded),
 	  mWorkersMutex(),
 	  mHeaderMutex(),
+	  mHeaderIOMutex(),
 	  mListMutex(),
 	  mFastCacheMutex(),
 	  mHeaderAPRFile(NULL),
 	  mReadOnly(TRUE), //do not allow to change the texture cache until setReadOnly() is called.
+	  mHeaderWritePending(false),
 	  mTexturesSizeTotal(0),
 	  mDoPurge(FALSE),
+	  mPurgeTargetSize(0),
 	  mFastCachep(NULL),
 	  mFastCachePoolp(NULL),
 	  mFastCachePadBuffer(NULL)
 {
     mHeaderAPRFilePoolp = new LLVolatileAPRPool(); // is_local = true, because this pool is for headers, headers are under own mutex
+
+    // Header entries are written back on their own thread so that texture
+    // workers never wait on header disk I/O while holding mHeaderMutex
+    mHeaderThreadPool.reset(new LL::ThreadPool("TextureCacheHeader", 1));
+    mHeaderThreadPool->start();
 }
 
 LLTextureCache::~LLTextureCache()
 {
 	clearDeleteList() ;
+	mHeaderThreadPool->close();
 	writeUpdatedEntries() ;
 	delete mFastCachep;
 	delete mFastCachePoolp;
@@ -847,7 +866,7 @@ size_t LLTextureCache::update(F32 max_time_ms)
 	if(!res && timer.getElapsedTimeF32() > MAX_TIME_INTERVAL)
 	{
 		timer.reset() ;
-		writeUpdatedEntries() ;
+		scheduleHeaderWrite() ;
 	}
 
 	return res;
@@ -1134,32 +1153,24 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
 			{
 				// Add an entry to the end of the list
 				idx = mHeaderEntriesInfo.mEntries++;
-
-			}
-			else if (!mFreeList.empty())
-			{
-				idx = *(mFreeList.begin());
-				mFreeList.erase(mFreeList.begin());
+				setEntry(idx, Entry());
 			}
 			else
 			{
-				// Look for a still valid entry in the LRU
-				for (std::set<LLUUID>::iterator iter2 = mLRU.begin(); iter2 != mLRU.end();)
+				if (mFreeList.empty() && !mTimeIndex.empty())
 				{
-					std::set<LLUUID>::iterator curiter2 = iter2++;
-					LLUUID oldid = *curiter2;
-					// Erase entry from LRU regardless
-					mLRU.erase(curiter2);
-					// Look up entry and use it if it is valid
-					id_map_t::iterator iter3 = mHeaderIDMap.find(oldid);
-					if (iter3 != mHeaderIDMap.end() && iter3->second >= 0)
-					{
-						idx = iter3->second;
-						removeCachedTexture(oldid) ;//remove the existing cached texture to release the entry index.
-						break;
-					}
+					// Recycle the least recently used entry
+					S32 lru_idx = mTimeIndex.begin()->second;
+					Entry lru_entry = mEntries[lru_idx];
+					std::string tex_filename = getTextureFileName(lru_entry.mID);
+					removeEntry(lru_idx, lru_entry, tex_filename);
+				}
+				if (!mFreeList.empty())
+				{
+					idx = *(mFreeList.begin());
+					mFreeList.erase(mFreeList.begin());
 				}
-				// if (idx < 0) at this point, we will rebuild the LRU 
+				// if (idx < 0) at this point, we will reload the header
 				//  and retry if called from setHeaderCacheEntry(),
 				//  otherwise this shouldn't happen and will trigger an error
 			}
@@ -1173,18 +1184,7 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
 	}
 	else
 	{
-		// Remove this entry from the LRU if it exists
-		mLRU.erase(id);
-		// Read the entry
-		idx_entry_map_t::iterator iter = mUpdatedEntryMap.find(idx) ;
-		if(iter != mUpdatedEntryMap.end())
-		{
-			entry = iter->second ;
-		}
-		else
-		{
-			readEntryFromHeaderImmediately(idx, entry) ;
-		}
+		entry = mEntries[idx];
 		if(entry.mImageSize <= entry.mBodySize)//it happens on 64-bit systems, do not know why
 		{
 			LL_WARNS() << "corrupted entry: " << id << " entry image size: " << entry.mImageSize << " entry body size: " << entry.mBodySize << LL_ENDL ;
@@ -1192,7 +1192,6 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
 			//erase this entry and the cached texture from the cache.
 			std::string tex_filename = getTextureFileName(id);
 			removeEntry(idx, entry, tex_filename) ;
-			mUpdatedEntryMap.erase(idx) ;
 			idx = -1 ;
 		}
 	}
@@ -1200,54 +1199,27 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
 }
 
 //mHeaderMutex is locked before calling this.
-void LLTextureCache::writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header)
-{	
-	LLAPRFile* aprfile ;
-	S32 bytes_written ;
-	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-	if(write_header)
+//update the in-memory copy of an entry and the LRU index, and mark it
+//for the next header write.
+void LLTextureCache::setEntry(S32 idx, const Entry& entry)
+{
+	if (idx >= (S32)mEntries.size())
 	{
-		aprfile = openHeaderEntriesFile(false, 0);		
-		bytes_written = aprfile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-		if(bytes_written != sizeof(EntriesInfo))
-		{
-			clearCorruptedCache() ; //clear the cache.
-			idx = -1 ;//mark the idx invalid.
-			return ;
-		}
-
-		mHeaderAPRFile->seek(APR_SET, offset);
+		mEntries.resize(idx + 1);
 	}
-	else
+
+	Entry& cur_entry = mEntries[idx];
+	if (cur_entry.mImageSize > cur_entry.mBodySize)
 	{
-		aprfile = openHeaderEntriesFile(false, offset);
+		mTimeIndex.erase(std::make_pair(cur_entry.mTime, idx));
 	}
-	bytes_written = aprfile->write((void*)&entry, (S32)sizeof(Entry));
-	if(bytes_written != sizeof(Entry))
+	cur_entry = entry;
+	if (cur_entry.mImageSize > cur_entry.mBodySize)
 	{
-		clearCorruptedCache() ; //clear the cache.
-		idx = -1 ;//mark the idx invalid.
-
-		return ;
+		mTimeIndex.insert(std::make_pair(cur_entry.mTime, idx));
 	}
 
-	closeHeaderEntriesFile();
-	mUpdatedEntryMap.erase(idx) ;
-}
-
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::readEntryFromHeaderImmediately(S32& idx, Entry& entry)
-{
-	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-	LLAPRFile* aprfile = openHeaderEntriesFile(true, offset);
-	S32 bytes_read = aprfile->read((void*)&entry, (S32)sizeof(Entry));
-	closeHeaderEntriesFile();
-
-	if(bytes_read != sizeof(Entry))
-	{
-		clearCorruptedCache() ; //clear the cache.
-		idx = -1 ;//mark the idx invalid.
-	}
+	mDirtyPages.insert(idx / TEXTURE_CACHE_ENTRIES_PER_PAGE);
 }
 
 //mHeaderMutex is locked before calling this.
@@ -1266,7 +1238,7 @@ void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
 		if (!mReadOnly)
 		{
 			entry.mTime = time(NULL);			
-			mUpdatedEntryMap[idx] = entry ;
+			setEntry(idx, entry);
 		}
 	}
 }
@@ -1287,15 +1259,11 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 
 		lockHeaders() ;
 
-		bool update_header = false ;
 		if(entry.mImageSize < 0) //is a brand-new entry
 		{
 			mHeaderIDMap[entry.mID] = idx;
 			mTexturesSizeMap[entry.mID] = new_body_size ;
 			mTexturesSizeTotal += new_body_size ;
-			
-			// Update Header
-			update_header = true ;
 		}				
 		else if (entry.mBodySize != new_body_size)
 		{
@@ -1308,7 +1276,8 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 		entry.mImageSize = new_image_size ; 
 		entry.mBodySize = new_body_size ;
 		
-		writeEntryToHeaderImmediately(idx, entry, update_header) ;
+		setEntry(idx, entry);
+		scheduleHeaderWrite();
 	
 		if (mTexturesSizeTotal > sCacheMaxTexturesSize)
 		{
@@ -1326,7 +1295,10 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 	return false ;
 }
 
-U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
+//mHeaderMutex is locked before calling this.
+//this is the only place the entries are read from the header file, from
+//then on the in-memory copy is kept up to date as entries change.
+U32 LLTextureCache::openAndReadEntries()
 {
 	U32 num_entries = mHeaderEntriesInfo.mEntries;
 
@@ -1334,119 +1306,172 @@ U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
 	mTexturesSizeMap.clear();
 	mFreeList.clear();
 	mTexturesSizeTotal = 0;
+	mEntries.clear();
+	mTimeIndex.clear();
+	mDirtyPages.clear();
 
-	LLAPRFile* aprfile = NULL; 
-	if(mUpdatedEntryMap.empty())
+	if (!num_entries)
 	{
-		aprfile = openHeaderEntriesFile(true, (S32)sizeof(EntriesInfo));
+		return 0;
 	}
-	else //update the header file first.
+
+	mEntries.resize(num_entries);
+	S32 entries_size = (S32)(num_entries * sizeof(Entry));
+	LLAPRFile* aprfile = openHeaderEntriesFile(true, (S32)sizeof(EntriesInfo));
+	S32 bytes_read = aprfile->read((void*)mEntries.data(), entries_size);
+	closeHeaderEntriesFile();
+	if (bytes_read < entries_size)
 	{
-		aprfile = openHeaderEntriesFile(false, 0);
-		updatedHeaderEntriesFile() ;
-		if(!aprfile)
-		{
-			return 0;
-		}
-		aprfile->seek(APR_SET, (S32)sizeof(EntriesInfo));
+		LL_WARNS() << "Corrupted header entries, failed at " << bytes_read / (S32)sizeof(Entry) << " / " << num_entries << LL_ENDL;
+		purgeAllTextures(false);
+		return 0;
 	}
+
 	for (U32 idx=0; idx<num_entries; idx++)
 	{
-		Entry entry;
-		S32 bytes_read = aprfile->read((void*)(&entry), (S32)sizeof(Entry));
-		if (bytes_read < sizeof(Entry))
-		{
-			LL_WARNS() << "Corrupted header entries, failed at " << idx << " / " << num_entries << LL_ENDL;
-			closeHeaderEntriesFile();
-			purgeAllTextures(false);
-			return 0;
-		}
-		entries.push_back(entry);
+		const Entry& entry = mEntries[idx];
 // 		LL_INFOS() << "ENTRY: " << entry.mTime << " TEX: " << entry.mID << " IDX: " << idx << " Size: " << entry.mImageSize << LL_ENDL;
-		if(entry.mImageSize > entry.mBodySize)
+		if(entry.mImageSize > entry.mBodySize && mHeaderIDMap.find(entry.mID) == mHeaderIDMap.end())
 		{
 			mHeaderIDMap[entry.mID] = idx;
 			mTexturesSizeMap[entry.mID] = entry.mBodySize;
 			mTexturesSizeTotal += entry.mBodySize;
+			mTimeIndex.insert(std::make_pair(entry.mTime, (S32)idx));
 		}
 		else
 		{
 			mFreeList.insert(idx);
 		}
 	}
-	closeHeaderEntriesFile();
 	return num_entries;
 }
 
-void LLTextureCache::writeEntriesAndClose(const std::vector<Entry>& entries)
+void LLTextureCache::writeUpdatedEntries()
 {
-	S32 num_entries = entries.size();
-	llassert_always(num_entries == mHeaderEntriesInfo.mEntries);
-	
-	if (!mReadOnly)
+	lockHeaders() ;
+	writeDirtyEntries() ;
+	unlockHeaders() ;
+}
+
+//mHeaderMutex is locked before calling this.
+//synchronous version of writeDirtyEntriesAsync(), for when the file is
+//about to be read or the cache is shutting down.
+void LLTextureCache::writeDirtyEntries()
+{
+	if (mReadOnly || mDirtyPages.empty())
 	{
-		LLAPRFile* aprfile = openHeaderEntriesFile(false, (S32)sizeof(EntriesInfo));
-		for (S32 idx=0; idx<num_entries; idx++)
-		{
-			S32 bytes_written = aprfile->write((void*)(&entries[idx]), (S32)sizeof(Entry));
-			if(bytes_written != sizeof(Entry))
-			{
-				clearCorruptedCache() ; //clear the cache.
-				return ;
-			}
-		}
-		closeHeaderEntriesFile();
+		return;
+	}
+
+	entry_run_list_t runs;
+	collectDirtyEntries(runs);
+
+	bool success;
+	{
+		LLMutexLock io_lock(&mHeaderIOMutex);
+		success = writeEntryRuns(mHeaderEntriesInfo, runs);
+	}
+	if (!success)
+	{
+		clearCorruptedCache() ; //clear the cache.
 	}
 }
 
-void LLTextureCache::writeUpdatedEntries()
+// Can be called from any thread
+void LLTextureCache::scheduleHeaderWrite()
 {
-	lockHeaders() ;
-	if (!mReadOnly && !mUpdatedEntryMap.empty())
+	if (mHeaderWritePending)
 	{
-		openHeaderEntriesFile(false, 0);
-		updatedHeaderEntriesFile() ;
-		closeHeaderEntriesFile();
+		return; // the pending write will pick up the latest changes
+	}
+	mHeaderWritePending = true;
+
+	// After shutdown started the queue is closed, the destructor flushes
+	// whatever is still dirty.
+	if (!mHeaderThreadPool->getQueue().post([this]() { writeDirtyEntriesAsync(); }))
+	{
+		mHeaderWritePending = false;
+	}
+}
+
+// Called from the header thread
+void LLTextureCache::writeDirtyEntriesAsync()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+	EntriesInfo info;
+	entry_run_list_t runs;
+
+	mHeaderMutex.lock();
+	mHeaderWritePending = false;
+	if (mReadOnly || mDirtyPages.empty())
+	{
+		mHeaderMutex.unlock();
+		return;
+	}
+	info = mHeaderEntriesInfo;
+	collectDirtyEntries(runs);
+
+	// Take the I/O lock before letting go of the headers, so that batches
+	// reach the file in the order they were collected in.
+	mHeaderIOMutex.lock();
+	mHeaderMutex.unlock();
+
+	bool success = writeEntryRuns(info, runs);
+	mHeaderIOMutex.unlock();
+
+	if (!success)
+	{
+		LLMutexLock lock(&mHeaderMutex);
+		clearCorruptedCache() ; //clear the cache.
 	}
-	unlockHeaders() ;
 }
 
-//mHeaderMutex is locked and mHeaderAPRFile is created before calling this.
-void LLTextureCache::updatedHeaderEntriesFile()
+//mHeaderMutex is locked before calling this.
+//copies out the blocks of entries changed since the last write, merging
+//adjacent blocks into a single run.
+void LLTextureCache::collectDirtyEntries(entry_run_list_t& runs)
 {
-	if (!mReadOnly && !mUpdatedEntryMap.empty() && mHeaderAPRFile)
+	const S32 num_entries = (S32)mEntries.size();
+	std::set<S32>::iterator iter = mDirtyPages.begin();
+	while (iter != mDirtyPages.end())
 	{
-		//entriesInfo
-		mHeaderAPRFile->seek(APR_SET, 0);
-		S32 bytes_written = mHeaderAPRFile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-		if(bytes_written != sizeof(EntriesInfo))
+		S32 first_page = *iter;
+		S32 last_page = first_page;
+		while (++iter != mDirtyPages.end() && *iter == last_page + 1)
 		{
-			clearCorruptedCache() ; //clear the cache.
-			return ;
+			last_page = *iter;
 		}
-		
-		//write each updated entry
-		S32 entry_size = (S32)sizeof(Entry) ;
-		S32 prev_idx = -1 ;
-		S32 delta_idx ;
-		for (idx_entry_map_t::iterator iter = mUpdatedEntryMap.begin(); iter != mUpdatedEntryMap.end(); ++iter)
-		{
-			delta_idx = iter->first - prev_idx - 1;
-			prev_idx = iter->first ;
-			if(delta_idx)
-			{
-				mHeaderAPRFile->seek(APR_CUR, delta_idx * entry_size);
-			}
-			
-			bytes_written = mHeaderAPRFile->write((void*)(&iter->second), entry_size);
-			if(bytes_written != entry_size)
-			{
-				clearCorruptedCache() ; //clear the cache.
-				return ;
-			}
+
+		S32 first_idx = first_page * TEXTURE_CACHE_ENTRIES_PER_PAGE;
+		S32 end_idx = llmin((last_page + 1) * TEXTURE_CACHE_ENTRIES_PER_PAGE, num_entries);
+		if (first_idx < end_idx)
+		{
+			runs.push_back(std::make_pair(first_idx, std::vector<Entry>(mEntries.begin() + first_idx, mEntries.begin() + end_idx)));
 		}
-		mUpdatedEntryMap.clear() ;
 	}
+	mDirtyPages.clear();
+}
+
+//mHeaderIOMutex is locked before calling this, mHeaderMutex may not be.
+//one write for the entries info and one per run of entries.
+bool LLTextureCache::writeEntryRuns(const EntriesInfo& info, const entry_run_list_t& runs)
+{
+	LLFILE* file = LLFile::fopen(mHeaderEntriesFileName, "r+b");
+	if (!file)
+	{
+		LL_WARNS("TextureCache") << "Failed to open " << mHeaderEntriesFileName << LL_ENDL;
+		return false;
+	}
+
+	bool success = fwrite(&info, sizeof(EntriesInfo), 1, file) == 1;
+	for (entry_run_list_t::const_iterator iter = runs.begin(); success && iter != runs.end(); ++iter)
+	{
+		const std::vector<Entry>& entries = iter->second;
+		success = fseek(file, (long)(sizeof(EntriesInfo) + iter->first * sizeof(Entry)), SEEK_SET) == 0
+			&& fwrite(entries.data(), sizeof(Entry), entries.size(), file) == entries.size();
+	}
+	success = (fclose(file) == 0) && success;
+	return success;
 }
 //----------------------------------------------------------------------------
 
@@ -1454,8 +1479,10 @@ void LLTextureCache::updatedHeaderEntriesFile()
 void LLTextureCache::readHeaderCache()
 {
 	mHeaderMutex.lock();
+	// Keep the header thread away from the file while it is reloaded
+	mHeaderIOMutex.lock();
 
-	mLRU.clear(); // always clear the LRU
+	writeDirtyEntries(); // the file is about to be reloaded
 
 	readEntriesHeader();
 	
@@ -1471,70 +1498,38 @@ void LLTextureCache::readHeaderCache()
 	}
 	else
 	{
-		std::vector<Entry> entries;
-		U32 num_entries = openAndReadEntries(entries);
+		U32 num_entries = openAndReadEntries();
 		if (num_entries)
 		{
-			U32 empty_entries = 0;
-			typedef std::pair<U32, S32> lru_data_t;
-			std::set<lru_data_t> lru;
-			std::set<U32> purge_list;
 			for (U32 i=0; i<num_entries; i++)
 			{
-				Entry& entry = entries[i];
-				if (entry.mImageSize <= 0)
+				Entry entry = mEntries[i];
+				if (entry.mImageSize > 0 && entry.mBodySize > entry.mImageSize)
 				{
-					// This will be in the Free List, don't put it in the LRU
-					++empty_entries;
-				}
-				else
-				{
-					lru.insert(std::make_pair(entry.mTime, i));
-					if (entry.mBodySize > 0)
-					{
-						if (entry.mBodySize > entry.mImageSize)
-						{
-							// Shouldn't happen, failsafe only
-							LL_WARNS() << "Bad entry: " << i << ": " << entry.mID << ": BodySize: " << entry.mBodySize << LL_ENDL;
-							purge_list.insert(i);
-						}
-					}
+					// Shouldn't happen, failsafe only
+					LL_WARNS() << "Bad entry: " << i << ": " << entry.mID << ": BodySize: " << entry.mBodySize << LL_ENDL;
+					// Already in the free list, just get rid of the body
+					LLAPRFile::remove(getTextureFileName(entry.mID), mHeaderAPRFilePoolp);
+					entry.mImageSize = -1;
+					entry.mBodySize = 0;
+					setEntry(i, entry);
 				}
 			}
-			if (num_entries - empty_entries > sCacheMaxEntries)
+
+			U32 valid_entries = (U32)mHeaderIDMap.size();
+			if (valid_entries > sCacheMaxEntries)
 			{
 				// Special case: cache size was reduced, need to remove entries
-				U32 entries_to_purge = (num_entries - empty_entries) - sCacheMaxEntries;
-				LL_INFOS() << "Texture Cache Entries: " << num_entries << " Max: " << sCacheMaxEntries << " Empty: " << empty_entries << " Purging: " << entries_to_purge << LL_ENDL;
-				// We can exit the following loop with the given condition, since if we'd reach the end of the lru set we'd have:
-				// purge_list.size() = lru.size() = num_entries - empty_entries = entries_to_purge + sCacheMaxEntries >= entries_to_purge
-				// So, it's certain that iter will never reach lru.end() first.
-				std::set<lru_data_t>::iterator iter = lru.begin();
-				while (purge_list.size() < entries_to_purge)
-				{
-					purge_list.insert(iter->second);
-					++iter;
-				}
-			}
+				U32 entries_to_purge = valid_entries - sCacheMaxEntries;
+				LL_INFOS() << "Texture Cache Entries: " << num_entries << " Max: " << sCacheMaxEntries << " Empty: " << num_entries - valid_entries << " Purging: " << entries_to_purge << LL_ENDL;
 
-			{
-				S32 lru_entries = (S32)((F32)sCacheMaxEntries * TEXTURE_CACHE_LRU_SIZE);
-				for (std::set<lru_data_t>::iterator iter = lru.begin(); iter != lru.end(); ++iter)
-				{
-					mLRU.insert(entries[iter->second].mID);
-// 					LL_INFOS() << "LRU: " << iter->first << " : " << iter->second << LL_ENDL;
-					if (--lru_entries <= 0)
-						break;
-				}
-			}
-			
-			if (purge_list.size() > 0)
-			{
 				LLTimer timer;
-				for (std::set<U32>::iterator iter = purge_list.begin(); iter != purge_list.end(); ++iter)
+				while (entries_to_purge-- > 0 && !mTimeIndex.empty())
 				{
-					std::string tex_filename = getTextureFileName(entries[*iter].mID);
-					removeEntry((S32)*iter, entries[*iter], tex_filename);
+					S32 idx = mTimeIndex.begin()->second;
+					Entry entry = mEntries[idx];
+					std::string tex_filename = getTextureFileName(entry.mID);
+					removeEntry(idx, entry, tex_filename);
 
 					//make sure that pruning entries doesn't take too much time
 					if (timer.getElapsedTimeF32() > TEXTURE_PRUNING_MAX_TIME)
@@ -1542,14 +1537,12 @@ void LLTextureCache::readHeaderCache()
 						break;
 					}
 				}
-				writeEntriesAndClose(entries);
-			}
-			else
-			{
-				//entries are not changed, nothing here.
 			}
+
+			writeDirtyEntries();
 		}
 	}
+	mHeaderIOMutex.unlock();
 	mHeaderMutex.unlock();
 }
 
@@ -1580,6 +1573,8 @@ void LLTextureCache::clearCorruptedCache()
 
 void LLTextureCache::purgeAllTextures(bool purge_directories)
 {
+	LLMutexLock io_lock(&mHeaderIOMutex);
+
 	if (!mReadOnly)
 	{
 // <FS:ND> Windows can be really slow deleting a huge texture cache.
@@ -1642,7 +1637,10 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 	mTexturesSizeTotal = 0;
 	mFreeList.clear();
 	mTexturesSizeTotal = 0;
-	mUpdatedEntryMap.clear();
+	mEntries.clear();
+	mTimeIndex.clear();
+	mDirtyPages.clear();
+	mPurgeTargetSize = 0;
 
 	// Info with 0 entries
 	setEntriesHeader();
@@ -1651,11 +1649,11 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 	LL_INFOS() << "The entire texture cache is cleared." << LL_ENDL ;
 }
 
-void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
+bool LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 {
 	if (mReadOnly)
 	{
-		return;
+		return false;
 	}
 
 	if (!mThreaded)
@@ -1666,74 +1664,30 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 	// time_limit doesn't account for lock time
 	LLMutexLock lock(&mHeaderMutex);
 
-	if (mPurgeEntryList.empty())
+	if (!mPurgeTargetSize)
 	{
-		// Read the entries list and form list of textures to purge
-		std::vector<Entry> entries;
-		U32 num_entries = openAndReadEntries(entries);
-		if (!num_entries)
-		{
-			return; // nothing to purge
-		}
-
-		// Use mTexturesSizeMap to collect UUIDs of textures with bodies
-		typedef std::set<std::pair<U32, S32> > time_idx_set_t;
-		std::set<std::pair<U32, S32> > time_idx_set;
-		for (size_map_t::iterator iter1 = mTexturesSizeMap.begin();
-			iter1 != mTexturesSizeMap.end(); ++iter1)
-		{
-			if (iter1->second > 0)
-			{
-				id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-				if (iter2 != mHeaderIDMap.end())
-				{
-					S32 idx = iter2->second;
-					time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
-				}
-				else
-				{
-					LL_ERRS("TextureCache") << "mTexturesSizeMap / mHeaderIDMap corrupted." << LL_ENDL;
-				}
-			}
-		}
+		mPurgeTargetSize = (llmax(mTexturesSizeTotal, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
+		LL_DEBUGS("TextureCache") << "Purging down to " << mPurgeTargetSize << " bytes" << LL_ENDL;
+	}
 
-		S64 cache_size = mTexturesSizeTotal;
-		S64 purged_cache_size = (llmax(cache_size, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
-		for (time_idx_set_t::iterator iter = time_idx_set.begin();
-			iter != time_idx_set.end(); ++iter)
-		{
-			S32 idx = iter->second;
-			if (cache_size >= purged_cache_size)
-			{
-				cache_size -= entries[idx].mBodySize;
-				mPurgeEntryList.push_back(std::pair<S32, Entry>(idx, entries[idx]));
-			}
-			else
-			{
-				break;
-			}
-		}
-		LL_DEBUGS("TextureCache") << "Formed Purge list of " << mPurgeEntryList.size() << " entries" << LL_ENDL;
+	// Remove the least recently used entries until back under the target
+	LLTimer timer;
+	while (mTexturesSizeTotal >= mPurgeTargetSize && !mTimeIndex.empty()
+		   && timer.getElapsedTimeF32() < time_limit_sec)
+	{
+		S32 idx = mTimeIndex.begin()->second;
+		Entry entry = mEntries[idx];
+		std::string tex_filename = getTextureFileName(entry.mID);
+		removeEntry(idx, entry, tex_filename);
 	}
-	else
+	scheduleHeaderWrite();
+
+	if (mTexturesSizeTotal < mPurgeTargetSize || mTimeIndex.empty())
 	{
-		// Remove collected entried
-		LLTimer timer;
-		while (!mPurgeEntryList.empty() && timer.getElapsedTimeF32() < time_limit_sec)
-		{
-			S32 idx = mPurgeEntryList.back().first;
-			Entry entry = mPurgeEntryList.back().second;
-			mPurgeEntryList.pop_back();
-			// make sure record is still valid
-			id_map_t::iterator iter_header = mHeaderIDMap.find(entry.mID);
-			if (iter_header != mHeaderIDMap.end() && iter_header->second == idx)
-			{
-				std::string tex_filename = getTextureFileName(entry.mID);
-				removeEntry(idx, entry, tex_filename);
-				writeEntryToHeaderImmediately(idx, entry);
-			}
-		}
+		mPurgeTargetSize = 0;
+		return false;
 	}
+	return true;
 }
 
 void LLTextureCache::purgeTextures(bool validate)
@@ -1753,36 +1707,11 @@ void LLTextureCache::purgeTextures(bool validate)
 
 	LL_INFOS() << "TEXTURE CACHE: Purging." << LL_ENDL;
 
-	// Read the entries list
-	std::vector<Entry> entries;
-	U32 num_entries = openAndReadEntries(entries);
-	if (!num_entries)
+	if (mTimeIndex.empty())
 	{
 		return; // nothing to purge
 	}
 	
-	// Use mTexturesSizeMap to collect UUIDs of textures with bodies
-	typedef std::set<std::pair<U32,S32> > time_idx_set_t;
-	std::set<std::pair<U32,S32> > time_idx_set;
-	for (size_map_t::iterator iter1 = mTexturesSizeMap.begin();
-		 iter1 != mTexturesSizeMap.end(); ++iter1)
-	{
-		if (iter1->second > 0)
-		{
-			id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-			if (iter2 != mHeaderIDMap.end())
-			{
-				S32 idx = iter2->second;
-				time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
-// 				LL_INFOS() << "TIME: " << entries[idx].mTime << " TEX: " << entries[idx].mID << " IDX: " << idx << " Size: " << entries[idx].mImageSize << LL_ENDL;
-			}
-			else
-			{
-				LL_ERRS() << "mTexturesSizeMap / mHeaderIDMap corrupted." << LL_ENDL ;
-			}
-		}
-	}
-	
 	// Validate 1/256th of the files on startup
 	U32 validate_idx = 0;
 	if (validate)
@@ -1793,32 +1722,33 @@ void LLTextureCache::purgeTextures(bool validate)
 		LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Validating: " << validate_idx << LL_ENDL;
 	}
 
-	S64 cache_size = mTexturesSizeTotal;
-	S64 purged_cache_size = (llmax(cache_size, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
+	S64 purged_cache_size = (llmax(mTexturesSizeTotal, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
 	S32 purge_count = 0;
-	for (time_idx_set_t::iterator iter = time_idx_set.begin();
-		 iter != time_idx_set.end(); ++iter)
+	// Oldest first. Advance before removing, removeEntry() erases the current element.
+	for (time_idx_set_t::iterator iter = mTimeIndex.begin();
+		 iter != mTimeIndex.end(); )
 	{
-		S32 idx = iter->second;
+		S32 idx = (iter++)->second;
+		Entry entry = mEntries[idx];
 		bool purge_entry = false;		
 
-		if (cache_size >= purged_cache_size)
+		if (mTexturesSizeTotal >= purged_cache_size)
 		{
 			purge_entry = true;
 		}
 		else if (validate)
 		{
 			// make sure file exists and is the correct size
-			U32 uuididx = entries[idx].mID.mData[0];
+			U32 uuididx = entry.mID.mData[0];
 			if (uuididx == validate_idx)
 			{
-				std::string filename = getTextureFileName(entries[idx].mID);
-				LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entries[idx].mBodySize << LL_ENDL;
+				std::string filename = getTextureFileName(entry.mID);
+				LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entry.mBodySize << LL_ENDL;
 				// mHeaderAPRFilePoolp because this is under header mutex in main thread
 				S32 bodysize = LLAPRFile::size(filename, mHeaderAPRFilePoolp);
-				if (bodysize != entries[idx].mBodySize)
+				if (bodysize != entry.mBodySize)
 				{
-					LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entries[idx].mBodySize << filename << LL_ENDL;
+					LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entry.mBodySize << filename << LL_ENDL;
 					purge_entry = true;
 				}
 			}
@@ -1831,23 +1761,22 @@ void LLTextureCache::purgeTextures(bool validate)
 		if (purge_entry)
 		{
 			purge_count++;
-            std::string filename = getTextureFileName(entries[idx].mID);
+            std::string filename = getTextureFileName(entry.mID);
 	 		LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
-			cache_size -= entries[idx].mBodySize;
-			removeEntry(idx, entries[idx], filename) ;			
+			removeEntry(idx, entry, filename) ;			
 		}
 	}
 
-	LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Writing Entries: " << num_entries << LL_ENDL;
+	LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Writing changed entries of " << mHeaderEntriesInfo.mEntries << LL_ENDL;
 
-	writeEntriesAndClose(entries);
+	writeDirtyEntries();
 	
 	// *FIX:Mani - watchdog back on.
 	LLAppViewer::instance()->resumeMainloopTimeout();
 	
 	LL_INFOS("TextureCache") << "TEXTURE CACHE:"
 			<< " PURGED: " << purge_count
-			<< " ENTRIES: " << num_entries
+			<< " ENTRIES: " << mHeaderEntriesInfo.mEntries
 			<< " CACHE SIZE: " << mTexturesSizeTotal / (1024 * 1024) << " MB"
 			<< LL_ENDL;
 }
@@ -1905,7 +1834,7 @@ S32 LLTextureCache::setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imag
 
 	if(idx < 0) // retry once
 	{
-		readHeaderCache(); // We couldn't write an entry, so refresh the LRU
+		readHeaderCache(); // We couldn't write an entry, so reload the header
 
 		mHeaderMutex.lock();
 		idx = openAndReadEntry(id, entry, true);
@@ -2006,8 +1935,7 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id,
 	{
 		// NOTE: Needs to be done on the control thread
 		//  (i.e. here)
-		purgeTexturesLazy(TEXTURE_LAZY_PURGE_TIME_LIMIT);
-		mDoPurge = !mPurgeEntryList.empty();
+		mDoPurge = purgeTexturesLazy(TEXTURE_LAZY_PURGE_TIME_LIMIT);
 	}
 
 	// <FS:ND> There seems to be an edge case of KDU failing to decode images and then we end with null data here.
@@ -2028,6 +1956,51 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id,
 	return handle;
 }
 
+// Fast cache entries are stored one per header entry index, in fixed
+// TEXTURE_FAST_CACHE_ENTRY_SIZE slots. Pixels are stored planar (all the
+// reds, then all the greens...) so that constant channels, like the alpha
+// of opaque images, deflate to almost nothing.
+struct LLFastCacheEntryHeader
+{
+	U32 mVersion;
+	S16 mWidth;
+	S16 mHeight;
+	S8 mComponents;
+	S8 mDiscardLevel;
+	U8 mCodec;
+	U8 mPad;
+	S32 mDataSize; // bytes stored after the header
+};
+static_assert(sizeof(LLFastCacheEntryHeader) == TEXTURE_FAST_CACHE_ENTRY_OVERHEAD, "fast cache entry header size mismatch");
+
+enum EFastCacheCodec
+{
+	FAST_CACHE_CODEC_RAW = 0,
+	FAST_CACHE_CODEC_ZLIB = 1
+};
+
+static void fast_cache_to_planar(const U8* in, U8* out, S32 pixels, S32 components)
+{
+	for (S32 c = 0; c < components; ++c)
+	{
+		for (S32 i = 0; i < pixels; ++i)
+		{
+			*out++ = in[i * components + c];
+		}
+	}
+}
+
+static void fast_cache_from_planar(const U8* in, U8* out, S32 pixels, S32 components)
+{
+	for (S32 c = 0; c < components; ++c)
+	{
+		for (S32 i = 0; i < pixels; ++i)
+		{
+			out[i * components + c] = *in++;
+		}
+	}
+}
+
 //called in the main thread
 LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& discardlevel)
 {
@@ -2044,8 +2017,8 @@ LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& d
 	}
 	offset *= TEXTURE_FAST_CACHE_ENTRY_SIZE;
 
-	U8* data;
-	S32 head[4];
+	LLFastCacheEntryHeader head;
+	U8 stored[TEXTURE_FAST_CACHE_DATA_SIZE];
 	{
 		LLMutexLock lock(&mFastCacheMutex);
 
@@ -2053,34 +2026,67 @@ LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& d
 
 		mFastCachep->seek(APR_SET, offset);		
 	
-		if(mFastCachep->read(head, TEXTURE_FAST_CACHE_ENTRY_OVERHEAD) != TEXTURE_FAST_CACHE_ENTRY_OVERHEAD)
+		if(mFastCachep->read(&head, TEXTURE_FAST_CACHE_ENTRY_OVERHEAD) != TEXTURE_FAST_CACHE_ENTRY_OVERHEAD)
 		{
 			//cache corrupted or under thread race condition
 			closeFastCache(); 
 			return NULL;
 		}
 		
-		S32 image_size = head[0] * head[1] * head[2];
-        if(image_size <= 0
-           || image_size > TEXTURE_FAST_CACHE_DATA_SIZE
-           || head[3] < 0) //invalid
+		if(head.mVersion != TEXTURE_FAST_CACHE_VERSION
+		   || head.mDataSize <= 0
+		   || head.mDataSize > TEXTURE_FAST_CACHE_DATA_SIZE) //invalid, or written by an older viewer
 		{
 			closeFastCache();
 			return NULL;
 		}
-		discardlevel = head[3];
-		
-		data = (U8*)ll_aligned_malloc_16(image_size);
-		if(mFastCachep->read(data, image_size) != image_size)
+
+		if(mFastCachep->read(stored, head.mDataSize) != head.mDataSize)
 		{
-			ll_aligned_free_16(data);
 			closeFastCache();
 			return NULL;
 		}
 
 		closeFastCache();
 	}
-	LLPointer<LLImageRaw> raw = new LLImageRaw(data, head[0], head[1], head[2], true);
+
+	S32 pixels = head.mWidth * head.mHeight;
+	S32 image_size = pixels * head.mComponents;
+	if(head.mWidth <= 0 || head.mWidth > TEXTURE_FAST_CACHE_MAX_DIMENSION
+	   || head.mHeight <= 0 || head.mHeight > TEXTURE_FAST_CACHE_MAX_DIMENSION
+	   || head.mComponents <= 0 || head.mComponents > 4
+	   || head.mDiscardLevel < 0)
+	{
+		return NULL;
+	}
+
+	U8 planar[TEXTURE_FAST_CACHE_MAX_DIMENSION * TEXTURE_FAST_CACHE_MAX_DIMENSION * 4];
+	if(head.mCodec == FAST_CACHE_CODEC_ZLIB)
+	{
+		uLongf planar_size = image_size;
+		if(uncompress(planar, &planar_size, stored, head.mDataSize) != Z_OK || planar_size != (uLongf)image_size)
+		{
+			return NULL;
+		}
+	}
+	else if(head.mCodec == FAST_CACHE_CODEC_RAW && head.mDataSize == image_size)
+	{
+		memcpy(planar, stored, image_size);
+	}
+	else
+	{
+		return NULL;
+	}
+
+	U8* data = (U8*)ll_aligned_malloc_16(image_size);
+	if(!data)
+	{
+		return NULL;
+	}
+	fast_cache_from_planar(planar, data, pixels, head.mComponents);
+	discardlevel = head.mDiscardLevel;
+
+	LLPointer<LLImageRaw> raw = new LLImageRaw(data, head.mWidth, head.mHeight, head.mComponents, true);
 
 	return raw;
 }
@@ -2101,47 +2107,76 @@ bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImage
 	h = raw->getHeight();
 	c = raw->getComponents();
 
-	S32 i = 0 ;
+	LLFastCacheEntryHeader head;
+	memset(&head, 0, sizeof(head));
+	U8* stored = mFastCachePadBuffer + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD;
 
-	// Search for a discard level that will fit into fast cache
-	while(((w >> i) * (h >> i) * c) > TEXTURE_FAST_CACHE_DATA_SIZE)
+	// Walk down the mip pyramid, starting at the first level that fits
+	// TEXTURE_FAST_CACHE_MAX_DIMENSION, and keep the largest level whose
+	// pixels fit in the entry once compressed.
+	S32 i = 0;
+	while((w >> i) > TEXTURE_FAST_CACHE_MAX_DIMENSION || (h >> i) > TEXTURE_FAST_CACHE_MAX_DIMENSION)
 	{
-		++i ;
+		++i;
 	}
-		
-	if(i)
+
+	bool duplicated = false;
+	while((w >> i) > 0 && (h >> i) > 0 && c > 0 && c <= 4)
 	{
-		w >>= i;
-		h >>= i;
-		if(w * h *c > 0) //valid
+		S32 level_w = w >> i;
+		S32 level_h = h >> i;
+		if(level_w != raw->getWidth() || level_h != raw->getHeight())
 		{
-            // Make a duplicate to keep the original raw image untouched.
-            raw = raw->duplicate();
-
-			if (raw->isBufferInvalid())
+			if(!duplicated)
 			{
-				LL_WARNS() << "Invalid image duplicate buffer" << LL_ENDL;
-				return false;
+				// Make a duplicate to keep the original raw image untouched.
+				raw = raw->duplicate();
+				duplicated = true;
+
+				if (raw->isBufferInvalid())
+				{
+					LL_WARNS() << "Invalid image duplicate buffer" << LL_ENDL;
+					return false;
+				}
 			}
+			raw->scale(level_w, level_h);
+		}
 
-			raw->scale(w, h);
+		S32 pixels = level_w * level_h;
+		S32 image_size = pixels * c;
+		U8 planar[TEXTURE_FAST_CACHE_MAX_DIMENSION * TEXTURE_FAST_CACHE_MAX_DIMENSION * 4];
+		fast_cache_to_planar(raw->getData(), planar, pixels, c);
 
-			discardlevel += i ;
+		uLongf stored_size = TEXTURE_FAST_CACHE_DATA_SIZE;
+		if(compress2(stored, &stored_size, planar, image_size, Z_DEFAULT_COMPRESSION) == Z_OK
+		   && (S32)stored_size < image_size)
+		{
+			head.mCodec = FAST_CACHE_CODEC_ZLIB;
+			head.mDataSize = (S32)stored_size;
+		}
+		else if(image_size <= TEXTURE_FAST_CACHE_DATA_SIZE)
+		{
+			memcpy(stored, planar, image_size);
+			head.mCodec = FAST_CACHE_CODEC_RAW;
+			head.mDataSize = image_size;
+		}
+		else
+		{
+			++i;
+			continue;
 		}
-	}
-	
-	//copy data
-	memcpy(mFastCachePadBuffer, &w, sizeof(S32));
-	memcpy(mFastCachePadBuffer + sizeof(S32), &h, sizeof(S32));
-	memcpy(mFastCachePadBuffer + sizeof(S32) * 2, &c, sizeof(S32));
-	memcpy(mFastCachePadBuffer + sizeof(S32) * 3, &discardlevel, sizeof(S32));
 
-	S32 copy_size = w * h * c;
-	if(copy_size > 0) //valid
-	{
-		copy_size = llmin(copy_size, TEXTURE_FAST_CACHE_ENTRY_SIZE - TEXTURE_FAST_CACHE_ENTRY_OVERHEAD);
-		memcpy(mFastCachePadBuffer + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD, raw->getData(), copy_size);
+		head.mVersion = TEXTURE_FAST_CACHE_VERSION;
+		head.mWidth = level_w;
+		head.mHeight = level_h;
+		head.mComponents = c;
+		head.mDiscardLevel = discardlevel + i;
+		break;
 	}
+	// If no level fit (very thin images), the invalid header written below
+	// makes later reads miss.
+	memcpy(mFastCachePadBuffer, &head, sizeof(head));
+
 	S32 offset = id * TEXTURE_FAST_CACHE_ENTRY_SIZE;
 
 	{
@@ -2154,7 +2189,7 @@ bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImage
 		//no need to do this assertion check. When it fails, let it fail quietly.
 		//this failure could happen because other viewer removes the fast cache file when clearing cache.
 		//--> llassert_always(mFastCachep->write(mFastCachePadBuffer, TEXTURE_FAST_CACHE_ENTRY_SIZE) == TEXTURE_FAST_CACHE_ENTRY_SIZE);
-		mFastCachep->write(mFastCachePadBuffer, TEXTURE_FAST_CACHE_ENTRY_SIZE);
+		mFastCachep->write(mFastCachePadBuffer, TEXTURE_FAST_CACHE_ENTRY_OVERHEAD + head.mDataSize);
 
 		closeFastCache(true);
 	}
@@ -2247,20 +2282,6 @@ void LLTextureCache::addCompleted(Responder* responder, bool success)
 
 //////////////////////////////////////////////////////////////////////////////
 
-//called after mHeaderMutex is locked.
-void LLTextureCache::removeCachedTexture(const LLUUID& id)
-{
-	if(mTexturesSizeMap.find(id) != mTexturesSizeMap.end())
-	{
-		mTexturesSizeTotal -= mTexturesSizeMap[id] ;
-		mTexturesSizeMap.erase(id);
-	}
-	mHeaderIDMap.erase(id);
-	// We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
-	// but getLocalAPRFilePool() is not safe, it might be in use by worker
-	LLAPRFile::remove(getTextureFileName(id), mHeaderAPRFilePoolp);
-}
-
 //called after mHeaderMutex is locked.
 void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
 {
@@ -2289,6 +2310,7 @@ void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
 		mHeaderIDMap.erase(entry.mID);
 		mTexturesSizeMap.erase(entry.mID);		
 		mFreeList.insert(idx);	
+		setEntry(idx, entry);
 	}
 
 	if (file_maybe_exists)
@@ -2311,7 +2333,7 @@ bool LLTextureCache::removeFromCache(const LLUUID& id)
 		removeEntry(idx, entry, tex_filename) ;
 		if (idx >= 0)
 		{			
-			writeEntryToHeaderImmediately(idx, entry);					
+			scheduleHeaderWrite();
 			ret = true;
 		}
 
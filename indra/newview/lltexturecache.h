@@ -33,6 +33,7 @@
 #include "lluuid.h"
 
 #include "llworkerthread.h"
+#include "threadpool_fwd.h"
 
 class LLImageFormatted;
 class LLTextureCacheWorker;
@@ -163,7 +164,7 @@ private:
 	void readHeaderCache();
 	void clearCorruptedCache();
 	void purgeAllTextures(bool purge_directories);
-	void purgeTexturesLazy(F32 time_limit_sec);
+	bool purgeTexturesLazy(F32 time_limit_sec); // returns true while more textures need purging
 	void purgeTextures(bool validate);
 	LLAPRFile* openHeaderEntriesFile(bool readonly, S32 offset);
 	void closeHeaderEntriesFile();
@@ -173,16 +174,18 @@ private:
 	S32 openAndReadEntry(const LLUUID& id, Entry& entry, bool create);
 	bool updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_body_size);
 	void updateEntryTimeStamp(S32 idx, Entry& entry) ;
-	U32 openAndReadEntries(std::vector<Entry>& entries);
-	void writeEntriesAndClose(const std::vector<Entry>& entries);
-	void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
-	void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
+	U32 openAndReadEntries();
+	void setEntry(S32 idx, const Entry& entry);
 	void removeEntry(S32 idx, Entry& entry, std::string& filename);
-	void removeCachedTexture(const LLUUID& id) ;
 	S32 getHeaderCacheEntry(const LLUUID& id, Entry& entry);
 	S32 setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize);
+	typedef std::vector<std::pair<S32, std::vector<Entry> > > entry_run_list_t;
 	void writeUpdatedEntries() ;
-	void updatedHeaderEntriesFile() ;
+	void writeDirtyEntries() ;
+	void scheduleHeaderWrite() ;
+	void writeDirtyEntriesAsync() ;
+	void collectDirtyEntries(entry_run_list_t& runs) ;
+	bool writeEntryRuns(const EntriesInfo& info, const entry_run_list_t& runs) ;
 	void lockHeaders() { mHeaderMutex.lock(); }
 	void unlockHeaders() { mHeaderMutex.unlock(); }
 	
@@ -194,6 +197,7 @@ private:
 	// Internal
 	LLMutex mWorkersMutex;
 	LLMutex mHeaderMutex;
+	LLMutex mHeaderIOMutex; // held while writing the entries file, taken after mHeaderMutex
 	LLMutex mListMutex;
 	LLMutex mFastCacheMutex;
 	LLAPRFile* mHeaderAPRFile;
@@ -224,9 +228,19 @@ private:
 	std::string mFastCacheFileName;
 	EntriesInfo mHeaderEntriesInfo;
 	std::set<S32> mFreeList; // deleted entries
-	std::set<LLUUID> mLRU;
 	typedef std::map<LLUUID, S32> id_map_t;
 	id_map_t mHeaderIDMap;
+	// In-memory copy of the entries file, read once by readHeaderCache()
+	// and then kept up to date as entries change.
+	std::vector<Entry> mEntries;
+	// Valid entries by (time stamp, index), least recently used first
+	typedef std::set<std::pair<U32, S32> > time_idx_set_t;
+	time_idx_set_t mTimeIndex;
+	// Blocks of TEXTURE_CACHE_ENTRIES_PER_PAGE entries not yet written back
+	std::set<S32> mDirtyPages;
+	// Writes dirty entries back to the entries file, see scheduleHeaderWrite()
+	std::unique_ptr<LL::ThreadPool> mHeaderThreadPool;
+	LLAtomicBool mHeaderWritePending;
 
 	LLAPRFile*   mFastCachep;
 	LLFrameTimer mFastCacheTimer;
@@ -238,11 +252,7 @@ private:
 	size_map_t mTexturesSizeMap;
 	S64 mTexturesSizeTotal;
 	LLAtomicBool mDoPurge;
-
-	typedef std::map<S32, Entry> idx_entry_map_t;
-	idx_entry_map_t mUpdatedEntryMap;
-	typedef std::vector<std::pair<S32, Entry> > idx_entry_vector_t;
-	idx_entry_vector_t mPurgeEntryList;
+	S64 mPurgeTargetSize; // cache size the lazy purge is working down to, 0 when not purging
 
 	// Statics
 	static F32 sHeaderCacheVersion;
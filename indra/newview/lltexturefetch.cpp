@@ -68,12 +68,19 @@
 LLTrace::CountStatHandle<F64> LLTextureFetch::sCacheHit("texture_cache_hit");
 LLTrace::CountStatHandle<F64> LLTextureFetch::sCacheAttempt("texture_cache_attempt");
 LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > LLTextureFetch::sCacheHitRate("texture_cache_hits");
+LLTrace::CountStatHandle<F64> LLTextureFetch::sFastCacheHit("texture_fast_cache_hit");
+LLTrace::CountStatHandle<F64> LLTextureFetch::sFastCacheAttempt("texture_fast_cache_attempt");
 
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheReadLatency("texture_cache_read_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexDecodeLatency("texture_decode_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheWriteLatency("texture_write_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexFetchLatency("texture_fetch_latency");
 
+LLTrace::SampleStatHandle<> LLTextureFetch::sHttpWaitDepth("texture_fetch_http_wait_depth", "Texture requests waiting for an HTTP slot");
+LLTrace::SampleStatHandle<> LLTextureFetch::sHttpActiveDepth("texture_fetch_http_active_depth", "Texture HTTP requests in flight");
+LLTrace::SampleStatHandle<> LLTextureFetch::sCacheReadDepth("texture_fetch_cache_read_depth", "Texture cache reads in flight");
+LLTrace::SampleStatHandle<> LLTextureFetch::sDecodeDepth("texture_fetch_decode_depth", "Texture decodes in flight");
+
 LLTextureFetchTester* LLTextureFetch::sTesterp = NULL ;
 const std::string sTesterName("TextureFetchTester");
 
@@ -299,6 +306,13 @@ private:
 			: mFetcher(fetcher), mID(id)
 		{
 			setImage(image);
+			mFetcher->mCacheReadsInFlight++;
+		}
+
+		// Threads:  T*
+		virtual ~CacheReadResponder()
+		{
+			mFetcher->mCacheReadsInFlight--;
 		}
 
 		// Threads:  Ttc
@@ -349,6 +363,13 @@ private:
 		DecodeResponder(LLTextureFetch* fetcher, const LLUUID& id, LLTextureFetchWorker* worker)
 			: mFetcher(fetcher), mID(id)
 		{
+			mFetcher->mDecodesInFlight++;
+		}
+
+		// Threads:  T*
+		virtual ~DecodeResponder()
+		{
+			mFetcher->mDecodesInFlight--;
 		}
 
 		// Threads:  Tid
@@ -793,6 +814,30 @@ public:
 };
 
 
+/**
+ * @brief Implements a 'Downgrade Requests' cross-thread command.
+ *
+ * When the agent teleports, requests made for the old location
+ * shouldn't compete with the ones for the new location.  The fetch
+ * thread walks all requests once and lowers their priority in bulk.
+ *
+ * Corresponds to LLTextureFetch::commandDowngradeRequests()
+ */
+class TFReqDowngradeRequests : public LLTextureFetch::TFRequest
+{
+public:
+	TFReqDowngradeRequests()
+		: LLTextureFetch::TFRequest()
+		{}
+	TFReqDowngradeRequests & operator=(const TFReqDowngradeRequests &);	// Not defined
+
+	virtual ~TFReqDowngradeRequests()
+		{}
+
+	virtual bool doWork(LLTextureFetch * fetcher);
+};
+
+
 /**
  * @brief Implements a 'Send Metrics' cross-thread command.
  *
@@ -882,6 +927,28 @@ const char* sStateDescs[] = {
 	"DONE"
 };
 
+// Time spent by requests in each state, sampled when they leave it.
+// Indexed by LLTextureFetchWorker::e_state, see e_state_name.
+static LLTrace::SampleStatHandle<F32Seconds> sStateTime[] =
+{
+	"texture_fetch_state_invalid",
+	"texture_fetch_state_init",
+	"texture_fetch_state_load_from_texture_cache",
+	"texture_fetch_state_cache_post",
+	"texture_fetch_state_load_from_network",
+	"texture_fetch_state_load_from_simulator",
+	"texture_fetch_state_wait_http_resource",
+	"texture_fetch_state_wait_http_resource2",
+	"texture_fetch_state_send_http_req",
+	"texture_fetch_state_wait_http_req",
+	"texture_fetch_state_decode_image",
+	"texture_fetch_state_decode_image_update",
+	"texture_fetch_state_write_to_cache",
+	"texture_fetch_state_wait_on_write",
+	"texture_fetch_state_done"
+};
+static_assert(LL_ARRAY_SIZE(sStateTime) == LL_ARRAY_SIZE(e_state_name), "sStateTime must match e_state_name");
+
 const std::set<S32> LOGGED_STATES = { LLTextureFetchWorker::LOAD_FROM_TEXTURE_CACHE, LLTextureFetchWorker::LOAD_FROM_NETWORK, LLTextureFetchWorker::LOAD_FROM_SIMULATOR, // <FS:Ansariel> OpenSim compatibility
 										LLTextureFetchWorker::WAIT_HTTP_REQ, LLTextureFetchWorker::DECODE_IMAGE_UPDATE, LLTextureFetchWorker::WAIT_ON_WRITE };
 
@@ -1092,6 +1159,11 @@ void LLTextureFetchWorker::setDesiredDiscard(S32 discard, S32 size)
 // Locks:  Mw
 void LLTextureFetchWorker::setImagePriority(F32 priority)
 {
+	if (WAIT_HTTP_RESOURCE2 == mState &&
+		LLTextureFetch::getPriorityBucket(priority) != LLTextureFetch::getPriorityBucket(mImagePriority))
+	{
+		mFetcher->updateHttpWaiterPriority(mID, priority);
+	}
 	mImagePriority = priority; //should map to max virtual size, abort if zero
 }
 
@@ -1157,6 +1229,16 @@ bool LLTextureFetchWorker::doWork(S32 param)
 			LL_DEBUGS(LOG_TXT) << mID << " abort: mImagePriority < F_ALMOST_ZERO" << LL_ENDL;
 			return true; // abort
 		}
+		if (mState == WAIT_HTTP_RESOURCE2)
+		{
+			// Stale request still waiting for an HTTP slot.  Leave the
+			// state so that releaseHttpWaiters() won't hand it one.
+            LL_PROFILE_ZONE_NAMED_CATEGORY_THREAD("tfwdw - priority < 0 waiter");
+			LL_DEBUGS(LOG_TXT) << mID << " abort: waiting for HTTP and mImagePriority < F_ALMOST_ZERO" << LL_ENDL;
+			mFetcher->removeHttpWaiter(mID);
+			setState(DONE);
+			return true; // abort
+		}
 	}
     if (mState > CACHE_POST && !mCanUseCapability && mCanUseHTTP)
     {
@@ -1260,6 +1342,12 @@ bool LLTextureFetchWorker::doWork(S32 param)
                 return doWork(param);
                 // return false;
 			}
+			static LLCachedControl<U32> max_cache_reads(gSavedSettings, "FSTextureFetchMaxCacheReads", 32);
+			if (max_cache_reads > 0 && mFetcher->mCacheReadsInFlight >= (S32)max_cache_reads())
+			{
+				// Cache read queue is full, try again later
+				return false;
+			}
 			mFileSize = 0;
 			mLoaded = FALSE;			
 
@@ -1531,7 +1619,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
             (mFetcher->getHttpWaitersCount() || ! acquireHttpSemaphore()))
 		{
 			setState(WAIT_HTTP_RESOURCE2);
-			mFetcher->addHttpWaiter(this->mID);
+			mFetcher->addHttpWaiter(this->mID, mImagePriority);
 			++mResourceWaitCount;
 			return false;
 		}
@@ -1952,6 +2040,12 @@ bool LLTextureFetchWorker::doWork(S32 param)
 			LL_DEBUGS(LOG_TXT) << mID << " DECODE_IMAGE abort: mLoadedDiscard < 0" << LL_ENDL;
 			return true;
 		}
+		static LLCachedControl<U32> max_decodes(gSavedSettings, "FSTextureFetchMaxDecodes", 32);
+		if (max_decodes > 0 && mFetcher->mDecodesInFlight >= (S32)max_decodes())
+		{
+			// Decode queue is full, try again later
+			return false;
+		}
 		mDecodeTimer.reset();
 		mRawImage = NULL;
 		mAuxImage = NULL;
@@ -2663,6 +2757,8 @@ LLTextureFetch::LLTextureFetch(LLTextureCache* cache, bool threaded, bool qa_mod
 	  mDebugPause(FALSE),
 	  mPacketCount(0),
 	  mBadPacketCount(0),
+	  mCacheReadsInFlight(0),
+	  mDecodesInFlight(0),
 	  mQueueMutex(),
 	  mNetworkQueueMutex(),
 	  mTextureCache(cache),
@@ -2725,7 +2821,7 @@ LLTextureFetch::~LLTextureFetch()
 		delete req;
 	}
 
-	mHttpWaitResource.clear();
+	cancelHttpWaiters();
 	
 	delete mHttpRequest;
 	mHttpRequest = NULL;
@@ -3221,6 +3317,11 @@ void LLTextureFetch::commonUpdate()
 
 	// Release waiters
 	releaseHttpWaiters();
+
+	sample(sHttpWaitDepth, getHttpWaitersCount());
+	sample(sHttpActiveDepth, (S32)mHttpSemaphore);
+	sample(sCacheReadDepth, (S32)mCacheReadsInFlight);
+	sample(sDecodeDepth, (S32)mDecodesInFlight);
 	
 	// Run a cross-thread command, if any.
 	cmdDoWork();
@@ -3590,6 +3691,10 @@ void LLTextureFetchWorker::setState(e_state new_state)
 	}
 	
 	F32 d_time = mStateTimer.getElapsedTimeF32();
+	if (new_state != mState)
+	{
+		sample(sStateTime[mState], F32Seconds(d_time));
+	}
 	if (d_time >= 0.0001F)
 	{
 		if (LOGGED_STATES.count(mState))
@@ -3848,11 +3953,11 @@ void LLTextureFetch::dump()
 	}
 
 	LL_INFOS(LOG_TXT) << "LLTextureFetch WAIT_HTTP_RESOURCE:" << LL_ENDL;
-	for (wait_http_res_queue_t::const_iterator iter(mHttpWaitResource.begin());
-		 mHttpWaitResource.end() != iter;
+	for (wait_http_res_index_t::const_iterator iter(mHttpWaitIndex.begin());
+		 mHttpWaitIndex.end() != iter;
 		 ++iter)
 	{
-		LL_INFOS(LOG_TXT) << " ID: " << (*iter) << LL_ENDL;
+		LL_INFOS(LOG_TXT) << " ID: " << iter->first << " Bucket: " << iter->second.first << LL_ENDL;
 	}
 }
 
@@ -3860,11 +3965,29 @@ void LLTextureFetch::dump()
 
 // HTTP Resource Waiting Methods
 
+// static
+U32 LLTextureFetch::getPriorityBucket(F32 priority)
+{
+	if (priority < F_ALMOST_ZERO)
+	{
+		return 0;
+	}
+	// Everything below one pixel shares the first live bucket
+	S32 bucket = 1 + (S32)(log2f(llmax(priority, 1.f)));
+	return (U32)llclamp(bucket, 1, (S32)PRIORITY_BUCKETS - 1);
+}
+
 // Threads:  Ttf
-void LLTextureFetch::addHttpWaiter(const LLUUID & tid)
+void LLTextureFetch::addHttpWaiter(const LLUUID & tid, F32 priority)
 {
+	U32 bucket(getPriorityBucket(priority));
+
 	mNetworkQueueMutex.lock();											// +Mfnq
-	mHttpWaitResource.insert(tid);
+	if (mHttpWaitIndex.find(tid) == mHttpWaitIndex.end())
+	{
+		wait_http_res_queue_t & queue(mHttpWaitResource[bucket]);
+		mHttpWaitIndex[tid] = std::make_pair(bucket, queue.insert(queue.end(), tid));
+	}
 	mNetworkQueueMutex.unlock();										// -Mfnq
 }
 
@@ -3872,10 +3995,28 @@ void LLTextureFetch::addHttpWaiter(const LLUUID & tid)
 void LLTextureFetch::removeHttpWaiter(const LLUUID & tid)
 {
 	mNetworkQueueMutex.lock();											// +Mfnq
-	wait_http_res_queue_t::iterator iter(mHttpWaitResource.find(tid));
-	if (mHttpWaitResource.end() != iter)
+	wait_http_res_index_t::iterator iter(mHttpWaitIndex.find(tid));
+	if (mHttpWaitIndex.end() != iter)
 	{
-		mHttpWaitResource.erase(iter);
+		mHttpWaitResource[iter->second.first].erase(iter->second.second);
+		mHttpWaitIndex.erase(iter);
+	}
+	mNetworkQueueMutex.unlock();										// -Mfnq
+}
+
+// Threads:  T*
+void LLTextureFetch::updateHttpWaiterPriority(const LLUUID & tid, F32 priority)
+{
+	U32 bucket(getPriorityBucket(priority));
+
+	mNetworkQueueMutex.lock();											// +Mfnq
+	wait_http_res_index_t::iterator iter(mHttpWaitIndex.find(tid));
+	if (mHttpWaitIndex.end() != iter && iter->second.first != bucket)
+	{
+		// Goes to the back of its new bucket, splice keeps the iterator valid
+		wait_http_res_queue_t & queue(mHttpWaitResource[bucket]);
+		queue.splice(queue.end(), mHttpWaitResource[iter->second.first], iter->second.second);
+		iter->second.first = bucket;
 	}
 	mNetworkQueueMutex.unlock();										// -Mfnq
 }
@@ -3884,8 +4025,8 @@ void LLTextureFetch::removeHttpWaiter(const LLUUID & tid)
 bool LLTextureFetch::isHttpWaiter(const LLUUID & tid)
 {
 	mNetworkQueueMutex.lock();											// +Mfnq
-	wait_http_res_queue_t::iterator iter(mHttpWaitResource.find(tid));
-	const bool ret(mHttpWaitResource.end() != iter);
+	wait_http_res_index_t::iterator iter(mHttpWaitIndex.find(tid));
+	const bool ret(mHttpWaitIndex.end() != iter);
 	mNetworkQueueMutex.unlock();										// -Mfnq
 	return ret;
 }
@@ -3893,13 +4034,12 @@ bool LLTextureFetch::isHttpWaiter(const LLUUID & tid)
 // Release as many requests as permitted from the WAIT_HTTP_RESOURCE2
 // state to the SEND_HTTP_REQ state based on their current priority.
 //
-// This data structures and code associated with this looks a bit
-// indirect and naive but it's done in the name of safety.  An
-// ordered container may become invalid from time to time due to
-// priority changes caused by actions in other threads.  State itself
-// could also suffer the same fate with canceled operations.  Even
-// done this way, I'm not fully trusting we're truly safe.  This
-// module is due for a major refactoring and we'll deal with it then.
+// Waiters are kept in priority buckets that are updated as priorities
+// change (see LLTextureFetchWorker::setImagePriority()), so picking
+// the requests to release is a walk down from the highest bucket, with
+// requests of similar priority served in arrival order.  We still copy
+// the UUIDs and look the workers up again without holding the lock:
+// state could have changed behind our back with canceled operations.
 //
 // Threads:  Ttf
 // Locks:  -Mw (must not hold any worker when called)
@@ -3919,7 +4059,7 @@ void LLTextureFetch::releaseHttpWaiters()
 		return;
 	}
 
-	// Quickly make a copy of all the LLUIDs.  Get off the
+	// Quickly copy the LLUIDs of the best candidates.  Get off the
 	// mutex as early as possible.
 	typedef std::vector<LLUUID> uuid_vec_t;
 	uuid_vec_t tids;
@@ -3927,33 +4067,30 @@ void LLTextureFetch::releaseHttpWaiters()
 	{
 		LLMutexLock lock(&mNetworkQueueMutex);							// +Mfnq
 
-		if (mHttpWaitResource.empty())
+		if (mHttpWaitIndex.empty())
 			return;
-		tids.reserve(mHttpWaitResource.size());
-		tids.assign(mHttpWaitResource.begin(), mHttpWaitResource.end());
+		tids.reserve(llmin((size_t)needed, mHttpWaitIndex.size()));
+		for (S32 bucket = PRIORITY_BUCKETS - 1; bucket >= 0 && tids.size() < (size_t)needed; --bucket)
+		{
+			const wait_http_res_queue_t & queue(mHttpWaitResource[bucket]);
+			for (wait_http_res_queue_t::const_iterator iter(queue.begin());
+				 queue.end() != iter && tids.size() < (size_t)needed;
+				 ++iter)
+			{
+				tids.push_back(*iter);
+			}
+		}
 	}																	// -Mfnq
 
-	// Now lookup the UUUIDs to find valid requests and sort
-	// them in priority order, highest to lowest.  We're going
-	// to modify priority later as a side-effect of releasing
-	// these objects.  That, in turn, would violate the partial
-	// ordering assumption of std::set, std::map, etc. so we
-	// don't use those containers.  We use a vector and an explicit
-	// sort to keep the containers valid later.
-	typedef std::vector<LLTextureFetchWorker *> worker_list_t;
-	worker_list_t tids2;
-
-	tids2.reserve(tids.size());
-	for (uuid_vec_t::iterator iter(tids.begin());
-		 tids.end() != iter;
-		 ++iter)
+	// Release workers up to the high water mark.  Since we aren't
+	// holding any locks at this point, we can be in competition
+	// with other callers.  Do defensive things like getting
+	// refreshed counts of requests and checking if someone else
+	// has moved any worker state around....
+	for (uuid_vec_t::iterator iter(tids.begin()); tids.end() != iter; ++iter)
 	{
 		LLTextureFetchWorker * worker(getWorker(* iter));
-		if (worker)
-		{
-			tids2.push_back(worker);
-		}
-		else
+		if (! worker)
 		{
 			// If worker isn't found, this should be due to a request
 			// for deletion.  We signal our recognition that this
@@ -3961,35 +4098,18 @@ void LLTextureFetch::releaseHttpWaiters()
 			// erasing it from the resource waiter list.  That allows
 			// deleteOK to do final deletion on the worker.
 			removeHttpWaiter(* iter);
+			continue;
 		}
-	}
-	tids.clear();
-
-	// Sort into priority order, if necessary and only as much as needed
-	if (tids2.size() > needed)
-	{
-		LLTextureFetchWorker::Compare compare;
-		std::partial_sort(tids2.begin(), tids2.begin() + needed, tids2.end(), compare);
-	}
-
-	// Release workers up to the high water mark.  Since we aren't
-	// holding any locks at this point, we can be in competition
-	// with other callers.  Do defensive things like getting
-	// refreshed counts of requests and checking if someone else
-	// has moved any worker state around....
-	for (worker_list_t::iterator iter2(tids2.begin()); tids2.end() != iter2; ++iter2)
-	{
-		LLTextureFetchWorker * worker(* iter2);
 
 		worker->lockWorkMutex();										// +Mw
 		if (LLTextureFetchWorker::WAIT_HTTP_RESOURCE2 != worker->mState)
 		{
 			// Not in expected state, remove it, try the next one
 			worker->unlockWorkMutex();									// -Mw
-			LL_WARNS(LOG_TXT) << "Resource-waited texture " << worker->mID
-							  << " in unexpected state:  " << worker->mState
-							  << ".  Removing from wait list."
-							  << LL_ENDL;
+			LL_DEBUGS(LOG_TXT) << "Resource-waited texture " << worker->mID
+							   << " in unexpected state:  " << worker->mState
+							   << ".  Removing from wait list."
+							   << LL_ENDL;
 			removeHttpWaiter(worker->mID);
 			continue;
 		}
@@ -4012,7 +4132,11 @@ void LLTextureFetch::releaseHttpWaiters()
 void LLTextureFetch::cancelHttpWaiters()
 {
 	mNetworkQueueMutex.lock();											// +Mfnq
-	mHttpWaitResource.clear();
+	for (U32 bucket = 0; bucket < PRIORITY_BUCKETS; ++bucket)
+	{
+		mHttpWaitResource[bucket].clear();
+	}
+	mHttpWaitIndex.clear();
 	mNetworkQueueMutex.unlock();										// -Mfnq
 }
 
@@ -4020,7 +4144,7 @@ void LLTextureFetch::cancelHttpWaiters()
 int LLTextureFetch::getHttpWaitersCount()
 {
 	mNetworkQueueMutex.lock();											// +Mfnq
-	int ret(mHttpWaitResource.size());
+	int ret(mHttpWaitIndex.size());
 	mNetworkQueueMutex.unlock();										// -Mfnq
 	return ret;
 }
@@ -4066,6 +4190,59 @@ void LLTextureFetch::commandSetRegion(U64 region_handle)
 	cmdEnqueue(req);
 }
 
+// Threads:  T*
+void LLTextureFetch::commandDowngradeRequests()
+{
+	TFReqDowngradeRequests * req = new TFReqDowngradeRequests();
+
+	cmdEnqueue(req);
+}
+
+// Threads:  Ttf
+void LLTextureFetch::downgradeRequests()
+{
+    LL_PROFILE_ZONE_SCOPED;
+	// Priority given to downgraded requests: lowest live bucket, so
+	// they are still fetched when nothing better is waiting.
+	static const F32 DOWNGRADED_PRIORITY = 1.f;
+
+	typedef std::vector<LLUUID> uuid_vec_t;
+	uuid_vec_t tids;
+
+	lockQueue();														// +Mfq
+	tids.reserve(mRequestMap.size());
+	for (map_t::const_iterator iter(mRequestMap.begin()); mRequestMap.end() != iter; ++iter)
+	{
+		tids.push_back(iter->first);
+	}
+	unlockQueue();														// -Mfq
+
+	// Same rules as updateRequestPriority(): look the worker up again
+	// and only touch it under its own lock.
+	S32 downgraded(0);
+	for (uuid_vec_t::const_iterator iter(tids.begin()); tids.end() != iter; ++iter)
+	{
+		LLTextureFetchWorker * worker(getWorker(* iter));
+		if (! worker)
+		{
+			continue;
+		}
+
+		worker->lockWorkMutex();										// +Mw
+		// Requests already on the wire or past it are left alone, the
+		// data is (nearly) paid for.
+		if (worker->mState < LLTextureFetchWorker::SEND_HTTP_REQ &&
+			worker->mImagePriority > DOWNGRADED_PRIORITY)
+		{
+			worker->setImagePriority(DOWNGRADED_PRIORITY);
+			++downgraded;
+		}
+		worker->unlockWorkMutex();										// -Mw
+	}
+
+	LL_DEBUGS(LOG_TXT) << "Downgraded " << downgraded << " of " << tids.size() << " requests" << LL_ENDL;
+}
+
 // Threads:  T*
 void LLTextureFetch::commandSendMetrics(const std::string & caps_url,
 										const LLUUID & session_id,
@@ -4183,6 +4360,20 @@ TFReqSetRegion::doWork(LLTextureFetch *)
 	return true;
 }
 
+
+/**
+ * Implements the 'Downgrade Requests' command.
+ *
+ * Thread:  Thread1 (TextureFetch)
+ */
+bool
+TFReqDowngradeRequests::doWork(LLTextureFetch * fetcher)
+{
+	fetcher->downgradeRequests();
+
+	return true;
+}
+
 TFReqSendMetrics::TFReqSendMetrics(const std::string & caps_url,
                                    const LLUUID & session_id,
                                    const LLUUID & agent_id,
@@ -27,6 +27,7 @@
 #ifndef LL_LLTEXTUREFETCH_H
 #define LL_LLTEXTUREFETCH_H
 
+#include <list>
 #include <vector>
 #include <map>
 
@@ -60,6 +61,16 @@ class LLTextureFetch : public LLWorkerThread
 public:
     static std::string getStateString(S32 state);
 
+	// Requests are ordered by priority bucket rather than by their exact
+	// priority so that the small changes made every frame by the texture
+	// list don't have to be propagated or re-sorted.  Bucket 0 holds
+	// requests nobody wants anymore, the others are log2 ranges of the
+	// priority (which maps to the virtual size in pixels).
+	static const U32 PRIORITY_BUCKETS = 32;
+
+	// Threads:  T*
+	static U32 getPriorityBucket(F32 priority);
+
 	LLTextureFetch(LLTextureCache* cache, bool threaded, bool qa_mode);
 	~LLTextureFetch();
 
@@ -161,6 +172,18 @@ public:
 	// Threads:  T*
 	void commandSetRegion(U64 region_handle);
 
+	// Lower the priority of every request that hasn't reached the
+	// network yet, so that requests made for the new location go
+	// first.  Requests still wanted get their priority back on the
+	// next texture list update, the others are canceled when it drops
+	// to zero.  Used on teleport.
+	//
+	// Threads:  T*
+	void commandDowngradeRequests();
+
+	// Threads:  Ttf
+	void downgradeRequests();
+
 	// Threads:  T*
 	void commandSendMetrics(const std::string & caps_url,
 							const LLUUID & session_id,
@@ -192,17 +215,23 @@ public:
 	// HTTP resource waiting methods
 
     // Threads:  T*
-	void addHttpWaiter(const LLUUID & tid);
+	void addHttpWaiter(const LLUUID & tid, F32 priority);
 
     // Threads:  T*
 	void removeHttpWaiter(const LLUUID & tid);
 
+	// Move a waiter to the bucket of its new priority.  No-op if the
+	// request isn't waiting.
+	//
+    // Threads:  T*
+	void updateHttpWaiterPriority(const LLUUID & tid, F32 priority);
+
     // Threads:  T*
 	bool isHttpWaiter(const LLUUID & tid);
 
 	// If there are slots, release one or more LLTextureFetchWorker
 	// requests from resource wait state (WAIT_HTTP_RESOURCE) to
-	// active (SEND_HTTP_REQ).
+	// active (SEND_HTTP_REQ), highest priority bucket first.
 	//
 	// Because this will modify state of many workers, you may not
 	// hold any Mw lock while calling.  This makes it a little
@@ -324,6 +353,20 @@ public:
 	static LLTrace::SampleStatHandle<F32Seconds> sCacheWriteLatency;
     static LLTrace::SampleStatHandle<F32Seconds> sTexFetchLatency;
     static LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > sCacheHitRate;
+    static LLTrace::CountStatHandle<F64>        sFastCacheHit;
+    static LLTrace::CountStatHandle<F64>        sFastCacheAttempt;
+
+    // Queue depths, sampled on every fetcher update
+    static LLTrace::SampleStatHandle<>          sHttpWaitDepth;
+    static LLTrace::SampleStatHandle<>          sHttpActiveDepth;
+    static LLTrace::SampleStatHandle<>          sCacheReadDepth;
+    static LLTrace::SampleStatHandle<>          sDecodeDepth;
+
+	// Cache reads and decodes in flight.  Counted by the responders
+	// for their whole lifetime, so that aborted requests give their
+	// slot back as well.
+	LLAtomicS32 mCacheReadsInFlight;
+	LLAtomicS32 mDecodesInFlight;
 
 private:
 	LLMutex mQueueMutex;        //to protect mRequestMap and mCommands only
@@ -389,8 +432,12 @@ private:
 	// exceed the high water level (but not go below zero).
 	LLAtomicS32							mHttpSemaphore;					// Ttf
 	
-	typedef std::set<LLUUID> wait_http_res_queue_t;
-	wait_http_res_queue_t				mHttpWaitResource;				// Mfnq
+	// Requests in WAIT_HTTP_RESOURCE2, one FIFO per priority bucket,
+	// plus an index to find and move them when their priority changes.
+	typedef std::list<LLUUID> wait_http_res_queue_t;
+	typedef std::map<LLUUID, std::pair<U32, wait_http_res_queue_t::iterator> > wait_http_res_index_t;
+	wait_http_res_queue_t				mHttpWaitResource[PRIORITY_BUCKETS];	// Mfnq
+	wait_http_res_index_t				mHttpWaitIndex;					// Mfnq
 
 	// Cumulative stats on the states/requests issued by
 	// textures running through here.
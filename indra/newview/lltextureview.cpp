@@ -542,6 +542,11 @@ void LLGLTexMemBar::draw()
 
 	F32 cacheHitRate = (cacheAttempts > 0.0) ? F32((cacheHits / cacheAttempts) * 100.0f) : 0.0f;
 
+    F64 fastCacheHits     = recording.getSampleCount(LLTextureFetch::sFastCacheHit);
+    F64 fastCacheAttempts = recording.getSampleCount(LLTextureFetch::sFastCacheAttempt);
+
+	F32 fastCacheHitRate = (fastCacheAttempts > 0.0) ? F32((fastCacheHits / fastCacheAttempts) * 100.0f) : 0.0f;
+
     U32 cacheReadLatMin = U32(recording.getMin(LLTextureFetch::sCacheReadLatency).value() * 1000.0f);
     U32 cacheReadLatMed = U32(recording.getMean(LLTextureFetch::sCacheReadLatency).value() * 1000.0f);
     U32 cacheReadLatMax = U32(recording.getMax(LLTextureFetch::sCacheReadLatency).value() * 1000.0f);
@@ -649,8 +654,9 @@ void LLGLTexMemBar::draw()
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*5,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
 
-    text = llformat("CacheHitRate: %3.2f Read: %d/%d/%d Decode: %d/%d/%d Fetch: %d/%d/%d",
+    text = llformat("CacheHitRate: %3.2f FastCache: %3.2f Read: %d/%d/%d Decode: %d/%d/%d Fetch: %d/%d/%d",
                     cacheHitRate,
+                    fastCacheHitRate,
                     cacheReadLatMin,
                     cacheReadLatMed,
                     cacheReadLatMax,
@@ -29,6 +29,7 @@
 #include "llviewerobjectlist.h"
 
 #include "message.h"
+#include "llmessageview.h"
 #include "llfasttimer.h"
 #include "llrender.h"
 #include "llwindow.h"		// decBusyCount()
@@ -459,12 +460,13 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 	LLPCode		pcode = 0;
 	LLUUID		fullid;
 	S32			i;
+	LLObjectUpdateView view(mesgsys);
 
 	// figure out which simulator these are from and get it's index
 	// Coordinates in simulators are region-local
 	// Until we get region-locality working on viewer we
 	// have to transform to absolute coordinates.
-	num_objects = mesgsys->getNumberOfBlocksFast(_PREHASH_ObjectData);
+	num_objects = view.getObjectCount();
 
 	// I don't think this case is ever hit.  TODO* Test this.
 	if (!compressed && update_type != OUT_FULL)
@@ -502,8 +504,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		gFullObjectUpdates += num_objects;
 	}
 
-	U64 region_handle;
-	mesgsys->getU64Fast(_PREHASH_RegionData, _PREHASH_RegionHandle, region_handle);
+	U64 region_handle = view.getRegionHandle();
 	
 	LLViewerRegion *regionp = LLWorld::getInstance()->getRegionFromHandle(region_handle);
 
@@ -526,15 +527,14 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		{
 			compressed_dp.reset();
 
-			S32 uncompressed_length = mesgsys->getSizeFast(_PREHASH_ObjectData, i, _PREHASH_Data);
+			S32 uncompressed_length = view.getDataSize(i);
             LL_DEBUGS("ObjectUpdate") << "got binary data from message to compressed_dpbuffer" << LL_ENDL;
-			mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, compressed_dpbuffer, 0, i, 2048);
+			view.getData(i, compressed_dpbuffer, 2048);
 			compressed_dp.assignBuffer(compressed_dpbuffer, uncompressed_length);
 
 			if (update_type != OUT_TERSE_IMPROVED) // OUT_FULL_COMPRESSED only?
 			{
-				U32 flags = 0;
-				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
+				U32 flags = view.getUpdateFlags(i);
 
 				compressed_dp.unpackUUID(fullid, "ID");
 				compressed_dp.unpackU32(local_id, "LocalID");
@@ -575,7 +575,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		}
 		else if (update_type != OUT_FULL) // !compressed, !OUT_FULL ==> OUT_FULL_CACHED only?
 		{
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+			local_id = view.getLocalID(i);
 
 			getUUIDFromLocal(fullid,
 							local_id,
@@ -594,8 +594,8 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		else // OUT_FULL only?
 		{
 			update_cache = true;
-			mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_FullID, fullid, i);
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+			fullid = view.getFullID(i);
+			local_id = view.getLocalID(i);
 			LL_DEBUGS("ObjectUpdate") << "Full Update, obj " << local_id << ", global ID " << fullid << " from " << mesgsys->getSender() << LL_ENDL;
 		}
 		objectp = findObject(fullid);
@@ -669,7 +669,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 					continue;
 				}
 
-				mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_PCode, pcode, i);
+				pcode = view.getPCode(i);
 
 			}
 #ifdef IGNORE_DEAD
@@ -237,6 +237,9 @@ public:
 	// etc.
 	LLUUID mCacheID;
 
+	// Object cache files being read on a cache I/O thread, see loadObjectCache()
+	LLVOCache::region_cache_future_t mCacheLoad;
+
 	CapabilityMap mCapabilities;
 	CapabilityMap mSecondCapabilitiesTracker; 
 
@@ -710,6 +713,12 @@ LLViewerRegion::LLViewerRegion(const U64 &handle,
 	setOriginGlobal(from_region_handle(handle));
 	calculateCenterGlobal();
 
+	// Start reading the object cache now, it is needed when the handshake arrives
+	if(LLVOCache::instanceExists())
+	{
+		mImpl->mCacheLoad = LLVOCache::instance().requestRegionCache(mHandle);
+	}
+
 	// Create the object lists
 	initStats();
 // <FS:CR> FIRE-11593: Opensim "4096 Bug" Fix by Latif Khalifa
@@ -844,13 +853,20 @@ void LLViewerRegion::loadObjectCache()
 	if(LLVOCache::instanceExists())
 	{
         LLVOCache & vocache = LLVOCache::instance();
-		// <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-		// vocache.readFromCache(mHandle, mImpl->mCacheID, mImpl->mCacheMap);
-		// vocache.readGenericExtrasFromCache(mHandle, mImpl->mCacheID, mImpl->mGLTFOverridesLLSD);		
+		if (!mImpl->mCacheLoad.valid())
+		{
+			mImpl->mCacheLoad = vocache.requestRegionCache(mHandle);
+		}
+
+		// The files were decoded on a cache I/O thread since the region was
+		// created; this only waits if that has not finished yet.
+		LLVOCache::RegionCacheData data;
+		if (mImpl->mCacheLoad.valid())
+		{
+			data = mImpl->mCacheLoad.get();
+		}
 		// mark as dirty if read fails to force a rewrite.
-		mCacheDirty = !vocache.readFromCache(mHandle, mImpl->mCacheID, mImpl->mCacheMap);
-		vocache.readGenericExtrasFromCache(mHandle, mImpl->mCacheID, mImpl->mGLTFOverridesLLSD, mImpl->mCacheMap);
-		// </FS:Beq>
+		mCacheDirty = !vocache.applyRegionCache(mHandle, mImpl->mCacheID, data, mImpl->mCacheMap, mImpl->mGLTFOverridesLLSD);
 
 		if (mImpl->mCacheMap.empty())
 		{
@@ -3956,6 +3972,8 @@ void LLViewerRegion::applyCacheMiscExtras(LLViewerObject* obj)
             iter->second.mObjectId = obj->getID();
         }
         // </FS:Beq>
+        // entries read from the object cache are decoded on first use
+        iter->second.unpack();
         llassert(iter->second.mGLTFMaterial.size() == iter->second.mSides.size());
 
         for (auto& side : iter->second.mGLTFMaterial)
@@ -1196,6 +1196,7 @@ void LLViewerFetchedTexture::loadFromFastCache()
     mInFastCacheList = FALSE;
 
     add(LLTextureFetch::sCacheAttempt, 1.0);
+    add(LLTextureFetch::sFastCacheAttempt, 1.0);
 
     LLTimer fastCacheTimer;
 	mRawImage = LLAppViewer::getTextureCache()->readFromFastCache(getID(), mRawDiscardLevel);
@@ -1204,6 +1205,7 @@ void LLViewerFetchedTexture::loadFromFastCache()
         F32 cachReadTime = fastCacheTimer.getElapsedTimeF32();
 
         add(LLTextureFetch::sCacheHit, 1.0);
+        add(LLTextureFetch::sFastCacheHit, 1.0);
         record(LLTextureFetch::sCacheHitRate, LLUnits::Ratio::fromValue(1));
         sample(LLTextureFetch::sCacheReadLatency, cachReadTime);
 
@@ -1223,8 +1225,8 @@ void LLViewerFetchedTexture::loadFromFastCache()
 		{
             if (mBoostLevel == LLGLTexture::BOOST_ICON)
             {
-                // Shouldn't do anything usefull since texures in fast cache are 16x16,
-                // it is here in case fast cache changes.
+                // Fast cache textures are at most 64x64, but icons can be
+                // smaller than that.
                 S32 expected_width = mKnownDrawWidth > 0 ? mKnownDrawWidth : DEFAULT_ICON_DIMENSIONS;
                 S32 expected_height = mKnownDrawHeight > 0 ? mKnownDrawHeight : DEFAULT_ICON_DIMENSIONS;
                 if (mRawImage && (mRawImage->getWidth() > expected_width || mRawImage->getHeight() > expected_height))
@@ -2097,7 +2099,12 @@ bool LLViewerFetchedTexture::updateFetch()
 			if(decode_priority > 0.0f || mStopFetchingTimer.getElapsedTimeF32() > MAX_HOLD_TIME)
 			{
 				mStopFetchingTimer.reset();
-				LLAppViewer::getTextureFetch()->updateRequestPriority(mID, decode_priority);
+				// The fetcher only orders requests by priority bucket, don't
+				// bother it with changes that wouldn't move this one.
+				if (LLTextureFetch::getPriorityBucket(decode_priority) != LLTextureFetch::getPriorityBucket((F32)mFetchPriority))
+				{
+					LLAppViewer::getTextureFetch()->updateRequestPriority(mID, decode_priority);
+				}
 			}
 		}
 	}
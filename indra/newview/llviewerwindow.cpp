@@ -780,6 +780,12 @@ public:
 				addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Cache Read/Write ", LLMeshRepository::sCacheBytesRead/(1024.f*1024.f), LLMeshRepository::sCacheBytesWritten/(1024.f*1024.f)));
                 ypos += y_inc;
 
+				addText(xpos, ypos, llformat("%d/%d Mesh Decoded Cache Reads/Writes", LLMeshRepository::sDecodedCacheReads, LLMeshRepository::sDecodedCacheWrites));
+				ypos += y_inc;
+
+				addText(xpos, ypos, llformat("%d Mesh LODs Simplified, %.1f KTris Removed", LLMeshRepository::sSimplifiedLODs, LLMeshRepository::sSimplifiedTris / 1000.f));
+				ypos += y_inc;
+
                 addText(xpos, ypos, llformat("%.3f/%.3f MB Mesh Skins/Decompositions Memory", LLMeshRepository::sCacheBytesSkins / (1024.f*1024.f), LLMeshRepository::sCacheBytesDecomps / (1024.f*1024.f)));
                 ypos += y_inc;
 
@@ -26,6 +26,7 @@
 
 #include "llviewerprecompiledheaders.h"
 #include "llvocache.h"
+#include "llvocachefile.h"
 #include "llregionhandle.h"
 #include "llviewercontrol.h"
 #include "llviewerobjectlist.h"
@@ -35,6 +36,7 @@
 #include "llsdserialize.h"
 #include "llagent.h" // <FS:Beq/> For gAgent
 #include "llworld.h" // <FS:Beq/> For LLWorld::getInstance()
+#include "threadpool.h"
 
 //static variables
 U32 LLVOCacheEntry::sMinFrameRange = 0;
@@ -44,9 +46,6 @@ F32 LLVOCacheEntry::sFrontPixelThreshold = 1.0f;
 F32 LLVOCacheEntry::sRearPixelThreshold = 1.0f;
 BOOL LLVOCachePartition::sNeedsOcclusionCheck = FALSE;
 
-const S32 ENTRY_HEADER_SIZE = 6 * sizeof(S32);
-const S32 MAX_ENTRY_BODY_SIZE = 10000;
-
 BOOL check_read(LLAPRFile* apr_file, void* src, S32 n_bytes) 
 {
 	return apr_file->read(src, n_bytes) == n_bytes ;
@@ -56,103 +55,6 @@ BOOL check_write(LLAPRFile* apr_file, void* src, S32 n_bytes)
 {
 	return apr_file->write(src, n_bytes) == n_bytes ;
 }
-// <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-const std::string LLGLTFOverrideCacheEntry::VERSION_LABEL = {"GLTFCacheVer"};
-const int LLGLTFOverrideCacheEntry::VERSION = 1;
-// </FS:Beq>
-
-bool LLGLTFOverrideCacheEntry::fromLLSD(const LLSD& data)
-{
-    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
-    
-    llassert(data.has("local_id"));
-    llassert(data.has("object_id"));
-    llassert(data.has("region_handle_x") && data.has("region_handle_y"));
-
-    if (!data.has("local_id"))
-    {
-        return false;
-    }
-
-    if (data.has("region_handle_x") && data.has("region_handle_y"))
-    {
-        // TODO start requiring this once server sends this for all messages
-        U32 region_handle_y = data["region_handle_y"].asInteger();
-        U32 region_handle_x = data["region_handle_x"].asInteger();
-        mRegionHandle = to_region_handle(region_handle_x, region_handle_y);
-    }
-    else
-    {
-        return false;
-    }
-
-    mLocalId = data["local_id"].asInteger();
-    mObjectId = data["object_id"];
-
-    // message should be interpreted thusly:
-    ///  sides is a list of face indices
-    //   gltf_llsd is a list of corresponding GLTF override LLSD
-    //   any side not represented in "sides" has no override
-    if (data.has("sides") && data.has("gltf_llsd"))
-    {
-        LLSD const& sides = data.get("sides");
-        LLSD const& gltf_llsd = data.get("gltf_llsd");
-
-        if (sides.isArray() && gltf_llsd.isArray() &&
-            sides.size() != 0 &&
-            sides.size() == gltf_llsd.size())
-        {
-            for (int i = 0; i < sides.size(); ++i)
-            {
-                S32 side_idx = sides[i].asInteger();
-                mSides[side_idx] = gltf_llsd[i];
-                LLGLTFMaterial* override_mat = new LLGLTFMaterial();
-                override_mat->applyOverrideLLSD(gltf_llsd[i]);
-                mGLTFMaterial[side_idx] = override_mat;
-            }
-        }
-        else
-        {
-            LL_WARNS_IF(sides.size() != 0, "GLTF") << "broken override cache entry" << LL_ENDL;
-        }
-    }
-
-    llassert(mSides.size() == mGLTFMaterial.size());
-#ifdef SHOW_ASSERT
-    for (auto const & side : mSides)
-    {
-        // check that mSides and mGLTFMaterial have exactly the same keys present
-        llassert(mGLTFMaterial.count(side.first) == 1);
-    }
-#endif
-
-    return true;
-}
-
-LLSD LLGLTFOverrideCacheEntry::toLLSD() const
-{
-    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
-    LLSD data;
-    U32 region_handle_x, region_handle_y;
-    from_region_handle(mRegionHandle, &region_handle_x, &region_handle_y);
-    data["region_handle_y"] = LLSD::Integer(region_handle_y);
-    data["region_handle_x"] = LLSD::Integer(region_handle_x);
-
-    data["object_id"] = mObjectId;
-    data["local_id"] = (LLSD::Integer) mLocalId;
-
-    llassert(mSides.size() == mGLTFMaterial.size());
-    for (auto const & side : mSides)
-    {
-        // check that mSides and mGLTFMaterial have exactly the same keys present
-        llassert(mGLTFMaterial.count(side.first) == 1);
-        data["sides"].append(LLSD::Integer(side.first));
-        data["gltf_llsd"].append(side.second);
-    }
-
-    return data;
-}
-
 //---------------------------------------------------------------------------
 // LLVOCacheEntry
 //---------------------------------------------------------------------------
@@ -194,7 +96,7 @@ LLVOCacheEntry::LLVOCacheEntry()
 	mDP.assignBuffer(mBuffer, 0);
 }
 
-LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
+LLVOCacheEntry::LLVOCacheEntry(const U8* header, const U8* instance_data, S32 instance_size, const U8* shared_data, S32 shared_size)
 :	LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY), 
 	mBuffer(NULL),
 	mUpdateFlags(-1),
@@ -205,60 +107,36 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
 	mBSphereRadius(-1.0f)
 {
 	S32 size = -1;
-	BOOL success;
-    static U8 data_buffer[ENTRY_HEADER_SIZE];
 
 	mDP.assignBuffer(mBuffer, 0);
 
-    success = check_read(apr_file, (void *)data_buffer, ENTRY_HEADER_SIZE);
-    if (success)
-    {
-        memcpy(&mLocalID, data_buffer, sizeof(U32));
-        memcpy(&mCRC, data_buffer + sizeof(U32), sizeof(U32));
-        memcpy(&mHitCount, data_buffer + (2 * sizeof(U32)), sizeof(S32));
-        memcpy(&mDupeCount, data_buffer + (3 * sizeof(U32)), sizeof(S32));
-        memcpy(&mCRCChangeCount, data_buffer + (4 * sizeof(U32)), sizeof(S32));
-        memcpy(&size, data_buffer + (5 * sizeof(U32)), sizeof(S32));
-
-		// Corruption in the cache entries
-		if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1))
-		{
-			// We've got a bogus size, skip reading it.
-			// We won't bother seeking, because the rest of this file
-			// is likely bogus, and will be tossed anyway.
-			LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
-			success = FALSE;
-		}
-	}
-	if(success && size > 0)
-	{
-		mBuffer = new U8[size];
-		success = check_read(apr_file, mBuffer, size);
-
-		if(success)
-		{
-			mDP.assignBuffer(mBuffer, size);
-		}
-		else
-		{
-			// <FS:Beq/> improve logging around vocache
-			LL_WARNS() << "Error loading cache entry for " << mLocalID << ", size " << size << " aborting!" << LL_ENDL;
-			delete[] mBuffer ;
-			mBuffer = NULL ;
-		}
-	}
+	memcpy(&mLocalID, header, sizeof(U32));
+	memcpy(&mCRC, header + sizeof(U32), sizeof(U32));
+	memcpy(&mHitCount, header + (2 * sizeof(U32)), sizeof(S32));
+	memcpy(&mDupeCount, header + (3 * sizeof(U32)), sizeof(S32));
+	memcpy(&mCRCChangeCount, header + (4 * sizeof(U32)), sizeof(S32));
+	memcpy(&size, header + (5 * sizeof(U32)), sizeof(S32));
 
-	if(!success)
+	// Corruption in the cache entries
+	if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1) || (size != instance_size + shared_size))
 	{
+		LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
 		mLocalID = 0;
 		mCRC = 0;
 		mHitCount = 0;
 		mDupeCount = 0;
 		mCRCChangeCount = 0;
-		mBuffer = NULL;
 		mEntry = NULL;
-		mState = INACTIVE;
+		return;
 	}
+
+	mBuffer = new U8[size];
+	memcpy(mBuffer, instance_data, instance_size);
+	if (shared_size > 0)
+	{
+		memcpy(mBuffer + instance_size, shared_data, shared_size);
+	}
+	mDP.assignBuffer(mBuffer, size);
 }
 
 LLVOCacheEntry::~LLVOCacheEntry()
@@ -432,6 +310,11 @@ void LLVOCacheEntry::dump() const
 		<< LL_ENDL;
 }
 
+S32 LLVOCacheEntry::getInstanceDataSize() const
+{
+	return LLVOCacheFile::getInstanceDataSize(mBuffer, mDP.getBufferSize());
+}
+
 S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer) const
 {
     S32 size = mDP.getBufferSize();
@@ -1155,6 +1038,7 @@ const U32 MIN_ENTRIES_TO_PURGE = 16 ;
 const U32 INVALID_TIME = 0 ;
 const char* object_cache_dirname = "objectcache";
 const char* header_filename = "object.cache";
+const U32 IO_SHARDS = 4;
 
 
 LLVOCache::LLVOCache(bool read_only) :
@@ -1172,6 +1056,13 @@ LLVOCache::LLVOCache(bool read_only) :
 
 LLVOCache::~LLVOCache()
 {
+	// Closing the pools runs whatever is still queued, so every pending
+	// region file write lands before the header is written.
+	for (auto& pool : mIOThreadPools)
+	{
+		pool->close();
+	}
+
 	if(mEnabled)
 	{
 		writeCacheHeader();
@@ -1217,6 +1108,7 @@ void LLVOCache::initCache(ELLPath location, U32 size, U32 cache_version)
 	mMetaInfo.mAddressSize = expected_address;
 
 	readCacheHeader();	
+	startIOThreads();
 
 	LL_INFOS() << "Viewer Object Cache Versions - expected: " << cache_version << " found: " << mMetaInfo.mVersion <<  LL_ENDL;
 
@@ -1255,6 +1147,7 @@ void LLVOCache::removeCache(ELLPath location, bool started)
 
 	std::string mask = "*";
 	std::string cache_dir = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
+	flushIO();
 	LL_INFOS() << "Removing cache at " << cache_dir << LL_ENDL;
 	gDirUtilp->deleteFilesInDir(cache_dir, mask); //delete all files
 	LLFile::rmdir(cache_dir);
@@ -1277,6 +1170,8 @@ void LLVOCache::removeCache()
 		return ;
 	}
 
+	flushIO();
+
 	std::string mask = "*";
 	LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
 	gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask); 
@@ -1368,9 +1263,10 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
 		return ;
 	}
 
+	// Removed on the region's I/O thread, after any write still queued for it
 	std::string filename;
 	getObjectCacheFilename(entry->mHandle, filename);
-	LLAPRFile::remove(filename, mLocalAPRFilePoolp);
+	postIO(entry->mHandle, [filename]() { LLFile::remove(filename); });
 	// <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
 	// Note that removeFromCache should take responsibility for cleaning up all cache artefactgs specfic to the handle/entry.
 	// as such this now includes the generic extras
@@ -1524,160 +1420,167 @@ BOOL LLVOCache::updateEntry(const HeaderEntryInfo* entry)
 
 	return check_write(&apr_file, (void*)entry, sizeof(HeaderEntryInfo)) ;
 }
-// <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-// void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) 
-// we now return bool to trigger dirty cache
-// and force a rewrite after a partial read due to corruption.
-bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) 
-// </FS:Beq>
+void LLVOCache::startIOThreads()
 {
-	if(!mEnabled)
+	if (!mIOThreadPools.empty())
 	{
-		LL_WARNS() << "Not reading cache for handle " << handle << "): Cache is currently disabled." << LL_ENDL;
-		return true; // <FS:Beq/> FIRE-33808 - Material Override Cache causes long delays
+		return;
 	}
-	llassert_always(mInitialized);
 
-	handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
-	if(iter == mHandleEntryMap.end()) //no cache
+	for (U32 i = 0; i < IO_SHARDS; ++i)
 	{
-		LL_WARNS() << "No handle map entry for " << handle << LL_ENDL;
-		return false; // <FS:Beq/> FIRE-33808 - Material Override Cache causes long delays
+		mIOThreadPools.emplace_back(new LL::ThreadPool(llformat("VOCacheIO%d", i), 1));
+		mIOThreadPools.back()->start();
 	}
+}
 
-	bool success = true ;
-	S32 num_entries=0;  // <FS:Beq/> FIRE-33808 - Material Override Cache causes long delays
-	std::string filename;
+void LLVOCache::postIO(U64 handle, const std::function<void()>& work)
+{
+	// Once the pools are closed (viewer shutdown) the work is done right here.
+	if (mIOThreadPools.empty() ||
+		!mIOThreadPools[(handle ^ (handle >> 32)) % mIOThreadPools.size()]->getQueue().post(work))
 	{
-		LLUUID cache_id;
-		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
-	
-		success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
-	
-		if(success)
-		{		
-			if(cache_id != id)
-			{
-				LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
-				success = false ;
-			}
+		work();
+	}
+}
 
-			if(success)
+void LLVOCache::flushIO()
+{
+	std::vector<std::future<void> > done;
+	for (auto& pool : mIOThreadPools)
+	{
+		auto promise = std::make_shared<std::promise<void> >();
+		done.push_back(promise->get_future());
+		if (!pool->getQueue().post([promise]() { promise->set_value(); }))
+		{
+			done.pop_back();
+		}
+	}
+	for (auto& future : done)
+	{
+		future.wait();
+	}
+}
+
+LLVOCache::region_cache_future_t LLVOCache::requestRegionCache(U64 handle)
+{
+	if(!mEnabled || !mInitialized)
+	{
+		return region_cache_future_t();
+	}
+
+	auto promise = std::make_shared<std::promise<RegionCacheData> >();
+	region_cache_future_t future = promise->get_future();
+
+	if(mHandleEntryMap.find(handle) == mHandleEntryMap.end()) //no cache
+	{
+		promise->set_value(RegionCacheData());
+		return future;
+	}
+
+	std::string filename;
+	getObjectCacheFilename(handle, filename);
+	std::string extras_filename(getObjectCacheExtrasFilename(handle));
+	postIO(handle, [handle, filename, extras_filename, promise]()
+		{
+			LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("VOCache read");
+			RegionCacheData data;
+			data.mRead = true;
+			readObjectCacheFile(filename, data);
+			readExtrasCacheFile(handle, extras_filename, data);
+			promise->set_value(std::move(data));
+		});
+	return future;
+}
+
+// Called from a cache I/O thread
+//static
+void LLVOCache::readObjectCacheFile(const std::string& filename, RegionCacheData& data)
+{
+	std::string contents;
+	LLFILE* fp = LLFile::fopen(filename, "rb");
+	if (fp)
+	{
+		if (!fseek(fp, 0, SEEK_END))
+		{
+			long size = ftell(fp);
+			if (size > 0 && !fseek(fp, 0, SEEK_SET))
 			{
-				// S32 num_entries;  // if removal was enabled during write num_entries might be wrong
-				success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
-	
-				if(success)
-				{
-					for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
-					{
-						LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
-						if (!entry->getLocalID())
-						{
-							LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
-                        success = false ;
-							break ;
-						}
-						cache_entry_map[entry->getLocalID()] = entry;
-					}
-				}
+				contents.resize(size);
+				contents.resize(fread(&contents[0], 1, size, fp));
 			}
-		}		
+		}
+		fclose(fp);
 	}
-	
-	if(!success)
+
+	// Whatever was read before any damage is still used
+	std::vector<LLVOCacheFile::Entry> entries;
+	bool success = LLVOCacheFile::parse(contents, data.mCacheID, entries);
+	for (std::vector<LLVOCacheFile::Entry>::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
 	{
-		if(cache_entry_map.empty())
+		LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(iter->mHeader, iter->mInstanceData, iter->mInstanceSize,
+															 iter->mSharedData, iter->mSharedSize);
+		if (entry->getLocalID() == 0)
 		{
-			removeEntry(iter->second) ;
+			success = false;
+			break;
 		}
-
+		data.mEntries[entry->getLocalID()] = entry;
 	}
-	// <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-	// return ;
-	LL_DEBUGS("GLTF", "VOCache") << "Read " << cache_entry_map.size() << " entries from object cache " << filename << ", expected " << num_entries << ", success=" << (success?"True":"False") << LL_ENDL;
-	return success;
-	// </FS:Beq>
+	if (!success)
+	{
+		LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+	}
+	data.mExpectedEntries = (S32)entries.size();
+	data.mSuccess = success;
 }
 
-// <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-// void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map)
-void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)
+// Called from a cache I/O thread. Only the entries whose objects are in the
+// primary cache are kept, which keeps stale overrides from piling up.
+//static
+void LLVOCache::readExtrasCacheFile(U64 handle, const std::string& filename, RegionCacheData& data)
 {
-	int loaded= 0;
-	int discarded = 0;
-	// get ViewerRegion pointer from handle
-	LLViewerRegion* pRegion = LLWorld::getInstance()->getRegionFromHandle(handle);
-// </FS:Beq>
-    if(!mEnabled)
-    {
-        LL_WARNS() << "Not reading cache for handle " << handle << "): Cache is currently disabled." << LL_ENDL;
-        return ;
-    }
-    llassert_always(mInitialized);
+    llifstream in(filename, std::ios::in | std::ios::binary);
 
-    handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
-    if(iter == mHandleEntryMap.end()) //no cache
+    char magic[sizeof(LLGLTFOverrideCacheEntry::BINARY_MAGIC)] = { 0 };
+    in.read(magic, sizeof(magic));
+    if (in.good() && !memcmp(magic, LLGLTFOverrideCacheEntry::BINARY_MAGIC, sizeof(magic)))
     {
-        LL_WARNS() << "No handle map entry for " << handle << LL_ENDL;
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        readBinaryExtras(handle, contents, data);
         return;
     }
 
-    std::string filename(getObjectCacheExtrasFilename(handle));
-    llifstream in(filename, std::ios::in | std::ios::binary);
-
+    // A text file from an older viewer, it is rewritten in the binary format
+    // the next time the region is saved.
+    in.clear();
+    in.seekg(0);
     std::string line;
     std::getline(in, line);
     if(!in.good()) {
         LL_WARNS() << "Failed reading extras cache for handle " << handle << LL_ENDL;
-		// <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-        in.close();
-        removeGenericExtrasForHandle(handle);
-		// </FS:Beq>
+        data.mExtrasCorrupt = true;
         return;
     }
 
-    // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-    // file formats need versions, let's add one. legacy cache files will be considered version 0
-    int versionNumber=0;
+    // file formats need versions, legacy cache files will be considered version 0
     if (line.compare(0, LLGLTFOverrideCacheEntry::VERSION_LABEL.length(), LLGLTFOverrideCacheEntry::VERSION_LABEL) == 0) 
     {
-        std::string versionStr = line.substr(LLGLTFOverrideCacheEntry::VERSION_LABEL.length()+1); // skip the version label and ':'
-        versionNumber = std::stol(versionStr);
         std::getline(in, line); // read the next line for the region UUID check
     }
-    // </FS:Beq>
     if(!LLUUID::validate(line))
     {
         LL_WARNS() << "Failed reading extras cache for handle" << handle << ". invalid uuid line: '" << line << "'" << LL_ENDL;
-        // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-        in.close();
-        removeGenericExtrasForHandle(handle);
-        // </FS:Beq>
-        return;
-    }
-
-    LLUUID cache_id(line);
-    if(cache_id != id)
-    {
-        // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-        // if the cache id doesn't match the expected region we should just kill the file.
-        LL_WARNS() << "Cache ID doesn't match for this region, deleting it" << LL_ENDL;
-        in.close();
-        removeGenericExtrasForHandle(handle);
-        // </FS:Beq>
+        data.mExtrasCorrupt = true;
         return;
     }
+    data.mExtrasCacheID.set(line);
 
     U32 num_entries;  // if removal was enabled during write num_entries might be wrong
     std::getline(in, line);
     if(!in.good()) {
         LL_WARNS() << "Failed reading extras cache for handle " << handle << LL_ENDL;
-        // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-        in.close();
-        removeGenericExtrasForHandle(handle);
-        // </FS:Beq>
+        data.mExtrasCorrupt = true;
         return;
     }
     try {
@@ -1686,16 +1589,14 @@ void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCac
     catch(std::logic_error&)  // either invalid_argument or out_of_range
     {
         LL_WARNS() << "Failed reading extras cache for handle " << handle << ". unreadable num_entries" << LL_ENDL;
-        // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-        in.close();
-        removeGenericExtrasForHandle(handle);
-        // </FS:Beq>
+        data.mExtrasCorrupt = true;
         return;
     }
 
-    // <FS:Beq/> FIRE-33808 - Material Override Cache causes long delays
-    LL_DEBUGS("GLTF") << "Beginning reading extras cache for handle " << handle << " from " << getObjectCacheExtrasFilename(handle) << LL_ENDL;
+    LL_DEBUGS("GLTF") << "Beginning reading extras cache for handle " << handle << " from " << filename << LL_ENDL;
 
+    int loaded = 0;
+    int discarded = 0;
     LLSD entry_llsd;
     for (U32 i = 0; i < num_entries && !in.eof(); i++)
     {
@@ -1703,29 +1604,73 @@ void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCac
         bool success = LLSDSerialize::deserialize(entry_llsd, in, max_size);
         // check bool(in) this time since eof is not a failure condition here
         if(!success || !in) {
-            // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
             LL_WARNS() << "Failed reading extras cache for handle " << handle << ", entry number " << i << " cache patrtial load only." << LL_ENDL;
-            in.close();
-            removeGenericExtrasForHandle(handle);
+            data.mExtrasCorrupt = true;
             break;
-            // </FS:Beq>
         }
 
-        LLGLTFOverrideCacheEntry entry;
-        entry.fromLLSD(entry_llsd);
         U32 local_id = entry_llsd["local_id"].asInteger();
-        // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-        // cache_extras_entry_map[local_id] = entry;
-        // only add entries that exist in the primary cache
-        // this is a self-healing test that avoids us polluting the cache with entries that are no longer valid.
-        if(cache_entry_map.find(local_id)!= cache_entry_map.end())
+        if(data.mEntries.find(local_id) != data.mEntries.end())
         {
-            // attempt to backfill a null objectId, though these shouldn't be in the persisted cache really
-            if(entry.mObjectId.isNull() && pRegion)
-            {
-                gObjectList.getUUIDFromLocal( entry.mObjectId, local_id, pRegion->getHost().getAddress(), pRegion->getHost().getPort() );
-            }
-            cache_extras_entry_map[local_id] = entry;
+            LLGLTFOverrideCacheEntry entry;
+            entry.fromLLSD(entry_llsd);
+            data.mExtras[local_id] = entry;
+            loaded++;
+        }
+        else
+        {
+            discarded++;
+        }
+    }
+    LL_DEBUGS("GLTF") << "Completed reading extras cache for handle " << handle << ", " << loaded << " loaded, " << discarded << " discarded" << LL_ENDL;
+}
+
+// Called from a cache I/O thread. 'contents' is the file after the magic.
+//static
+void LLVOCache::readBinaryExtras(U64 handle, const std::string& contents, RegionCacheData& data)
+{
+    const U8* ptr = (const U8*)contents.data();
+    const U8* end = ptr + contents.size();
+
+    S32 version = 0;
+    U32 num_entries = 0;
+    if (end - ptr < (std::ptrdiff_t)(sizeof(S32) + UUID_BYTES + sizeof(U32)))
+    {
+        LL_WARNS() << "Failed reading extras cache for handle " << handle << ", truncated header" << LL_ENDL;
+        data.mExtrasCorrupt = true;
+        return;
+    }
+    memcpy(&version, ptr, sizeof(S32));
+    ptr += sizeof(S32);
+    if (version != LLGLTFOverrideCacheEntry::VERSION)
+    {
+        LL_WARNS() << "Discarding extras cache for handle " << handle << ", unknown version " << version << LL_ENDL;
+        data.mExtrasCorrupt = true;
+        return;
+    }
+    memcpy(data.mExtrasCacheID.mData, ptr, UUID_BYTES);
+    ptr += UUID_BYTES;
+    memcpy(&num_entries, ptr, sizeof(U32));
+    ptr += sizeof(U32);
+
+    // The override data itself stays packed until the object uses it, see
+    // LLViewerRegion::applyCacheMiscExtras().
+    int loaded = 0;
+    int discarded = 0;
+    for (U32 i = 0; i < num_entries; i++)
+    {
+        LLGLTFOverrideCacheEntry entry;
+        if (!entry.readBinary(ptr, end))
+        {
+            LL_WARNS() << "Failed reading extras cache for handle " << handle << ", entry number " << i << " cache partial load only." << LL_ENDL;
+            data.mExtrasCorrupt = true;
+            break;
+        }
+
+        if (data.mEntries.find(entry.mLocalId) != data.mEntries.end())
+        {
+            entry.mRegionHandle = handle;
+            data.mExtras[entry.mLocalId] = std::move(entry);
             loaded++;
         }
         else
@@ -1734,7 +1679,74 @@ void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCac
         }
     }
     LL_DEBUGS("GLTF") << "Completed reading extras cache for handle " << handle << ", " << loaded << " loaded, " << discarded << " discarded" << LL_ENDL;
-    // </FS:Beq>
+}
+
+bool LLVOCache::applyRegionCache(U64 handle, const LLUUID& id, RegionCacheData& data,
+								 LLVOCacheEntry::vocache_entry_map_t& cache_entry_map,
+								 LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map)
+{
+	if(!mEnabled)
+	{
+		LL_WARNS() << "Not reading cache for handle " << handle << "): Cache is currently disabled." << LL_ENDL;
+		return true;
+	}
+	llassert_always(mInitialized);
+
+	// The header may have changed while the files were read
+	handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
+	if(!data.mRead || iter == mHandleEntryMap.end()) //no cache
+	{
+		LL_WARNS() << "No handle map entry for " << handle << LL_ENDL;
+		return false;
+	}
+
+	bool success = data.mSuccess;
+	if(success && data.mCacheID != id)
+	{
+		LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
+		data.mEntries.clear();
+		success = false;
+	}
+
+	LL_DEBUGS("GLTF", "VOCache") << "Read " << data.mEntries.size() << " entries from object cache for handle " << handle << ", expected " << data.mExpectedEntries << ", success=" << (success?"True":"False") << LL_ENDL;
+
+	if(!success && data.mEntries.empty())
+	{
+		// also removes the extras file
+		removeEntry(iter->second) ;
+		return false;
+	}
+
+	llassert(cache_entry_map.empty());
+	cache_entry_map.swap(data.mEntries);
+
+	if(data.mExtrasCorrupt)
+	{
+		// whatever was read before the damage is still used
+		removeGenericExtrasForHandle(handle);
+	}
+	else if(data.mExtrasCacheID != id)
+	{
+		// if the cache id doesn't match the expected region we should just kill the file.
+		LL_WARNS() << "Cache ID doesn't match for this region, deleting it" << LL_ENDL;
+		removeGenericExtrasForHandle(handle);
+	}
+
+	if(data.mExtrasCacheID == id)
+	{
+		// attempt to backfill a null objectId, though these shouldn't be in the persisted cache really
+		LLViewerRegion* pRegion = LLWorld::getInstance()->getRegionFromHandle(handle);
+		for (auto& extras : data.mExtras)
+		{
+			if(extras.second.mObjectId.isNull() && pRegion)
+			{
+				gObjectList.getUUIDFromLocal(extras.second.mObjectId, extras.first, pRegion->getHost().getAddress(), pRegion->getHost().getPort());
+			}
+		}
+		cache_extras_entry_map.swap(data.mExtras);
+	}
+
+	return success;
 }
 
 void LLVOCache::purgeEntries(U32 size)
@@ -1820,83 +1832,54 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 		return ; //nothing changed, no need to update.
 	}
 
-	//write to cache file
-	bool success = true ;
+	// Serialize the entries here, the entries themselves must not be touched
+	// off the main thread; the file is written on the region's I/O thread.
+	LLVOCacheFile file;
+	U8 entry_buffer[ENTRY_HEADER_SIZE + MAX_ENTRY_BODY_SIZE];
+	for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
 	{
-		std::string filename;
-		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE, mLocalAPRFilePoolp);
-	
-		success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
-	
-		if(success)
+		if (!removal_enabled || iter->second->isValid())
 		{
-			S32 num_entries = cache_entry_map.size(); // if removal is enabled num_entries might be wrong
-			success = check_write(&apr_file, &num_entries, sizeof(S32));
-            if (success)
-            {
-                const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
-                U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
-                S32 size_in_buffer = 0;
-
-                // This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
-                for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
-                {
-                    if (!removal_enabled || iter->second->isValid())
-                    {
-                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
-
-                        if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
-                        {
-                            size_in_buffer += size;
-                        }
-                        else
-                        {
-                            // <FS:Beq/> FIRE-33808 - Material Override Cache causes long delays
-                            LL_WARNS() << "Failed to write cache entry to buffer for " << filename << ", entry number " << iter->second->getLocalID() << LL_ENDL;
-                            success = false;
-                            break;
-                        }
-
-                        // Make sure we have space in buffer for next element
-                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
-                        {
-                            success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                            size_in_buffer = 0;
-                            if (!success)
-                            {
-                                // <FS:Beq/> FIRE-33808 - Material Override Cache causes long delays
-                                LL_WARNS() << "Failed to write cache to disk " << filename << LL_ENDL;
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                if (success && size_in_buffer > 0)
-                {
-                    // final write
-                    success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                    // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-                    if(!success)
-                    {
-                        LL_WARNS() << "Failed to write cache entry to disk " << filename << LL_ENDL;
-                    }
-                    // </FS:Beq>
-                    size_in_buffer = 0;
-                }
-                // <FS:Beq/> FIRE-33808 - Material Override Cache causes long delays
-                LL_DEBUGS("VOCache") << "Wrote " << num_entries << " entries to the primary VOCache file " << filename << ". success = " << (success ? "True":"False") << LL_ENDL;
-            }
+			S32 size = iter->second->writeToBuffer(entry_buffer);
+			if (size <= ENTRY_HEADER_SIZE) // body is minimum of 1
+			{
+				// <FS:Beq/> FIRE-33808 - Material Override Cache causes long delays
+				LL_WARNS() << "Failed to write cache entry to buffer for " << filename << ", entry number " << iter->second->getLocalID() << LL_ENDL;
+				removeEntry(entry) ;
+				return ;
+			}
+			file.addEntry(entry_buffer, size - ENTRY_HEADER_SIZE, iter->second->getInstanceDataSize());
 		}
 	}
 
-	if(!success)
+	S32 num_entries = file.getNumEntries();
+	S32 num_blocks = file.getNumBlocks();
+	std::string data = file.getData(id);
+
+	LL_DEBUGS("VOCache") << "Object cache " << filename << ": " << num_entries << " entries share " << num_blocks << " data blocks" << LL_ENDL;
+	// <FS:Beq/> FIRE-33808 - Material Override Cache causes long delays
+	LL_DEBUGS("VOCache") << "Writing " << num_entries << " entries to the primary VOCache file " << filename << LL_ENDL;
+	postIO(handle, [filename, data = std::move(data)]() { writeCacheFile(filename, data); });
+}
+
+// Called from a cache I/O thread. A file that could not be written is
+// removed; its header entry then fails the next read and gets dropped.
+//static
+void LLVOCache::writeCacheFile(const std::string& filename, const std::string& data)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+	LLFILE* fp = LLFile::fopen(filename, "wb");
+	bool success = fp != NULL;
+	if (success)
 	{
-		removeEntry(entry) ;
+		success = fwrite(data.data(), 1, data.size(), fp) == data.size();
+		success = (fclose(fp) == 0) && success;
+	}
+	if (!success)
+	{
+		LL_WARNS() << "Failed to write cache to disk " << filename << LL_ENDL;
+		LLFile::remove(filename);
 	}
-
-	return ;
 }
 // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
 void LLVOCache::removeGenericExtrasForHandle(U64 handle)
@@ -1906,8 +1889,9 @@ void LLVOCache::removeGenericExtrasForHandle(U64 handle)
         LL_WARNS() << "Not removing cache for handle " << handle << ": Cache is currently in read-only mode." << LL_ENDL;
         return ;
     }
-    LL_WARNS("GLTF", "VOCache") << "Removing generic extras for handle " << handle << "Filename: " << getObjectCacheExtrasFilename(handle) << LL_ENDL;
-    LLFile::remove(getObjectCacheExtrasFilename(handle));
+    std::string filename(getObjectCacheExtrasFilename(handle));
+    LL_WARNS("GLTF", "VOCache") << "Removing generic extras for handle " << handle << "Filename: " << filename << LL_ENDL;
+    postIO(handle, [filename]() { LLFile::remove(filename); });
 }
 // </FS:Beq>
 
@@ -1929,59 +1913,19 @@ void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LL
     // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
     std::string filename = getObjectCacheExtrasFilename(handle);
     // </FS:Beq>
-    llofstream out(filename, std::ios::out | std::ios::binary);
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        // <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-    //     return;
-    //     // TODO - clean up broken cache file
-    // }
-
-    // out << id << '\n';
-    // if(!out.good())
-    // {
-    //     LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-    //     return;
-    //     // TODO - clean up broken cache file
-    // }
-
-    // U32 num_entries = cache_extras_entry_map.size();
-    // out << num_entries << '\n';
-    // if(!out.good())
-    // {
-    //     LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-    //     return;
-    //     // TODO - clean up broken cache file
-    // }
-        removeGenericExtrasForHandle(handle);
-        return;
-    }
-    // It is good practice to version file formats so let's add one.
-    // legacy versions will be treated as version 0.
-    out << LLGLTFOverrideCacheEntry::VERSION_LABEL << ":" << LLGLTFOverrideCacheEntry::VERSION << '\n';
 
-    out << id << '\n';
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        removeGenericExtrasForHandle(handle); // <FS:Beq/> FIRE-33808 - Material Override Cache causes long delays
-        return;
-    }
-
-    auto num_entries_placeholder = out.tellp();
-    out << std::setw(10) << std::setfill('0') << 0 << '\n';
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        removeGenericExtrasForHandle(handle); 
-        return;
-    }
+    // Built in memory, the file itself is written on the region's I/O thread
+    std::string data(LLGLTFOverrideCacheEntry::BINARY_MAGIC, sizeof(LLGLTFOverrideCacheEntry::BINARY_MAGIC));
+    S32 version = LLGLTFOverrideCacheEntry::VERSION;
+    data.append((const char*)&version, sizeof(S32));
+    data.append((const char*)id.mData, UUID_BYTES);
+    size_t num_entries_offset = data.size();
+    U32 num_entries = 0;
+    data.append((const char*)&num_entries, sizeof(U32));
 
     // get ViewerRegion pointer from handle
     LLViewerRegion* pRegion = LLWorld::getInstance()->getRegionFromHandle(handle);
 
-    U32 num_entries = 0;
     U32 inmem_entries = 0;
     U32 skipped = 0;
     inmem_entries = cache_extras_entry_map.size();
@@ -1996,22 +1940,15 @@ void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LL
             gObjectList.getUUIDFromLocal( entry.mObjectId, local_id, pRegion->getHost().getAddress(), pRegion->getHost().getPort() );
         }
 
+        // Entries still packed came from the cache and were valid when written
         if( /*entry.mObjectId.notNull() &&*/
-            entry.mSides.size() > 0 &&
-            entry.mSides.size() == entry.mGLTFMaterial.size()
+            entry.isPacked() ||
+            (entry.mSides.size() > 0 &&
+             entry.mSides.size() == entry.mGLTFMaterial.size())
         )
         {
-            LLSD entry_llsd = entry.toLLSD();
-            entry_llsd["local_id"] = (S32)local_id;
-            LLSDSerialize::serialize(entry_llsd, out, LLSDSerialize::LLSD_XML);
-            out << '\n';
-            if(!out.good())
-            {
-                // We're not in a good place when this happens so we might as well nuke the file.
-                LL_WARNS() << "Failed writing extras cache for handle " << handle << ". Corrupted cache file " << filename << " removed." << LL_ENDL;
-                removeGenericExtrasForHandle(handle);
-                return;
-            }
+            entry.mLocalId = local_id;
+            entry.writeBinary(data);
             num_entries++;
         }
         else
@@ -2019,13 +1956,8 @@ void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LL
             skipped++;
         }
     }
-    out.seekp(num_entries_placeholder);
-    out << std::setw(10) << std::setfill('0') << num_entries << '\n';
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        removeGenericExtrasForHandle(handle);
-        return;
-    }
+    memcpy(&data[num_entries_offset], &num_entries, sizeof(U32));
+
+    postIO(handle, [filename, data = std::move(data)]() { writeCacheFile(filename, data); });
     LL_DEBUGS("GLTF") << "Completed writing extras cache for handle " << handle << ", " << num_entries << " entries. Total in RAM: " << inmem_entries << " skipped (no persist): " << skipped << LL_ENDL;
 }
@@ -32,29 +32,16 @@
 #include "lldir.h"
 #include "llvieweroctree.h"
 #include "llapr.h"
-#include "llgltfmaterial.h"
+#include "llgltfoverridecacheentry.h"
+#include "threadpool_fwd.h"
 
+#include <future>
 #include <unordered_map>
 
 //---------------------------------------------------------------------------
 // Cache entries
 class LLCamera;
 
-class LLGLTFOverrideCacheEntry
-{
-public:
-    static const std::string VERSION_LABEL;
-    static const int VERSION;
-    bool fromLLSD(const LLSD& data);
-    LLSD toLLSD() const;
-
-    LLUUID mObjectId;
-    U32    mLocalId = 0;
-    std::unordered_map<S32, LLSD> mSides; //override LLSD per side
-    std::unordered_map<S32, LLPointer<LLGLTFMaterial> > mGLTFMaterial; //GLTF material per side
-    U64 mRegionHandle = 0;
-};
-
 class LLVOCacheEntry 
 :	public LLViewerOctreeEntryData
 {
@@ -109,7 +96,10 @@ protected:
 	~LLVOCacheEntry();
 public:
 	LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
-	LLVOCacheEntry(LLAPRFile* apr_file);
+	// Entry read from an object cache file: 'header' holds the fields written
+	// by writeToBuffer(), the update data is the instance part followed by
+	// the shared part (see getInstanceDataSize()).
+	LLVOCacheEntry(const U8* header, const U8* instance_data, S32 instance_size, const U8* shared_data, S32 shared_size);
 	LLVOCacheEntry();	
 
 	void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -133,6 +123,11 @@ public:
 
 	void dump() const;
 	S32 writeToBuffer(U8 *data_buffer) const;
+	// Size of the leading part of the update data that is specific to this
+	// object (ids, position, owner, parent...). The rest (texture entries,
+	// volume and extra parameters...) is often the same for copies of a prim
+	// and is stored once per cache file.
+	S32 getInstanceDataSize() const;
 	LLDataPackerBinaryBuffer *getDP();
 	void recordHit();
 	void recordDupe() { mDupeCount++; }
@@ -248,7 +243,8 @@ private:
 };
 
 //
-//Note: LLVOCache is not thread-safe
+//Note: LLVOCache is not thread-safe, all calls must come from the main thread.
+//      Only the region cache file I/O runs on its own threads.
 //
 class LLVOCache : public LLParamSingleton<LLVOCache>
 {
@@ -288,15 +284,34 @@ private:
 	typedef std::map<U64, HeaderEntryInfo*> handle_entry_map_t;
 
 public:
+	// Contents of the cache files of one region, decoded on a cache I/O thread
+	// and handed over to the region in one piece by applyRegionCache().
+	struct RegionCacheData
+	{
+		bool mRead = false;          // the files were looked at, the handle has a cache entry
+		bool mSuccess = false;       // the object cache file was read completely
+		S32  mExpectedEntries = 0;
+		LLUUID mCacheID;             // region id stored in the object cache file
+		LLVOCacheEntry::vocache_entry_map_t mEntries;
+
+		bool mExtrasCorrupt = false; // the extras cache file should be removed
+		LLUUID mExtrasCacheID;
+		LLVOCacheEntry::vocache_gltf_overrides_map_t mExtras;
+	};
+	typedef std::future<RegionCacheData> region_cache_future_t;
+
 	// We need this init to be separate from constructor, since we might construct cache, purge it, then init.
 	void initCache(ELLPath location, U32 size, U32 cache_version);
 	void removeCache(ELLPath location, bool started = false) ;
-	// <FS:Beq> FIRE-33808 - Material Override Cache causes long delays
-	// void readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) ;
-	// void readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map);
-	bool readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) ;
-	void readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map);
-	// </FS:Beq>
+
+	// Start reading and decoding the cache files of a region on the I/O thread
+	// owning that region. Returns an invalid future if the cache is not usable yet.
+	region_cache_future_t requestRegionCache(U64 handle);
+	// Move the decoded entries into the region maps. Returns false if the cache
+	// file was missing or damaged and should be rewritten.
+	bool applyRegionCache(U64 handle, const LLUUID& id, RegionCacheData& data,
+						  LLVOCacheEntry::vocache_entry_map_t& cache_entry_map,
+						  LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map);
 
 	void writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, BOOL dirty_cache, bool removal_enabled);
     void writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map, BOOL dirty_cache, bool removal_enabled);
@@ -319,6 +334,17 @@ private:
 	void removeEntry(HeaderEntryInfo* entry) ;
 	void purgeEntries(U32 size);
 	BOOL updateEntry(const HeaderEntryInfo* entry);
+
+	// Region cache files are read and written on one of IO_SHARDS single
+	// thread pools picked by region handle, so that all file operations on
+	// a given region run in the order they were issued.
+	void startIOThreads();
+	void postIO(U64 handle, const std::function<void()>& work);
+	void flushIO();
+	static void readObjectCacheFile(const std::string& filename, RegionCacheData& data);
+	static void readExtrasCacheFile(U64 handle, const std::string& filename, RegionCacheData& data);
+	static void readBinaryExtras(U64 handle, const std::string& contents, RegionCacheData& data);
+	static void writeCacheFile(const std::string& filename, const std::string& data);
 	
 private:
 	bool                 mEnabled;
@@ -332,6 +358,7 @@ private:
 	LLVolatileAPRPool*   mLocalAPRFilePoolp ; 	
 	header_entry_queue_t mHeaderEntryQueue;
 	handle_entry_map_t   mHandleEntryMap;	
+	std::vector<std::unique_ptr<LL::ThreadPool> > mIOThreadPools;
 };
 
 #endif
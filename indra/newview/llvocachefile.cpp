@@ -0,0 +1,192 @@
+/**
+ * @file llvocachefile.cpp
+ * @brief Layout of the region object cache files.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llvocachefile.h"
+
+#include "hbxxh.h"
+#include "v3math.h"
+
+// Layout of the cached object update data, see LLViewerObject::initObjectDataMap()
+const S32 SPECIAL_CODE_OFFSET = 64;
+const S32 INSTANCE_DATA_SIZE = 84; // everything up to and including the owner id
+
+LLVOCacheFile::LLVOCacheFile(hash_func_t hash)
+:	mHash(hash),
+	mNumEntries(0)
+{
+}
+
+void LLVOCacheFile::addEntry(const U8* entry, S32 body_size, S32 instance_size)
+{
+	const U8* shared = entry + ENTRY_HEADER_SIZE + instance_size;
+	S32 shared_size = body_size - instance_size;
+	S32 block = -1;
+	if (shared_size > 0)
+	{
+		U64 hash = mHash ? mHash(shared, shared_size) : HBXXH64::digest(shared, shared_size);
+		auto found = mBlockIndex.find(hash);
+		if (found != mBlockIndex.end() &&
+			mBlocks[found->second].second == shared_size &&
+			!memcmp(mSharedData.data() + mBlocks[found->second].first, shared, shared_size))
+		{
+			block = found->second;
+		}
+		else
+		{
+			block = (S32)mBlocks.size();
+			mBlocks.emplace_back(mSharedData.size() + sizeof(S32), shared_size);
+			mSharedData.append((const char*)&shared_size, sizeof(S32));
+			mSharedData.append((const char*)shared, shared_size);
+			// on a hash collision the first block keeps the slot
+			mBlockIndex.emplace(hash, block);
+		}
+	}
+
+	mEntryData.append((const char*)entry, ENTRY_HEADER_SIZE);
+	mEntryData.append((const char*)&instance_size, sizeof(S32));
+	mEntryData.append((const char*)&block, sizeof(S32));
+	mEntryData.append((const char*)entry + ENTRY_HEADER_SIZE, instance_size);
+	mNumEntries++;
+}
+
+std::string LLVOCacheFile::getData(const LLUUID& region_id) const
+{
+	S32 num_blocks = getNumBlocks();
+	std::string data;
+	data.reserve(UUID_BYTES + 2 * sizeof(S32) + mSharedData.size() + mEntryData.size());
+	data.append((const char*)region_id.mData, UUID_BYTES);
+	data.append((const char*)&mNumEntries, sizeof(S32));
+	data.append((const char*)&num_blocks, sizeof(S32));
+	data.append(mSharedData);
+	data.append(mEntryData);
+	return data;
+}
+
+//static
+bool LLVOCacheFile::parse(const std::string& contents, LLUUID& region_id, std::vector<Entry>& entries)
+{
+	entries.clear();
+
+	const U8* ptr = (const U8*)contents.data();
+	const U8* end = ptr + contents.size();
+	S32 num_entries = 0;
+	S32 num_blocks = 0;
+	if ((end - ptr) < (std::ptrdiff_t)(UUID_BYTES + 2 * sizeof(S32)))
+	{
+		return false;
+	}
+	memcpy(region_id.mData, ptr, UUID_BYTES);
+	ptr += UUID_BYTES;
+	memcpy(&num_entries, ptr, sizeof(S32));
+	ptr += sizeof(S32);
+	memcpy(&num_blocks, ptr, sizeof(S32));
+	ptr += sizeof(S32);
+	if (num_entries < 0 || num_blocks < 0)
+	{
+		return false;
+	}
+
+	// The shared blocks are referenced straight from the file contents
+	std::vector<std::pair<const U8*, S32> > blocks;
+	for (S32 i = 0; i < num_blocks; i++)
+	{
+		S32 size = 0;
+		if ((end - ptr) < (std::ptrdiff_t)sizeof(S32))
+		{
+			return false;
+		}
+		memcpy(&size, ptr, sizeof(S32));
+		ptr += sizeof(S32);
+		if (size < 1 || size > MAX_ENTRY_BODY_SIZE || (end - ptr) < size)
+		{
+			return false;
+		}
+		blocks.emplace_back(ptr, size);
+		ptr += size;
+	}
+
+	// Every entry takes at least its header, don't trust the count further
+	entries.reserve(llmin((size_t)num_entries, (size_t)(end - ptr) / (ENTRY_HEADER_SIZE + 2 * sizeof(S32))));
+	for (S32 i = 0; i < num_entries; i++)
+	{
+		Entry entry;
+		S32 block = -1;
+		S32 size = 0;
+		if ((end - ptr) < (std::ptrdiff_t)(ENTRY_HEADER_SIZE + 2 * sizeof(S32)))
+		{
+			return false;
+		}
+		entry.mHeader = ptr;
+		memcpy(&size, ptr + 5 * sizeof(S32), sizeof(S32));
+		ptr += ENTRY_HEADER_SIZE;
+		memcpy(&entry.mInstanceSize, ptr, sizeof(S32));
+		ptr += sizeof(S32);
+		memcpy(&block, ptr, sizeof(S32));
+		ptr += sizeof(S32);
+		if (entry.mInstanceSize < 0 || (end - ptr) < entry.mInstanceSize ||
+			block < -1 || block >= (S32)blocks.size())
+		{
+			return false;
+		}
+		entry.mInstanceData = ptr;
+		ptr += entry.mInstanceSize;
+		entry.mSharedData = block >= 0 ? blocks[block].first : NULL;
+		entry.mSharedSize = block >= 0 ? blocks[block].second : 0;
+		if (size < 1 || size > MAX_ENTRY_BODY_SIZE || size != entry.mInstanceSize + entry.mSharedSize)
+		{
+			return false;
+		}
+		entries.push_back(entry);
+	}
+
+	// The entry count is exact, anything past the last entry is damage
+	return ptr == end;
+}
+
+//static
+S32 LLVOCacheFile::getInstanceDataSize(const U8* body, S32 size)
+{
+	if (size < INSTANCE_DATA_SIZE)
+	{
+		return size;
+	}
+
+	U32 special_code;
+	memcpy(&special_code, body + SPECIAL_CODE_OFFSET, sizeof(U32));
+	S32 instance_size = INSTANCE_DATA_SIZE;
+	if (special_code & 0x80)
+	{
+		instance_size += sizeof(LLVector3); // angular velocity
+	}
+	if (special_code & 0x20)
+	{
+		instance_size += sizeof(U32); // parent id
+	}
+	return llmin(instance_size, size);
+}
@@ -0,0 +1,95 @@
+/**
+ * @file llvocachefile.h
+ * @brief Layout of the region object cache files.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOCACHEFILE_H
+#define LL_LLVOCACHEFILE_H
+
+#include "lluuid.h"
+
+#include <unordered_map>
+#include <vector>
+
+const S32 ENTRY_HEADER_SIZE = 6 * sizeof(S32);
+const S32 MAX_ENTRY_BODY_SIZE = 10000;
+
+// Builds and splits the object cache file of a region. The part of an
+// object update that is not specific to the object (see getInstanceDataSize())
+// is stored once per distinct content and shared by the entries using it.
+//
+// File layout:
+//  region id, S32 entry count, S32 shared block count,
+//  shared blocks: S32 size, data
+//  entries: ENTRY_HEADER_SIZE header, S32 instance data size, S32 shared
+//           block index (-1 for none), instance data
+class LLVOCacheFile
+{
+public:
+	// An entry of a parsed file, pointing into the file contents
+	struct Entry
+	{
+		const U8* mHeader;       // ENTRY_HEADER_SIZE bytes
+		const U8* mInstanceData;
+		S32 mInstanceSize;
+		const U8* mSharedData;   // NULL when the whole update is instance data
+		S32 mSharedSize;
+	};
+
+	typedef U64 (*hash_func_t)(const void* data, size_t size);
+
+	// hash is only there for the tests to force collisions, NULL for xxHash
+	explicit LLVOCacheFile(hash_func_t hash = NULL);
+
+	// entry holds the ENTRY_HEADER_SIZE bytes header followed by body_size
+	// bytes of update data, the first instance_size of which are the
+	// object's own
+	void addEntry(const U8* entry, S32 body_size, S32 instance_size);
+
+	S32 getNumEntries() const { return mNumEntries; }
+	S32 getNumBlocks() const { return (S32)mBlocks.size(); }
+
+	// Contents of the file for the entries added so far
+	std::string getData(const LLUUID& region_id) const;
+
+	// Split file contents into entries. Returns false for truncated or
+	// damaged contents, entries then holds the ones before the damage.
+	static bool parse(const std::string& contents, LLUUID& region_id, std::vector<Entry>& entries);
+
+	// Number of bytes at the start of an object update that only hold data
+	// specific to the object, the rest (shape, texture entry, extra params...)
+	// is commonly the same for many objects of a region.
+	static S32 getInstanceDataSize(const U8* body, S32 size);
+
+private:
+	hash_func_t mHash;
+	std::string mSharedData;
+	std::vector<std::pair<size_t, S32> > mBlocks; // offset and size in mSharedData
+	std::unordered_map<U64, S32> mBlockIndex;     // content hash -> block
+	std::string mEntryData;
+	S32 mNumEntries;
+};
+
+#endif // LL_LLVOCACHEFILE_H
@@ -0,0 +1,465 @@
+/**
+ * @file llaisapi_test.cpp
+ * @brief AISUpdate stream parsing tests.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llaisapi.h"
+
+#include "../llagent.h"
+#include "../llinventorymodel.h"
+#include "../llviewercontrol.h"
+#include "../llviewernetwork.h"
+#include "../llviewerregion.h"
+#include "../llvoavatarself.h"
+
+#include "llsdserialize.h"
+#include "llsdutil.h"
+
+// Content the updates were applied with, keyed by id
+static std::map<LLUUID, LLSD> sCategoriesCreated;
+static std::map<LLUUID, LLSD> sItemsCreated;
+// Categories the viewer already knows of
+static std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > sKnownCategories;
+
+//----------------------------------------------------------------------------
+// Stubs
+//----------------------------------------------------------------------------
+
+LLAgent gAgent;
+LLAgent::LLAgent() : mAgentAccess(NULL) { }
+LLAgent::~LLAgent() { }
+LLViewerRegion* LLAgent::getRegion() const { return NULL; }
+LLUUID gAgentID;
+BOOL gDisconnected = FALSE;
+LLControlGroup gSavedSettings("Global");
+LLPointer<LLVOAvatarSelf> gAgentAvatarp;
+void dump_sequential_xml(const std::string outprefix, const LLSD& content) { }
+
+LLGridManager::LLGridManager() { }
+LLGridManager::~LLGridManager() { }
+bool LLGridManager::isInProductionGrid() { return false; }
+bool LLGridManager::isSystemGrid(const std::string& grid) { return false; }
+bool LLViewerRegion::isCapabilityAvailable(const std::string& name) const { return false; }
+
+LLInventoryModel gInventory;
+LLInventoryModel::LLInventoryModel() { }
+LLInventoryModel::~LLInventoryModel() { }
+LLViewerInventoryCategory* LLInventoryModel::getCategory(const LLUUID& id) const
+{
+	std::map<LLUUID, LLPointer<LLViewerInventoryCategory> >::const_iterator it = sKnownCategories.find(id);
+	return (it != sKnownCategories.end()) ? it->second.get() : NULL;
+}
+LLViewerInventoryItem* LLInventoryModel::getItem(const LLUUID& id) const { return NULL; }
+void LLInventoryModel::updateCategory(const LLViewerInventoryCategory* cat, U32 mask)
+{
+	LLSD& entry = sCategoriesCreated[cat->getUUID()];
+	entry["parent_id"] = cat->getParentUUID();
+	entry["name"] = cat->getName();
+	entry["type"] = (S32)cat->getPreferredType();
+	entry["version"] = cat->getVersion();
+	entry["descendents"] = cat->getDescendentCount();
+}
+U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item, U32 mask)
+{
+	LLSD& entry = sItemsCreated[item->getUUID()];
+	entry["parent_id"] = item->getParentUUID();
+	entry["name"] = item->getName();
+	entry["type"] = (S32)item->getActualType();
+	entry["linked_id"] = item->getLinkedUUID();
+	entry["link"] = item->getIsLinkType();
+	return mask;
+}
+void LLInventoryModel::accountForUpdate(const LLCategoryUpdate& update) const { }
+void LLInventoryModel::notifyObservers(const LLUUID& transaction_id) { }
+bool LLInventoryModel::fetchDescendentsOf(const LLUUID& folder_id) const { return false; }
+const LLUUID LLInventoryModel::findCategoryUUIDForType(LLFolderType::EType preferred_type) const { return LLUUID::null; }
+void LLInventoryModel::onObjectDeletedFromServer(const LLUUID& item_id, bool fix_broken_links, bool update_parent_version, bool do_notify_observers) { }
+
+LLViewerInventoryItem::LLViewerInventoryItem() : mIsComplete(false) { }
+LLViewerInventoryItem::~LLViewerInventoryItem() { }
+void LLViewerInventoryItem::copyViewerItem(const LLViewerInventoryItem* other)
+{
+	LLInventoryItem::copyItem(other);
+	mIsComplete = other->mIsComplete;
+}
+void LLViewerInventoryItem::copyItem(const LLInventoryItem* other) { LLInventoryItem::copyItem(other); }
+BOOL LLViewerInventoryItem::unpackMessage(const LLSD& item)
+{
+	mIsComplete = TRUE;
+	return LLInventoryItem::fromLLSD(item);
+}
+BOOL LLViewerInventoryItem::unpackMessage(LLMessageSystem* msg, const char* block, S32 block_num) { return FALSE; }
+LLAssetType::EType LLViewerInventoryItem::getType() const { return LLInventoryItem::getType(); }
+const LLUUID& LLViewerInventoryItem::getAssetUUID() const { return LLInventoryItem::getAssetUUID(); }
+const LLUUID& LLViewerInventoryItem::getProtectedAssetUUID() const { return LLInventoryItem::getAssetUUID(); }
+const std::string& LLViewerInventoryItem::getName() const { return LLInventoryItem::getName(); }
+S32 LLViewerInventoryItem::getSortField() const { return 0; }
+void LLViewerInventoryItem::getSLURL() { }
+const LLPermissions& LLViewerInventoryItem::getPermissions() const { return LLInventoryItem::getPermissions(); }
+const bool LLViewerInventoryItem::getIsFullPerm() const { return true; }
+const LLUUID& LLViewerInventoryItem::getCreatorUUID() const { return LLInventoryItem::getCreatorUUID(); }
+const std::string& LLViewerInventoryItem::getDescription() const { return LLInventoryItem::getDescription(); }
+const LLSaleInfo& LLViewerInventoryItem::getSaleInfo() const { return LLInventoryItem::getSaleInfo(); }
+const LLUUID& LLViewerInventoryItem::getThumbnailUUID() const { return LLInventoryItem::getThumbnailUUID(); }
+LLInventoryType::EType LLViewerInventoryItem::getInventoryType() const { return LLInventoryItem::getInventoryType(); }
+bool LLViewerInventoryItem::isWearableType() const { return false; }
+LLWearableType::EType LLViewerInventoryItem::getWearableType() const { return LLWearableType::WT_INVALID; }
+bool LLViewerInventoryItem::isSettingsType() const { return false; }
+LLSettingsType::type_e LLViewerInventoryItem::getSettingsType() const { return LLSettingsType::ST_NONE; }
+U32 LLViewerInventoryItem::getFlags() const { return LLInventoryItem::getFlags(); }
+time_t LLViewerInventoryItem::getCreationDate() const { return LLInventoryItem::getCreationDate(); }
+U32 LLViewerInventoryItem::getCRC32() const { return LLInventoryItem::getCRC32(); }
+void LLViewerInventoryItem::updateParentOnServer(BOOL restamp) const { }
+void LLViewerInventoryItem::updateServer(BOOL is_new) const { }
+void LLViewerInventoryItem::packMessage(LLMessageSystem* msg) const { }
+BOOL LLViewerInventoryItem::importLegacyStream(std::istream& input_stream) { return FALSE; }
+void LLViewerInventoryItem::setTransactionID(const LLTransactionID& transaction_id) { }
+
+LLViewerInventoryCategory::LLViewerInventoryCategory(const LLUUID& owner_id) :
+	mOwnerID(owner_id),
+	mVersion(VERSION_UNKNOWN),
+	mDescendentCount(DESCENDENT_COUNT_UNKNOWN),
+	mFetching(FETCH_NONE)
+{
+}
+LLViewerInventoryCategory::LLViewerInventoryCategory(const LLViewerInventoryCategory* other) :
+	mOwnerID(other->mOwnerID),
+	mVersion(other->mVersion),
+	mDescendentCount(other->mDescendentCount),
+	mFetching(FETCH_NONE)
+{
+	copyCategory(other);
+}
+LLViewerInventoryCategory::~LLViewerInventoryCategory() { }
+void LLViewerInventoryCategory::updateParentOnServer(BOOL restamp_children) const { }
+void LLViewerInventoryCategory::updateServer(BOOL is_new) const { }
+void LLViewerInventoryCategory::packMessage(LLMessageSystem* msg) const { }
+S32 LLViewerInventoryCategory::getVersion() const { return mVersion; }
+void LLViewerInventoryCategory::setVersion(S32 version) { mVersion = version; }
+bool LLViewerInventoryCategory::fetch(S32 expiry_seconds) { return false; }
+S32 LLViewerInventoryCategory::getViewerDescendentCount() const { return 0; }
+void LLViewerInventoryCategory::unpackMessage(LLMessageSystem* msg, const char* block, S32 block_num) { }
+BOOL LLViewerInventoryCategory::unpackMessage(const LLSD& category) { return LLInventoryCategory::fromLLSD(category); }
+
+//----------------------------------------------------------------------------
+// Tests
+//----------------------------------------------------------------------------
+
+namespace
+{
+	const LLUUID ROOT_ID("10000000-0000-0000-0000-000000000001");
+	const LLUUID FOLDER_ID("10000000-0000-0000-0000-000000000002");
+	const LLUUID STALE_ID("10000000-0000-0000-0000-000000000003");
+	const LLUUID SUBFOLDER_ID("10000000-0000-0000-0000-000000000004");
+	const LLUUID ITEM_ID("20000000-0000-0000-0000-000000000001");
+	const LLUUID FOLDER_ITEM_ID("20000000-0000-0000-0000-000000000002");
+	const LLUUID STALE_ITEM_ID("20000000-0000-0000-0000-000000000003");
+	const LLUUID LINK_ID("20000000-0000-0000-0000-000000000004");
+
+	std::string item_map_xml(const LLUUID& id, const LLUUID& parent_id, const std::string& name)
+	{
+		return "<map>"
+			"<key>item_id</key><uuid>" + id.asString() + "</uuid>"
+			"<key>parent_id</key><uuid>" + parent_id.asString() + "</uuid>"
+			"<key>asset_id</key><uuid>30000000-0000-0000-0000-00000000000a</uuid>"
+			"<key>name</key><string>" + name + "</string>"
+			"<key>desc</key><string>(No Description)</string>"
+			"<key>type</key><integer>0</integer>"
+			"<key>inv_type</key><integer>0</integer>"
+			"<key>flags</key><integer>0</integer>"
+			"<key>created_at</key><integer>1700000000</integer>"
+			"<key>permissions</key><map>"
+				"<key>creator_id</key><uuid>40000000-0000-0000-0000-000000000001</uuid>"
+				"<key>owner_id</key><uuid>40000000-0000-0000-0000-000000000001</uuid>"
+				"<key>last_owner_id</key><uuid>40000000-0000-0000-0000-000000000001</uuid>"
+				"<key>group_id</key><uuid>00000000-0000-0000-0000-000000000000</uuid>"
+				"<key>base_mask</key><integer>2147483647</integer>"
+				"<key>owner_mask</key><integer>2147483647</integer>"
+				"<key>group_mask</key><integer>0</integer>"
+				"<key>everyone_mask</key><integer>0</integer>"
+				"<key>next_owner_mask</key><integer>532480</integer>"
+				"<key>is_owner_group</key><boolean>0</boolean>"
+			"</map>"
+			"<key>sale_info</key><map>"
+				"<key>sale_price</key><integer>10</integer>"
+				"<key>sale_type</key><integer>0</integer>"
+			"</map>"
+			"</map>";
+	}
+
+	std::string item_xml(const LLUUID& id, const LLUUID& parent_id, const std::string& name)
+	{
+		return "<key>" + id.asString() + "</key>" + item_map_xml(id, parent_id, name);
+	}
+
+	std::string category_fields_xml(const LLUUID& id, const LLUUID& parent_id,
+									const std::string& name, S32 version)
+	{
+		return "<key>category_id</key><uuid>" + id.asString() + "</uuid>"
+			"<key>parent_id</key><uuid>" + parent_id.asString() + "</uuid>"
+			"<key>agent_id</key><uuid>40000000-0000-0000-0000-000000000001</uuid>"
+			"<key>name</key><string>" + name + "</string>"
+			"<key>type_default</key><integer>-1</integer>"
+			"<key>version</key><integer>" + std::to_string(version) + "</integer>"
+			"<key>descendents</key><integer>1</integer>";
+	}
+
+	// A recorded FETCHCATEGORYCHILDREN response, cut down to a few objects.
+	// The stale folder lists its "_embedded" content before its version, so
+	// that a stream only learns it was stale once its content is parsed.
+	std::string response_xml()
+	{
+		return "<?xml version=\"1.0\" ?><llsd><map>"
+			+ category_fields_xml(ROOT_ID, LLUUID::null, "My Inventory", 7) +
+			"<key>_embedded</key><map>"
+				"<key>categories</key><map>"
+					"<key>" + FOLDER_ID.asString() + "</key><map>"
+						+ category_fields_xml(FOLDER_ID, ROOT_ID, "Folder", 2) +
+						"<key>_embedded</key><map>"
+							"<key>categories</key><map>"
+								"<key>" + SUBFOLDER_ID.asString() + "</key><map>"
+									+ category_fields_xml(SUBFOLDER_ID, FOLDER_ID, "Sub &amp; Folder", 4) +
+								"</map>"
+							"</map>"
+							"<key>links</key><map />"
+							"<key>items</key><map>"
+								+ item_xml(FOLDER_ITEM_ID, FOLDER_ID, "Folder item") +
+							"</map>"
+						"</map>"
+					"</map>"
+					"<key>" + STALE_ID.asString() + "</key><map>"
+						"<key>_embedded</key><map>"
+							"<key>categories</key><map />"
+							"<key>links</key><map />"
+							"<key>items</key><map>"
+								+ item_xml(STALE_ITEM_ID, STALE_ID, "Stale item") +
+							"</map>"
+						"</map>"
+						+ category_fields_xml(STALE_ID, ROOT_ID, "Stale", 3) +
+					"</map>"
+				"</map>"
+				"<key>links</key><map>"
+					"<key>" + LINK_ID.asString() + "</key><map>"
+						"<key>item_id</key><uuid>" + LINK_ID.asString() + "</uuid>"
+						"<key>parent_id</key><uuid>" + ROOT_ID.asString() + "</uuid>"
+						"<key>linked_id</key><uuid>" + ITEM_ID.asString() + "</uuid>"
+						"<key>name</key><string>Link</string>"
+						"<key>desc</key><string />"
+						"<key>type</key><integer>24</integer>"
+						"<key>inv_type</key><integer>0</integer>"
+						"<key>created_at</key><integer>1700000000</integer>"
+						"<key>_embedded</key><map>"
+							"<key>item</key>" + item_map_xml(ITEM_ID, ROOT_ID, "Item") +
+						"</map>"
+					"</map>"
+				"</map>"
+				"<key>items</key><map>"
+					+ item_xml(ITEM_ID, ROOT_ID, "Item") +
+				"</map>"
+			"</map>"
+			"</map></llsd>";
+	}
+
+	// Splits a buffer in spans of at most chunk bytes, the way a response
+	// body is held by the BufferArray blocks it was received into
+	LLSDSpanList make_spans(const std::string& data, size_t chunk)
+	{
+		LLSDSpanList spans;
+		for (size_t offset = 0; offset < data.size(); offset += chunk)
+		{
+			spans.push_back(LLSDSpan(data.data() + offset, llmin(chunk, data.size() - offset)));
+		}
+		return spans;
+	}
+
+	LLSD make_request_body()
+	{
+		LLSD body;
+		body["depth"] = 2;
+		return body;
+	}
+
+	void reset_inventory()
+	{
+		sCategoriesCreated.clear();
+		sItemsCreated.clear();
+		sKnownCategories.clear();
+		// The viewer has a newer version of the stale folder
+		LLPointer<LLViewerInventoryCategory> stale = new LLViewerInventoryCategory(LLUUID::null);
+		stale->setUUID(STALE_ID);
+		stale->setParent(ROOT_ID);
+		stale->setVersion(5);
+		stale->setDescendentCount(1);
+		sKnownCategories[STALE_ID] = stale;
+	}
+}
+
+namespace tut
+{
+	struct aisapi_test
+	{
+		aisapi_test()
+		{
+			reset_inventory();
+		}
+
+		// Applies the response parsed as a whole, returns what was created
+		void parse_update(std::map<LLUUID, LLSD>& categories, std::map<LLUUID, LLSD>& items)
+		{
+			reset_inventory();
+			LLSD update;
+			std::istringstream stream(response_xml());
+			ensure("recorded response parses", LLSDSerialize::fromXML(update, stream) > 0);
+			AISUpdate ais_update(update, AISAPI::FETCHCATEGORYCHILDREN, make_request_body());
+			ais_update.doUpdate();
+			categories.swap(sCategoriesCreated);
+			items.swap(sItemsCreated);
+		}
+
+		// Applies the response fed in chunks, returns what was created
+		bool parse_stream(const std::string& data, size_t chunk, LLSD& top_level,
+						  std::map<LLUUID, LLSD>& categories, std::map<LLUUID, LLSD>& items)
+		{
+			reset_inventory();
+			AISUpdate ais_update(AISAPI::FETCHCATEGORYCHILDREN, make_request_body());
+			top_level = LLSD::emptyMap();
+			bool parsed = ais_update.parseStream(make_spans(data, chunk), top_level);
+			if (parsed)
+			{
+				ais_update.doUpdate();
+			}
+			categories.swap(sCategoriesCreated);
+			items.swap(sItemsCreated);
+			return parsed;
+		}
+
+		void ensure_same(const std::string& msg, const std::map<LLUUID, LLSD>& expected,
+						 const std::map<LLUUID, LLSD>& actual)
+		{
+			ensure_equals(msg + " count", actual.size(), expected.size());
+			for (std::map<LLUUID, LLSD>::const_iterator it = expected.begin(); it != expected.end(); ++it)
+			{
+				std::map<LLUUID, LLSD>::const_iterator found = actual.find(it->first);
+				ensure(msg + " has " + it->first.asString(), found != actual.end());
+				ensure(msg + " " + it->first.asString() + " matches", llsd_equals(it->second, found->second));
+			}
+		}
+	};
+
+	typedef test_group<aisapi_test> aisapi_t;
+	typedef aisapi_t::object aisapi_object_t;
+	tut::aisapi_t tut_aisapi("LLAISAPI");
+
+	template<> template<>
+	void aisapi_object_t::test<1>()
+	{
+		set_test_name("chunked stream matches parseUpdate");
+
+		std::map<LLUUID, LLSD> categories, items;
+		parse_update(categories, items);
+
+		ensure("root created", categories.count(ROOT_ID) == 1);
+		ensure("folder created", categories.count(FOLDER_ID) == 1);
+		ensure("subfolder created", categories.count(SUBFOLDER_ID) == 1);
+		ensure("stale folder skipped", categories.count(STALE_ID) == 0);
+		ensure("item created", items.count(ITEM_ID) == 1);
+		ensure("folder item created", items.count(FOLDER_ITEM_ID) == 1);
+		ensure("stale item skipped", items.count(STALE_ITEM_ID) == 0);
+		ensure("link created", items.count(LINK_ID) == 1);
+		ensure("link is a link", items[LINK_ID]["link"].asBoolean());
+		ensure_equals("link target", items[LINK_ID]["linked_id"].asUUID(), ITEM_ID);
+
+		const std::string data = response_xml();
+		const size_t chunks[] = { 1, 3, 7, 64, 1024, data.size() };
+		for (size_t chunk : chunks)
+		{
+			const std::string msg = "chunk " + std::to_string(chunk);
+			LLSD top_level;
+			std::map<LLUUID, LLSD> stream_categories, stream_items;
+			ensure(msg + " parses", parse_stream(data, chunk, top_level, stream_categories, stream_items));
+			ensure_same(msg + " categories", categories, stream_categories);
+			ensure_same(msg + " items", items, stream_items);
+			ensure_equals(msg + " top level id", top_level["category_id"].asUUID(), ROOT_ID);
+			ensure(msg + " top level has no content", !top_level.has("_embedded"));
+		}
+	}
+
+	template<> template<>
+	void aisapi_object_t::test<2>()
+	{
+		set_test_name("truncated stream is rejected");
+
+		const std::string data = response_xml();
+		// Cut inside the stale folder, after its content was taken in but
+		// before it was known to be stale, and at a few other places
+		const size_t stale_at = data.find("Stale item");
+		ensure("stale item in response", stale_at != std::string::npos);
+		const size_t cuts[] = { 0, 10, data.size() / 3, stale_at, stale_at + 200, data.size() / 2, data.size() - 20, data.size() - 1 };
+		for (size_t cut : cuts)
+		{
+			const std::string msg = "cut at " + std::to_string(cut);
+			LLSD top_level;
+			std::map<LLUUID, LLSD> stream_categories, stream_items;
+			ensure(msg + " rejected", !parse_stream(data.substr(0, cut), 5, top_level, stream_categories, stream_items));
+			ensure(msg + " applies nothing", stream_categories.empty() && stream_items.empty());
+		}
+	}
+
+	template<> template<>
+	void aisapi_object_t::test<3>()
+	{
+		set_test_name("malformed stream is rejected");
+
+		std::string data = response_xml();
+		const std::string bad[] = {
+			// Unbalanced tag inside the stale folder content
+			"</map></map></map>",
+			// Not xml at all
+			"<<<>>>",
+			// Mismatched tag
+			"</array>"
+		};
+		const size_t stale_at = data.find("Stale item");
+		for (const std::string& junk : bad)
+		{
+			std::string broken = data;
+			broken.insert(stale_at, junk);
+			LLSD top_level;
+			std::map<LLUUID, LLSD> stream_categories, stream_items;
+			ensure("rejected: " + junk, !parse_stream(broken, 11, top_level, stream_categories, stream_items));
+			ensure("applies nothing: " + junk, stream_categories.empty() && stream_items.empty());
+		}
+
+		// A top level which is not a map
+		LLSD top_level;
+		std::map<LLUUID, LLSD> stream_categories, stream_items;
+		ensure("array rejected", !parse_stream("<llsd><array><integer>1</integer></array></llsd>", 4,
+											   top_level, stream_categories, stream_items));
+	}
+}
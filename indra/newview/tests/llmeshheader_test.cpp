@@ -0,0 +1,151 @@
+/**
+ * @file llmeshheader_test.cpp
+ * @brief LLMeshHeader tests.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llmeshheader.h"
+
+#include "llsd.h"
+
+namespace
+{
+	// Header LLSD as the mesh asset carries it, with the LOD blocks laid out
+	// back to back, lowest LOD first
+	LLSD make_header(S32 lowest, S32 low, S32 medium, S32 high)
+	{
+		const char* names[] = { "lowest_lod", "low_lod", "medium_lod", "high_lod" };
+		const S32 sizes[] = { lowest, low, medium, high };
+		LLSD header;
+		header["version"] = 1;
+		S32 offset = 0;
+		for (S32 i = 0; i < 4; ++i)
+		{
+			if (sizes[i] > 0)
+			{
+				header[names[i]]["offset"] = offset;
+				header[names[i]]["size"] = sizes[i];
+				offset += sizes[i];
+			}
+		}
+		return header;
+	}
+}
+
+namespace tut
+{
+	struct mesh_header_data
+	{
+	};
+	typedef test_group<mesh_header_data> mesh_header_test;
+	typedef mesh_header_test::object mesh_header_object;
+	tut::mesh_header_test mesh_header_testcase("LLMeshHeader");
+
+	template<> template<>
+	void mesh_header_object::test<1>()
+	{
+		set_test_name("well reduced LODs are used as uploaded");
+		LLMeshHeader header(make_header(1000, 3000, 9000, 27000));
+		for (S32 lod = 0; lod < 4; ++lod)
+		{
+			ensure_equals("no substitute", header.getSubstituteSourceLOD(lod), -1);
+		}
+	}
+
+	template<> template<>
+	void mesh_header_object::test<2>()
+	{
+		set_test_name("missing LOD is simplified from the LOD above");
+		LLMeshHeader header(make_header(0, 3000, 9000, 27000));
+		ensure_equals("lowest from low", header.getSubstituteSourceLOD(0), 1);
+		ensure_equals("low as uploaded", header.getSubstituteSourceLOD(1), -1);
+
+		// Missing LODs are skipped on the way up
+		header.fromLLSD(make_header(1000, 0, 0, 27000));
+		ensure_equals("low from high", header.getSubstituteSourceLOD(1), 3);
+		ensure_equals("medium from high", header.getSubstituteSourceLOD(2), 3);
+		ensure_equals("lowest as uploaded", header.getSubstituteSourceLOD(0), -1);
+
+		// Nothing above to simplify
+		header.fromLLSD(make_header(1000, 3000, 9000, 0));
+		ensure_equals("high missing", header.getSubstituteSourceLOD(3), -1);
+	}
+
+	template<> template<>
+	void mesh_header_object::test<3>()
+	{
+		set_test_name("oversized LOD is simplified from the LOD above");
+		// Low holds 90% of medium's bytes
+		LLMeshHeader header(make_header(1000, 8100, 9000, 27000));
+		ensure_equals("low from medium", header.getSubstituteSourceLOD(1), 2);
+		ensure_equals("lowest as uploaded", header.getSubstituteSourceLOD(0), -1);
+		ensure_equals("medium as uploaded", header.getSubstituteSourceLOD(2), -1);
+
+		// Just under the ratio is reduced enough
+		header.fromLLSD(make_header(1000, 6700, 9000, 27000));
+		ensure_equals("low at 74%", header.getSubstituteSourceLOD(1), -1);
+
+		// An oversized source is walked past too
+		header.fromLLSD(make_header(1000, 3000, 26000, 27000));
+		ensure_equals("medium from high", header.getSubstituteSourceLOD(2), 3);
+		ensure_equals("low as uploaded", header.getSubstituteSourceLOD(1), -1);
+		header.fromLLSD(make_header(1000, 25000, 26000, 27000));
+		ensure_equals("low from high", header.getSubstituteSourceLOD(1), 3);
+	}
+
+	template<> template<>
+	void mesh_header_object::test<4>()
+	{
+		set_test_name("LODs all the size of the high LOD are simplified from it");
+		LLMeshHeader header(make_header(27000, 27000, 27000, 27000));
+		ensure_equals("lowest", header.getSubstituteSourceLOD(0), 3);
+		ensure_equals("low", header.getSubstituteSourceLOD(1), 3);
+		ensure_equals("medium", header.getSubstituteSourceLOD(2), 3);
+		ensure_equals("high", header.getSubstituteSourceLOD(3), -1);
+	}
+
+	template<> template<>
+	void mesh_header_object::test<5>()
+	{
+		set_test_name("no substitutes for unusable headers");
+		LLSD data = make_header(0, 27000, 27000, 27000);
+		LLMeshHeader header(data);
+		ensure_equals("usable", header.getSubstituteSourceLOD(0), 3);
+		ensure_equals("negative LOD", header.getSubstituteSourceLOD(-1), -1);
+		ensure_equals("LOD out of range", header.getSubstituteSourceLOD(4), -1);
+
+		data["404"] = true;
+		header.fromLLSD(data);
+		ensure_equals("404", header.getSubstituteSourceLOD(0), -1);
+
+		data = make_header(0, 27000, 27000, 27000);
+		data["version"] = MAX_MESH_VERSION + 1;
+		header.fromLLSD(data);
+		ensure_equals("unsupported version", header.getSubstituteSourceLOD(0), -1);
+	}
+}
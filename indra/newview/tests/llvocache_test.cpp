@@ -137,11 +137,19 @@ namespace tut
     template<> template<>
     void vocacheTestObject::test<2>()
     {
+        LLVOCacheEntry::vocache_entry_map_t entries;
         LLVOCacheEntry::vocache_gltf_overrides_map_t extras;
 
         U64 region_handle = to_region_handle(140, 81);
         LLUUID region_id = LLUUID::generateNewID();
 
-        LLVOCache::instance().readGenericExtrasFromCache(region_handle, region_id, extras);
+        LLVOCache::RegionCacheData data;
+        LLVOCache::region_cache_future_t future = LLVOCache::instance().requestRegionCache(region_handle);
+        if (future.valid())
+        {
+            data = future.get();
+        }
+        LLVOCache::instance().applyRegionCache(region_handle, region_id, data, entries, extras);
+        ensure("no cached entries", entries.empty() && extras.empty());
     }
 }
@@ -0,0 +1,235 @@
+/**
+ * @file llvocachefile_test.cpp
+ * @brief LLVOCacheFile tests.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llvocachefile.h"
+
+namespace
+{
+	// Every shared part collides
+	U64 constant_hash(const void*, size_t)
+	{
+		return 42;
+	}
+
+	// Cache entry as LLVOCacheEntry::writeToBuffer() lays it out: local id,
+	// crc, hit count, dupe count, crc change count, body size, body
+	std::string make_entry(U32 local_id, const std::string& body)
+	{
+		S32 header[6] = { (S32)local_id, (S32)(local_id * 7), 1, 0, 0, (S32)body.size() };
+		return std::string((const char*)header, sizeof(header)) + body;
+	}
+
+	// Update data with instance_size bytes specific to the object followed
+	// by a shared part filled with fill
+	std::string make_body(U32 local_id, S32 instance_size, char fill, S32 shared_size)
+	{
+		std::string body(instance_size, (char)local_id);
+		return body + std::string(shared_size, fill);
+	}
+
+	void add_entry(LLVOCacheFile& file, const std::string& entry, S32 instance_size)
+	{
+		file.addEntry((const U8*)entry.data(), (S32)entry.size() - ENTRY_HEADER_SIZE, instance_size);
+	}
+
+	std::string entry_body(const LLVOCacheFile::Entry& entry)
+	{
+		std::string body((const char*)entry.mInstanceData, entry.mInstanceSize);
+		if (entry.mSharedData)
+		{
+			body.append((const char*)entry.mSharedData, entry.mSharedSize);
+		}
+		return body;
+	}
+}
+
+namespace tut
+{
+	struct vocache_file_data
+	{
+		vocache_file_data()
+		:	mRegionID("6e4a6a1a-3c3b-4d5e-9f10-112233445566")
+		{
+		}
+
+		LLUUID mRegionID;
+	};
+	typedef test_group<vocache_file_data> vocache_file_test;
+	typedef vocache_file_test::object vocache_file_object;
+	tut::vocache_file_test vocache_file_testcase("LLVOCacheFile");
+
+	template<> template<>
+	void vocache_file_object::test<1>()
+	{
+		set_test_name("identical shared parts are stored once");
+		const std::string bodies[] =
+		{
+			make_body(1, 84, 'a', 300),
+			make_body(2, 84, 'a', 300),
+			make_body(3, 96, 'b', 200),
+			make_body(4, 20, 'c', 0),
+			make_body(5, 84, 'a', 300),
+		};
+		const S32 instance_sizes[] = { 84, 84, 96, 20, 84 };
+		LLVOCacheFile file;
+		for (S32 i = 0; i < 5; ++i)
+		{
+			add_entry(file, make_entry(i + 1, bodies[i]), instance_sizes[i]);
+		}
+		ensure_equals("entries", file.getNumEntries(), 5);
+		ensure_equals("blocks", file.getNumBlocks(), 2);
+
+		std::string data = file.getData(mRegionID);
+		LLUUID region_id;
+		std::vector<LLVOCacheFile::Entry> entries;
+		ensure("parsed", LLVOCacheFile::parse(data, region_id, entries));
+		ensure_equals("region id", region_id, mRegionID);
+		ensure_equals("parsed entries", entries.size(), (size_t)5);
+		for (S32 i = 0; i < 5; ++i)
+		{
+			U32 local_id = 0;
+			memcpy(&local_id, entries[i].mHeader, sizeof(U32));
+			ensure_equals("local id", local_id, (U32)(i + 1));
+			ensure_equals("instance size", entries[i].mInstanceSize, instance_sizes[i]);
+			ensure("body", entry_body(entries[i]) == bodies[i]);
+		}
+		ensure("no shared part", entries[3].mSharedData == NULL);
+		ensure("same block", entries[0].mSharedData == entries[1].mSharedData && entries[1].mSharedData == entries[4].mSharedData);
+		ensure("distinct block", entries[0].mSharedData != entries[2].mSharedData);
+	}
+
+	template<> template<>
+	void vocache_file_object::test<2>()
+	{
+		set_test_name("colliding hashes keep distinct shared parts apart");
+		const std::string bodies[] =
+		{
+			make_body(1, 84, 'a', 300),
+			make_body(2, 84, 'b', 300),
+			make_body(3, 84, 'c', 120),
+			make_body(4, 84, 'b', 300),
+		};
+		LLVOCacheFile file(constant_hash);
+		for (S32 i = 0; i < 4; ++i)
+		{
+			add_entry(file, make_entry(i + 1, bodies[i]), 84);
+		}
+		// the first block keeps the hash slot, the others are not shared
+		ensure_equals("blocks", file.getNumBlocks(), 4);
+
+		// the entries point into the file contents
+		std::string data = file.getData(mRegionID);
+		LLUUID region_id;
+		std::vector<LLVOCacheFile::Entry> entries;
+		ensure("parsed", LLVOCacheFile::parse(data, region_id, entries));
+		ensure_equals("parsed entries", entries.size(), (size_t)4);
+		for (S32 i = 0; i < 4; ++i)
+		{
+			ensure("body", entry_body(entries[i]) == bodies[i]);
+		}
+	}
+
+	template<> template<>
+	void vocache_file_object::test<3>()
+	{
+		set_test_name("out of range block index is rejected");
+		LLVOCacheFile file;
+		add_entry(file, make_entry(1, make_body(1, 84, 'a', 300)), 84);
+		std::string data = file.getData(mRegionID);
+		ensure_equals("one block", file.getNumBlocks(), 1);
+
+		// the block index follows the entry header and instance size
+		size_t block_offset = UUID_BYTES + 2 * sizeof(S32) + sizeof(S32) + 300 + ENTRY_HEADER_SIZE + sizeof(S32);
+		const S32 bad_blocks[] = { 1, -2, 1000000 };
+		for (S32 bad_block : bad_blocks)
+		{
+			std::string bad = data;
+			memcpy(&bad[block_offset], &bad_block, sizeof(S32));
+			LLUUID region_id;
+			std::vector<LLVOCacheFile::Entry> entries;
+			ensure("rejected", !LLVOCacheFile::parse(bad, region_id, entries));
+			ensure("no entry", entries.empty());
+		}
+
+		// a block index without shared part would not add up to the body size
+		S32 no_block = -1;
+		std::string bad = data;
+		memcpy(&bad[block_offset], &no_block, sizeof(S32));
+		LLUUID region_id;
+		std::vector<LLVOCacheFile::Entry> entries;
+		ensure("size mismatch rejected", !LLVOCacheFile::parse(bad, region_id, entries));
+	}
+
+	template<> template<>
+	void vocache_file_object::test<4>()
+	{
+		set_test_name("truncated file is rejected");
+		LLVOCacheFile file;
+		add_entry(file, make_entry(1, make_body(1, 84, 'a', 300)), 84);
+		add_entry(file, make_entry(2, make_body(2, 84, 'a', 300)), 84);
+		add_entry(file, make_entry(3, make_body(3, 40, 'b', 0)), 40);
+		std::string data = file.getData(mRegionID);
+
+		for (size_t size = 0; size < data.size(); ++size)
+		{
+			LLUUID region_id;
+			std::vector<LLVOCacheFile::Entry> entries;
+			ensure("truncated rejected", !LLVOCacheFile::parse(data.substr(0, size), region_id, entries));
+			ensure("only complete entries", entries.size() < 3);
+		}
+
+		LLUUID region_id;
+		std::vector<LLVOCacheFile::Entry> entries;
+		ensure("trailing bytes rejected", !LLVOCacheFile::parse(data + "x", region_id, entries));
+		ensure("complete file", LLVOCacheFile::parse(data, region_id, entries));
+	}
+
+	template<> template<>
+	void vocache_file_object::test<5>()
+	{
+		set_test_name("instance data size");
+		std::string body(200, '\0');
+		U8* buffer = (U8*)&body[0];
+		ensure_equals("short update", LLVOCacheFile::getInstanceDataSize(buffer, 50), 50);
+		ensure_equals("plain", LLVOCacheFile::getInstanceDataSize(buffer, 200), 84);
+
+		U32 special_code = 0x80;
+		memcpy(buffer + 64, &special_code, sizeof(U32));
+		ensure_equals("angular velocity", LLVOCacheFile::getInstanceDataSize(buffer, 200), 96);
+		special_code = 0x20;
+		memcpy(buffer + 64, &special_code, sizeof(U32));
+		ensure_equals("parent id", LLVOCacheFile::getInstanceDataSize(buffer, 200), 88);
+		special_code = 0xa0;
+		memcpy(buffer + 64, &special_code, sizeof(U32));
+		ensure_equals("both", LLVOCacheFile::getInstanceDataSize(buffer, 200), 100);
+		ensure_equals("capped", LLVOCacheFile::getInstanceDataSize(buffer, 90), 90);
+	}
+}
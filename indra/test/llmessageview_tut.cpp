@@ -0,0 +1,299 @@
+/**
+ * @file llmessageview_tut.cpp
+ * @brief Tests and timings for LLMessageView.
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (c) 2026 The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+
+#include <chrono>
+#include <iostream>
+
+#include "llapr.h"
+#include "llmessagetemplate.h"
+#include "llmessageview.h"
+#include "lltemplatemessagebuilder.h"
+#include "lltemplatemessagereader.h"
+#include "message.h"
+#include "message_prehash.h"
+
+namespace tut
+{
+	static LLTemplateMessageBuilder::message_template_name_map_t viewNameMap;
+	static LLTemplateMessageReader::message_template_number_map_t viewNumberMap;
+
+	struct LLMessageViewTestData
+	{
+		LLMessageViewTestData()
+		{
+			static bool init = false;
+			if (!init)
+			{
+				ll_init_apr();
+				init = true;
+			}
+			// The reader hands messages to gMessageSystem's handlers
+			start_messaging_system("notafile", 13035,
+								   1,
+								   0,
+								   0,
+								   FALSE,
+								   "notasharedsecret",
+								   NULL,
+								   false,
+								   5.f,
+								   100.f);
+
+			// Built once, as templates live as long as the message system,
+			// which the bound fields rely on
+			if (viewNumberMap.empty())
+			{
+				// Shaped like ObjectUpdate
+				LLMessageTemplate* full = new LLMessageTemplate(_PREHASH_ObjectUpdate, 1, MFT_HIGH);
+				LLMessageBlock* region = new LLMessageBlock(_PREHASH_RegionData, MBT_SINGLE);
+				region->addVariable(const_cast<char*>(_PREHASH_RegionHandle), MVT_U64, 8);
+				region->addVariable(const_cast<char*>(_PREHASH_TimeDilation), MVT_U16, 2);
+				full->addBlock(region);
+				LLMessageBlock* object = new LLMessageBlock(_PREHASH_ObjectData, MBT_VARIABLE);
+				object->addVariable(const_cast<char*>(_PREHASH_ID), MVT_U32, 4);
+				object->addVariable(const_cast<char*>(_PREHASH_State), MVT_U8, 1);
+				object->addVariable(const_cast<char*>(_PREHASH_FullID), MVT_LLUUID, 16);
+				object->addVariable(const_cast<char*>(_PREHASH_PCode), MVT_U8, 1);
+				object->addVariable(const_cast<char*>(_PREHASH_Data), MVT_VARIABLE, 2);
+				object->addVariable(const_cast<char*>(_PREHASH_UpdateFlags), MVT_U32, 4);
+				full->addBlock(object);
+
+				// Shaped like ImprovedTerseObjectUpdate, Data in another place
+				LLMessageTemplate* terse = new LLMessageTemplate(_PREHASH_ImprovedTerseObjectUpdate, 2, MFT_HIGH);
+				region = new LLMessageBlock(_PREHASH_RegionData, MBT_SINGLE);
+				region->addVariable(const_cast<char*>(_PREHASH_TimeDilation), MVT_U16, 2);
+				region->addVariable(const_cast<char*>(_PREHASH_RegionHandle), MVT_U64, 8);
+				terse->addBlock(region);
+				object = new LLMessageBlock(_PREHASH_ObjectData, MBT_VARIABLE);
+				object->addVariable(const_cast<char*>(_PREHASH_TextureEntry), MVT_VARIABLE, 2);
+				object->addVariable(const_cast<char*>(_PREHASH_Data), MVT_VARIABLE, 1);
+				terse->addBlock(object);
+
+				viewNameMap[_PREHASH_ObjectUpdate] = full;
+				viewNameMap[_PREHASH_ImprovedTerseObjectUpdate] = terse;
+				viewNumberMap[1] = full;
+				viewNumberMap[2] = terse;
+			}
+			mReader = new LLTemplateMessageReader(viewNumberMap);
+		}
+
+		~LLMessageViewTestData()
+		{
+			delete mReader;
+
+			// not end_messaging_system(), as in message_tut.cpp
+			delete static_cast<LLMessageSystem*>(gMessageSystem);
+			gMessageSystem = NULL;
+		}
+
+		static LLUUID objectID(S32 object)
+		{
+			LLUUID id;
+			id.mData[0] = (U8)object;
+			id.mData[15] = 0x5a;
+			return id;
+		}
+
+		// Reads an ObjectUpdate of count objects into mReader
+		void readFull(S32 count)
+		{
+			LLTemplateMessageBuilder builder(viewNameMap);
+			builder.newMessage(_PREHASH_ObjectUpdate);
+			builder.nextBlock(_PREHASH_RegionData);
+			builder.addU64(_PREHASH_RegionHandle, 0x0003e80000040100ULL);
+			builder.addU16(_PREHASH_TimeDilation, 65535);
+			for (S32 i = 0; i < count; ++i)
+			{
+				U8 data[64];
+				memset(data, i, sizeof(data));
+				builder.nextBlock(_PREHASH_ObjectData);
+				builder.addU32(_PREHASH_ID, 1000 + i);
+				builder.addU8(_PREHASH_State, 0);
+				builder.addUUID(_PREHASH_FullID, objectID(i));
+				builder.addU8(_PREHASH_PCode, (U8)(9 + i % 3));
+				builder.addBinaryData(_PREHASH_Data, data, 8 + i % 50);
+				builder.addU32(_PREHASH_UpdateFlags, 0x10000 | i);
+			}
+			read(builder);
+		}
+
+		// Reads an ImprovedTerseObjectUpdate of count objects into mReader
+		void readTerse(S32 count)
+		{
+			LLTemplateMessageBuilder builder(viewNameMap);
+			builder.newMessage(_PREHASH_ImprovedTerseObjectUpdate);
+			builder.nextBlock(_PREHASH_RegionData);
+			builder.addU16(_PREHASH_TimeDilation, 65535);
+			builder.addU64(_PREHASH_RegionHandle, 42);
+			for (S32 i = 0; i < count; ++i)
+			{
+				U8 data[60];
+				memset(data, 0xf0 | i, sizeof(data));
+				builder.nextBlock(_PREHASH_ObjectData);
+				builder.addBinaryData(_PREHASH_TextureEntry, data, 4);
+				builder.addBinaryData(_PREHASH_Data, data, 44 + i % 17);
+			}
+			read(builder);
+		}
+
+		void read(LLTemplateMessageBuilder& builder)
+		{
+			U8 buffer[MAX_BUFFER_SIZE];
+			memset(buffer, 0, LL_PACKET_ID_SIZE);
+			U32 size = builder.buildMessage(buffer, MAX_BUFFER_SIZE, 0);
+			mReader->clearMessage();
+			ensure("message valid", mReader->validateMessage(buffer, size, LLHost()));
+			ensure("message read", mReader->readMessage(buffer, LLHost()));
+		}
+
+		LLTemplateMessageReader* mReader;
+	};
+
+	typedef test_group<LLMessageViewTestData> LLMessageViewTestGroup;
+	typedef LLMessageViewTestGroup::object LLMessageViewTestObject;
+	LLMessageViewTestGroup messageViewTestGroup("LLMessageView");
+
+	template<> template<>
+	void LLMessageViewTestObject::test<1>()
+		// the view reads what the named calls read
+	{
+		readFull(20);
+		LLObjectUpdateView view(mReader);
+
+		U64 handle = 0;
+		mReader->getU64(_PREHASH_RegionData, _PREHASH_RegionHandle, handle);
+		ensure_equals("region handle", view.getRegionHandle(), handle);
+		ensure_equals("object count", view.getObjectCount(), 20);
+		ensure_equals("named count", mReader->getNumberOfBlocks(_PREHASH_ObjectData), 20);
+
+		for (S32 i = 0; i < 20; ++i)
+		{
+			U32 local_id = 0;
+			U32 flags = 0;
+			U8 pcode = 0;
+			LLUUID full_id;
+			mReader->getU32(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+			mReader->getU32(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
+			mReader->getU8(_PREHASH_ObjectData, _PREHASH_PCode, pcode, i);
+			mReader->getUUID(_PREHASH_ObjectData, _PREHASH_FullID, full_id, i);
+			ensure_equals("local id", view.getLocalID(i), local_id);
+			ensure_equals("local id value", local_id, (U32)(1000 + i));
+			ensure_equals("flags", view.getUpdateFlags(i), flags);
+			ensure_equals("pcode", view.getPCode(i), pcode);
+			ensure_equals("full id", view.getFullID(i), full_id);
+			ensure_equals("full id value", full_id, objectID(i));
+
+			S32 size = mReader->getSize(_PREHASH_ObjectData, i, _PREHASH_Data);
+			ensure_equals("data size", view.getDataSize(i), size);
+			U8 named[64];
+			U8 viewed[64];
+			mReader->getBinaryData(_PREHASH_ObjectData, _PREHASH_Data, named, 0, i, sizeof(named));
+			view.getData(i, viewed, sizeof(viewed));
+			ensure("data", !memcmp(named, viewed, size));
+		}
+	}
+
+	template<> template<>
+	void LLMessageViewTestObject::test<2>()
+		// fields shared by messages rebind as the template changes
+	{
+		for (S32 round = 0; round < 3; ++round)
+		{
+			readTerse(5);
+			LLObjectUpdateView terse(mReader);
+			ensure_equals("terse region handle", terse.getRegionHandle(), (U64)42);
+			ensure_equals("terse object count", terse.getObjectCount(), 5);
+			for (S32 i = 0; i < 5; ++i)
+			{
+				U8 data[64];
+				ensure_equals("terse data size", terse.getDataSize(i), 44 + i % 17);
+				terse.getData(i, data, sizeof(data));
+				ensure_equals("terse data", data[0], (U8)(0xf0 | i));
+			}
+
+			readFull(3);
+			LLObjectUpdateView full(mReader);
+			ensure_equals("full region handle", full.getRegionHandle(), 0x0003e80000040100ULL);
+			ensure_equals("full object count", full.getObjectCount(), 3);
+			ensure_equals("full data size", full.getDataSize(2), 10);
+			ensure_equals("full local id", full.getLocalID(2), (U32)1002);
+		}
+
+		// No ObjectData blocks at all
+		readFull(0);
+		LLObjectUpdateView empty(mReader);
+		ensure_equals("no objects", empty.getObjectCount(), 0);
+	}
+
+	template<> template<>
+	void LLMessageViewTestObject::test<3>()
+		// timings of the view against the named calls
+	{
+		typedef std::chrono::steady_clock clock_t;
+		typedef std::chrono::duration<double, std::milli> ms_t;
+		const S32 OBJECTS = 16;
+		const S32 ROUNDS = 50000;
+
+		readFull(OBJECTS);
+		U64 named_sum = 0;
+		auto start = clock_t::now();
+		for (S32 round = 0; round < ROUNDS; ++round)
+		{
+			for (S32 i = 0; i < OBJECTS; ++i)
+			{
+				U32 local_id = 0;
+				U32 flags = 0;
+				U8 pcode = 0;
+				LLUUID full_id;
+				mReader->getU32(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+				mReader->getU32(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
+				mReader->getU8(_PREHASH_ObjectData, _PREHASH_PCode, pcode, i);
+				mReader->getUUID(_PREHASH_ObjectData, _PREHASH_FullID, full_id, i);
+				named_sum += local_id + flags + pcode + full_id.mData[0];
+			}
+		}
+		auto middle = clock_t::now();
+		U64 view_sum = 0;
+		for (S32 round = 0; round < ROUNDS; ++round)
+		{
+			LLObjectUpdateView view(mReader);
+			for (S32 i = 0; i < OBJECTS; ++i)
+			{
+				view_sum += view.getLocalID(i) + view.getUpdateFlags(i) + view.getPCode(i) + view.getFullID(i).mData[0];
+			}
+		}
+		auto end = clock_t::now();
+		ensure_equals("same values read", view_sum, named_sum);
+		std::cout << ROUNDS << " ObjectUpdates of " << OBJECTS << " objects, named: "
+				  << ms_t(middle - start).count() << " ms, view: "
+				  << ms_t(end - middle).count() << " ms" << std::endl;
+	}
+}
@@ -30,6 +30,7 @@
 #include "linden_common.h"
 #include "lltut.h"
 
+#include "llformat.h"
 #include "llsdtraits.h"
 #include "llstring.h"
 
@@ -811,6 +812,95 @@ namespace tut
 		ensure("type is a string", v.isString());
 	}
 
+	template<> template<>
+	void SDTestObject::test<15>()
+		// moving hands the Impl over and leaves the source Undefined
+	{
+		ensure("move is noexcept", std::is_nothrow_move_constructible<LLSD>::value);
+
+		LLSD a;
+		a["key"] = "value";
+		a["list"].append(1);
+
+		{
+			SDAllocationCheck check("move construct and assign", 0);
+
+			LLSD b(std::move(a));
+			ensure("moved-from is undefined", a.isUndefined());
+			ensure_equals("moved map", b["key"].asString(), "value");
+
+			LLSD c;
+			c = std::move(b);
+			ensure("moved-from is undefined", b.isUndefined());
+			ensure_equals("moved map", c["list"][0].asInteger(), 1);
+
+			LLSD& alias = c;
+			c = std::move(alias);
+			ensure_equals("self move keeps value", c["key"].asString(), "value");
+
+			a = std::move(c);
+		}
+
+		// a moved-from value is usable again
+		LLSD b(std::move(a));
+		a = "reused";
+		ensure_equals("reassigned", a.asString(), "reused");
+		ensure_equals("moved value", b["key"].asString(), "value");
+	}
+
+	template<> template<>
+	void SDTestObject::test<16>()
+		// map values stay put, keys are sorted and shared between maps
+	{
+		LLSD a;
+		LLSD& zed = a["zed"];
+		zed = 1;
+		for (S32 i = 0; i < 100; ++i)
+		{
+			a[llformat("key%d", i)] = i;
+		}
+		a.erase("key50");
+		ensure_equals("reference survives inserts and erases", zed.asInteger(), 1);
+		zed = 2;
+		ensure_equals("reference still refers into the map", a["zed"].asInteger(), 2);
+
+		a.insert("zed", 3);
+		ensure_equals("insert keeps an existing value", a["zed"].asInteger(), 2);
+		ensure_equals("size", a.size(), 100);
+
+		std::string last;
+		for (LLSD::map_const_iterator it = a.beginMap(); it != a.endMap(); ++it)
+		{
+			ensure("keys in order", last < it->first);
+			last = it->first;
+		}
+		ensure_equals("last key", last, "zed");
+
+		LLSD::map_iterator end = a.endMap();
+		--end;
+		ensure_equals("decrement", end->first, "zed");
+		LLSD::map_const_iterator cbegin = a.beginMap();
+		ensure_equals("distance", end - cbegin, 99);
+		ensure_equals("random access", (cbegin + 1)->first, "key1");
+		ensure_equals("subscript", cbegin[1].second.asInteger(), 1);
+
+		LLSD b;
+		b["zed"] = "other";
+		const LLSD& ca(a);
+		ensure("key shared between maps", &(ca.endMap() - 1)->first == &b.beginMap()->first);
+
+		LLSD copy(a);
+		copy["zed"] = "copied";
+		a.erase("zed");
+		ensure_equals("copy keeps its key", (copy.endMap() - 1)->first, "zed");
+		ensure_equals("copy keeps its value", copy["zed"].asString(), "copied");
+		ensure("original lost its key", !a.has("zed"));
+
+		const auto& [key, value] = *copy.beginMap();
+		ensure_equals("structured binding key", key, "key0");
+		ensure_equals("structured binding value", value.asInteger(), 0);
+	}
+
 	/* TO DO:
 		conversion of undefined to UUID, Date, URI and Binary
 		conversion of undefined to map and array